@@ -0,0 +1,182 @@
+import os
+import struct
+import sys
+import zlib
+
+# Builds /res/cache/resources.cache, which libg maps read-only instead of
+# decoding resources in every process. The layout must match
+# libs/libg/include/libg/ResourceCache.h.
+#
+# make_resource_cache.py --list <res_dir>            prints the inputs
+# make_resource_cache.py <res_dir> <out_file>        writes the cache
+
+CACHE_MAGIC = b"RCCH"
+CACHE_VERSION = 1
+CACHE_ALIGNMENT = 16
+
+ENTRY_BITMAP = 0
+ENTRY_FONT = 1
+
+FORMAT_RGB = 0
+FORMAT_RGBA = 1
+
+HEADER_FORMAT = "<4sIII"
+ENTRY_FORMAT = "<IIIIHHBBH"
+
+
+def fnv1a(data):
+    hash = 0x811c9dc5
+    for byte in data:
+        hash ^= byte
+        hash = (hash * 0x01000193) & 0xffffffff
+    return hash
+
+
+def paeth_predictor(a, b, c):
+    p = a + b - c
+    pa = abs(p - a)
+    pb = abs(p - b)
+    pc = abs(p - c)
+    if pa <= pb and pa <= pc:
+        return a
+    if pb <= pc:
+        return b
+    return c
+
+
+def unfilter(filter_type, line, prior, bpp):
+    res = bytearray(line)
+    for i in range(len(res)):
+        a = res[i - bpp] if i >= bpp else 0
+        b = prior[i]
+        c = prior[i - bpp] if i >= bpp else 0
+        if filter_type == 1:
+            res[i] = (res[i] + a) & 0xff
+        elif filter_type == 2:
+            res[i] = (res[i] + b) & 0xff
+        elif filter_type == 3:
+            res[i] = (res[i] + ((a + b) >> 1)) & 0xff
+        elif filter_type == 4:
+            res[i] = (res[i] + paeth_predictor(a, b, c)) & 0xff
+    return res
+
+
+# Decodes the same subset PNGLoader handles: 8-bit RGB and RGBA without
+# interlacing. Returns None for anything else, such files stay on the
+# regular path.
+def decode_png(data):
+    if data[:8] != b"\x89PNG\r\n\x1a\n":
+        return None
+
+    offset = 8
+    ihdr = None
+    idat = b""
+    while offset + 8 <= len(data):
+        length, chunk_type = struct.unpack(">I4s", data[offset:offset + 8])
+        body = data[offset + 8:offset + 8 + length]
+        offset += 12 + length
+        if chunk_type == b"IHDR":
+            ihdr = struct.unpack(">IIBBBBB", body)
+        elif chunk_type == b"IDAT":
+            idat += body
+        elif chunk_type == b"IEND":
+            break
+
+    if not ihdr:
+        return None
+    width, height, depth, color_type, _, _, interlace = ihdr
+    if depth != 8 or interlace != 0 or color_type not in (2, 6):
+        return None
+    if width > 0xffff or height > 0xffff:
+        return None
+
+    bpp = 3 if color_type == 2 else 4
+    raw = zlib.decompress(idat)
+    stride = width * bpp
+
+    # Pixels are stored the way LG::Color keeps them in memory:
+    # blue, green, red and opacity, which is 255 - alpha.
+    pixels = bytearray(width * height * 4)
+    prior = bytearray(stride)
+    pos = 0
+    for y in range(height):
+        filter_type = raw[pos]
+        line = unfilter(filter_type, raw[pos + 1:pos + 1 + stride], prior, bpp)
+        pos += 1 + stride
+        for x in range(width):
+            r = line[x * bpp]
+            g = line[x * bpp + 1]
+            b = line[x * bpp + 2]
+            alpha = line[x * bpp + 3] if bpp == 4 else 255
+            at = (y * width + x) * 4
+            pixels[at:at + 4] = bytes((b, g, r, 255 - alpha))
+        prior = line
+
+    format = FORMAT_RGB if color_type == 2 else FORMAT_RGBA
+    return (width, height, format, bytes(pixels))
+
+
+def collect_resources(res_dir):
+    res = []
+    for root, dirs, files in os.walk(res_dir):
+        dirs.sort()
+        for name in sorted(files):
+            if name.endswith(".png") or name.endswith(".font"):
+                res.append(os.path.join(root, name))
+    return res
+
+
+def align(value):
+    return (value + CACHE_ALIGNMENT - 1) & ~(CACHE_ALIGNMENT - 1)
+
+
+def build_cache(res_dir, out_file):
+    entries = []
+    for path in collect_resources(res_dir):
+        cache_path = "/res/" + os.path.relpath(path, res_dir).replace(os.sep, "/")
+        data = open(path, "rb").read()
+        if path.endswith(".png"):
+            decoded = decode_png(data)
+            if not decoded:
+                continue
+            width, height, format, pixels = decoded
+            entries.append((cache_path, ENTRY_BITMAP, width, height, format, pixels))
+        else:
+            entries.append((cache_path, ENTRY_FONT, 0, 0, 0, data))
+
+    entries.sort(key=lambda entry: (fnv1a(entry[0].encode()), entry[0]))
+
+    header_size = struct.calcsize(HEADER_FORMAT)
+    entry_size = struct.calcsize(ENTRY_FORMAT)
+    strings_offset = header_size + len(entries) * entry_size
+
+    strings = b""
+    path_offsets = []
+    for entry in entries:
+        path_offsets.append(strings_offset + len(strings))
+        strings += entry[0].encode() + b"\0"
+
+    data_offset = align(strings_offset + len(strings))
+    table = b""
+    blobs = b""
+    for i, entry in enumerate(entries):
+        cache_path, entry_type, width, height, format, blob = entry
+        offset = data_offset + len(blobs)
+        table += struct.pack(ENTRY_FORMAT, fnv1a(cache_path.encode()), path_offsets[i], offset, len(blob), width, height, entry_type, format, 0)
+        blobs += blob + b"\0" * (align(len(blob)) - len(blob))
+
+    header = struct.pack(HEADER_FORMAT, CACHE_MAGIC, CACHE_VERSION, len(entries), strings_offset)
+    padding = b"\0" * (data_offset - strings_offset - len(strings))
+
+    out_dir = os.path.dirname(out_file)
+    if out_dir and not os.path.exists(out_dir):
+        os.makedirs(out_dir)
+    with open(out_file, "wb") as out:
+        out.write(header + table + strings + padding + blobs)
+
+
+if sys.argv[1] == "--list":
+    for path in collect_resources(sys.argv[2]):
+        print(path)
+else:
+    build_cache(sys.argv[1], sys.argv[2])
@@ -7,12 +7,19 @@
 #ifndef _KERNEL_ALGO_RINGBUFFER_H
 #define _KERNEL_ALGO_RINGBUFFER_H
 
+#include <libkern/atomic.h>
 #include <libkern/libkern.h>
 #include <libkern/lock.h>
 #include <mem/vmm/zoner.h>
 
 #define RINGBUFFER_STD_SIZE (16 * KB)
 
+/**
+ * Single-producer single-consumer ringbuffer. The size is a power of two,
+ * start and end are free-running counters, so the buffer could be filled
+ * up completely. The producer owns end, the consumer owns start, each of
+ * them publishes its counter only after the data is copied.
+ */
 struct __ringbuffer {
     zone_t zone;
     uint32_t start;
@@ -33,6 +40,7 @@ uint32_t ringbuffer_write(ringbuffer_t* buf, const uint8_t*, uint32_t);
 uint32_t ringbuffer_write_ignore_bounds(ringbuffer_t* buf, const uint8_t* holder, uint32_t siz);
 uint32_t ringbuffer_read_one(ringbuffer_t* buf, uint8_t* data);
 uint32_t ringbuffer_write_one(ringbuffer_t* buf, uint8_t data);
+uint32_t ringbuffer_unwrite_one(ringbuffer_t* buf);
 void ringbuffer_clear(ringbuffer_t* buf);
 
-#endif //_KERNEL_ALGO_RINGBUFFER_H
\ No newline at end of file
+#endif //_KERNEL_ALGO_RINGBUFFER_H
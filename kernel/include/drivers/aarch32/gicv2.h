@@ -17,6 +17,11 @@ enum GICDControlMasks {
     MASKDEFINE(GICD_ENABLE, 0, 1),
 };
 
+enum GICDSgiMasks {
+    MASKDEFINE(GICD_SGI_ID, 0, 4),
+    MASKDEFINE(GICD_SGI_TARGETS, 16, 8),
+};
+
 enum GICCControlMasks {
     MASKDEFINE(GICC_ENABLE_GR1, 0, 1),
     MASKDEFINE(GICC_FIQ_BYP_DIS_GR1, 5, 1),
@@ -48,6 +53,8 @@ struct gicv2_distributor_registers {
     uint32_t itargetsr[64];
     SKIP(0x8FC + 0x4, 0xC00);
     uint32_t icfgr[16];
+    SKIP(0xC3C + 0x4, 0xF00);
+    uint32_t sgir;
     // TO BE CONTINUED
 };
 typedef struct gicv2_distributor_registers gicv2_distributor_registers_t;
@@ -68,6 +75,7 @@ struct gicv2_cpu_interface_registers {
 typedef struct gicv2_cpu_interface_registers gicv2_cpu_interface_registers_t;
 
 void gicv2_enable_irq(irq_line_t id, irq_priority_t prior, irq_type_t type, int cpu_mask);
+void gicv2_send_sgi(irq_line_t id, int cpu_mask);
 void gicv2_install();
 void gicv2_install_secondary_cpu();
 uint32_t gicv2_interrupt_descriptor();
@@ -52,5 +52,6 @@ struct pl111_registers {
 typedef struct pl111_registers pl111_registers_t;
 
 void pl111_install();
+void pl111_set_resolution(uint32_t width, uint32_t height);
 
 #endif //_KERNEL_DRIVERS_AARCH32_PL111_H
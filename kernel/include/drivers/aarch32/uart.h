@@ -14,6 +14,7 @@
 void uart_setup();
 void uart_remap();
 int uart_write(int port, uint8_t data);
+int uart_write_buf(int port, const uint8_t* data, size_t len);
 int uart_read(int port, uint8_t* data);
 
 #endif /* _KERNEL_DRIVERS_AARCH32_UART_H */
\ No newline at end of file
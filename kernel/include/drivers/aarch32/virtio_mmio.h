@@ -0,0 +1,59 @@
+/*
+ * Copyright (c) 2021, Krisna Pranav
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef _KERNEL_DRIVERS_AARCH32_VIRTIO_MMIO_H
+#define _KERNEL_DRIVERS_AARCH32_VIRTIO_MMIO_H
+
+#include <drivers/driver_manager.h>
+#include <drivers/generic/virtio.h>
+#include <libkern/types.h>
+#include <platform/aarch32/interrupts.h>
+#include <platform/aarch32/target/cortex-a15/device_settings.h>
+
+#define VIRTIO_MMIO_MAGIC 0x74726976 // "virt"
+
+struct virtio_mmio_registers {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t device_id;
+    uint32_t vendor_id;
+    uint32_t device_features;
+    uint32_t device_features_sel;
+    uint32_t skip0[2];
+    uint32_t driver_features;
+    uint32_t driver_features_sel;
+    uint32_t guest_page_size; // legacy
+    uint32_t skip1;
+    uint32_t queue_sel;
+    uint32_t queue_num_max;
+    uint32_t queue_num;
+    uint32_t queue_align; // legacy
+    uint32_t queue_pfn; // legacy
+    uint32_t queue_ready;
+    uint32_t skip2[2];
+    uint32_t queue_notify;
+    uint32_t skip3[3];
+    uint32_t interrupt_status;
+    uint32_t interrupt_ack;
+    uint32_t skip4[2];
+    uint32_t status;
+    uint32_t skip5[3];
+    uint32_t queue_desc_low;
+    uint32_t queue_desc_high;
+    uint32_t skip6[2];
+    uint32_t queue_avail_low;
+    uint32_t queue_avail_high;
+    uint32_t skip7[2];
+    uint32_t queue_used_low;
+    uint32_t queue_used_high;
+    uint32_t skip8[22];
+    uint32_t config[];
+};
+typedef struct virtio_mmio_registers virtio_mmio_registers_t;
+
+void virtio_mmio_install();
+
+#endif //_KERNEL_DRIVERS_AARCH32_VIRTIO_MMIO_H
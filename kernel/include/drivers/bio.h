@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2021, Krisna Pranav
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef _KERNEL_DRIVERS_BIO_H
+#define _KERNEL_DRIVERS_BIO_H
+
+#include <drivers/driver_manager.h>
+#include <libkern/lock.h>
+#include <libkern/types.h>
+
+#define BLK_SECTOR_SIZE 512
+#define BLK_DEFAULT_MAX_SECTORS 64
+#define BLK_QUEUE_MAX_REQUESTS 32
+#define BLK_MAX_BIOS_PER_CALL 16
+
+enum BIO_OPS {
+    BIO_READ,
+    BIO_WRITE,
+    BIO_FLUSH,
+};
+
+struct bio;
+typedef void (*bio_end_io_t)(struct bio* bio);
+
+/**
+ * bio describes one contiguous transfer. It is owned by the submitter
+ * until done is set; end_io may be called from an interrupt handler.
+ */
+struct bio {
+    device_t* dev;
+    uint32_t op;
+    uint32_t sector;
+    uint32_t count; // in sectors
+    uint8_t* buf;
+    int status;
+    volatile bool done;
+    bio_end_io_t end_io;
+    void* private;
+    struct bio* next;
+};
+typedef struct bio bio_t;
+
+struct blk_request;
+typedef void (*blk_end_request_t)(struct blk_request* req);
+
+/**
+ * blk_request is what drivers see: one or more adjacent bios of the same
+ * op, merged by the queue. Drivers finish it with blk_request_complete().
+ */
+struct blk_request {
+    uint32_t op;
+    uint32_t sector;
+    uint32_t count;
+    bio_t* bios;
+    blk_end_request_t end_request;
+    void* private;
+    struct blk_request* next;
+};
+typedef struct blk_request blk_request_t;
+
+struct blk_queue {
+    bool active;
+    device_t* dev;
+    lock_t lock;
+    uint32_t max_sectors;
+
+    // Pending bios sorted by sector, dispatched in C-LOOK order.
+    // Flushes wait until everything queued before them is done.
+    bio_t* pending;
+    bio_t* flushes;
+    bool dispatching;
+    uint32_t next_sector;
+
+    blk_request_t requests[BLK_QUEUE_MAX_REQUESTS];
+    blk_request_t* free_requests;
+    uint32_t in_flight;
+
+    uint32_t stat_bios;
+    uint32_t stat_requests;
+};
+typedef struct blk_queue blk_queue_t;
+
+blk_queue_t* blk_get_queue(device_t* dev);
+int bio_submit(bio_t* bio);
+void bio_wait(bio_t* bio);
+int blk_queue_run(blk_queue_t* q);
+bool blk_has_pending_work();
+void blk_worker();
+
+void blk_request_gather(blk_request_t* req, uint8_t* dst);
+void blk_request_scatter(blk_request_t* req, uint8_t* src);
+void blk_request_complete(blk_request_t* req, int status);
+
+int blk_read(device_t* dev, uint32_t sector, uint32_t count, uint8_t* buf);
+int blk_write(device_t* dev, uint32_t sector, uint32_t count, uint8_t* buf);
+
+#endif // _KERNEL_DRIVERS_BIO_H
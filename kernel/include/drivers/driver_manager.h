@@ -75,6 +75,9 @@ enum DRIVER_STORAGE_OPERTAION {
     DRIVER_STORAGE_WRITE,
     DRIVER_STORAGE_FLUSH,
     DRIVER_STORAGE_CAPACITY,
+    DRIVER_STORAGE_SUBMIT, // optional, async submit of blk_request_t
+    DRIVER_STORAGE_POLL, // optional, reaps finished requests without interrupts
+    DRIVER_STORAGE_MAX_SECTORS, // optional, max sectors in one blk_request_t
 };
 
 // Api function of DRIVER_INPUT_SYSTEMS type
@@ -0,0 +1,45 @@
+/*
+ * Copyright (c) 2021, Krisna Pranav
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef _KERNEL_DRIVERS_GENERIC_INPUT_H
+#define _KERNEL_DRIVERS_GENERIC_INPUT_H
+
+#include <libkern/lock.h>
+#include <libkern/types.h>
+
+#define INPUT_RING_EVENTS 256 // Must be a power of two.
+
+/**
+ * Merges @event into @last, which is the newest event still waiting to
+ * be read. Returns false if the events can't be coalesced.
+ */
+typedef bool (*input_merge_t)(void* last, const void* event);
+
+/**
+ * Ring of fixed-size input events shared by an interrupt handler and
+ * readers of the device file. Reads return as many whole events as fit,
+ * so a consumer drains the ring with one syscall.
+ */
+struct input_ring {
+    lock_t lock;
+    uint8_t* events;
+    uint32_t event_size;
+    uint32_t start;
+    uint32_t end;
+    input_merge_t merge;
+
+    uint32_t stat_pushed;
+    uint32_t stat_merged;
+    uint32_t stat_dropped;
+};
+typedef struct input_ring input_ring_t;
+
+void input_ring_init(input_ring_t* ring, void* storage, uint32_t event_size, input_merge_t merge);
+void input_ring_push(input_ring_t* ring, const void* event);
+bool input_ring_can_read(input_ring_t* ring);
+int input_ring_read(input_ring_t* ring, uint8_t* buf, uint32_t len);
+
+#endif // _KERNEL_DRIVERS_GENERIC_INPUT_H
@@ -182,6 +182,7 @@ typedef uint32_t key_t;
 /* The keyboard packet should be aligned to 4 bytes */
 struct kbd_packet {
     key_t key;
+    uint32_t time; // ms since boot
 };
 typedef struct kbd_packet kbd_packet_t;
 
@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2021, Krisna Pranav
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef _KERNEL_DRIVERS_GENERIC_VIRTIO_H
+#define _KERNEL_DRIVERS_GENERIC_VIRTIO_H
+
+#include <libkern/c_attrs.h>
+#include <libkern/types.h>
+#include <mem/vmm/zoner.h>
+
+#define VIRTIO_VENDOR_ID 0x1AF4
+#define VIRTIO_DEVICE_ID_BLOCK 2
+
+#define VIRTIO_STATUS_ACKNOWLEDGE 0x01
+#define VIRTIO_STATUS_DRIVER 0x02
+#define VIRTIO_STATUS_DRIVER_OK 0x04
+#define VIRTIO_STATUS_FEATURES_OK 0x08
+#define VIRTIO_STATUS_FAILED 0x80
+
+#define VIRTIO_ISR_QUEUE 0x1
+#define VIRTIO_ISR_CONFIG 0x2
+
+#define VIRTQ_DESC_F_NEXT 0x1
+#define VIRTQ_DESC_F_WRITE 0x2
+
+#define VIRTQ_AVAIL_F_NO_INTERRUPT 0x1
+
+#define VIRTQUEUE_MAX_SIZE 256
+#define VIRTQUEUE_ALIGN 4096
+
+/**
+ * Split virtqueue layout shared by the device and the driver.
+ */
+
+struct PACKED virtq_desc {
+    uint64_t addr;
+    uint32_t len;
+    uint16_t flags;
+    uint16_t next;
+};
+typedef struct virtq_desc virtq_desc_t;
+
+struct PACKED virtq_avail {
+    uint16_t flags;
+    uint16_t idx;
+    uint16_t ring[];
+};
+typedef struct virtq_avail virtq_avail_t;
+
+struct PACKED virtq_used_elem {
+    uint32_t id;
+    uint32_t len;
+};
+typedef struct virtq_used_elem virtq_used_elem_t;
+
+struct PACKED virtq_used {
+    uint16_t flags;
+    uint16_t idx;
+    virtq_used_elem_t ring[];
+};
+typedef struct virtq_used virtq_used_t;
+
+struct virtqueue {
+    uint16_t index;
+    uint16_t size;
+    uint32_t paddr;
+    zone_t zone;
+    volatile virtq_desc_t* desc;
+    volatile virtq_avail_t* avail;
+    volatile virtq_used_t* used;
+    uint16_t free_head;
+    uint16_t num_free;
+    uint16_t last_used_idx;
+};
+typedef struct virtqueue virtqueue_t;
+
+struct virtq_buf {
+    uint32_t paddr;
+    uint32_t len;
+    bool device_writable;
+};
+typedef struct virtq_buf virtq_buf_t;
+
+/**
+ * Transport (PCI or MMIO) is hidden behind virtio_transport_ops_t,
+ * so device drivers are shared between platforms.
+ */
+
+struct virtio_device;
+
+struct virtio_transport_ops {
+    uint32_t (*get_features)(struct virtio_device* vdev);
+    void (*set_features)(struct virtio_device* vdev, uint32_t features);
+    uint8_t (*get_status)(struct virtio_device* vdev);
+    void (*set_status)(struct virtio_device* vdev, uint8_t status);
+    uint32_t (*read_config)(struct virtio_device* vdev, uint32_t offset);
+    uint16_t (*queue_size)(struct virtio_device* vdev, uint16_t index);
+    int (*activate_queue)(struct virtio_device* vdev, virtqueue_t* vq);
+    void (*notify)(struct virtio_device* vdev, uint16_t index);
+    uint32_t (*ack_interrupt)(struct virtio_device* vdev);
+};
+typedef struct virtio_transport_ops virtio_transport_ops_t;
+
+struct virtio_device {
+    virtio_transport_ops_t* ops;
+    uint32_t base; // Port base for PCI, mapped registers for MMIO.
+    uint32_t version;
+    uint32_t interrupt;
+};
+typedef struct virtio_device virtio_device_t;
+
+int virtio_alloc_dma(uint32_t size, zone_t* zone, uint32_t* paddr);
+int virtio_negotiate(virtio_device_t* vdev, uint32_t wanted_features, uint32_t* accepted_features);
+void virtio_driver_ok(virtio_device_t* vdev);
+void virtio_fail(virtio_device_t* vdev);
+
+int virtqueue_init(virtio_device_t* vdev, virtqueue_t* vq, uint16_t index);
+int virtqueue_add(virtqueue_t* vq, virtq_buf_t* bufs, int count);
+void virtqueue_kick(virtio_device_t* vdev, virtqueue_t* vq);
+int virtqueue_get_used(virtqueue_t* vq, uint32_t* len);
+
+static inline uint32_t virtqueue_avail_offset(uint16_t size)
+{
+    return sizeof(virtq_desc_t) * size;
+}
+
+static inline uint32_t virtqueue_used_offset(uint16_t size)
+{
+    uint32_t end = virtqueue_avail_offset(size) + sizeof(virtq_avail_t) + sizeof(uint16_t) * (size + 1);
+    return (end + VIRTQUEUE_ALIGN - 1) & ~(VIRTQUEUE_ALIGN - 1);
+}
+
+#endif // _KERNEL_DRIVERS_GENERIC_VIRTIO_H
@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2021, Krisna Pranav
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef _KERNEL_DRIVERS_GENERIC_VIRTIO_BLK_H
+#define _KERNEL_DRIVERS_GENERIC_VIRTIO_BLK_H
+
+#include <drivers/bio.h>
+#include <drivers/driver_manager.h>
+#include <drivers/generic/virtio.h>
+#include <libkern/lock.h>
+#include <libkern/types.h>
+
+#define VIRTIO_BLK_SECTOR_SIZE 512
+#define VIRTIO_BLK_MAX_REQUESTS 16
+#define VIRTIO_BLK_SLOT_SECTORS 8 // One page of data per request.
+
+#define VIRTIO_BLK_F_RO (1 << 5)
+#define VIRTIO_BLK_F_FLUSH (1 << 9)
+
+#define VIRTIO_BLK_CONFIG_CAPACITY 0x0
+
+enum VIRTIO_BLK_REQUEST_TYPES {
+    VIRTIO_BLK_T_IN = 0,
+    VIRTIO_BLK_T_OUT = 1,
+    VIRTIO_BLK_T_FLUSH = 4,
+};
+
+enum VIRTIO_BLK_REQUEST_STATUS {
+    VIRTIO_BLK_S_OK = 0,
+    VIRTIO_BLK_S_IOERR = 1,
+    VIRTIO_BLK_S_UNSUPP = 2,
+};
+
+struct PACKED virtio_blk_req_header {
+    uint32_t type;
+    uint32_t reserved;
+    uint64_t sector;
+};
+typedef struct virtio_blk_req_header virtio_blk_req_header_t;
+
+struct virtio_blk {
+    bool active;
+    virtio_device_t vdev;
+    virtqueue_t vq;
+    lock_t lock;
+    uint32_t features;
+    uint64_t capacity; // in sectors
+    volatile bool reap_pending;
+
+    // Headers and statuses of all slots live in one page, data has a page per slot.
+    zone_t meta_zone;
+    uint32_t meta_paddr;
+    zone_t data_zone;
+    uint32_t data_paddr;
+
+    blk_request_t* slots[VIRTIO_BLK_MAX_REQUESTS];
+    int slot_heads[VIRTIO_BLK_MAX_REQUESTS];
+};
+typedef struct virtio_blk virtio_blk_t;
+
+int virtio_blk_init(device_t* dev, virtio_device_t* vdev);
+void virtio_blk_handle_interrupts();
+
+int virtio_blk_read(device_t* dev, uint32_t sector, uint8_t* read_data);
+int virtio_blk_write(device_t* dev, uint32_t sector, uint8_t* data, uint32_t size);
+int virtio_blk_flush(device_t* dev);
+uint32_t virtio_blk_capacity(device_t* dev);
+int virtio_blk_submit(device_t* dev, blk_request_t* req);
+void virtio_blk_poll(device_t* dev);
+uint32_t virtio_blk_max_sectors(device_t* dev);
+
+#endif // _KERNEL_DRIVERS_GENERIC_VIRTIO_BLK_H
@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2021, Krisna Pranav
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef _KERNEL_DRIVERS_X86_ACPI_H
+#define _KERNEL_DRIVERS_X86_ACPI_H
+
+#include <libkern/c_attrs.h>
+#include <libkern/types.h>
+#include <platform/generic/cpu.h>
+
+#define ACPI_ISA_IRQS 16
+
+struct PACKED acpi_rsdp {
+    char signature[8];
+    uint8_t checksum;
+    char oem_id[6];
+    uint8_t revision;
+    uint32_t rsdt_paddr;
+};
+typedef struct acpi_rsdp acpi_rsdp_t;
+
+struct PACKED acpi_sdt_header {
+    char signature[4];
+    uint32_t length;
+    uint8_t revision;
+    uint8_t checksum;
+    char oem_id[6];
+    char oem_table_id[8];
+    uint32_t oem_revision;
+    uint32_t creator_id;
+    uint32_t creator_revision;
+};
+typedef struct acpi_sdt_header acpi_sdt_header_t;
+
+enum ACPI_MADT_ENTRY_TYPE {
+    ACPI_MADT_LAPIC = 0,
+    ACPI_MADT_IOAPIC = 1,
+    ACPI_MADT_INTERRUPT_OVERRIDE = 2,
+};
+
+struct PACKED acpi_madt {
+    acpi_sdt_header_t header;
+    uint32_t lapic_paddr;
+    uint32_t flags;
+};
+typedef struct acpi_madt acpi_madt_t;
+
+struct PACKED acpi_madt_entry {
+    uint8_t type;
+    uint8_t length;
+};
+typedef struct acpi_madt_entry acpi_madt_entry_t;
+
+struct PACKED acpi_madt_lapic {
+    acpi_madt_entry_t entry;
+    uint8_t acpi_processor_id;
+    uint8_t apic_id;
+    uint32_t flags;
+};
+typedef struct acpi_madt_lapic acpi_madt_lapic_t;
+
+struct PACKED acpi_madt_ioapic {
+    acpi_madt_entry_t entry;
+    uint8_t ioapic_id;
+    uint8_t reserved;
+    uint32_t ioapic_paddr;
+    uint32_t gsi_base;
+};
+typedef struct acpi_madt_ioapic acpi_madt_ioapic_t;
+
+struct PACKED acpi_madt_override {
+    acpi_madt_entry_t entry;
+    uint8_t bus;
+    uint8_t source;
+    uint32_t gsi;
+    uint16_t flags;
+};
+typedef struct acpi_madt_override acpi_madt_override_t;
+
+#define ACPI_MADT_LAPIC_ENABLED 0x1
+#define ACPI_MADT_POLARITY_MASK 0x3
+#define ACPI_MADT_POLARITY_LOW 0x3
+#define ACPI_MADT_TRIGGER_MASK 0xc
+#define ACPI_MADT_TRIGGER_LEVEL 0xc
+
+typedef struct {
+    uint32_t gsi;
+    uint16_t flags;
+} acpi_isa_irq_t;
+
+/**
+ * The summary of MADT which is needed to bring up LAPICs, IOAPIC and APs.
+ * CPUs are listed in the MADT order, which is not obliged to start with the
+ * boot cpu.
+ */
+typedef struct {
+    uint32_t lapic_paddr;
+    uint32_t ioapic_paddr;
+    uint32_t ioapic_gsi_base;
+    int cpu_count;
+    uint8_t cpu_apic_ids[CPU_CNT];
+    acpi_isa_irq_t isa_irqs[ACPI_ISA_IRQS];
+} acpi_madt_info_t;
+
+int acpi_install();
+acpi_madt_info_t* acpi_madt_info();
+
+#endif /* _KERNEL_DRIVERS_X86_ACPI_H */
@@ -0,0 +1,25 @@
+/*
+ * Copyright (c) 2021, Krisna Pranav
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef _KERNEL_DRIVERS_X86_IOAPIC_H
+#define _KERNEL_DRIVERS_X86_IOAPIC_H
+
+#include <drivers/x86/acpi.h>
+#include <libkern/types.h>
+
+#define IOAPIC_REGSEL 0x00
+#define IOAPIC_WINDOW 0x10
+
+#define IOAPIC_REG_VERSION 0x01
+#define IOAPIC_REG_REDTBL 0x10
+
+#define IOAPIC_REDTBL_POLARITY_LOW 0x2000
+#define IOAPIC_REDTBL_LEVEL 0x8000
+#define IOAPIC_REDTBL_MASKED 0x10000
+
+int ioapic_install(acpi_madt_info_t* info, uint8_t dest_apic_id);
+
+#endif /* _KERNEL_DRIVERS_X86_IOAPIC_H */
@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2021, Krisna Pranav
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef _KERNEL_DRIVERS_X86_LAPIC_H
+#define _KERNEL_DRIVERS_X86_LAPIC_H
+
+#include <libkern/types.h>
+#include <platform/x86/idt.h>
+
+#define LAPIC_DEFAULT_PADDR 0xFEE00000
+
+#define LAPIC_ID 0x020
+#define LAPIC_VERSION 0x030
+#define LAPIC_TPR 0x080
+#define LAPIC_EOI 0x0B0
+#define LAPIC_SVR 0x0F0
+#define LAPIC_ESR 0x280
+#define LAPIC_ICR_LOW 0x300
+#define LAPIC_ICR_HIGH 0x310
+#define LAPIC_LVT_TIMER 0x320
+#define LAPIC_LVT_LINT0 0x350
+#define LAPIC_LVT_LINT1 0x360
+#define LAPIC_LVT_ERROR 0x370
+#define LAPIC_TIMER_INITIAL 0x380
+#define LAPIC_TIMER_CURRENT 0x390
+#define LAPIC_TIMER_DIVIDE 0x3E0
+
+#define LAPIC_SVR_ENABLE 0x100
+#define LAPIC_LVT_MASKED 0x10000
+#define LAPIC_TIMER_PERIODIC 0x20000
+#define LAPIC_TIMER_DIVIDE_BY_16 0x3
+
+#define LAPIC_ICR_INIT 0x500
+#define LAPIC_ICR_STARTUP 0x600
+#define LAPIC_ICR_DELIVERY_PENDING 0x1000
+#define LAPIC_ICR_ASSERT 0x4000
+#define LAPIC_ICR_LEVEL 0x8000
+
+extern volatile uint32_t* lapic_registers;
+extern uint8_t lapic_id_to_cpu_id[256];
+extern uint8_t lapic_cpu_id_to_lapic_id[];
+
+static inline uint32_t lapic_read(uint32_t reg)
+{
+    return lapic_registers[reg / sizeof(uint32_t)];
+}
+
+static inline void lapic_write(uint32_t reg, uint32_t val)
+{
+    lapic_registers[reg / sizeof(uint32_t)] = val;
+}
+
+static inline bool lapic_is_enabled()
+{
+    return lapic_registers != NULL;
+}
+
+static inline uint8_t lapic_id()
+{
+    return lapic_read(LAPIC_ID) >> 24;
+}
+
+static inline void lapic_eoi()
+{
+    lapic_write(LAPIC_EOI, 0);
+}
+
+int lapic_install(uint32_t paddr);
+void lapic_install_secondary_cpu();
+void lapic_timer_setup();
+void lapic_timer_handler();
+
+void lapic_send_ipi(uint8_t apic_id, uint32_t icr);
+void lapic_send_init(uint8_t apic_id);
+void lapic_send_startup(uint8_t apic_id, uint32_t trampoline_paddr);
+
+#endif /* _KERNEL_DRIVERS_X86_LAPIC_H */
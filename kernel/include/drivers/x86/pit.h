@@ -12,8 +12,10 @@
 
 #define PIT_BASE_FREQ 1193180
 #define TIMER_TICKS_PER_SECOND 125
+#define PIT_GATE_PORT 0x61
 
 void pit_setup();
 void pit_handler();
+void pit_busy_wait_us(uint32_t us);
 
 #endif /* _KERNEL_DRIVERS_X86_PIT_H */
@@ -14,8 +14,11 @@
 #define COM3 0x3E8
 #define COM4 0x2E8
 
+#define UART_FIFO_SIZE 16
+
 void uart_setup();
 int uart_write(int port, uint8_t data);
+int uart_write_buf(int port, const uint8_t* data, size_t len);
 int uart_read(int port, uint8_t* data);
 
 #endif //_KERNEL_DRIVERS_X86_UART_H
\ No newline at end of file
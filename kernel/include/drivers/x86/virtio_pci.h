@@ -0,0 +1,36 @@
+/*
+ * Copyright (c) 2021, Krisna Pranav
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef _KERNEL_DRIVERS_X86_VIRTIO_PCI_H
+#define _KERNEL_DRIVERS_X86_VIRTIO_PCI_H
+
+#include <drivers/driver_manager.h>
+#include <drivers/generic/virtio.h>
+#include <libkern/types.h>
+#include <platform/x86/port.h>
+
+#define VIRTIO_PCI_DEVICE_ID_BLOCK 0x1001 // Transitional device
+
+/**
+ * Legacy virtio-pci registers, relative to the I/O BAR.
+ */
+#define VIRTIO_PCI_DEVICE_FEATURES 0x00
+#define VIRTIO_PCI_DRIVER_FEATURES 0x04
+#define VIRTIO_PCI_QUEUE_PFN 0x08
+#define VIRTIO_PCI_QUEUE_SIZE 0x0C
+#define VIRTIO_PCI_QUEUE_SELECT 0x0E
+#define VIRTIO_PCI_QUEUE_NOTIFY 0x10
+#define VIRTIO_PCI_DEVICE_STATUS 0x12
+#define VIRTIO_PCI_ISR_STATUS 0x13
+#define VIRTIO_PCI_CONFIG 0x14 // MSI-X is not enabled, so config follows directly.
+
+#define PCI_COMMAND 0x04
+#define PCI_COMMAND_IO 0x1
+#define PCI_COMMAND_BUS_MASTER 0x4
+
+void virtio_pci_blk_install();
+
+#endif //_KERNEL_DRIVERS_X86_VIRTIO_PCI_H
@@ -129,6 +129,7 @@ typedef struct fs_desc fs_desc_t;
 enum FD_TYPE {
     FD_TYPE_FILE,
     FD_TYPE_SOCKET,
+    FD_TYPE_EPOLL,
 };
 
 // TODO: Locks might be implemented as RWLocks.
@@ -137,6 +138,7 @@ struct file_descriptor {
     union {
         dentry_t* dentry; // type == FD_TYPE_FILE
         struct socket* sock_entry; // type == FD_TYPE_SOCKET
+        struct epoll* epoll; // type == FD_TYPE_EPOLL
     };
     uint32_t offset;
     uint32_t flags;
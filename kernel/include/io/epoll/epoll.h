@@ -0,0 +1,50 @@
+/*
+ * Copyright (c) 2021, Krisna Pranav
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef _KERNEL_IO_EPOLL_EPOLL_H
+#define _KERNEL_IO_EPOLL_EPOLL_H
+
+#include <fs/vfs.h>
+#include <libkern/atomic.h>
+#include <libkern/bits/sys/epoll.h>
+#include <libkern/lock.h>
+#include <libkern/types.h>
+
+#define EPOLL_MAX_ITEMS 16
+
+struct epoll_item {
+    int fd;
+    uint32_t events;
+    epoll_data_t data;
+    uint32_t reported; // Ready bits which were already reported, used by EPOLLET.
+};
+typedef struct epoll_item epoll_item_t;
+
+struct epoll {
+    uint32_t d_count;
+    uint32_t items_count;
+    epoll_item_t items[EPOLL_MAX_ITEMS];
+    lock_t lock;
+};
+typedef struct epoll epoll_t;
+
+/**
+ * Producers of data (ptys, sockets, devices) bump the generation, so
+ * blocked waiters re-check their interest sets only when something has
+ * really happened, instead of on every scheduler pass.
+ */
+extern uint32_t epoll_generation;
+static inline void epoll_notify() { atomic_add(&epoll_generation, 1); }
+static inline uint32_t epoll_get_generation() { return atomic_load(&epoll_generation); }
+
+struct proc;
+int epoll_create(file_descriptor_t* fd);
+epoll_t* epoll_duplicate(epoll_t* ep);
+int epoll_put(epoll_t* ep);
+int epoll_ctl(epoll_t* ep, int op, int fd, epoll_event_t* event);
+int epoll_collect(struct proc* p, epoll_t* ep, epoll_event_t* events, int maxevents, bool consume);
+
+#endif // _KERNEL_IO_EPOLL_EPOLL_H
@@ -14,5 +14,7 @@
 #define atomic_add(x, val) (__atomic_add_fetch(x, val, __ATOMIC_SEQ_CST))
 #define atomic_store(x, val) (__atomic_store_n(x, val, __ATOMIC_SEQ_CST))
 #define atomic_load(x) (__atomic_load_n(x, __ATOMIC_SEQ_CST))
+#define atomic_store_release(x, val) (__atomic_store_n(x, val, __ATOMIC_RELEASE))
+#define atomic_load_acquire(x) (__atomic_load_n(x, __ATOMIC_ACQUIRE))
 
 #endif // _KERNEL_LIBKERN_LOCK_H
\ No newline at end of file
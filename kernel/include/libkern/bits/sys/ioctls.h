@@ -1,6 +1,8 @@
 #ifndef _KERNEL_LIBKERN_BITS_SYS_IOCTLS_H
 #define _KERNEL_LIBKERN_BITS_SYS_IOCTLS_H
 
+#include <libkern/types.h>
+
 /* TTY */
 #define TIOCGPGRP 0x0101
 #define TIOCSPGRP 0x0102
@@ -13,5 +15,29 @@
 #define BGA_SWAP_BUFFERS 0x0101
 #define BGA_GET_HEIGHT 0x0102
 #define BGA_GET_WIDTH 0x0103
+#define BGA_GET_MODES_COUNT 0x0104
+#define BGA_GET_MODE 0x0105
+#define BGA_SET_MODE 0x0106
+#define BGA_GET_BUFFERS 0x0107
+
+#define BGA_MAX_BUFFERS 3
+
+/**
+ * BGA_GET_MODE fills the mode with the given index, BGA_SET_MODE takes
+ * width, height and the number of scanout buffers. Buffers lie one after
+ * another in the mmaped framebuffer, BGA_SWAP_BUFFERS shows buffer #arg.
+ */
+struct display_mode {
+    uint32_t index;
+    uint32_t width;
+    uint32_t height;
+    uint32_t bpp;
+    uint32_t buffers;
+};
+typedef struct display_mode display_mode_t;
+
+/* TRACE */
+#define TRACE_SET_MASK 0x0201
+#define TRACE_GET_MASK 0x0202
 
 #endif // _KERNEL_LIBKERN_BITS_SYS_IOCTLS_H
\ No newline at end of file
@@ -0,0 +1,41 @@
+#ifndef _KERNEL_LIBKERN_BITS_SYS_TRACE_H
+#define _KERNEL_LIBKERN_BITS_SYS_TRACE_H
+
+#include <libkern/types.h>
+
+/**
+ * Every tracepoint is listed here once: its id, name and the meaning of
+ * its arguments. The kernel and the dump tool expand the list.
+ */
+#define TRACEPOINTS(X)                                              \
+    X(TRACE_SCHED_SWITCH, "sched_switch", "tid prio")               \
+    X(TRACE_SYSCALL_ENTER, "syscall_enter", "id a1 a2 a3")          \
+    X(TRACE_SYSCALL_EXIT, "syscall_exit", "id ret")                 \
+    X(TRACE_PAGE_FAULT, "page_fault", "vaddr info")                 \
+    X(TRACE_BIO_ISSUE, "bio_issue", "op sector count dev")          \
+    X(TRACE_BIO_COMPLETE, "bio_complete", "op sector count status") \
+    X(TRACE_IPC_SEND, "ipc_send", "len written")
+
+#define TRACEPOINT_ENUM_ENTRY(id, name, args) id,
+enum TRACEPOINT_IDS {
+    TRACEPOINTS(TRACEPOINT_ENUM_ENTRY)
+    TRACEPOINTS_COUNT,
+};
+#undef TRACEPOINT_ENUM_ENTRY
+
+#define TRACE_ARGS 4
+
+/**
+ * A binary trace record. The time is taken from the cpu timestamp
+ * counter, so only differences between records are meaningful.
+ */
+struct trace_event {
+    uint64_t time;
+    uint16_t id;
+    uint16_t cpu;
+    uint32_t tid;
+    uint32_t args[TRACE_ARGS];
+};
+typedef struct trace_event trace_event_t;
+
+#endif // _KERNEL_LIBKERN_BITS_SYS_TRACE_H
\ No newline at end of file
@@ -48,6 +48,12 @@ enum __sysid {
     SYS_SHBUF_CREATE,
     SYS_SHBUF_GET,
     SYS_SHBUF_FREE,
+    SYS_VFORK,
+    SYS_SPAWN,
+    SYS_EPOLL_CREATE,
+    SYS_EPOLL_CTL,
+    SYS_EPOLL_WAIT,
+    SYS_EXIT_THREAD,
 };
 typedef enum __sysid sysid_t;
 
@@ -27,10 +27,25 @@ static ALWAYS_INLINE void lock_init(lock_t* lock)
     __atomic_store_n(&lock->status, 0, __ATOMIC_RELAXED);
 }
 
+/**
+ * The holder of a lock could be waiting for a TLB shootdown to be acked by
+ * the spinning cpu, which runs with interrupts disabled. So spinning cpus
+ * serve shootdowns themselves, see mem/vmm/tlb.c.
+ */
+void tlb_serve_pending();
+
 static ALWAYS_INLINE void lock_acquire(lock_t* lock)
 {
     while (__atomic_exchange_n(&lock->status, 1, __ATOMIC_ACQUIRE) == 1) {
         // TODO: May be some cpu sleep?
+        tlb_serve_pending();
+    }
+}
+
+/* Used by the shootdown code itself. */
+static ALWAYS_INLINE void lock_acquire_no_serve(lock_t* lock)
+{
+    while (__atomic_exchange_n(&lock->status, 1, __ATOMIC_ACQUIRE) == 1) {
     }
 }
 
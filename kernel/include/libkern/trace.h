@@ -0,0 +1,31 @@
+/*
+ * Copyright (c) 2021, Krisna Pranav
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef _KERNEL_LIBKERN_TRACE_H
+#define _KERNEL_LIBKERN_TRACE_H
+
+#include <libkern/bits/sys/trace.h>
+#include <libkern/types.h>
+
+#define TRACE_RING_EVENTS 1024 // Per cpu, must be a power of two.
+
+extern volatile uint32_t trace_enabled_mask;
+
+void trace_emit(uint32_t id, uint32_t a0, uint32_t a1, uint32_t a2, uint32_t a3);
+int trace_install();
+
+/**
+ * A disabled tracepoint costs one load and a branch, arguments are
+ * not evaluated.
+ */
+#define TRACE(id, a0, a1, a2, a3)                                                           \
+    do {                                                                                    \
+        if (unlikely(trace_enabled_mask & (1 << (id)))) {                                   \
+            trace_emit(id, (uint32_t)(a0), (uint32_t)(a1), (uint32_t)(a2), (uint32_t)(a3)); \
+        }                                                                                   \
+    } while (0)
+
+#endif // _KERNEL_LIBKERN_TRACE_H
\ No newline at end of file
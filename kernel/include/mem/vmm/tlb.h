@@ -0,0 +1,54 @@
+/*
+ * Copyright (c) 2021, Krisna Pranav
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef _KERNEL_MEM_VMM_TLB_H
+#define _KERNEL_MEM_VMM_TLB_H
+
+#include <libkern/lock.h>
+#include <libkern/types.h>
+
+#define TLB_BATCH_MAX 32
+
+struct pdirectory;
+
+/**
+ * Invalidations which are collected during a single vmm operation.
+ * If the batch overflows, the whole TLB is flushed.
+ */
+struct tlb_batch {
+    struct pdirectory* pdir;
+    bool flush_all;
+    bool broadcast;
+    uint32_t count;
+    uint32_t vaddrs[TLB_BATCH_MAX];
+};
+typedef struct tlb_batch tlb_batch_t;
+
+/**
+ * Pending invalidations of a cpu, which are posted by other cpus.
+ */
+struct tlb_mailbox {
+    lock_t lock;
+    bool flush_all;
+    uint32_t count;
+    uint32_t vaddrs[TLB_BATCH_MAX];
+    uint32_t requested;
+    uint32_t done;
+};
+typedef struct tlb_mailbox tlb_mailbox_t;
+
+void tlb_setup_cpu();
+
+void tlb_invalidate_page(uint32_t vaddr);
+void tlb_invalidate_all();
+void tlb_shootdown();
+void tlb_shootdown_handler();
+
+/* Implemented by a platform */
+void tlb_platform_setup_cpu();
+void tlb_platform_send_ipi(int cpu_id);
+
+#endif // _KERNEL_MEM_VMM_TLB_H
@@ -23,6 +23,7 @@ enum PAGE_FLAGS {
     PAGE_NOT_CACHEABLE = 0x8,
     PAGE_COW = 0x10,
     PAGE_USER = 0x20,
+    PAGE_WRITE_COMBINING = 0x40,
 };
 
 #define USER_PAGE true
@@ -44,6 +45,13 @@ typedef struct pdirectory {
     table_desc_t entities[VMM_PDE_COUNT];
 } pdirectory_t;
 
+/**
+ * Ptables are allocated by pages, so one page of ptables serves 4MB of
+ * vspace on both x86 and aarch32. Large pages are placed by such groups,
+ * thus zones which want to be backed by large pages should be aligned to it.
+ */
+#define VMM_LARGE_ZONE_ALIGNMENT ((VMM_PAGE_SIZE / sizeof(ptable_t)) * VMM_LARGE_PAGE_SIZE)
+
 enum VMM_PF_HANDLER {
     OK = 0,
     SHOULD_CRASH = -1,
@@ -64,6 +72,7 @@ int vmm_free_pdir(pdirectory_t* pdir, struct dynamic_array* zones);
 
 int vmm_map_page(uint32_t vaddr, uint32_t paddr, uint32_t settings);
 int vmm_map_pages(uint32_t vaddr, uint32_t paddr, uint32_t n_pages, uint32_t settings);
+int vmm_map_large_pages(uint32_t vaddr, uint32_t paddr, uint32_t n_pages, uint32_t settings);
 int vmm_unmap_page(uint32_t vaddr);
 int vmm_unmap_pages(uint32_t vaddr, uint32_t n_pages);
 int vmm_copy_page(uint32_t to_vaddr, uint32_t src_vaddr, ptable_t* src_ptable);
@@ -82,7 +91,9 @@ pdirectory_t* vmm_get_kernel_pdir();
 int vmm_load_page(uint32_t vaddr, uint32_t settings);
 int vmm_tune_page(uint32_t vaddr, uint32_t settings);
 int vmm_tune_pages(uint32_t vaddr, uint32_t length, uint32_t settings);
+bool vmm_is_page_present(uint32_t vaddr);
 int vmm_free_page(uint32_t vaddr, page_desc_t* page, struct dynamic_array* zones);
+int vmm_free_pages(uint32_t vaddr, uint32_t n_pages, struct dynamic_array* zones);
 
 int vmm_switch_pdir(pdirectory_t* pdir);
 void vmm_enable_paging();
@@ -14,6 +14,8 @@
 #define ALL_CPU_MASK 0xff
 #define BOOT_CPU_MASK 0x01
 
+#define IRQ_SGI_TLB_SHOOTDOWN 1
+
 typedef int irq_type_t;
 typedef int irq_line_t;
 typedef uint8_t irq_priority_t;
@@ -27,6 +29,7 @@ struct gic_descritptor {
     uint32_t (*interrupt_descriptor)();
     void (*end_interrupt)(uint32_t int_desc);
     void (*enable_irq)(irq_line_t line, irq_priority_t prior, irq_type_t type, int cpu_mask);
+    void (*send_sgi)(irq_line_t line, int cpu_mask);
 };
 typedef struct gic_descritptor gic_descritptor_t;
 
@@ -54,6 +57,7 @@ extern void irq_handler();
 extern void fast_irq_handler();
 
 void irq_register_handler(irq_line_t line, irq_priority_t prior, irq_type_t type, irq_handler_t func, int cpu_mask);
+void irq_send_sgi(irq_line_t line, int cpu_mask);
 void irq_set_gic_desc(gic_descritptor_t gic_desc);
 
 void gic_setup();
@@ -75,6 +75,11 @@ inline static void system_disable_write_protect()
 {
 }
 
+// Sections are always supported by the short-descriptor format.
+inline static void system_enable_large_pages()
+{
+}
+
 inline static void system_enable_paging()
 {
     volatile uint32_t val;
@@ -92,6 +97,18 @@ inline static void system_disable_paging()
 {
 }
 
+/**
+ * Returns the virtual count of the generic timer. It is used for
+ * accounting only, so the frequency does not need to be known.
+ */
+inline static uint64_t system_read_timestamp()
+{
+    uint32_t lo, hi;
+    asm volatile("mrrc p15, 1, %0, %1, c14"
+                 : "=r"(lo), "=r"(hi));
+    return ((uint64_t)hi << 32) | lo;
+}
+
 inline static void system_stop_until_interrupt()
 {
     asm volatile("wfi");
@@ -16,6 +16,7 @@
  *      pl111
  *      pl050
  *      pl031
+ *      virtio-mmio
  */
 
 /* Base is read from CBAR */
@@ -36,6 +37,10 @@
 
 #define PL031_BASE 0x1c170000
 
+#define VIRTIO_MMIO_BASE 0x1c130000
+#define VIRTIO_MMIO_TRANSPORT_SIZE 0x200
+#define VIRTIO_MMIO_TRANSPORTS 4
+
 /**
  * Interrupt lines:
  *      SP804 TIMER1: 2nd line in SPI (32+2)
@@ -46,4 +51,6 @@
 #define PL050_KEYBOARD_IRQ_LINE (32 + 12)
 #define PL050_MOUSE_IRQ_LINE (32 + 13)
 
+#define VIRTIO_MMIO_IRQ_LINE (32 + 40)
+
 #endif /* _KERNEL_PLATFORM_AARCH32_TARGET_CORTEX_A15_DEVICE_SETTINGS_H */
\ No newline at end of file
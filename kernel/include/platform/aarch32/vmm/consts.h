@@ -10,6 +10,7 @@
 #define VMM_PTE_COUNT (256)
 #define VMM_PDE_COUNT (4096)
 #define VMM_PAGE_SIZE (4096)
+#define VMM_LARGE_PAGE_SIZE (1024 * 1024)
 
 #define VMM_OFFSET_IN_DIRECTORY(a) (((a) >> 20) & 0xfff)
 #define VMM_OFFSET_IN_TABLE(a) (((a) >> 12) & 0xff)
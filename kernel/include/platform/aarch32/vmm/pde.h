@@ -42,7 +42,8 @@ enum TABLE_DESC_PAGE_FLAGS {
     TABLE_DESC_CPU_GLOBAL = 0x100,
     TABLE_DESC_LV4_GLOBAL = 0x200,
     TABLE_DESC_COPY_ON_WRITE = 0x400,
-    TABLE_DESC_ZEROING_ON_DEMAND = 0x800
+    TABLE_DESC_ZEROING_ON_DEMAND = 0x800,
+    TABLE_DESC_WRITE_COMBINING = 0x1000,
 };
 
 void table_desc_init(table_desc_t* pde);
@@ -62,4 +63,8 @@ bool table_desc_is_4mb(table_desc_t pde);
 bool table_desc_is_copy_on_write(table_desc_t pde);
 uint32_t table_desc_get_frame(table_desc_t pde);
 
+void table_desc_init_large(table_desc_t* pde, uint32_t paddr, uint32_t attrs);
+bool table_desc_is_large(table_desc_t pde);
+uint32_t table_desc_get_large_frame(table_desc_t pde);
+
 #endif //_KERNEL_PLATFORM_AARCH32_VMM_PDE_H
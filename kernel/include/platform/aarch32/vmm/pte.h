@@ -44,7 +44,8 @@ enum PAGE_DESC_PAGE_FLAGS {
     PAGE_DESC_CPU_GLOBAL = 0x100,
     PAGE_DESC_LV4_GLOBAL = 0x200,
     PAGE_DESC_COPY_ON_WRITE = 0x400,
-    PAGE_DESC_ZEROING_ON_DEMAND = 0x800
+    PAGE_DESC_ZEROING_ON_DEMAND = 0x800,
+    PAGE_DESC_WRITE_COMBINING = 0x1000,
 };
 
 void page_desc_init(page_desc_t* pte);
@@ -59,6 +60,7 @@ bool page_desc_is_present(page_desc_t pte);
 bool page_desc_is_writable(page_desc_t pte);
 bool page_desc_is_user(page_desc_t pte);
 bool page_desc_is_not_cacheable(page_desc_t pte);
+bool page_desc_is_write_combining(page_desc_t pte);
 bool page_desc_is_cow(page_desc_t pte);
 
 uint32_t page_desc_get_frame(page_desc_t pte);
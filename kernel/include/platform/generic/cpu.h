@@ -42,6 +42,8 @@ typedef struct {
     time_t stat_ticks_since_boot;
     time_t stat_system_and_idle_ticks;
     time_t stat_user_ticks;
+    uint32_t stat_unblock_calls;
+    uint64_t stat_unblock_time; // in system_read_timestamp() units
 
 #ifdef FPU_ENABLED
     // Information about current state of fpu.
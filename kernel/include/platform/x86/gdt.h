@@ -10,12 +10,13 @@
 #include <libkern/c_attrs.h>
 #include <libkern/types.h>
 
-#define GDT_MAX_ENTRIES 6
+#define GDT_MAX_ENTRIES 7
 #define SEG_KCODE 1 // kernel code
 #define SEG_KDATA 2 // kernel data+stack
 #define SEG_UCODE 3 // user code
 #define SEG_UDATA 4 // user data+stack
 #define SEG_TSS 5 // task state NOT USED CURRENTLY
+#define SEG_UTLS 6 // user tls, rewritten on every switch
 
 #define SEGF_X 0x8 // exec
 #define SEGF_A 0x1 // accessed
@@ -45,7 +46,8 @@ struct PACKED gdt_entry {
     uint32_t base_31_24 : 8;
 };
 
-extern struct gdt_entry gdt[GDT_MAX_ENTRIES];
+// Every cpu has its own GDT, since TSS and TLS segments are per cpu.
+extern struct gdt_entry gdt[][GDT_MAX_ENTRIES];
 
 // segment with page granularity
 #define SEG_PG(type, base, limit, dpl)                                    \
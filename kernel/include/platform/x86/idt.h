@@ -33,6 +33,7 @@ extern void** handlers[IDT_ENTRIES];
 
 void idt_element_setup(uint8_t n, void* handler_addr, bool user);
 void interrupts_setup();
+void interrupts_setup_secondary_cpu();
 
 void set_irq_handler(uint8_t interrupt_no, void (*handler)());
 void init_irq_handlers();
@@ -87,6 +88,9 @@ extern void irq12();
 extern void irq13();
 extern void irq14();
 extern void irq15();
+extern void irq_lapic_timer();
+extern void irq_lapic_spurious();
+extern void irq_tlb_shootdown();
 extern void irq_null();
 extern void irq_empty_handler();
 
@@ -109,4 +113,8 @@ extern void syscall();
 #define IRQ14 46
 #define IRQ15 47
 
+#define IRQ_LAPIC_TIMER 48
+#define IRQ_TLB_SHOOTDOWN 49
+#define IRQ_LAPIC_SPURIOUS 0xFF
+
 #endif // _KERNEL_PLATFORM_X86_IDT_H
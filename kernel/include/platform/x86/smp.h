@@ -0,0 +1,25 @@
+/*
+ * Copyright (c) 2021, Krisna Pranav
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef _KERNEL_PLATFORM_X86_SMP_H
+#define _KERNEL_PLATFORM_X86_SMP_H
+
+#include <libkern/c_attrs.h>
+#include <libkern/types.h>
+
+// Should be in sync with ap_trampoline.s
+#define AP_TRAMPOLINE_PADDR 0x70000
+
+struct PACKED ap_trampoline_params {
+    uint32_t pdir;
+    uint32_t stack;
+    uint32_t entry;
+};
+typedef struct ap_trampoline_params ap_trampoline_params_t;
+
+void smp_setup();
+
+#endif /* _KERNEL_PLATFORM_X86_SMP_H */
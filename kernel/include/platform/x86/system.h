@@ -69,6 +69,47 @@ inline static void system_disable_paging()
     asm volatile("mov %eax, %cr0");
 }
 
+inline static void system_enable_large_pages()
+{
+    uint32_t tmp;
+    asm volatile("mov %%cr4, %0"
+                 : "=r"(tmp));
+    tmp |= (1 << 4); // CR4.PSE
+    asm volatile("mov %0, %%cr4" ::"r"(tmp));
+}
+
+inline static void system_flush_caches()
+{
+    asm volatile("wbinvd" ::
+                     : "memory");
+}
+
+inline static uint64_t system_read_msr(uint32_t msr)
+{
+    uint32_t lo, hi;
+    asm volatile("rdmsr"
+                 : "=a"(lo), "=d"(hi)
+                 : "c"(msr));
+    return ((uint64_t)hi << 32) | lo;
+}
+
+inline static void system_write_msr(uint32_t msr, uint64_t val)
+{
+    asm volatile("wrmsr" ::"c"(msr), "a"((uint32_t)val), "d"((uint32_t)(val >> 32)));
+}
+
+/**
+ * Returns the time stamp counter. It is used for accounting only, so
+ * the frequency does not need to be known.
+ */
+inline static uint64_t system_read_timestamp()
+{
+    uint32_t lo, hi;
+    asm volatile("rdtsc"
+                 : "=a"(lo), "=d"(hi));
+    return ((uint64_t)hi << 32) | lo;
+}
+
 inline static void system_stop_until_interrupt()
 {
     asm volatile("hlt");
@@ -85,9 +126,19 @@ NORETURN inline static void system_stop()
  * CPU
  */
 
+extern volatile uint32_t* lapic_registers;
+extern uint8_t lapic_id_to_cpu_id[256];
+
+/**
+ * Until LAPIC is mapped only the boot cpu is running.
+ */
 inline static int system_cpu_id()
 {
-    return 0;
+    if (!lapic_registers) {
+        return 0;
+    }
+    uint32_t apic_id = lapic_registers[0x20 / sizeof(uint32_t)] >> 24; // LAPIC_ID
+    return lapic_id_to_cpu_id[apic_id];
 }
 
 #endif /* _KERNEL_PLATFORM_X86_SYSTEM_H */
\ No newline at end of file
@@ -116,6 +116,7 @@ static inline void tf_setup_as_user_thread(trapframe_t* tf)
     tf->ds = (SEG_UDATA << 3) | DPL_USER;
     tf->es = tf->ds;
     tf->ss = tf->ds;
+    tf->gs = (SEG_UTLS << 3) | DPL_USER;
     tf->eflags = FL_IF;
 }
 
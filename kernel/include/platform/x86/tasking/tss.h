@@ -55,7 +55,7 @@ struct PACKED tss {
 };
 typedef struct tss tss_t;
 
-extern tss_t tss;
+extern tss_t tss[];
 
 void ltr(uint16_t seg);
 
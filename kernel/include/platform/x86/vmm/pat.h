@@ -0,0 +1,34 @@
+/*
+ * Copyright (c) 2021, Krisna Pranav
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef _KERNEL_PLATFORM_X86_VMM_PAT_H
+#define _KERNEL_PLATFORM_X86_VMM_PAT_H
+
+#include <libkern/types.h>
+
+#define MSR_IA32_PAT 0x277
+
+enum PAT_MEMORY_TYPES {
+    PAT_UC = 0x0,
+    PAT_WC = 0x1,
+    PAT_WT = 0x4,
+    PAT_WP = 0x5,
+    PAT_WB = 0x6,
+    PAT_UC_MINUS = 0x7,
+};
+
+/**
+ * PAT entries 0-3 keep their power-on values, so pages without the PAT
+ * bit behave as before. Entry 4, selected by the PAT bit alone, is
+ * reprogrammed to write-combining.
+ */
+#define PAT_ENTRY(i, type) ((uint64_t)(type) << ((i)*8))
+#define PAT_VALUE (PAT_ENTRY(0, PAT_WB) | PAT_ENTRY(1, PAT_WT) | PAT_ENTRY(2, PAT_UC_MINUS) | PAT_ENTRY(3, PAT_UC) | PAT_ENTRY(4, PAT_WC) | PAT_ENTRY(5, PAT_WT) | PAT_ENTRY(6, PAT_UC_MINUS) | PAT_ENTRY(7, PAT_UC))
+
+void pat_setup_cpu();
+bool pat_is_supported();
+
+#endif // _KERNEL_PLATFORM_X86_VMM_PAT_H
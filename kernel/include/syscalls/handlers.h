@@ -22,6 +22,8 @@ void sys_handler(trapframe_t* tf);
 void sys_restart_syscall(trapframe_t* tf);
 void sys_exit(trapframe_t* tf);
 void sys_fork(trapframe_t* tf);
+void sys_vfork(trapframe_t* tf);
+void sys_spawn(trapframe_t* tf);
 void sys_read(trapframe_t* tf);
 void sys_write(trapframe_t* tf);
 void sys_open(trapframe_t* tf);
@@ -51,8 +53,12 @@ void sys_ioctl(trapframe_t* tf);
 void sys_setpgid(trapframe_t* tf);
 void sys_getpgid(trapframe_t* tf);
 void sys_create_thread(trapframe_t* tf);
+void sys_exit_thread(trapframe_t* tf);
 void sys_sleep(trapframe_t* tf);
 void sys_select(trapframe_t* tf);
+void sys_epoll_create(trapframe_t* tf);
+void sys_epoll_ctl(trapframe_t* tf);
+void sys_epoll_wait(trapframe_t* tf);
 void sys_fstat(trapframe_t* tf);
 void sys_sched_yield(trapframe_t* tf);
 void sys_uname(trapframe_t* tf);
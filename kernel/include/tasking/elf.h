@@ -72,6 +72,12 @@ enum P_TYPE_FIELDS {
     PT_HIPROC = 0x7FFFFFFF,
 };
 
+enum P_FLAGS_FIELDS {
+    PF_X = 0x1,
+    PF_W = 0x2,
+    PF_R = 0x4,
+};
+
 typedef struct {
     uint32_t p_type;
     uint32_t p_offset;
@@ -169,6 +175,23 @@ enum ST_TYPE_FIELDS {
     STT_HIPROC = 15
 };
 
+enum AT_TYPE_FIELDS {
+    AT_NULL = 0,
+    AT_PHDR = 3,
+    AT_PHENT = 4,
+    AT_PHNUM = 5,
+    AT_PAGESZ = 6,
+    AT_BASE = 7,
+    AT_ENTRY = 9,
+};
+
+typedef struct {
+    uint32_t a_type;
+    uint32_t a_val;
+} elf_auxv_32_t;
+
+#define ELF_INTERP_PATH_MAX 128
+
 struct proc;
 struct file_descriptor;
 
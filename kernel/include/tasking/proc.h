@@ -29,6 +29,7 @@ enum ZONE_FLAGS {
     ZONE_NOT_CACHEABLE = 0x8,
     ZONE_COW = 0x10,
     ZONE_USER = 0x20,
+    ZONE_WRITE_COMBINING = 0x40,
 };
 
 enum ZONE_TYPES {
@@ -41,8 +42,11 @@ enum ZONE_TYPES {
     ZONE_TYPE_MAPPED = 0x20,
     ZONE_TYPE_MAPPED_FILE_PRIVATLY = 0x40,
     ZONE_TYPE_MAPPED_FILE_SHAREDLY = 0x80,
+    ZONE_TYPE_GUARD = 0x100,
 };
 
+#define USER_STACK_SIZE (1024 * 1024)
+
 struct proc_zone {
     uint32_t start;
     uint32_t len;
@@ -53,6 +57,24 @@ struct proc_zone {
 };
 typedef struct proc_zone proc_zone_t;
 
+/* The TLS initialization image, taken from PT_TLS header of the exec. */
+struct proc_tls {
+    uint32_t start;
+    uint32_t filesz;
+    uint32_t memsz;
+    uint32_t align;
+};
+typedef struct proc_tls proc_tls_t;
+
+/* Passed to the dynamic loader in the aux vector, base is 0 for static execs. */
+struct proc_auxv {
+    uint32_t phdr;
+    uint32_t phnum;
+    uint32_t entry;
+    uint32_t base;
+};
+typedef struct proc_auxv proc_auxv_t;
+
 enum PROC_STATUS {
     PROC_INVALID = 0,
     PROC_ALIVE,
@@ -79,6 +101,8 @@ struct proc {
     gid_t sgid;
 
     dynamic_array_t zones;
+    proc_tls_t tls;
+    proc_auxv_t auxv;
 
     dentry_t* proc_file;
     dentry_t* cwd;
@@ -86,6 +110,9 @@ struct proc {
     tty_entry_t* tty;
 
     bool is_kthread;
+
+    /* The thread which waits in vfork while the proc uses its pdir. */
+    struct thread* vfork_parent;
 };
 typedef struct proc proc_t;
 
@@ -120,6 +147,7 @@ int kthread_free(proc_t* p);
 
 int proc_load(proc_t* p, struct thread* main_thread, const char* path);
 int proc_copy_of(proc_t* new_proc, struct thread* from_thread);
+int proc_inherit_of(proc_t* new_proc, proc_t* from_proc);
 
 int proc_die(proc_t* p);
 int proc_block_all_threads(proc_t* p, struct blocker* blocker);
@@ -140,7 +168,9 @@ int proc_get_fd_id(proc_t* proc, file_descriptor_t* fd);
 proc_zone_t* proc_new_zone(proc_t* p, uint32_t start, uint32_t len);
 proc_zone_t* proc_extend_zone(proc_t* proc, uint32_t start, uint32_t len);
 proc_zone_t* proc_new_random_zone(proc_t* p, uint32_t len);
+proc_zone_t* proc_new_random_zone_aligned(proc_t* p, uint32_t len, uint32_t alignment);
 proc_zone_t* proc_new_random_zone_backward(proc_t* p, uint32_t len);
+proc_zone_t* proc_new_stack_zone(proc_t* p, uint32_t len);
 proc_zone_t* proc_find_zone(proc_t* p, uint32_t addr);
 proc_zone_t* proc_find_zone_no_proc(dynamic_array_t* zones, uint32_t addr);
 int proc_delete_zone_no_proc(dynamic_array_t*, proc_zone_t*);
@@ -0,0 +1,24 @@
+/*
+ * Copyright (c) 2021, Krisna Pranav
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef _KERNEL_TASKING_PROFILER_H
+#define _KERNEL_TASKING_PROFILER_H
+
+#include <libkern/bits/sys/profile.h>
+#include <libkern/types.h>
+
+#define PROFILE_RING_SAMPLES 1024 // Per cpu, must be a power of two.
+#define PROFILE_RING_DRAIN_SAMPLES (PROFILE_RING_SAMPLES / 2)
+
+int profiler_start();
+void profiler_stop();
+bool profiler_is_running();
+void profiler_tick();
+bool profiler_can_read();
+int profiler_read(uint8_t* buf, uint32_t len);
+uint32_t profiler_dropped();
+
+#endif // _KERNEL_TASKING_PROFILER_H
\ No newline at end of file
@@ -0,0 +1,57 @@
+/*
+ * Copyright (c) 2021, Krisna Pranav
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef _KERNEL_TASKING_SOFTIRQ_H
+#define _KERNEL_TASKING_SOFTIRQ_H
+
+#include <libkern/types.h>
+#include <platform/generic/cpu.h>
+#include <platform/generic/tasking/trapframe.h>
+
+#define IRQ_STAT_LINES 256
+
+enum SOFTIRQ_VECTORS {
+    SOFTIRQ_KEYBOARD,
+    SOFTIRQ_MOUSE,
+    SOFTIRQ_BLOCK,
+    SOFTIRQ_COUNT,
+};
+
+typedef void (*softirq_handler_t)();
+
+struct irq_stat {
+    uint32_t count;
+    uint64_t time; // in system_read_timestamp() units
+};
+typedef struct irq_stat irq_stat_t;
+
+/**
+ * Interrupt accounting of one cpu. It is touched only by its own cpu
+ * with interrupts off, so no locking is needed.
+ */
+struct cpu_irq_stat {
+    irq_stat_t lines[IRQ_STAT_LINES];
+    irq_stat_t softirqs[SOFTIRQ_COUNT];
+    uint32_t softirq_pending;
+
+    bool in_hard_irq;
+    int current_line;
+    uint64_t current_start;
+    trapframe_t* current_tf;
+};
+typedef struct cpu_irq_stat cpu_irq_stat_t;
+
+extern cpu_irq_stat_t cpu_irq_stats[CPU_CNT];
+
+void irq_enter(int line, trapframe_t* tf);
+void irq_exit();
+trapframe_t* irq_current_trapframe();
+
+void softirq_register(int vec, softirq_handler_t handler);
+void softirq_raise(int vec);
+void softirq_run();
+
+#endif // _KERNEL_TASKING_SOFTIRQ_H
\ No newline at end of file
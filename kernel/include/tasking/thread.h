@@ -31,17 +31,21 @@ struct blocker {
     int reason;
     int (*should_unblock)(struct thread* p);
     bool should_unblock_for_signal;
+    bool interrupted; // A signal was handled while blocked.
 };
 typedef struct blocker blocker_t;
 
 enum BLOCKER_REASON {
     BLOCKER_INVALID,
     BLOCKER_JOIN,
+    BLOCKER_VFORK,
     BLOCKER_READ,
     BLOCKER_WRITE,
     BLOCKER_SLEEP,
     BLOCKER_SELECT,
+    BLOCKER_EPOLL,
     BLOCKER_DUMPING,
+    BLOCKER_BLK,
 };
 
 struct proc;
@@ -55,6 +59,7 @@ struct thread {
     context_t* context; // context of kernel's registers
     trapframe_t* tf;
     fpu_state_t* fpu_state;
+    uint32_t tls; // Thread pointer of the user's TLS block.
 
     /* Scheduler data */
     struct thread* sched_prev;
@@ -73,6 +78,9 @@ struct thread {
     fd_set_t readfds;
     fd_set_t writefds;
     fd_set_t exceptfds;
+    struct epoll* blocker_epoll;
+    uint32_t blocker_epoll_gen;
+    time_t unblock_ticks;
 
     /* Stat data */
     time_t stat_total_running_ticks;
@@ -110,6 +118,7 @@ int thread_setup_kstack(thread_t* thread);
 int thread_copy_of(thread_t* thread, thread_t* from_thread);
 
 int thread_fill_up_stack(thread_t* thread, int argc, char** argv, char** env);
+int thread_setup_tls(thread_t* thread);
 
 int thread_kstack_free(thread_t* thread);
 int thread_free(thread_t* thread);
@@ -122,10 +131,13 @@ static ALWAYS_INLINE int thread_is_free(thread_t* thread) { return (thread->stat
  */
 
 int init_join_blocker(thread_t* p);
+int init_vfork_blocker(thread_t* thread, thread_t* child);
 int init_read_blocker(thread_t* p, file_descriptor_t* bfd);
 int init_write_blocker(thread_t* thread, file_descriptor_t* bfd);
 int init_sleep_blocker(thread_t* thread, uint32_t time);
+int init_epoll_blocker(thread_t* thread, struct epoll* ep, int timeout_ms);
 int init_select_blocker(thread_t* thread, int nfds, fd_set_t* readfds, fd_set_t* writefds, fd_set_t* exceptfds, timeval_t* timeout);
+int init_blk_blocker(thread_t* thread);
 
 /**
  * DEBUG FUNCTIONS
@@ -27,6 +27,7 @@ void timeman_timer_tick();
 time_t timeman_now();
 time_t timeman_seconds_since_boot();
 time_t timeman_get_ticks_from_last_second();
+uint32_t timeman_ms_since_boot();
 static inline time_t timeman_ticks_per_second() { return TIMER_TICKS_PER_SECOND; };
 static inline time_t timeman_ticks_since_boot() { return THIS_CPU->stat_ticks_since_boot; };
 
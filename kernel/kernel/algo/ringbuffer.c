@@ -5,14 +5,42 @@
  */
 
 #include <algo/ringbuffer.h>
+#include <mem/vmm/vmm.h>
+
+static ALWAYS_INLINE uint32_t _ringbuffer_mask(ringbuffer_t* buf)
+{
+    return buf->zone.len - 1;
+}
+
+/**
+ * Copies data out of the buffer, the data could wrap, so it's at most
+ * two memcpy calls.
+ */
+static ALWAYS_INLINE void _ringbuffer_copy_out(ringbuffer_t* buf, uint32_t from, uint8_t* holder, uint32_t siz)
+{
+    uint32_t idx = from & _ringbuffer_mask(buf);
+    uint32_t first = min(siz, buf->zone.len - idx);
+    memcpy(holder, buf->zone.ptr + idx, first);
+    memcpy(holder + first, buf->zone.ptr, siz - first);
+}
+
+static ALWAYS_INLINE void _ringbuffer_copy_in(ringbuffer_t* buf, uint32_t to, const uint8_t* holder, uint32_t siz)
+{
+    uint32_t idx = to & _ringbuffer_mask(buf);
+    uint32_t first = min(siz, buf->zone.len - idx);
+    memcpy(buf->zone.ptr + idx, holder, first);
+    memcpy(buf->zone.ptr, holder + first, siz - first);
+}
 
 ringbuffer_t ringbuffer_create(uint32_t size)
 {
     ringbuffer_t buf;
-    buf.zone = zoner_new_zone(size);
-    if (!buf.zone.start) {
-        return buf;
+    uint32_t pow2_size = VMM_PAGE_SIZE;
+    while (pow2_size < size) {
+        pow2_size <<= 1;
     }
+
+    buf.zone = zoner_new_zone(pow2_size);
     buf.start = 0;
     buf.end = 0;
     return buf;
@@ -27,124 +55,101 @@ void ringbuffer_free(ringbuffer_t* buf)
 
 uint32_t ringbuffer_space_to_read(ringbuffer_t* buf)
 {
-    uint32_t res = buf->zone.len - buf->start + buf->end;
-    if (buf->start <= buf->end) {
-        res = buf->end - buf->start;
-    }
-    return res;
+    return atomic_load_acquire(&buf->end) - atomic_load_acquire(&buf->start);
 }
 
 uint32_t ringbuffer_space_to_read_with_custom_start(ringbuffer_t* buf, uint32_t start)
 {
-    start %= buf->zone.len;
-    uint32_t res = buf->zone.len - start + buf->end;
-    if (start <= buf->end) {
-        res = buf->end - start;
-    }
-    return res;
+    // Readers with custom start could be overrun by the writer.
+    return min(atomic_load_acquire(&buf->end) - start, buf->zone.len);
 }
 
 uint32_t ringbuffer_space_to_write(ringbuffer_t* buf)
 {
-    uint32_t res = buf->zone.len - buf->end + buf->start;
-    if (buf->start > buf->end) {
-        res = buf->start - buf->end;
-    }
-    return res;
+    return buf->zone.len - ringbuffer_space_to_read(buf);
 }
 
 uint32_t ringbuffer_read(ringbuffer_t* buf, uint8_t* holder, uint32_t siz)
 {
-    uint32_t i = 0;
-    if (buf->start > buf->end) {
-        for (; i < siz && buf->start < buf->zone.len; i++, buf->start++) {
-            holder[i] = buf->zone.ptr[buf->start];
-        }
-        if (buf->start == buf->zone.len) {
-            buf->start = 0;
-        }
-    }
-    for (; i < siz && buf->start < buf->end; i++, buf->start++) {
-        holder[i] = buf->zone.ptr[buf->start];
-    }
-    return i;
+    uint32_t start = buf->start;
+    siz = min(siz, atomic_load_acquire(&buf->end) - start);
+    _ringbuffer_copy_out(buf, start, holder, siz);
+    atomic_store_release(&buf->start, start + siz);
+    return siz;
 }
 
 uint32_t ringbuffer_read_with_start(ringbuffer_t* buf, uint32_t start, uint8_t* holder, uint32_t siz)
 {
-    uint32_t i = 0;
-    start %= buf->zone.len;
-    if (start > buf->end) {
-        for (; i < siz && start < buf->zone.len; i++, start++) {
-            holder[i] = buf->zone.ptr[start];
-        }
-        if (start == buf->zone.len) {
-            start = 0;
-        }
+    uint32_t end = atomic_load_acquire(&buf->end);
+    if (end - start > buf->zone.len) {
+        start = end - buf->zone.len;
     }
-    for (; i < siz && start < buf->end; i++, start++) {
-        holder[i] = buf->zone.ptr[start];
-    }
-    return i;
+    siz = min(siz, end - start);
+    _ringbuffer_copy_out(buf, start, holder, siz);
+    return siz;
 }
 
 uint32_t ringbuffer_read_one(ringbuffer_t* buf, uint8_t* data)
 {
-    if (buf->start != buf->end) {
-        *data = buf->zone.ptr[buf->start];
-        buf->start++;
-        if (buf->start == buf->zone.len) {
-            buf->start = 0;
-        }
-        return 1;
+    uint32_t start = buf->start;
+    if (start == atomic_load_acquire(&buf->end)) {
+        return 0;
     }
-    return 0;
+    *data = buf->zone.ptr[start & _ringbuffer_mask(buf)];
+    atomic_store_release(&buf->start, start + 1);
+    return 1;
 }
 
 uint32_t ringbuffer_write(ringbuffer_t* buf, const uint8_t* holder, uint32_t siz)
 {
-    uint32_t i = 0;
-    if (buf->end >= buf->start) {
-        for (; i < siz && buf->end < buf->zone.len; i++, buf->end++) {
-            buf->zone.ptr[buf->end] = holder[i];
-        }
-        if (buf->end == buf->zone.len) {
-            buf->end = 0;
-        }
-    }
-    for (; i < siz && buf->end < buf->start; i++, buf->end++) {
-        buf->zone.ptr[buf->end] = holder[i];
-    }
-    return i;
+    uint32_t end = buf->end;
+    siz = min(siz, buf->zone.len - (end - atomic_load_acquire(&buf->start)));
+    _ringbuffer_copy_in(buf, end, holder, siz);
+    atomic_store_release(&buf->end, end + siz);
+    return siz;
 }
 
+/**
+ * Writes data even if it overwrites unread one. Used for buffers with
+ * many readers, each of them keeps its own start.
+ */
 uint32_t ringbuffer_write_ignore_bounds(ringbuffer_t* buf, const uint8_t* holder, uint32_t siz)
 {
-    uint32_t i = 0;
-    for (; i < siz; i++) {
-        buf->zone.ptr[buf->end++] = holder[i];
-        if (buf->end == buf->zone.len) {
-            buf->end = 0;
-        }
+    uint32_t end = buf->end;
+    uint32_t skip = 0;
+    if (siz > buf->zone.len) {
+        skip = siz - buf->zone.len;
     }
-    return i;
+    _ringbuffer_copy_in(buf, end + skip, holder + skip, siz - skip);
+    atomic_store_release(&buf->end, end + siz);
+    return siz;
 }
 
 uint32_t ringbuffer_write_one(ringbuffer_t* buf, uint8_t data)
 {
-    if (buf->end + 1 != buf->start) {
-        buf->zone.ptr[buf->end] = data;
-        buf->end++;
-        if (buf->end == buf->zone.len) {
-            buf->end = 0;
-        }
-        return 1;
+    uint32_t end = buf->end;
+    if (end - atomic_load_acquire(&buf->start) == buf->zone.len) {
+        return 0;
+    }
+    buf->zone.ptr[end & _ringbuffer_mask(buf)] = data;
+    atomic_store_release(&buf->end, end + 1);
+    return 1;
+}
+
+/**
+ * Removes the last written byte, if it's not read yet.
+ */
+uint32_t ringbuffer_unwrite_one(ringbuffer_t* buf)
+{
+    uint32_t end = buf->end;
+    if (end == atomic_load_acquire(&buf->start)) {
+        return 0;
     }
-    return 0;
+    atomic_store_release(&buf->end, end - 1);
+    return 1;
 }
 
 void ringbuffer_clear(ringbuffer_t* buf)
 {
-    buf->start = 0;
-    buf->end = 0;
-}
\ No newline at end of file
+    atomic_store_release(&buf->start, atomic_load_acquire(&buf->end));
+}
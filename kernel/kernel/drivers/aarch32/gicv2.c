@@ -21,6 +21,7 @@ static gic_descritptor_t gicv2_descriptor = {
     .interrupt_descriptor = gicv2_interrupt_descriptor,
     .end_interrupt = gicv2_end,
     .enable_irq = gicv2_enable_irq,
+    .send_sgi = gicv2_send_sgi,
 };
 static zone_t distributor_zone;
 static zone_t cpu_interface_zone;
@@ -74,6 +75,11 @@ void gicv2_enable_irq(irq_line_t id, irq_priority_t prior, irq_type_t type, int
     distributor_registers->isenabler[id_1bit_offset] |= (1 << id_1bit_bitpos);
 }
 
+void gicv2_send_sgi(irq_line_t id, int cpu_mask)
+{
+    distributor_registers->sgir = ((cpu_mask << GICD_SGI_TARGETS_POS) & GICD_SGI_TARGETS_MASK) | (id & GICD_SGI_ID_MASK);
+}
+
 void gicv2_install()
 {
     if (_gicv2_map_itself()) {
@@ -18,9 +18,26 @@
 
 static zone_t mapped_zone;
 static volatile pl111_registers_t* registers = (pl111_registers_t*)PL111_BASE;
-static char* pl111_bufs_paddr[2];
+struct pl111_mode {
+    uint32_t width;
+    uint32_t height;
+};
+
+static const struct pl111_mode pl111_modes[] = {
+    { 320, 568 },
+    { 640, 480 },
+    { 800, 600 },
+    { 1024, 768 },
+};
+#define PL111_MODES_COUNT (sizeof(pl111_modes) / sizeof(struct pl111_mode))
+#define PL111_MAX_WIDTH 1024
+#define PL111_MAX_HEIGHT 768
+
+static char* pl111_fb_paddr;
+static uint32_t pl111_fb_size;
 static uint32_t pl111_screen_width;
 static uint32_t pl111_screen_height;
+static uint32_t pl111_screen_buffers = 2;
 static uint32_t pl111_screen_buffer_size;
 
 static inline int _pl111_map_itself()
@@ -39,27 +56,77 @@ static inline uint32_t roundup_to_page_size(uint32_t size)
     return size;
 }
 
-static int _pl111_init_buffer(uint32_t width, uint32_t height)
+/**
+ * The framebuffer is allocated once for the biggest mode with all
+ * buffers, so mode changes never move memory which is mapped by users.
+ */
+static int _pl111_init_buffer()
 {
-    uint32_t one_screen_len = width * 4 * height;
-    pl111_screen_buffer_size = one_screen_len * 2;
-    char* paddr_zone = pmm_alloc(pl111_screen_buffer_size);
-    pl111_bufs_paddr[0] = (char*)(paddr_zone);
-    pl111_bufs_paddr[1] = (char*)(paddr_zone + one_screen_len);
-    registers->lcd_upbase = (uint32_t)pl111_bufs_paddr[0];
+    pl111_fb_size = roundup_to_page_size(PL111_MAX_WIDTH * 4 * PL111_MAX_HEIGHT * BGA_MAX_BUFFERS);
+    pl111_fb_paddr = pmm_alloc_aligned(pl111_fb_size, VMM_LARGE_PAGE_SIZE);
+    if (!pl111_fb_paddr) {
+        return -ENOMEM;
+    }
+    registers->lcd_upbase = (uint32_t)pl111_fb_paddr;
+    return 0;
+}
+
+static inline uint32_t _pl111_max_buffers(uint32_t width, uint32_t height)
+{
+    uint32_t buffers = pl111_fb_size / (width * 4 * height);
+    return buffers > BGA_MAX_BUFFERS ? BGA_MAX_BUFFERS : buffers;
+}
+
+static int _pl111_set_mode(uint32_t width, uint32_t height, uint32_t buffers)
+{
+    if (!width || !height || !buffers || buffers > BGA_MAX_BUFFERS) {
+        return -EINVAL;
+    }
+    // PPL is programmed in units of 16 pixels.
+    if (width > PL111_MAX_WIDTH || height > PL111_MAX_HEIGHT || (width % 16)) {
+        return -EINVAL;
+    }
+    if (buffers > _pl111_max_buffers(width, height)) {
+        return -ENOMEM;
+    }
+
+    pl111_set_resolution(width, height);
+    pl111_screen_buffers = buffers;
+    pl111_screen_buffer_size = width * 4 * height * buffers;
+    registers->lcd_upbase = (uint32_t)pl111_fb_paddr;
     return 0;
 }
 
 static int _pl111_ioctl(dentry_t* dentry, uint32_t cmd, uint32_t arg)
 {
+    display_mode_t* mode = (display_mode_t*)arg;
     switch (cmd) {
     case BGA_GET_HEIGHT:
         return pl111_screen_height;
     case BGA_GET_WIDTH:
         return pl111_screen_width;
+    case BGA_GET_BUFFERS:
+        return pl111_screen_buffers;
     case BGA_SWAP_BUFFERS:
-        registers->lcd_upbase = (uint32_t)pl111_bufs_paddr[(arg & 1)];
+        // The upper panel base is latched at the next frame, so this is a tear-free flip.
+        if (arg >= pl111_screen_buffers) {
+            return -EINVAL;
+        }
+        registers->lcd_upbase = (uint32_t)pl111_fb_paddr + arg * pl111_screen_width * 4 * pl111_screen_height;
         return 0;
+    case BGA_GET_MODES_COUNT:
+        return PL111_MODES_COUNT;
+    case BGA_GET_MODE:
+        if (mode->index >= PL111_MODES_COUNT) {
+            return -EINVAL;
+        }
+        mode->width = pl111_modes[mode->index].width;
+        mode->height = pl111_modes[mode->index].height;
+        mode->bpp = 32;
+        mode->buffers = _pl111_max_buffers(mode->width, mode->height);
+        return 0;
+    case BGA_SET_MODE:
+        return _pl111_set_mode(mode->width, mode->height, mode->buffers);
     default:
         return -EINVAL;
     }
@@ -73,18 +140,17 @@ static proc_zone_t* _pl111_mmap(dentry_t* dentry, mmap_params_t* params)
         return 0;
     }
 
-    proc_zone_t* zone = proc_new_random_zone(RUNNING_THREAD->process, pl111_screen_buffer_size);
+    proc_zone_t* zone = proc_new_random_zone_aligned(RUNNING_THREAD->process, pl111_screen_buffer_size, VMM_LARGE_ZONE_ALIGNMENT);
     if (!zone) {
         return 0;
     }
 
-    zone->flags |= ZONE_WRITABLE | ZONE_READABLE | ZONE_NOT_CACHEABLE;
+    zone->flags |= ZONE_WRITABLE | ZONE_READABLE | ZONE_WRITE_COMBINING;
     zone->type |= ZONE_TYPE_DEVICE;
     zone->file = dentry_duplicate(dentry);
 
-    for (int offset = 0; offset < pl111_screen_buffer_size; offset += VMM_PAGE_SIZE) {
-        vmm_map_page(zone->start + offset, (uint32_t)(pl111_bufs_paddr[0] + offset), zone->flags);
-    }
+    // The compositor touches the whole framebuffer every frame, sections keep it in a few TLB entries.
+    vmm_map_large_pages(zone->start, (uint32_t)pl111_fb_paddr, zone->len / VMM_PAGE_SIZE, zone->flags);
 
     return zone;
 }
@@ -134,12 +200,14 @@ void pl111_init(device_t* dev)
 #ifdef DEBUG_PL111
     log("PL111: Turning on");
 #endif
+    if (_pl111_init_buffer() < 0) {
+        log_error("PL111: Can't allocate framebuffer");
+        return;
+    }
 #ifdef TARGET_DESKTOP
-    _pl111_init_buffer(1024, 768);
-    pl111_set_resolution(1024, 768);
+    _pl111_set_mode(1024, 768, pl111_screen_buffers);
 #elif TARGET_MOBILE
-    _pl111_init_buffer(320, 568);
-    pl111_set_resolution(320, 568);
+    _pl111_set_mode(320, 568, pl111_screen_buffers);
 #endif
 
     volatile uint32_t ctl = registers->lcd_control;
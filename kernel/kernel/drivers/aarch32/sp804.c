@@ -10,6 +10,7 @@
 #include <mem/vmm/zoner.h>
 #include <platform/aarch32/interrupts.h>
 #include <tasking/cpu.h>
+#include <tasking/profiler.h>
 #include <tasking/sched.h>
 #include <time/time_manager.h>
 
@@ -35,6 +36,7 @@ static void _sp804_int_handler()
 {
     _sp804_clear_interrupt(timer1);
     cpu_tick();
+    profiler_tick();
     timeman_timer_tick();
     sched_tick();
 }
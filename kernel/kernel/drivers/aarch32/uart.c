@@ -35,6 +35,14 @@ int uart_write(int port, uint8_t data)
     return 0;
 }
 
+int uart_write_buf(int port, const uint8_t* data, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        *output = data[i];
+    }
+    return 0;
+}
+
 int uart_read(int port, uint8_t* data)
 {
     return 0;
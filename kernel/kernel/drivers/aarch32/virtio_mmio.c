@@ -0,0 +1,204 @@
+/*
+ * Copyright (c) 2021, Krisna Pranav
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <drivers/aarch32/virtio_mmio.h>
+#include <drivers/generic/virtio_blk.h>
+#include <libkern/log.h>
+#include <mem/vmm/vmm.h>
+#include <mem/vmm/zoner.h>
+
+// #define DEBUG_VIRTIO_MMIO
+
+static zone_t mapped_zone;
+
+static inline volatile virtio_mmio_registers_t* _virtio_mmio_regs(virtio_device_t* vdev)
+{
+    return (volatile virtio_mmio_registers_t*)vdev->base;
+}
+
+static inline int _virtio_mmio_map_itself()
+{
+    mapped_zone = zoner_new_zone(VIRTIO_MMIO_TRANSPORTS * VIRTIO_MMIO_TRANSPORT_SIZE);
+    vmm_map_page(mapped_zone.start, VIRTIO_MMIO_BASE, PAGE_READABLE | PAGE_WRITABLE | PAGE_NOT_CACHEABLE);
+    return 0;
+}
+
+/**
+ * TRANSPORT
+ */
+
+static uint32_t _virtio_mmio_get_features(virtio_device_t* vdev)
+{
+    volatile virtio_mmio_registers_t* regs = _virtio_mmio_regs(vdev);
+    regs->device_features_sel = 0;
+    return regs->device_features;
+}
+
+static void _virtio_mmio_set_features(virtio_device_t* vdev, uint32_t features)
+{
+    volatile virtio_mmio_registers_t* regs = _virtio_mmio_regs(vdev);
+    regs->driver_features_sel = 0;
+    regs->driver_features = features;
+    if (vdev->version >= 2) {
+        // VIRTIO_F_VERSION_1 is bit 32, modern devices refuse drivers without it.
+        regs->driver_features_sel = 1;
+        regs->driver_features = 1;
+    }
+}
+
+static uint8_t _virtio_mmio_get_status(virtio_device_t* vdev)
+{
+    return _virtio_mmio_regs(vdev)->status;
+}
+
+static void _virtio_mmio_set_status(virtio_device_t* vdev, uint8_t status)
+{
+    _virtio_mmio_regs(vdev)->status = status;
+}
+
+static uint32_t _virtio_mmio_read_config(virtio_device_t* vdev, uint32_t offset)
+{
+    return _virtio_mmio_regs(vdev)->config[offset / sizeof(uint32_t)];
+}
+
+static uint16_t _virtio_mmio_queue_size(virtio_device_t* vdev, uint16_t index)
+{
+    volatile virtio_mmio_registers_t* regs = _virtio_mmio_regs(vdev);
+    regs->queue_sel = index;
+    uint32_t max = regs->queue_num_max;
+    return max > VIRTQUEUE_MAX_SIZE ? VIRTQUEUE_MAX_SIZE : max;
+}
+
+static int _virtio_mmio_activate_queue(virtio_device_t* vdev, virtqueue_t* vq)
+{
+    volatile virtio_mmio_registers_t* regs = _virtio_mmio_regs(vdev);
+    regs->queue_sel = vq->index;
+    regs->queue_num = vq->size;
+
+    if (vdev->version == 1) {
+        regs->guest_page_size = VMM_PAGE_SIZE;
+        regs->queue_align = VIRTQUEUE_ALIGN;
+        regs->queue_pfn = vq->paddr / VMM_PAGE_SIZE;
+        return 0;
+    }
+
+    regs->queue_desc_low = vq->paddr;
+    regs->queue_desc_high = 0;
+    regs->queue_avail_low = vq->paddr + virtqueue_avail_offset(vq->size);
+    regs->queue_avail_high = 0;
+    regs->queue_used_low = vq->paddr + virtqueue_used_offset(vq->size);
+    regs->queue_used_high = 0;
+    regs->queue_ready = 1;
+    return 0;
+}
+
+static void _virtio_mmio_notify(virtio_device_t* vdev, uint16_t index)
+{
+    _virtio_mmio_regs(vdev)->queue_notify = index;
+}
+
+static uint32_t _virtio_mmio_ack_interrupt(virtio_device_t* vdev)
+{
+    volatile virtio_mmio_registers_t* regs = _virtio_mmio_regs(vdev);
+    uint32_t status = regs->interrupt_status;
+    regs->interrupt_ack = status;
+    return status;
+}
+
+static virtio_transport_ops_t _virtio_mmio_ops = {
+    .get_features = _virtio_mmio_get_features,
+    .set_features = _virtio_mmio_set_features,
+    .get_status = _virtio_mmio_get_status,
+    .set_status = _virtio_mmio_set_status,
+    .read_config = _virtio_mmio_read_config,
+    .queue_size = _virtio_mmio_queue_size,
+    .activate_queue = _virtio_mmio_activate_queue,
+    .notify = _virtio_mmio_notify,
+    .ack_interrupt = _virtio_mmio_ack_interrupt,
+};
+
+/**
+ * BLOCK DEVICE
+ */
+
+static void _virtio_mmio_int_handler()
+{
+    virtio_blk_handle_interrupts();
+}
+
+static void _virtio_mmio_blk_add_device(device_t* dev)
+{
+    virtio_device_t vdev = { 0 };
+    vdev.ops = &_virtio_mmio_ops;
+    vdev.base = dev->device_desc.port_base;
+    vdev.version = dev->device_desc.args[0];
+    vdev.interrupt = dev->device_desc.interrupt;
+
+    int err = virtio_blk_init(dev, &vdev);
+    if (err) {
+        log_error("virtio-mmio: can't init block device: %d", err);
+        return;
+    }
+
+    irq_register_handler(vdev.interrupt, 0, 0, _virtio_mmio_int_handler, BOOT_CPU_MASK);
+#ifdef DEBUG_VIRTIO_MMIO
+    log("virtio-mmio: block device v%d, irq %d", vdev.version, vdev.interrupt);
+#endif
+}
+
+static driver_desc_t _virtio_mmio_blk_driver_info()
+{
+    driver_desc_t blk_desc = { 0 };
+    blk_desc.type = DRIVER_STORAGE_DEVICE;
+    blk_desc.auto_start = false;
+    blk_desc.is_device_driver = true;
+    blk_desc.is_device_needed = false;
+    blk_desc.is_driver_needed = false;
+    blk_desc.functions[DRIVER_NOTIFICATION] = 0;
+    blk_desc.functions[DRIVER_STORAGE_ADD_DEVICE] = _virtio_mmio_blk_add_device;
+    blk_desc.functions[DRIVER_STORAGE_READ] = virtio_blk_read;
+    blk_desc.functions[DRIVER_STORAGE_WRITE] = virtio_blk_write;
+    blk_desc.functions[DRIVER_STORAGE_FLUSH] = virtio_blk_flush;
+    blk_desc.functions[DRIVER_STORAGE_CAPACITY] = virtio_blk_capacity;
+    blk_desc.functions[DRIVER_STORAGE_SUBMIT] = virtio_blk_submit;
+    blk_desc.functions[DRIVER_STORAGE_POLL] = virtio_blk_poll;
+    blk_desc.functions[DRIVER_STORAGE_MAX_SECTORS] = virtio_blk_max_sectors;
+    blk_desc.pci_serve_class = 0x01;
+    blk_desc.pci_serve_subclass = 0x00;
+    blk_desc.pci_serve_vendor_id = VIRTIO_VENDOR_ID;
+    blk_desc.pci_serve_device_id = VIRTIO_DEVICE_ID_BLOCK;
+    return blk_desc;
+}
+
+void virtio_mmio_install()
+{
+    if (_virtio_mmio_map_itself()) {
+#ifdef DEBUG_VIRTIO_MMIO
+        log_error("virtio-mmio: Can't map itself!");
+#endif
+        return;
+    }
+
+    driver_install(_virtio_mmio_blk_driver_info(), "vblkmmio");
+
+    for (int i = 0; i < VIRTIO_MMIO_TRANSPORTS; i++) {
+        uint32_t base = mapped_zone.start + i * VIRTIO_MMIO_TRANSPORT_SIZE;
+        volatile virtio_mmio_registers_t* regs = (volatile virtio_mmio_registers_t*)base;
+        if (regs->magic != VIRTIO_MMIO_MAGIC || regs->device_id != VIRTIO_DEVICE_ID_BLOCK) {
+            continue;
+        }
+
+        device_desc_t new_device = { 0 };
+        new_device.class_id = 0x01;
+        new_device.subclass_id = 0x00;
+        new_device.vendor_id = VIRTIO_VENDOR_ID;
+        new_device.device_id = VIRTIO_DEVICE_ID_BLOCK;
+        new_device.port_base = base;
+        new_device.interrupt = VIRTIO_MMIO_IRQ_LINE + i;
+        new_device.args[0] = regs->version;
+        device_install(new_device);
+    }
+}
@@ -0,0 +1,438 @@
+/*
+ * Copyright (c) 2021, Krisna Pranav
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <drivers/bio.h>
+#include <libkern/bits/errno.h>
+#include <libkern/libkern.h>
+#include <libkern/log.h>
+#include <libkern/trace.h>
+#include <platform/generic/system.h>
+#include <tasking/cpu.h>
+#include <tasking/thread.h>
+
+// #define DEBUG_BIO
+
+static blk_queue_t _blk_queues[MAX_DEVICES_COUNT];
+static lock_t _blk_queues_lock;
+
+static void _blk_end_request(blk_request_t* req);
+
+/**
+ * QUEUE
+ */
+
+static void _blk_queue_init(blk_queue_t* q, device_t* dev)
+{
+    memset(q, 0, sizeof(blk_queue_t));
+    q->dev = dev;
+    lock_init(&q->lock);
+
+    uint32_t (*max_sectors)(device_t * d) = dm_function_handler(dev, DRIVER_STORAGE_MAX_SECTORS);
+    q->max_sectors = max_sectors ? max_sectors(dev) : BLK_DEFAULT_MAX_SECTORS;
+
+    for (int i = 0; i < BLK_QUEUE_MAX_REQUESTS; i++) {
+        q->requests[i].private = q;
+        q->requests[i].next = q->free_requests;
+        q->free_requests = &q->requests[i];
+    }
+}
+
+blk_queue_t* blk_get_queue(device_t* dev)
+{
+    blk_queue_t* q = &_blk_queues[dev->id];
+    if (likely(__atomic_load_n(&q->active, __ATOMIC_ACQUIRE))) {
+        return q;
+    }
+
+    lock_acquire(&_blk_queues_lock);
+    if (!q->active) {
+        _blk_queue_init(q, dev);
+        __atomic_store_n(&q->active, true, __ATOMIC_RELEASE);
+    }
+    lock_release(&_blk_queues_lock);
+    return q;
+}
+
+/**
+ * Keeps pending bios sorted by sector. Bios for the same sector stay in
+ * submission order, so a read after a write sees the written data.
+ */
+static void _blk_insert_sorted(blk_queue_t* q, bio_t* bio)
+{
+    bio_t** link = &q->pending;
+    while (*link && (*link)->sector <= bio->sector) {
+        link = &(*link)->next;
+    }
+    bio->next = *link;
+    *link = bio;
+}
+
+static inline bool _blk_can_merge(blk_request_t* req, bio_t* bio, uint32_t max_sectors)
+{
+    return bio->op == req->op && bio->sector == req->sector + req->count && req->count + bio->count <= max_sectors;
+}
+
+/**
+ * C-LOOK elevator: serve the first bio at or after the last dispatched
+ * sector, wrapping to the lowest one. Following adjacent bios are merged
+ * into the same request.
+ */
+static blk_request_t* _blk_build_request(blk_queue_t* q)
+{
+    if (!q->free_requests) {
+        return NULL;
+    }
+
+    if (q->flushes) {
+        // Flush is a barrier: let everything before it finish first.
+        if (q->in_flight) {
+            return NULL;
+        }
+        blk_request_t* req = q->free_requests;
+        q->free_requests = req->next;
+        bio_t* bio = q->flushes;
+        q->flushes = bio->next;
+        bio->next = NULL;
+        req->op = BIO_FLUSH;
+        req->sector = 0;
+        req->count = 0;
+        req->bios = bio;
+        req->end_request = _blk_end_request;
+        req->next = NULL;
+        return req;
+    }
+
+    if (!q->pending) {
+        return NULL;
+    }
+
+    bio_t** link = &q->pending;
+    while (*link && (*link)->sector < q->next_sector) {
+        link = &(*link)->next;
+    }
+    if (!*link) {
+        link = &q->pending;
+    }
+
+    blk_request_t* req = q->free_requests;
+    q->free_requests = req->next;
+
+    bio_t* bio = *link;
+    req->op = bio->op;
+    req->sector = bio->sector;
+    req->count = bio->count;
+    req->bios = bio;
+    req->end_request = _blk_end_request;
+    req->next = NULL;
+
+    bio_t* last = bio;
+    while (last->next && _blk_can_merge(req, last->next, q->max_sectors)) {
+        req->count += last->next->count;
+        last = last->next;
+    }
+    *link = last->next;
+    last->next = NULL;
+
+    q->next_sector = req->sector + req->count;
+    return req;
+}
+
+static void _blk_requeue(blk_queue_t* q, blk_request_t* req)
+{
+    system_disable_interrupts();
+    lock_acquire(&q->lock);
+    bio_t* bio = req->bios;
+    while (bio) {
+        bio_t* next = bio->next;
+        if (bio->op == BIO_FLUSH) {
+            bio->next = q->flushes;
+            q->flushes = bio;
+        } else {
+            _blk_insert_sorted(q, bio);
+        }
+        bio = next;
+    }
+    q->next_sector = req->sector;
+    req->next = q->free_requests;
+    q->free_requests = req;
+    lock_release(&q->lock);
+    system_enable_interrupts();
+}
+
+static void _blk_end_request(blk_request_t* req)
+{
+    blk_queue_t* q = (blk_queue_t*)req->private;
+    system_disable_interrupts();
+    lock_acquire(&q->lock);
+    q->in_flight--;
+    req->next = q->free_requests;
+    q->free_requests = req;
+    lock_release(&q->lock);
+    system_enable_interrupts();
+}
+
+/**
+ * Runs a request through the plain DRIVER_STORAGE_READ/WRITE functions,
+ * for drivers which can't queue requests themselves.
+ */
+static void _blk_execute_sync(blk_queue_t* q, blk_request_t* req)
+{
+    int status = 0;
+    if (req->op == BIO_FLUSH) {
+        int (*flush)(device_t * d) = dm_function_handler(q->dev, DRIVER_STORAGE_FLUSH);
+        if (flush) {
+            status = flush(q->dev);
+        }
+        blk_request_complete(req, status);
+        return;
+    }
+
+    int (*read)(device_t * d, uint32_t s, uint8_t * r) = dm_function_handler(q->dev, DRIVER_STORAGE_READ);
+    int (*write)(device_t * d, uint32_t s, uint8_t * r, uint32_t siz) = dm_function_handler(q->dev, DRIVER_STORAGE_WRITE);
+    for (bio_t* bio = req->bios; bio && status >= 0; bio = bio->next) {
+        for (uint32_t i = 0; i < bio->count && status >= 0; i++) {
+            uint8_t* buf = bio->buf + i * BLK_SECTOR_SIZE;
+            if (req->op == BIO_READ) {
+                status = read(q->dev, bio->sector + i, buf);
+            } else {
+                status = write(q->dev, bio->sector + i, buf, BLK_SECTOR_SIZE);
+            }
+        }
+    }
+    blk_request_complete(req, status < 0 ? status : 0);
+}
+
+/**
+ * Hands pending work to the driver. Returns the number of dispatched
+ * requests. Can be called from any context, several cpus may run it.
+ */
+int blk_queue_run(blk_queue_t* q)
+{
+    int (*submit)(device_t * d, blk_request_t * r) = dm_function_handler(q->dev, DRIVER_STORAGE_SUBMIT);
+    void (*poll)(device_t * d) = dm_function_handler(q->dev, DRIVER_STORAGE_POLL);
+    int dispatched = 0;
+
+    for (;;) {
+        system_disable_interrupts();
+        lock_acquire(&q->lock);
+        // Synchronous drivers are not reentrant, one cpu drives them at a time.
+        if (!submit && q->dispatching) {
+            lock_release(&q->lock);
+            system_enable_interrupts();
+            break;
+        }
+        blk_request_t* req = _blk_build_request(q);
+        if (req) {
+            q->in_flight++;
+            q->stat_requests++;
+            q->dispatching = true;
+        }
+        lock_release(&q->lock);
+        system_enable_interrupts();
+
+        if (!req) {
+            break;
+        }
+
+        TRACE(TRACE_BIO_ISSUE, req->op, req->sector, req->count, q->dev->id);
+        if (submit) {
+            int err = submit(q->dev, req);
+            if (err == -EBUSY) {
+                system_disable_interrupts();
+                lock_acquire(&q->lock);
+                q->in_flight--;
+                q->dispatching = false;
+                lock_release(&q->lock);
+                system_enable_interrupts();
+                _blk_requeue(q, req);
+                break;
+            }
+            if (err) {
+                blk_request_complete(req, err);
+            }
+        } else {
+            _blk_execute_sync(q, req);
+        }
+        __atomic_store_n(&q->dispatching, false, __ATOMIC_RELEASE);
+        dispatched++;
+    }
+
+    if (poll && q->in_flight) {
+        poll(q->dev);
+    }
+    return dispatched;
+}
+
+/**
+ * REQUESTS
+ */
+
+void blk_request_gather(blk_request_t* req, uint8_t* dst)
+{
+    for (bio_t* bio = req->bios; bio; bio = bio->next) {
+        memcpy(dst, bio->buf, bio->count * BLK_SECTOR_SIZE);
+        dst += bio->count * BLK_SECTOR_SIZE;
+    }
+}
+
+void blk_request_scatter(blk_request_t* req, uint8_t* src)
+{
+    for (bio_t* bio = req->bios; bio; bio = bio->next) {
+        memcpy(bio->buf, src, bio->count * BLK_SECTOR_SIZE);
+        src += bio->count * BLK_SECTOR_SIZE;
+    }
+}
+
+/**
+ * Finishes every bio of the request. Might be called from an interrupt
+ * handler, a bio must not be touched after its done flag is set.
+ */
+void blk_request_complete(blk_request_t* req, int status)
+{
+    TRACE(TRACE_BIO_COMPLETE, req->op, req->sector, req->count, status);
+    bio_t* bio = req->bios;
+    req->bios = NULL;
+    while (bio) {
+        bio_t* next = bio->next;
+        bio->next = NULL;
+        bio->status = status;
+        if (bio->end_io) {
+            bio->end_io(bio);
+        }
+        __atomic_store_n(&bio->done, true, __ATOMIC_RELEASE);
+        bio = next;
+    }
+
+    if (req->end_request) {
+        req->end_request(req);
+    }
+}
+
+/**
+ * BIO
+ */
+
+int bio_submit(bio_t* bio)
+{
+    blk_queue_t* q = blk_get_queue(bio->dev);
+    if (bio->op != BIO_FLUSH && (bio->count == 0 || bio->count > q->max_sectors)) {
+        return -EINVAL;
+    }
+
+    bio->done = false;
+    bio->status = 0;
+    bio->next = NULL;
+
+    system_disable_interrupts();
+    lock_acquire(&q->lock);
+    if (bio->op == BIO_FLUSH) {
+        bio_t** link = &q->flushes;
+        while (*link) {
+            link = &(*link)->next;
+        }
+        *link = bio;
+    } else {
+        _blk_insert_sorted(q, bio);
+    }
+    q->stat_bios++;
+    lock_release(&q->lock);
+    system_enable_interrupts();
+    return 0;
+}
+
+/**
+ * Waits by driving the queue itself. Callers usually hold fs locks with
+ * interrupts off, so they can't give the cpu away.
+ */
+void bio_wait(bio_t* bio)
+{
+    blk_queue_t* q = blk_get_queue(bio->dev);
+    while (!__atomic_load_n(&bio->done, __ATOMIC_ACQUIRE)) {
+        blk_queue_run(q);
+    }
+}
+
+static int _blk_do_range(device_t* dev, uint32_t op, uint32_t sector, uint32_t count, uint8_t* buf)
+{
+    blk_queue_t* q = blk_get_queue(dev);
+    bio_t bios[BLK_MAX_BIOS_PER_CALL];
+
+    while (count) {
+        int bios_count = 0;
+        while (count && bios_count < BLK_MAX_BIOS_PER_CALL) {
+            uint32_t chunk = min(count, q->max_sectors);
+            bio_t* bio = &bios[bios_count++];
+            memset(bio, 0, sizeof(bio_t));
+            bio->dev = dev;
+            bio->op = op;
+            bio->sector = sector;
+            bio->count = chunk;
+            bio->buf = buf;
+            bio_submit(bio);
+            sector += chunk;
+            count -= chunk;
+            buf += chunk * BLK_SECTOR_SIZE;
+        }
+
+        int status = 0;
+        for (int i = 0; i < bios_count; i++) {
+            bio_wait(&bios[i]);
+            if (bios[i].status < 0) {
+                status = bios[i].status;
+            }
+        }
+        if (status < 0) {
+            return status;
+        }
+    }
+    return 0;
+}
+
+int blk_read(device_t* dev, uint32_t sector, uint32_t count, uint8_t* buf)
+{
+    return _blk_do_range(dev, BIO_READ, sector, count, buf);
+}
+
+int blk_write(device_t* dev, uint32_t sector, uint32_t count, uint8_t* buf)
+{
+    return _blk_do_range(dev, BIO_WRITE, sector, count, buf);
+}
+
+/**
+ * WORKER
+ */
+
+bool blk_has_pending_work()
+{
+    for (int i = 0; i < MAX_DEVICES_COUNT; i++) {
+        blk_queue_t* q = &_blk_queues[i];
+        if (q->active && (q->pending || q->flushes)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * blk_worker drives the hardware for bios nobody waits on, like
+ * writeback. It sleeps while all queues are empty.
+ */
+void blk_worker()
+{
+    for (;;) {
+        for (int i = 0; i < MAX_DEVICES_COUNT; i++) {
+            if (_blk_queues[i].active) {
+                blk_queue_run(&_blk_queues[i]);
+            }
+        }
+
+        system_disable_interrupts();
+        init_blk_blocker(RUNNING_THREAD);
+        // Same as ksyscall_impl, interrupts are restarted once the thread runs again.
+        cpu_enter_kernel_space();
+        system_enable_interrupts();
+    }
+}
@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2021, Krisna Pranav
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <drivers/generic/input.h>
+#include <io/epoll/epoll.h>
+#include <libkern/libkern.h>
+#include <platform/generic/system.h>
+
+static inline uint8_t* _input_ring_event(input_ring_t* ring, uint32_t index)
+{
+    return ring->events + (index & (INPUT_RING_EVENTS - 1)) * ring->event_size;
+}
+
+void input_ring_init(input_ring_t* ring, void* storage, uint32_t event_size, input_merge_t merge)
+{
+    memset(ring, 0, sizeof(input_ring_t));
+    lock_init(&ring->lock);
+    ring->events = storage;
+    ring->event_size = event_size;
+    ring->merge = merge;
+}
+
+/**
+ * Called from interrupt handlers. The event is coalesced with the newest
+ * unread one when the driver allows it, otherwise it is appended. When
+ * the ring is full the oldest event is dropped.
+ */
+void input_ring_push(input_ring_t* ring, const void* event)
+{
+    system_disable_interrupts();
+    lock_acquire(&ring->lock);
+    ring->stat_pushed++;
+
+    bool was_empty = (ring->start == ring->end);
+    if (!was_empty && ring->merge && ring->merge(_input_ring_event(ring, ring->end - 1), event)) {
+        ring->stat_merged++;
+        lock_release(&ring->lock);
+        system_enable_interrupts();
+        return;
+    }
+
+    if (ring->end - ring->start == INPUT_RING_EVENTS) {
+        ring->start++;
+        ring->stat_dropped++;
+    }
+    memcpy(_input_ring_event(ring, ring->end), event, ring->event_size);
+    ring->end++;
+    lock_release(&ring->lock);
+    system_enable_interrupts();
+
+    // Readers see the fd as readable until the ring is drained, so waiters
+    // need to be woken up only when the first event arrives.
+    if (was_empty) {
+        epoll_notify();
+    }
+}
+
+bool input_ring_can_read(input_ring_t* ring)
+{
+    return ring->start != ring->end;
+}
+
+/**
+ * Copies as many whole events as fit into @buf and returns the number
+ * of bytes read.
+ */
+int input_ring_read(input_ring_t* ring, uint8_t* buf, uint32_t len)
+{
+    uint32_t want = len / ring->event_size;
+
+    system_disable_interrupts();
+    lock_acquire(&ring->lock);
+    uint32_t count = ring->end - ring->start;
+    if (count > want) {
+        count = want;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        memcpy(buf + i * ring->event_size, _input_ring_event(ring, ring->start + i), ring->event_size);
+    }
+    ring->start += count;
+    lock_release(&ring->lock);
+    system_enable_interrupts();
+    return count * ring->event_size;
+}
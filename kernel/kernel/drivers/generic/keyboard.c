@@ -4,13 +4,26 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <drivers/generic/input.h>
 #include <drivers/generic/keyboard.h>
 #include <drivers/generic/keyboard_mappings/scancode_set1.h>
 #include <fs/devfs/devfs.h>
 #include <fs/vfs.h>
 #include <libkern/libkern.h>
+#include <platform/generic/system.h>
+#include <tasking/softirq.h>
+#include <time/time_manager.h>
 
-static ringbuffer_t gkeyboard_buffer;
+#define GKEYBOARD_PENDING_SCANCODES 32
+
+static input_ring_t gkeyboard_ring;
+static kbd_packet_t gkeyboard_events[INPUT_RING_EVENTS];
+
+// Raw scancodes from the hard handler, translated by the bottom half.
+static lock_t gkeyboard_pending_lock;
+static uint32_t gkeyboard_pending[GKEYBOARD_PENDING_SCANCODES];
+static uint32_t gkeyboard_pending_time[GKEYBOARD_PENDING_SCANCODES];
+static uint32_t gkeyboard_pending_count;
 static bool _gkeyboard_has_prefix_e0 = false;
 static bool _gkeyboard_shift_enabled = false;
 static bool _gkeyboard_ctrl_enabled = false;
@@ -19,6 +32,7 @@ static bool _gkeyboard_caps_enabled = false;
 static uint32_t _gkeyboard_last_scancode = KEY_UNKNOWN;
 
 static key_t _generic_keyboard_apply_modifiers(key_t key);
+static void _generic_keyboard_softirq();
 
 /* Simple struct to store the alternative key when a modifier key is presed. */
 struct alternative_key {
@@ -28,20 +42,13 @@ struct alternative_key {
 
 static bool _generic_keyboard_can_read(dentry_t* dentry, uint32_t start)
 {
-    return ringbuffer_space_to_read(&gkeyboard_buffer) >= 1;
+    return input_ring_can_read(&gkeyboard_ring);
 }
 
 static int _generic_keyboard_read(dentry_t* dentry, uint8_t* buf,
     uint32_t start, uint32_t len)
 {
-    uint32_t read_len;
-
-    read_len = ringbuffer_space_to_read(&gkeyboard_buffer);
-    if (read_len > len)
-        read_len = len;
-
-    ringbuffer_read(&gkeyboard_buffer, buf, read_len);
-    return read_len;
+    return input_ring_read(&gkeyboard_ring, buf, len);
 }
 
 int generic_keyboard_create_devfs()
@@ -61,10 +68,32 @@ int generic_keyboard_create_devfs()
 
 void generic_keyboard_init()
 {
-    gkeyboard_buffer = ringbuffer_create_std();
+    // Key presses are never coalesced, every one of them matters.
+    lock_init(&gkeyboard_pending_lock);
+    input_ring_init(&gkeyboard_ring, gkeyboard_events, sizeof(kbd_packet_t), NULL);
+    softirq_register(SOFTIRQ_KEYBOARD, _generic_keyboard_softirq);
 }
 
+/**
+ * Called from hard interrupt handlers. Translation of the scancode is
+ * left to the bottom half.
+ */
 void generic_emit_key_set1(uint32_t scancode)
+{
+    system_disable_interrupts();
+    lock_acquire(&gkeyboard_pending_lock);
+    if (gkeyboard_pending_count < GKEYBOARD_PENDING_SCANCODES) {
+        gkeyboard_pending[gkeyboard_pending_count] = scancode;
+        gkeyboard_pending_time[gkeyboard_pending_count] = timeman_ms_since_boot();
+        gkeyboard_pending_count++;
+    }
+    lock_release(&gkeyboard_pending_lock);
+    system_enable_interrupts();
+
+    softirq_raise(SOFTIRQ_KEYBOARD);
+}
+
+static void _generic_keyboard_process_set1(uint32_t scancode, uint32_t time)
 {
     if (scancode == 0xE0) {
         _gkeyboard_has_prefix_e0 = true;
@@ -134,7 +163,27 @@ void generic_emit_key_set1(uint32_t scancode)
         }
     }
 
-    ringbuffer_write(&gkeyboard_buffer, (uint8_t*)&packet, sizeof(kbd_packet_t));
+    packet.time = time;
+    input_ring_push(&gkeyboard_ring, &packet);
+}
+
+static void _generic_keyboard_softirq()
+{
+    uint32_t scancodes[GKEYBOARD_PENDING_SCANCODES];
+    uint32_t times[GKEYBOARD_PENDING_SCANCODES];
+
+    system_disable_interrupts();
+    lock_acquire(&gkeyboard_pending_lock);
+    uint32_t count = gkeyboard_pending_count;
+    memcpy(scancodes, gkeyboard_pending, count * sizeof(uint32_t));
+    memcpy(times, gkeyboard_pending_time, count * sizeof(uint32_t));
+    gkeyboard_pending_count = 0;
+    lock_release(&gkeyboard_pending_lock);
+    system_enable_interrupts();
+
+    for (uint32_t i = 0; i < count; i++) {
+        _generic_keyboard_process_set1(scancodes[i], times[i]);
+    }
 }
 
 static key_t _generic_keyboard_apply_modifiers(key_t key)
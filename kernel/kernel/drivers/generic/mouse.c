@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) 2021, Krisna Pranav
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <drivers/generic/input.h>
+#include <drivers/generic/mouse.h>
+#include <fs/devfs/devfs.h>
+#include <fs/vfs.h>
+#include <libkern/libkern.h>
+#include <platform/generic/system.h>
+#include <tasking/softirq.h>
+#include <time/time_manager.h>
+
+#define GMOUSE_PENDING_EVENTS 16
+
+static input_ring_t gmouse_ring;
+static mouse_packet_t gmouse_events[INPUT_RING_EVENTS];
+
+// Packets decoded by the hard handler, waiting for the bottom half.
+static lock_t gmouse_pending_lock;
+static mouse_packet_t gmouse_pending[GMOUSE_PENDING_EVENTS];
+static uint32_t gmouse_pending_count;
+
+static inline int16_t _generic_mouse_clamp(int32_t val)
+{
+    if (val > 0x7fff) {
+        return 0x7fff;
+    }
+    if (val < -0x8000) {
+        return -0x8000;
+    }
+    return val;
+}
+
+/**
+ * Movements are summed up while buttons stay the same, so the reader
+ * gets one event for a whole burst of motion. A button change always
+ * starts a new event, clicks are never lost or reordered.
+ */
+static bool _generic_mouse_merge(void* last_ptr, const void* event_ptr)
+{
+    mouse_packet_t* last = (mouse_packet_t*)last_ptr;
+    const mouse_packet_t* event = (const mouse_packet_t*)event_ptr;
+    if (last->button_states != event->button_states) {
+        return false;
+    }
+
+    last->x_offset = _generic_mouse_clamp((int32_t)last->x_offset + event->x_offset);
+    last->y_offset = _generic_mouse_clamp((int32_t)last->y_offset + event->y_offset);
+    last->wheel_data = _generic_mouse_clamp((int32_t)last->wheel_data + event->wheel_data);
+    last->time = event->time;
+    return true;
+}
+
+static bool _generic_mouse_can_read(dentry_t* dentry, uint32_t start)
+{
+    return input_ring_can_read(&gmouse_ring);
+}
+
+static int _generic_mouse_read(dentry_t* dentry, uint8_t* buf, uint32_t start, uint32_t len)
+{
+    return input_ring_read(&gmouse_ring, buf, len);
+}
+
+int generic_mouse_create_devfs()
+{
+    dentry_t* mp;
+    if (vfs_resolve_path("/dev", &mp) < 0) {
+        return -1;
+    }
+
+    file_ops_t fops = { 0 };
+    fops.can_read = _generic_mouse_can_read;
+    fops.read = _generic_mouse_read;
+    devfs_inode_t* res = devfs_register(mp, MKDEV(10, 1), "mouse", 5, 0, &fops);
+
+    dentry_put(mp);
+    return 0;
+}
+
+static void _generic_mouse_softirq()
+{
+    mouse_packet_t packets[GMOUSE_PENDING_EVENTS];
+
+    system_disable_interrupts();
+    lock_acquire(&gmouse_pending_lock);
+    uint32_t count = gmouse_pending_count;
+    memcpy(packets, gmouse_pending, count * sizeof(mouse_packet_t));
+    gmouse_pending_count = 0;
+    lock_release(&gmouse_pending_lock);
+    system_enable_interrupts();
+
+    for (uint32_t i = 0; i < count; i++) {
+        input_ring_push(&gmouse_ring, &packets[i]);
+    }
+}
+
+void generic_mouse_init()
+{
+    lock_init(&gmouse_pending_lock);
+    input_ring_init(&gmouse_ring, gmouse_events, sizeof(mouse_packet_t), _generic_mouse_merge);
+    softirq_register(SOFTIRQ_MOUSE, _generic_mouse_softirq);
+}
+
+/**
+ * Called from hard interrupt handlers. The packet is only stamped and
+ * stashed, coalescing and waking up readers is left to the bottom half.
+ */
+void generic_mouse_emit(mouse_packet_t* packet)
+{
+    packet->time = timeman_ms_since_boot();
+
+    system_disable_interrupts();
+    lock_acquire(&gmouse_pending_lock);
+    if (gmouse_pending_count < GMOUSE_PENDING_EVENTS) {
+        gmouse_pending[gmouse_pending_count++] = *packet;
+    } else {
+        _generic_mouse_merge(&gmouse_pending[GMOUSE_PENDING_EVENTS - 1], packet);
+    }
+    lock_release(&gmouse_pending_lock);
+    system_enable_interrupts();
+
+    softirq_raise(SOFTIRQ_MOUSE);
+}
\ No newline at end of file
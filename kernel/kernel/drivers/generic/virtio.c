@@ -0,0 +1,194 @@
+/*
+ * Copyright (c) 2021, Krisna Pranav
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <drivers/generic/virtio.h>
+#include <libkern/bits/errno.h>
+#include <libkern/libkern.h>
+#include <libkern/log.h>
+#include <mem/pmm.h>
+#include <mem/vmm/vmm.h>
+
+// #define DEBUG_VIRTIO
+
+#ifdef __arm__
+// Rings are shared with the device, keep them out of the cache.
+#define VIRTIO_DMA_PAGE_FLAGS (PAGE_READABLE | PAGE_WRITABLE | PAGE_NOT_CACHEABLE)
+#else
+#define VIRTIO_DMA_PAGE_FLAGS (PAGE_READABLE | PAGE_WRITABLE)
+#endif
+
+static inline void _virtio_barrier()
+{
+#ifdef __arm__
+    asm volatile("dmb ish" ::
+                     : "memory");
+#else
+    asm volatile("" ::
+                     : "memory");
+#endif
+}
+
+int virtio_alloc_dma(uint32_t size, zone_t* zone, uint32_t* paddr)
+{
+    size = (size + VMM_PAGE_SIZE - 1) & ~(VMM_PAGE_SIZE - 1);
+    uint32_t phys = (uint32_t)pmm_alloc_aligned(size, VMM_PAGE_SIZE);
+    if (!phys) {
+        return -ENOMEM;
+    }
+
+    *zone = zoner_new_zone(size);
+    if (!zone->start) {
+        pmm_free((void*)phys, size);
+        return -ENOMEM;
+    }
+
+    vmm_map_pages(zone->start, phys, size / VMM_PAGE_SIZE, VIRTIO_DMA_PAGE_FLAGS);
+    memset(zone->ptr, 0, size);
+    *paddr = phys;
+    return 0;
+}
+
+/**
+ * DEVICE STATUS
+ */
+
+int virtio_negotiate(virtio_device_t* vdev, uint32_t wanted_features, uint32_t* accepted_features)
+{
+    vdev->ops->set_status(vdev, 0);
+    vdev->ops->set_status(vdev, VIRTIO_STATUS_ACKNOWLEDGE);
+    vdev->ops->set_status(vdev, VIRTIO_STATUS_ACKNOWLEDGE | VIRTIO_STATUS_DRIVER);
+
+    uint32_t features = vdev->ops->get_features(vdev) & wanted_features;
+    vdev->ops->set_features(vdev, features);
+
+    // Legacy devices do not have FEATURES_OK, the transport sets it only when supported.
+    if (vdev->version >= 2) {
+        uint8_t status = VIRTIO_STATUS_ACKNOWLEDGE | VIRTIO_STATUS_DRIVER | VIRTIO_STATUS_FEATURES_OK;
+        vdev->ops->set_status(vdev, status);
+        if (!(vdev->ops->get_status(vdev) & VIRTIO_STATUS_FEATURES_OK)) {
+            virtio_fail(vdev);
+            return -ENODEV;
+        }
+    }
+
+    *accepted_features = features;
+    return 0;
+}
+
+void virtio_driver_ok(virtio_device_t* vdev)
+{
+    vdev->ops->set_status(vdev, vdev->ops->get_status(vdev) | VIRTIO_STATUS_DRIVER_OK);
+}
+
+void virtio_fail(virtio_device_t* vdev)
+{
+    vdev->ops->set_status(vdev, vdev->ops->get_status(vdev) | VIRTIO_STATUS_FAILED);
+}
+
+/**
+ * VIRTQUEUE
+ */
+
+int virtqueue_init(virtio_device_t* vdev, virtqueue_t* vq, uint16_t index)
+{
+    uint16_t size = vdev->ops->queue_size(vdev, index);
+    if (!size) {
+        return -ENODEV;
+    }
+
+    uint32_t bytes = virtqueue_used_offset(size) + sizeof(virtq_used_t) + sizeof(virtq_used_elem_t) * size + sizeof(uint16_t);
+    int err = virtio_alloc_dma(bytes, &vq->zone, &vq->paddr);
+    if (err) {
+        return err;
+    }
+
+    vq->index = index;
+    vq->size = size;
+    vq->desc = (virtq_desc_t*)vq->zone.ptr;
+    vq->avail = (virtq_avail_t*)(vq->zone.ptr + virtqueue_avail_offset(size));
+    vq->used = (virtq_used_t*)(vq->zone.ptr + virtqueue_used_offset(size));
+    vq->last_used_idx = 0;
+
+    // All descriptors start in a single free list linked through next.
+    for (uint16_t i = 0; i < size - 1; i++) {
+        vq->desc[i].next = i + 1;
+    }
+    vq->free_head = 0;
+    vq->num_free = size;
+
+#ifdef DEBUG_VIRTIO
+    log("virtio: queue %d of size %d at %x", index, size, vq->paddr);
+#endif
+    return vdev->ops->activate_queue(vdev, vq);
+}
+
+/**
+ * Puts a descriptor chain made of @bufs into the available ring.
+ * Returns the head descriptor id, which is reported back in the used
+ * ring on completion.
+ */
+int virtqueue_add(virtqueue_t* vq, virtq_buf_t* bufs, int count)
+{
+    if (count <= 0 || vq->num_free < count) {
+        return -ENOSPC;
+    }
+
+    uint16_t head = vq->free_head;
+    uint16_t id = head;
+    uint16_t last = head;
+    for (int i = 0; i < count; i++) {
+        vq->desc[id].addr = bufs[i].paddr;
+        vq->desc[id].len = bufs[i].len;
+        vq->desc[id].flags = (bufs[i].device_writable ? VIRTQ_DESC_F_WRITE : 0) | (i + 1 < count ? VIRTQ_DESC_F_NEXT : 0);
+        last = id;
+        id = vq->desc[id].next;
+    }
+    vq->free_head = vq->desc[last].next;
+    vq->num_free -= count;
+
+    uint16_t avail_idx = vq->avail->idx;
+    vq->avail->ring[avail_idx % vq->size] = head;
+    // The device must see the ring entry before the new index.
+    _virtio_barrier();
+    vq->avail->idx = avail_idx + 1;
+    return head;
+}
+
+void virtqueue_kick(virtio_device_t* vdev, virtqueue_t* vq)
+{
+    _virtio_barrier();
+    vdev->ops->notify(vdev, vq->index);
+}
+
+/**
+ * Takes one completed chain out of the used ring and returns its
+ * descriptors to the free list. Returns the head id or -EAGAIN.
+ */
+int virtqueue_get_used(virtqueue_t* vq, uint32_t* len)
+{
+    if (vq->last_used_idx == vq->used->idx) {
+        return -EAGAIN;
+    }
+    _virtio_barrier();
+
+    volatile virtq_used_elem_t* elem = &vq->used->ring[vq->last_used_idx % vq->size];
+    uint16_t head = elem->id;
+    if (len) {
+        *len = elem->len;
+    }
+    vq->last_used_idx++;
+
+    uint16_t id = head;
+    uint16_t freed = 1;
+    while (vq->desc[id].flags & VIRTQ_DESC_F_NEXT) {
+        id = vq->desc[id].next;
+        freed++;
+    }
+    vq->desc[id].next = vq->free_head;
+    vq->free_head = head;
+    vq->num_free += freed;
+    return head;
+}
@@ -0,0 +1,356 @@
+/*
+ * Copyright (c) 2021, Krisna Pranav
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <drivers/generic/virtio_blk.h>
+#include <libkern/bits/errno.h>
+#include <libkern/libkern.h>
+#include <libkern/log.h>
+#include <platform/generic/system.h>
+#include <tasking/softirq.h>
+
+// #define DEBUG_VIRTIO_BLK
+
+static virtio_blk_t _virtio_blk_devices[MAX_DEVICES_COUNT];
+
+static inline virtio_blk_t* _virtio_blk_get(device_t* dev)
+{
+    return &_virtio_blk_devices[dev->id];
+}
+
+static inline virtio_blk_req_header_t* _virtio_blk_header(virtio_blk_t* blk, int slot)
+{
+    return &((virtio_blk_req_header_t*)blk->meta_zone.ptr)[slot];
+}
+
+static inline uint32_t _virtio_blk_header_paddr(virtio_blk_t* blk, int slot)
+{
+    return blk->meta_paddr + slot * sizeof(virtio_blk_req_header_t);
+}
+
+static inline uint32_t _virtio_blk_status_offset(int slot)
+{
+    return VIRTIO_BLK_MAX_REQUESTS * sizeof(virtio_blk_req_header_t) + slot;
+}
+
+static inline uint8_t* _virtio_blk_data(virtio_blk_t* blk, int slot)
+{
+    return blk->data_zone.ptr + slot * VIRTIO_BLK_SLOT_SECTORS * VIRTIO_BLK_SECTOR_SIZE;
+}
+
+static inline uint32_t _virtio_blk_data_paddr(virtio_blk_t* blk, int slot)
+{
+    return blk->data_paddr + slot * VIRTIO_BLK_SLOT_SECTORS * VIRTIO_BLK_SECTOR_SIZE;
+}
+
+static int _virtio_blk_find_free_slot(virtio_blk_t* blk)
+{
+    for (int i = 0; i < VIRTIO_BLK_MAX_REQUESTS; i++) {
+        if (!blk->slots[i]) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static int _virtio_blk_find_slot_by_head(virtio_blk_t* blk, int head)
+{
+    for (int i = 0; i < VIRTIO_BLK_MAX_REQUESTS; i++) {
+        if (blk->slots[i] && blk->slot_heads[i] == head) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * Takes all finished requests out of the used ring. Called from the
+ * bottom half and from waiters, which run with interrupts off.
+ */
+static void _virtio_blk_reap(virtio_blk_t* blk)
+{
+    blk_request_t* finished[VIRTIO_BLK_MAX_REQUESTS];
+    int finished_status[VIRTIO_BLK_MAX_REQUESTS];
+    int finished_count = 0;
+
+    system_disable_interrupts();
+    lock_acquire(&blk->lock);
+    int head;
+    while ((head = virtqueue_get_used(&blk->vq, NULL)) >= 0) {
+        int slot = _virtio_blk_find_slot_by_head(blk, head);
+        if (slot < 0) {
+            log_warn("virtio-blk: unknown head %d in used ring", head);
+            continue;
+        }
+
+        blk_request_t* req = blk->slots[slot];
+        uint8_t status = blk->meta_zone.ptr[_virtio_blk_status_offset(slot)];
+        if (status == VIRTIO_BLK_S_OK) {
+            if (req->op == BIO_READ) {
+                blk_request_scatter(req, _virtio_blk_data(blk, slot));
+            }
+            finished_status[finished_count] = 0;
+        } else {
+            finished_status[finished_count] = (status == VIRTIO_BLK_S_UNSUPP) ? -EINVAL : -EIO;
+        }
+
+        blk->slots[slot] = NULL;
+        finished[finished_count++] = req;
+    }
+    lock_release(&blk->lock);
+    system_enable_interrupts();
+
+    for (int i = 0; i < finished_count; i++) {
+        blk_request_complete(finished[i], finished_status[i]);
+    }
+}
+
+static int _virtio_blk_do_sync(device_t* dev, uint32_t op, uint32_t sector, uint8_t* buf)
+{
+    virtio_blk_t* blk = _virtio_blk_get(dev);
+    bio_t bio = { 0 };
+    bio.dev = dev;
+    bio.op = op;
+    bio.sector = sector;
+    bio.count = (op == BIO_FLUSH) ? 0 : 1;
+    bio.buf = buf;
+
+    blk_request_t req = { 0 };
+    req.op = op;
+    req.sector = sector;
+    req.count = bio.count;
+    req.bios = &bio;
+
+    int err;
+    while ((err = virtio_blk_submit(dev, &req)) == -EBUSY) {
+        _virtio_blk_reap(blk);
+    }
+    if (err) {
+        return err;
+    }
+
+    // Syscalls run with interrupts off, so the waiter reaps by itself.
+    while (!bio.done) {
+        _virtio_blk_reap(blk);
+    }
+    return bio.status;
+}
+
+static void _virtio_blk_softirq()
+{
+    for (int i = 0; i < MAX_DEVICES_COUNT; i++) {
+        virtio_blk_t* blk = &_virtio_blk_devices[i];
+        if (blk->active && blk->reap_pending) {
+            blk->reap_pending = false;
+            _virtio_blk_reap(blk);
+        }
+    }
+}
+
+int virtio_blk_init(device_t* dev, virtio_device_t* vdev)
+{
+    virtio_blk_t* blk = _virtio_blk_get(dev);
+    memset(blk, 0, sizeof(virtio_blk_t));
+    blk->vdev = *vdev;
+    lock_init(&blk->lock);
+
+    int err = virtio_negotiate(&blk->vdev, VIRTIO_BLK_F_RO | VIRTIO_BLK_F_FLUSH, &blk->features);
+    if (err) {
+        return err;
+    }
+
+    err = virtqueue_init(&blk->vdev, &blk->vq, 0);
+    if (err) {
+        virtio_fail(&blk->vdev);
+        return err;
+    }
+
+    // Every request takes a chain of 3 descriptors: header, data and status.
+    if (blk->vq.size < 3 * VIRTIO_BLK_MAX_REQUESTS) {
+        virtio_fail(&blk->vdev);
+        return -ENODEV;
+    }
+
+    err = virtio_alloc_dma(VIRTIO_BLK_MAX_REQUESTS * (sizeof(virtio_blk_req_header_t) + 1), &blk->meta_zone, &blk->meta_paddr);
+    if (err) {
+        virtio_fail(&blk->vdev);
+        return err;
+    }
+
+    err = virtio_alloc_dma(VIRTIO_BLK_MAX_REQUESTS * VIRTIO_BLK_SLOT_SECTORS * VIRTIO_BLK_SECTOR_SIZE, &blk->data_zone, &blk->data_paddr);
+    if (err) {
+        virtio_fail(&blk->vdev);
+        return err;
+    }
+
+    uint32_t cap_lo = blk->vdev.ops->read_config(&blk->vdev, VIRTIO_BLK_CONFIG_CAPACITY);
+    uint32_t cap_hi = blk->vdev.ops->read_config(&blk->vdev, VIRTIO_BLK_CONFIG_CAPACITY + 4);
+    blk->capacity = ((uint64_t)cap_hi << 32) | cap_lo;
+
+    softirq_register(SOFTIRQ_BLOCK, _virtio_blk_softirq);
+    blk->active = true;
+    virtio_driver_ok(&blk->vdev);
+#ifdef DEBUG_VIRTIO_BLK
+    log("virtio-blk: %d sectors, features %x", (uint32_t)blk->capacity, blk->features);
+#endif
+    return 0;
+}
+
+static inline uint32_t _virtio_blk_request_type(uint32_t op)
+{
+    switch (op) {
+    case BIO_WRITE:
+        return VIRTIO_BLK_T_OUT;
+    case BIO_FLUSH:
+        return VIRTIO_BLK_T_FLUSH;
+    default:
+        return VIRTIO_BLK_T_IN;
+    }
+}
+
+/**
+ * Queues @req to the device and returns immediately. Up to
+ * VIRTIO_BLK_MAX_REQUESTS requests can be in flight; -EBUSY is returned
+ * when all slots are taken. The request is finished with
+ * blk_request_complete() once the device reports it.
+ */
+int virtio_blk_submit(device_t* dev, blk_request_t* req)
+{
+    virtio_blk_t* blk = _virtio_blk_get(dev);
+    if (!blk->active) {
+        return -ENODEV;
+    }
+    if (req->op != BIO_FLUSH && (req->count == 0 || req->count > VIRTIO_BLK_SLOT_SECTORS)) {
+        return -EINVAL;
+    }
+    if (req->op == BIO_WRITE && (blk->features & VIRTIO_BLK_F_RO)) {
+        return -EROFS;
+    }
+    if (req->op == BIO_FLUSH && !(blk->features & VIRTIO_BLK_F_FLUSH)) {
+        blk_request_complete(req, 0);
+        return 0;
+    }
+
+    system_disable_interrupts();
+    lock_acquire(&blk->lock);
+    int slot = _virtio_blk_find_free_slot(blk);
+    if (slot < 0) {
+        lock_release(&blk->lock);
+        system_enable_interrupts();
+        return -EBUSY;
+    }
+
+    virtio_blk_req_header_t* header = _virtio_blk_header(blk, slot);
+    header->type = _virtio_blk_request_type(req->op);
+    header->reserved = 0;
+    header->sector = req->sector;
+    blk->meta_zone.ptr[_virtio_blk_status_offset(slot)] = 0xFF;
+
+    virtq_buf_t bufs[3];
+    int bufs_count = 0;
+    bufs[bufs_count].paddr = _virtio_blk_header_paddr(blk, slot);
+    bufs[bufs_count].len = sizeof(virtio_blk_req_header_t);
+    bufs[bufs_count].device_writable = false;
+    bufs_count++;
+
+    if (req->op != BIO_FLUSH) {
+        if (req->op == BIO_WRITE) {
+            blk_request_gather(req, _virtio_blk_data(blk, slot));
+        }
+        bufs[bufs_count].paddr = _virtio_blk_data_paddr(blk, slot);
+        bufs[bufs_count].len = req->count * VIRTIO_BLK_SECTOR_SIZE;
+        bufs[bufs_count].device_writable = (req->op == BIO_READ);
+        bufs_count++;
+    }
+
+    bufs[bufs_count].paddr = blk->meta_paddr + _virtio_blk_status_offset(slot);
+    bufs[bufs_count].len = 1;
+    bufs[bufs_count].device_writable = true;
+    bufs_count++;
+
+    int head = virtqueue_add(&blk->vq, bufs, bufs_count);
+    if (head < 0) {
+        lock_release(&blk->lock);
+        system_enable_interrupts();
+        return -EBUSY;
+    }
+
+    blk->slots[slot] = req;
+    blk->slot_heads[slot] = head;
+    virtqueue_kick(&blk->vdev, &blk->vq);
+    lock_release(&blk->lock);
+    system_enable_interrupts();
+    return 0;
+}
+
+void virtio_blk_poll(device_t* dev)
+{
+    _virtio_blk_reap(_virtio_blk_get(dev));
+}
+
+uint32_t virtio_blk_max_sectors(device_t* dev)
+{
+    return VIRTIO_BLK_SLOT_SECTORS;
+}
+
+/**
+ * Interrupt lines may be shared between virtio devices, so every
+ * active device checks its own ISR. The hard handler only acknowledges
+ * the device, completions are reaped by the bottom half.
+ */
+void virtio_blk_handle_interrupts()
+{
+    bool raise = false;
+    for (int i = 0; i < MAX_DEVICES_COUNT; i++) {
+        virtio_blk_t* blk = &_virtio_blk_devices[i];
+        if (!blk->active) {
+            continue;
+        }
+        uint32_t isr = blk->vdev.ops->ack_interrupt(&blk->vdev);
+        if (isr & VIRTIO_ISR_QUEUE) {
+            blk->reap_pending = true;
+            raise = true;
+        }
+    }
+
+    if (raise) {
+        softirq_raise(SOFTIRQ_BLOCK);
+    }
+}
+
+/**
+ * DRIVER MANAGER API
+ */
+
+int virtio_blk_read(device_t* dev, uint32_t sector, uint8_t* read_data)
+{
+    return _virtio_blk_do_sync(dev, BIO_READ, sector, read_data);
+}
+
+int virtio_blk_write(device_t* dev, uint32_t sector, uint8_t* data, uint32_t size)
+{
+    uint8_t tmp_buf[VIRTIO_BLK_SECTOR_SIZE];
+    if (size < VIRTIO_BLK_SECTOR_SIZE) {
+        memcpy(tmp_buf, data, size);
+        memset(tmp_buf + size, 0, VIRTIO_BLK_SECTOR_SIZE - size);
+        data = tmp_buf;
+    }
+
+    return _virtio_blk_do_sync(dev, BIO_WRITE, sector, data);
+}
+
+int virtio_blk_flush(device_t* dev)
+{
+    return _virtio_blk_do_sync(dev, BIO_FLUSH, 0, NULL);
+}
+
+/* Returns a disk size in bytes */
+uint32_t virtio_blk_capacity(device_t* dev)
+{
+    // FIXME: Disks over 4GB do not fit.
+    virtio_blk_t* blk = _virtio_blk_get(dev);
+    uint64_t bytes = blk->capacity * VIRTIO_BLK_SECTOR_SIZE;
+    return bytes > 0xFFFFFFFF ? 0xFFFFFFFF : (uint32_t)bytes;
+}
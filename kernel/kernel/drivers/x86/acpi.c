@@ -0,0 +1,180 @@
+/*
+ * Copyright (c) 2021, Krisna Pranav
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <drivers/x86/acpi.h>
+#include <libkern/bits/errno.h>
+#include <libkern/libkern.h>
+#include <libkern/log.h>
+#include <mem/vmm/vmm.h>
+#include <mem/vmm/zoner.h>
+#include <platform/x86/memmap.h>
+
+// #define DEBUG_ACPI
+
+#define ACPI_EBDA_SEGMENT_PTR 0x40E
+#define ACPI_BIOS_AREA_START 0xE0000
+#define ACPI_BIOS_AREA_END 0x100000
+
+static acpi_madt_info_t _acpi_madt_info;
+
+/**
+ * The first 4MB of physical memory are always mapped at BIOS_SETTING_BASE.
+ */
+static inline void* _acpi_low_mem(uint32_t paddr)
+{
+    return (void*)(BIOS_SETTING_BASE + paddr);
+}
+
+static void* _acpi_map(uint32_t paddr, uint32_t len)
+{
+    uint32_t offset = paddr & (VMM_PAGE_SIZE - 1);
+    uint32_t pages = (offset + len + VMM_PAGE_SIZE - 1) / VMM_PAGE_SIZE;
+    zone_t zone = zoner_new_zone(pages * VMM_PAGE_SIZE);
+    vmm_map_pages(zone.start, paddr - offset, pages, PAGE_READABLE);
+    return (void*)(zone.start + offset);
+}
+
+static bool _acpi_checksum_ok(void* table, uint32_t len)
+{
+    uint8_t sum = 0;
+    uint8_t* ptr = (uint8_t*)table;
+    for (uint32_t i = 0; i < len; i++) {
+        sum += ptr[i];
+    }
+    return sum == 0;
+}
+
+static acpi_rsdp_t* _acpi_find_rsdp_in(uint32_t start, uint32_t end)
+{
+    for (uint32_t paddr = start; paddr + sizeof(acpi_rsdp_t) <= end; paddr += 16) {
+        acpi_rsdp_t* rsdp = (acpi_rsdp_t*)_acpi_low_mem(paddr);
+        if (memcmp(rsdp->signature, "RSD PTR ", 8) == 0 && _acpi_checksum_ok(rsdp, sizeof(acpi_rsdp_t))) {
+            return rsdp;
+        }
+    }
+    return NULL;
+}
+
+static acpi_rsdp_t* _acpi_find_rsdp()
+{
+    uint32_t ebda = (uint32_t)(*(uint16_t*)_acpi_low_mem(ACPI_EBDA_SEGMENT_PTR)) << 4;
+    if (ebda) {
+        acpi_rsdp_t* rsdp = _acpi_find_rsdp_in(ebda, ebda + 1024);
+        if (rsdp) {
+            return rsdp;
+        }
+    }
+    return _acpi_find_rsdp_in(ACPI_BIOS_AREA_START, ACPI_BIOS_AREA_END);
+}
+
+static acpi_sdt_header_t* _acpi_map_table(uint32_t paddr)
+{
+    acpi_sdt_header_t* header = (acpi_sdt_header_t*)_acpi_map(paddr, sizeof(acpi_sdt_header_t));
+    uint32_t len = header->length;
+    if (len <= sizeof(acpi_sdt_header_t)) {
+        return header;
+    }
+    return (acpi_sdt_header_t*)_acpi_map(paddr, len);
+}
+
+static acpi_madt_t* _acpi_find_madt(acpi_rsdp_t* rsdp)
+{
+    acpi_sdt_header_t* rsdt = _acpi_map_table(rsdp->rsdt_paddr);
+    if (memcmp(rsdt->signature, "RSDT", 4) != 0 || !_acpi_checksum_ok(rsdt, rsdt->length)) {
+        return NULL;
+    }
+
+    uint32_t entries = (rsdt->length - sizeof(acpi_sdt_header_t)) / sizeof(uint32_t);
+    uint32_t* tables = (uint32_t*)((uint8_t*)rsdt + sizeof(acpi_sdt_header_t));
+    for (uint32_t i = 0; i < entries; i++) {
+        acpi_sdt_header_t* header = _acpi_map_table(tables[i]);
+        if (memcmp(header->signature, "APIC", 4) == 0 && _acpi_checksum_ok(header, header->length)) {
+            return (acpi_madt_t*)header;
+        }
+    }
+    return NULL;
+}
+
+static void _acpi_parse_madt(acpi_madt_t* madt)
+{
+    acpi_madt_info_t* info = &_acpi_madt_info;
+    info->lapic_paddr = madt->lapic_paddr;
+
+    uint8_t* ptr = (uint8_t*)madt + sizeof(acpi_madt_t);
+    uint8_t* end = (uint8_t*)madt + madt->header.length;
+    while (ptr + sizeof(acpi_madt_entry_t) <= end) {
+        acpi_madt_entry_t* entry = (acpi_madt_entry_t*)ptr;
+        if (entry->length < sizeof(acpi_madt_entry_t)) {
+            break;
+        }
+
+        switch (entry->type) {
+        case ACPI_MADT_LAPIC: {
+            acpi_madt_lapic_t* lapic = (acpi_madt_lapic_t*)entry;
+            if ((lapic->flags & ACPI_MADT_LAPIC_ENABLED) && info->cpu_count < CPU_CNT) {
+                info->cpu_apic_ids[info->cpu_count++] = lapic->apic_id;
+            }
+            break;
+        }
+        case ACPI_MADT_IOAPIC: {
+            acpi_madt_ioapic_t* ioapic = (acpi_madt_ioapic_t*)entry;
+            // Only the first IOAPIC is used, it serves all ISA irqs.
+            if (!info->ioapic_paddr) {
+                info->ioapic_paddr = ioapic->ioapic_paddr;
+                info->ioapic_gsi_base = ioapic->gsi_base;
+            }
+            break;
+        }
+        case ACPI_MADT_INTERRUPT_OVERRIDE: {
+            acpi_madt_override_t* override = (acpi_madt_override_t*)entry;
+            if (override->bus == 0 && override->source < ACPI_ISA_IRQS) {
+                info->isa_irqs[override->source].gsi = override->gsi;
+                info->isa_irqs[override->source].flags = override->flags;
+            }
+            break;
+        }
+        default:
+            break;
+        }
+
+        ptr += entry->length;
+    }
+}
+
+int acpi_install()
+{
+    for (int i = 0; i < ACPI_ISA_IRQS; i++) {
+        _acpi_madt_info.isa_irqs[i].gsi = i;
+        _acpi_madt_info.isa_irqs[i].flags = 0;
+    }
+
+    acpi_rsdp_t* rsdp = _acpi_find_rsdp();
+    if (!rsdp) {
+#ifdef DEBUG_ACPI
+        log_warn("ACPI: no RSDP");
+#endif
+        return -ENODEV;
+    }
+
+    acpi_madt_t* madt = _acpi_find_madt(rsdp);
+    if (!madt) {
+#ifdef DEBUG_ACPI
+        log_warn("ACPI: no MADT");
+#endif
+        return -ENODEV;
+    }
+
+    _acpi_parse_madt(madt);
+#ifdef DEBUG_ACPI
+    log("ACPI: lapic %x, ioapic %x, %d cpus", _acpi_madt_info.lapic_paddr, _acpi_madt_info.ioapic_paddr, _acpi_madt_info.cpu_count);
+#endif
+    return 0;
+}
+
+acpi_madt_info_t* acpi_madt_info()
+{
+    return &_acpi_madt_info;
+}
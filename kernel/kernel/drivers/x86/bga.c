@@ -28,14 +28,36 @@
 #define VBE_DISPI_INDEX_VIRT_HEIGHT 0x7
 #define VBE_DISPI_INDEX_X_OFFSET 0x8
 #define VBE_DISPI_INDEX_Y_OFFSET 0x9
+#define VBE_DISPI_INDEX_VIDEO_MEMORY_64K 0xa
 
 #define VBE_DISPI_DISABLED 0x00
 #define VBE_DISPI_ENABLED 0x01
 #define VBE_DISPI_LFB_ENABLED 0x40
 
+#define BGA_DEFAULT_VRAM_SIZE (16 * 1024 * 1024)
+
+struct bga_mode {
+    uint16_t width;
+    uint16_t height;
+};
+
+static const struct bga_mode bga_modes[] = {
+    { 320, 568 },
+    { 640, 480 },
+    { 800, 600 },
+    { 1024, 768 },
+    { 1280, 720 },
+    { 1280, 1024 },
+    { 1600, 900 },
+    { 1920, 1080 },
+};
+#define BGA_MODES_COUNT (sizeof(bga_modes) / sizeof(struct bga_mode))
+
 static uint16_t bga_screen_width, bga_screen_height;
 static uint32_t bga_screen_line_size, bga_screen_buffer_size;
+static uint32_t bga_screen_buffers = 2;
 static uint32_t bga_buf_paddr;
+static uint32_t bga_vram_size;
 
 static inline void _bga_write_reg(uint16_t cmd, uint16_t data)
 {
@@ -49,13 +71,13 @@ static inline uint16_t _bga_read_reg(uint16_t cmd)
     return port_16bit_in(VBE_DISPI_IOPORT_DATA);
 }
 
-static void _bga_set_resolution(uint16_t width, uint16_t height)
+static void _bga_set_resolution(uint16_t width, uint16_t height, uint32_t buffers)
 {
     _bga_write_reg(VBE_DISPI_INDEX_ENABLE, VBE_DISPI_DISABLED);
     _bga_write_reg(VBE_DISPI_INDEX_XRES, width);
     _bga_write_reg(VBE_DISPI_INDEX_YRES, height);
     _bga_write_reg(VBE_DISPI_INDEX_VIRT_WIDTH, width);
-    _bga_write_reg(VBE_DISPI_INDEX_VIRT_HEIGHT, (uint16_t)height * 2);
+    _bga_write_reg(VBE_DISPI_INDEX_VIRT_HEIGHT, (uint16_t)(height * buffers));
     _bga_write_reg(VBE_DISPI_INDEX_BPP, 32);
     _bga_write_reg(VBE_DISPI_INDEX_X_OFFSET, 0);
     _bga_write_reg(VBE_DISPI_INDEX_Y_OFFSET, 0);
@@ -65,18 +87,92 @@ static void _bga_set_resolution(uint16_t width, uint16_t height)
     bga_screen_line_size = (uint32_t)width * 4;
 }
 
+static inline uint32_t _bga_max_buffers(uint32_t width, uint32_t height)
+{
+    uint32_t lines = bga_vram_size / (width * 4);
+    uint32_t buffers = lines / height;
+    return buffers > BGA_MAX_BUFFERS ? BGA_MAX_BUFFERS : buffers;
+}
+
+/**
+ * Only modes which fit into vram at least twice are reported, since
+ * the window server needs a back buffer.
+ */
+static const struct bga_mode* _bga_get_mode(uint32_t index)
+{
+    for (int i = 0; i < BGA_MODES_COUNT; i++) {
+        if (_bga_max_buffers(bga_modes[i].width, bga_modes[i].height) < 2) {
+            continue;
+        }
+        if (index == 0) {
+            return &bga_modes[i];
+        }
+        index--;
+    }
+    return NULL;
+}
+
+static uint32_t _bga_modes_count()
+{
+    uint32_t count = 0;
+    while (_bga_get_mode(count)) {
+        count++;
+    }
+    return count;
+}
+
+static int _bga_set_mode(uint32_t width, uint32_t height, uint32_t buffers)
+{
+    if (!width || !height || !buffers || buffers > BGA_MAX_BUFFERS) {
+        return -EINVAL;
+    }
+    if (width > 0xffff || height * buffers > 0xffff) {
+        return -EINVAL;
+    }
+    if (buffers > _bga_max_buffers(width, height)) {
+        return -ENOMEM;
+    }
+
+    _bga_set_resolution(width, height, buffers);
+    bga_screen_width = width;
+    bga_screen_height = height;
+    bga_screen_buffers = buffers;
+    bga_screen_buffer_size = bga_screen_line_size * height * buffers;
+    return 0;
+}
+
 static int _bga_ioctl(dentry_t* dentry, uint32_t cmd, uint32_t arg)
 {
-    uint32_t y_offset = 0;
+    const struct bga_mode* bmode;
+    display_mode_t* mode = (display_mode_t*)arg;
     switch (cmd) {
     case BGA_GET_HEIGHT:
         return bga_screen_height;
     case BGA_GET_WIDTH:
         return bga_screen_width;
+    case BGA_GET_BUFFERS:
+        return bga_screen_buffers;
     case BGA_SWAP_BUFFERS:
-        y_offset = bga_screen_height * (arg & 1);
-        _bga_write_reg(VBE_DISPI_INDEX_Y_OFFSET, (uint16_t)y_offset);
+        // Flipping is just a scanout offset in the virtual screen, no pixels are copied.
+        if (arg >= bga_screen_buffers) {
+            return -EINVAL;
+        }
+        _bga_write_reg(VBE_DISPI_INDEX_Y_OFFSET, (uint16_t)(bga_screen_height * arg));
         return 0;
+    case BGA_GET_MODES_COUNT:
+        return _bga_modes_count();
+    case BGA_GET_MODE:
+        bmode = _bga_get_mode(mode->index);
+        if (!bmode) {
+            return -EINVAL;
+        }
+        mode->width = bmode->width;
+        mode->height = bmode->height;
+        mode->bpp = 32;
+        mode->buffers = _bga_max_buffers(bmode->width, bmode->height);
+        return 0;
+    case BGA_SET_MODE:
+        return _bga_set_mode(mode->width, mode->height, mode->buffers);
     default:
         return -EINVAL;
     }
@@ -90,18 +186,17 @@ static proc_zone_t* _bga_mmap(dentry_t* dentry, mmap_params_t* params)
         return 0;
     }
 
-    proc_zone_t* zone = proc_new_random_zone(RUNNING_THREAD->process, bga_screen_buffer_size);
+    proc_zone_t* zone = proc_new_random_zone_aligned(RUNNING_THREAD->process, bga_screen_buffer_size, VMM_LARGE_ZONE_ALIGNMENT);
     if (!zone) {
         return 0;
     }
 
-    zone->flags |= ZONE_WRITABLE | ZONE_READABLE | ZONE_NOT_CACHEABLE;
+    zone->flags |= ZONE_WRITABLE | ZONE_READABLE | ZONE_WRITE_COMBINING;
     zone->type |= ZONE_TYPE_DEVICE;
     zone->file = dentry_duplicate(dentry);
 
-    for (int offset = 0; offset < bga_screen_buffer_size; offset += VMM_PAGE_SIZE) {
-        vmm_map_page(zone->start + offset, bga_buf_paddr + offset, zone->flags);
-    }
+    // The compositor touches the whole framebuffer every frame, large pages keep it in a few TLB entries.
+    vmm_map_large_pages(zone->start, bga_buf_paddr, zone->len / VMM_PAGE_SIZE, zone->flags);
 
     return zone;
 }
@@ -149,6 +244,10 @@ void bga_install()
 void bga_init(device_t* dev)
 {
     bga_buf_paddr = pci_read_bar(dev, 0) & 0xfffffff0;
+    bga_vram_size = (uint32_t)_bga_read_reg(VBE_DISPI_INDEX_VIDEO_MEMORY_64K) * 64 * 1024;
+    if (!bga_vram_size) {
+        bga_vram_size = BGA_DEFAULT_VRAM_SIZE;
+    }
 #ifdef TARGET_DESKTOP
     bga_set_resolution(1024, 768);
 #elif TARGET_MOBILE
@@ -158,8 +257,7 @@ void bga_init(device_t* dev)
 
 void bga_set_resolution(uint16_t width, uint16_t height)
 {
-    _bga_set_resolution(width, height);
-    bga_screen_width = width;
-    bga_screen_height = height;
-    bga_screen_buffer_size = bga_screen_line_size * (uint32_t)height * 2;
+    if (_bga_set_mode(width, height, bga_screen_buffers) < 0) {
+        _bga_set_mode(width, height, 1);
+    }
 }
\ No newline at end of file
@@ -68,6 +68,12 @@ void fpu_init()
                  : "=m"(fpu_state));
 }
 
+void fpu_init_secondary_cpu()
+{
+    fpu_setup();
+    asm volatile("fninit");
+}
+
 void fpu_init_state(fpu_state_t* new_fpu_state)
 {
     memcpy(new_fpu_state, &fpu_state, sizeof(fpu_state_t));
@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2021, Krisna Pranav
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <drivers/x86/ioapic.h>
+#include <libkern/log.h>
+#include <mem/vmm/vmm.h>
+#include <mem/vmm/zoner.h>
+#include <platform/x86/idt.h>
+
+// #define DEBUG_IOAPIC
+
+static zone_t ioapic_zone;
+static volatile uint32_t* ioapic_registers;
+
+static inline uint32_t _ioapic_read(uint32_t reg)
+{
+    ioapic_registers[IOAPIC_REGSEL / sizeof(uint32_t)] = reg;
+    return ioapic_registers[IOAPIC_WINDOW / sizeof(uint32_t)];
+}
+
+static inline void _ioapic_write(uint32_t reg, uint32_t val)
+{
+    ioapic_registers[IOAPIC_REGSEL / sizeof(uint32_t)] = reg;
+    ioapic_registers[IOAPIC_WINDOW / sizeof(uint32_t)] = val;
+}
+
+static void _ioapic_set_entry(uint32_t pin, uint32_t low, uint8_t dest_apic_id)
+{
+    _ioapic_write(IOAPIC_REG_REDTBL + 2 * pin + 1, (uint32_t)dest_apic_id << 24);
+    _ioapic_write(IOAPIC_REG_REDTBL + 2 * pin, low);
+}
+
+static void _ioapic_disable_pic()
+{
+    port_byte_out(MASTER_PIC_DATA, 0xFF);
+    port_byte_out(SLAVE_PIC_DATA, 0xFF);
+}
+
+/**
+ * Routes ISA irqs to the same vectors they had with 8259, so drivers
+ * stay unchanged. All irqs are delivered to the boot cpu.
+ */
+int ioapic_install(acpi_madt_info_t* info, uint8_t dest_apic_id)
+{
+    ioapic_zone = zoner_new_zone(VMM_PAGE_SIZE);
+    vmm_map_page(ioapic_zone.start, info->ioapic_paddr, PAGE_READABLE | PAGE_WRITABLE | PAGE_NOT_CACHEABLE);
+    ioapic_registers = (volatile uint32_t*)ioapic_zone.ptr;
+
+    uint32_t pins = ((_ioapic_read(IOAPIC_REG_VERSION) >> 16) & 0xFF) + 1;
+    for (uint32_t pin = 0; pin < pins; pin++) {
+        _ioapic_set_entry(pin, IOAPIC_REDTBL_MASKED, 0);
+    }
+
+    for (int irq = 0; irq < ACPI_ISA_IRQS; irq++) {
+        // Irq 2 is the cascade of 8259, its gsi is usually taken by the timer.
+        if (irq == 2) {
+            continue;
+        }
+
+        uint32_t pin = info->isa_irqs[irq].gsi - info->ioapic_gsi_base;
+        if (pin >= pins) {
+            continue;
+        }
+
+        uint32_t low = IRQ_MASTER_OFFSET + irq;
+        uint16_t flags = info->isa_irqs[irq].flags;
+        if ((flags & ACPI_MADT_POLARITY_MASK) == ACPI_MADT_POLARITY_LOW) {
+            low |= IOAPIC_REDTBL_POLARITY_LOW;
+        }
+        if ((flags & ACPI_MADT_TRIGGER_MASK) == ACPI_MADT_TRIGGER_LEVEL) {
+            low |= IOAPIC_REDTBL_LEVEL;
+        }
+        _ioapic_set_entry(pin, low, dest_apic_id);
+    }
+
+    _ioapic_disable_pic();
+#ifdef DEBUG_IOAPIC
+    log("IOAPIC: %d pins", pins);
+#endif
+    return 0;
+}
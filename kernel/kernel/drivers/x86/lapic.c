@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2021, Krisna Pranav
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <drivers/x86/lapic.h>
+#include <drivers/x86/pit.h>
+#include <libkern/log.h>
+#include <mem/vmm/vmm.h>
+#include <mem/vmm/zoner.h>
+#include <tasking/cpu.h>
+#include <tasking/profiler.h>
+#include <tasking/sched.h>
+#include <time/time_manager.h>
+
+// #define DEBUG_LAPIC
+#define LAPIC_CALIBRATION_US 10000
+
+volatile uint32_t* lapic_registers = NULL;
+uint8_t lapic_id_to_cpu_id[256];
+uint8_t lapic_cpu_id_to_lapic_id[CPU_CNT];
+static zone_t lapic_zone;
+static uint32_t lapic_timer_ticks_per_period = 0;
+
+static void _lapic_enable()
+{
+    lapic_write(LAPIC_TPR, 0);
+    // ISA irqs are delivered with IOAPIC, the 8259 is disconnected.
+    lapic_write(LAPIC_LVT_LINT0, LAPIC_LVT_MASKED);
+    lapic_write(LAPIC_LVT_TIMER, LAPIC_LVT_MASKED | IRQ_LAPIC_TIMER);
+    lapic_write(LAPIC_SVR, LAPIC_SVR_ENABLE | IRQ_LAPIC_SPURIOUS);
+    lapic_write(LAPIC_ESR, 0);
+    lapic_write(LAPIC_ESR, 0);
+    lapic_eoi();
+}
+
+/**
+ * Measures the LAPIC timer against the PIT. The bus clock is shared
+ * between all cores, so the value is reused on APs.
+ */
+static void _lapic_timer_calibrate()
+{
+    lapic_write(LAPIC_TIMER_DIVIDE, LAPIC_TIMER_DIVIDE_BY_16);
+    lapic_write(LAPIC_LVT_TIMER, LAPIC_LVT_MASKED | IRQ_LAPIC_TIMER);
+    lapic_write(LAPIC_TIMER_INITIAL, 0xFFFFFFFF);
+    pit_busy_wait_us(LAPIC_CALIBRATION_US);
+    uint32_t elapsed = 0xFFFFFFFF - lapic_read(LAPIC_TIMER_CURRENT);
+    lapic_write(LAPIC_TIMER_INITIAL, 0);
+
+    lapic_timer_ticks_per_period = elapsed * (1000000 / LAPIC_CALIBRATION_US) / TIMER_TICKS_PER_SECOND;
+#ifdef DEBUG_LAPIC
+    log("LAPIC: %d timer ticks per period", lapic_timer_ticks_per_period);
+#endif
+}
+
+int lapic_install(uint32_t paddr)
+{
+    lapic_zone = zoner_new_zone(VMM_PAGE_SIZE);
+    vmm_map_page(lapic_zone.start, paddr, PAGE_READABLE | PAGE_WRITABLE | PAGE_NOT_CACHEABLE);
+    lapic_registers = (volatile uint32_t*)lapic_zone.ptr;
+
+    set_irq_handler(IRQ_LAPIC_TIMER, lapic_timer_handler);
+    _lapic_enable();
+    _lapic_timer_calibrate();
+    return 0;
+}
+
+void lapic_install_secondary_cpu()
+{
+    _lapic_enable();
+}
+
+/**
+ * The boot cpu is ticked by PIT, APs are ticked by their own LAPIC timers.
+ */
+void lapic_timer_setup()
+{
+    lapic_write(LAPIC_TIMER_DIVIDE, LAPIC_TIMER_DIVIDE_BY_16);
+    lapic_write(LAPIC_LVT_TIMER, LAPIC_TIMER_PERIODIC | IRQ_LAPIC_TIMER);
+    lapic_write(LAPIC_TIMER_INITIAL, lapic_timer_ticks_per_period);
+}
+
+void lapic_timer_handler()
+{
+    cpu_tick();
+    profiler_tick();
+    timeman_timer_tick();
+    sched_tick();
+}
+
+void lapic_send_ipi(uint8_t apic_id, uint32_t icr)
+{
+    lapic_write(LAPIC_ICR_HIGH, (uint32_t)apic_id << 24);
+    lapic_write(LAPIC_ICR_LOW, icr);
+    while (lapic_read(LAPIC_ICR_LOW) & LAPIC_ICR_DELIVERY_PENDING) { }
+}
+
+void lapic_send_init(uint8_t apic_id)
+{
+    lapic_send_ipi(apic_id, LAPIC_ICR_INIT | LAPIC_ICR_LEVEL | LAPIC_ICR_ASSERT);
+}
+
+void lapic_send_startup(uint8_t apic_id, uint32_t trampoline_paddr)
+{
+    lapic_send_ipi(apic_id, LAPIC_ICR_STARTUP | (trampoline_paddr >> 12));
+}
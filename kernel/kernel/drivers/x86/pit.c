@@ -6,9 +6,11 @@
 
 #include <drivers/x86/pit.h>
 #include <libkern/kassert.h>
+#include <libkern/libkern.h>
 #include <libkern/log.h>
 #include <platform/generic/system.h>
 #include <tasking/cpu.h>
+#include <tasking/profiler.h>
 #include <tasking/sched.h>
 #include <time/time_manager.h>
 
@@ -41,9 +43,40 @@ void pit_setup()
     set_irq_handler(IRQ0, pit_handler);
 }
 
+/**
+ * Busy waits using the PIT channel 2 in one-shot mode. It doesn't depend
+ * on interrupts, so it is used during early boot (AP startup, LAPIC timer
+ * calibration).
+ */
+void pit_busy_wait_us(uint32_t us)
+{
+    while (us) {
+        uint32_t chunk = min(us, 50000);
+        uint32_t count = (PIT_BASE_FREQ / 1000) * chunk / 1000;
+        if (!count) {
+            count = 1;
+        }
+
+        uint8_t gate = port_byte_in(PIT_GATE_PORT);
+        port_byte_out(PIT_GATE_PORT, (gate & ~0x02) | 0x01); // gate on, speaker off
+        port_byte_out(0x43, 0xB0); // channel 2, lobyte/hibyte, mode 0
+        port_byte_out(0x42, (uint8_t)(count & 0xFF));
+        port_byte_out(0x42, (uint8_t)((count >> 8) & 0xFF));
+
+        // Restarting the gate to start counting from the loaded value.
+        gate = port_byte_in(PIT_GATE_PORT) & ~0x01;
+        port_byte_out(PIT_GATE_PORT, gate);
+        port_byte_out(PIT_GATE_PORT, gate | 0x01);
+        while (!(port_byte_in(PIT_GATE_PORT) & 0x20)) { }
+
+        us -= chunk;
+    }
+}
+
 void pit_handler()
 {
     cpu_tick();
+    profiler_tick();
     timeman_timer_tick();
     sched_tick();
 }
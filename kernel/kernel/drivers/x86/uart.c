@@ -41,6 +41,24 @@ int uart_write(int port, uint8_t data)
     return 0;
 }
 
+/**
+ * Once the transmitter is empty its FIFO takes UART_FIFO_SIZE bytes, so
+ * the line status is polled once per burst instead of once per byte.
+ */
+int uart_write_buf(int port, const uint8_t* data, size_t len)
+{
+    while (len) {
+        while (!_uart_is_free_out(port)) { }
+        size_t burst = len < UART_FIFO_SIZE ? len : UART_FIFO_SIZE;
+        for (size_t i = 0; i < burst; i++) {
+            port_byte_out(port, data[i]);
+        }
+        data += burst;
+        len -= burst;
+    }
+    return 0;
+}
+
 int uart_read(int port, uint8_t* data)
 {
     while (!_uart_is_free_out(port)) { }
@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) 2021, Krisna Pranav
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <drivers/generic/virtio_blk.h>
+#include <drivers/x86/pci.h>
+#include <drivers/x86/virtio_pci.h>
+#include <libkern/log.h>
+#include <platform/x86/idt.h>
+
+// #define DEBUG_VIRTIO_PCI
+
+static bool _virtio_pci_irq_used[16];
+
+/**
+ * LEGACY TRANSPORT
+ */
+
+static uint32_t _virtio_pci_get_features(virtio_device_t* vdev)
+{
+    return port_dword_in(vdev->base + VIRTIO_PCI_DEVICE_FEATURES);
+}
+
+static void _virtio_pci_set_features(virtio_device_t* vdev, uint32_t features)
+{
+    port_dword_out(vdev->base + VIRTIO_PCI_DRIVER_FEATURES, features);
+}
+
+static uint8_t _virtio_pci_get_status(virtio_device_t* vdev)
+{
+    return port_byte_in(vdev->base + VIRTIO_PCI_DEVICE_STATUS);
+}
+
+static void _virtio_pci_set_status(virtio_device_t* vdev, uint8_t status)
+{
+    port_byte_out(vdev->base + VIRTIO_PCI_DEVICE_STATUS, status);
+}
+
+static uint32_t _virtio_pci_read_config(virtio_device_t* vdev, uint32_t offset)
+{
+    return port_dword_in(vdev->base + VIRTIO_PCI_CONFIG + offset);
+}
+
+static uint16_t _virtio_pci_queue_size(virtio_device_t* vdev, uint16_t index)
+{
+    // Legacy devices have a fixed queue size, the driver can't shrink it.
+    port_word_out(vdev->base + VIRTIO_PCI_QUEUE_SELECT, index);
+    return port_word_in(vdev->base + VIRTIO_PCI_QUEUE_SIZE);
+}
+
+static int _virtio_pci_activate_queue(virtio_device_t* vdev, virtqueue_t* vq)
+{
+    port_word_out(vdev->base + VIRTIO_PCI_QUEUE_SELECT, vq->index);
+    port_dword_out(vdev->base + VIRTIO_PCI_QUEUE_PFN, vq->paddr / VIRTQUEUE_ALIGN);
+    return 0;
+}
+
+static void _virtio_pci_notify(virtio_device_t* vdev, uint16_t index)
+{
+    port_word_out(vdev->base + VIRTIO_PCI_QUEUE_NOTIFY, index);
+}
+
+static uint32_t _virtio_pci_ack_interrupt(virtio_device_t* vdev)
+{
+    // Reading ISR clears it and deasserts the line.
+    return port_byte_in(vdev->base + VIRTIO_PCI_ISR_STATUS);
+}
+
+static virtio_transport_ops_t _virtio_pci_ops = {
+    .get_features = _virtio_pci_get_features,
+    .set_features = _virtio_pci_set_features,
+    .get_status = _virtio_pci_get_status,
+    .set_status = _virtio_pci_set_status,
+    .read_config = _virtio_pci_read_config,
+    .queue_size = _virtio_pci_queue_size,
+    .activate_queue = _virtio_pci_activate_queue,
+    .notify = _virtio_pci_notify,
+    .ack_interrupt = _virtio_pci_ack_interrupt,
+};
+
+/**
+ * BLOCK DEVICE
+ */
+
+static void _virtio_pci_int_handler()
+{
+    virtio_blk_handle_interrupts();
+}
+
+static void _virtio_pci_enable_bus_master(device_t* dev)
+{
+    device_desc_t* desc = &dev->device_desc;
+    uint32_t command = pci_read(desc->bus, desc->device, desc->function, PCI_COMMAND) & 0xFFFF;
+    command |= PCI_COMMAND_IO | PCI_COMMAND_BUS_MASTER;
+    pci_write(desc->bus, desc->device, desc->function, PCI_COMMAND, command);
+}
+
+static void _virtio_pci_blk_add_device(device_t* dev)
+{
+    _virtio_pci_enable_bus_master(dev);
+
+    virtio_device_t vdev = { 0 };
+    vdev.ops = &_virtio_pci_ops;
+    vdev.base = dev->device_desc.port_base;
+    vdev.version = 1;
+    vdev.interrupt = dev->device_desc.interrupt & 0xFF;
+
+    int err = virtio_blk_init(dev, &vdev);
+    if (err) {
+        log_error("virtio-pci: can't init block device: %d", err);
+        return;
+    }
+
+    // Without an irq line completions are still picked up by waiters.
+    if (vdev.interrupt < 16 && !_virtio_pci_irq_used[vdev.interrupt]) {
+        _virtio_pci_irq_used[vdev.interrupt] = true;
+        set_irq_handler(IRQ_MASTER_OFFSET + vdev.interrupt, _virtio_pci_int_handler);
+    }
+
+#ifdef DEBUG_VIRTIO_PCI
+    log("virtio-pci: block device at port %x, irq %d", vdev.base, vdev.interrupt);
+#endif
+}
+
+static driver_desc_t _virtio_pci_blk_driver_info()
+{
+    driver_desc_t blk_desc = { 0 };
+    blk_desc.type = DRIVER_STORAGE_DEVICE;
+    blk_desc.auto_start = false;
+    blk_desc.is_device_driver = true;
+    blk_desc.is_device_needed = false;
+    blk_desc.is_driver_needed = false;
+    blk_desc.functions[DRIVER_NOTIFICATION] = 0;
+    blk_desc.functions[DRIVER_STORAGE_ADD_DEVICE] = _virtio_pci_blk_add_device;
+    blk_desc.functions[DRIVER_STORAGE_READ] = virtio_blk_read;
+    blk_desc.functions[DRIVER_STORAGE_WRITE] = virtio_blk_write;
+    blk_desc.functions[DRIVER_STORAGE_FLUSH] = virtio_blk_flush;
+    blk_desc.functions[DRIVER_STORAGE_CAPACITY] = virtio_blk_capacity;
+    blk_desc.functions[DRIVER_STORAGE_SUBMIT] = virtio_blk_submit;
+    blk_desc.functions[DRIVER_STORAGE_POLL] = virtio_blk_poll;
+    blk_desc.functions[DRIVER_STORAGE_MAX_SECTORS] = virtio_blk_max_sectors;
+    blk_desc.pci_serve_class = 0x01;
+    blk_desc.pci_serve_subclass = 0x00;
+    blk_desc.pci_serve_vendor_id = VIRTIO_VENDOR_ID;
+    blk_desc.pci_serve_device_id = VIRTIO_PCI_DEVICE_ID_BLOCK;
+    return blk_desc;
+}
+
+void virtio_pci_blk_install()
+{
+    driver_install(_virtio_pci_blk_driver_info(), "vblk86");
+}
@@ -4,6 +4,7 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <drivers/bio.h>
 #include <fs/vfs.h>
 #include <libkern/bits/errno.h>
 #include <libkern/libkern.h>
@@ -109,42 +110,62 @@ int ext2_rm(dentry_t* dentry);
 
 static void _ext2_read_from_dev(vfs_device_t* dev, uint8_t* buf, uint32_t start, uint32_t len)
 {
-    void (*read)(device_t * d, uint32_t s, uint8_t * r) = dm_function_handler(dev->dev, DRIVER_STORAGE_READ);
-    int already_read = 0;
-    uint32_t sector = start / 512;
-    uint32_t start_offset = start % 512;
-    uint8_t tmp_buf[512];
-
-    while (len) {
-        read(dev->dev, sector, tmp_buf);
-        for (int i = 0; i < min(512 - start_offset, len); i++) {
-            buf[already_read++] = tmp_buf[start_offset + i];
-        }
-        len -= min(512 - start_offset, len);
+    uint32_t sector = start / BLK_SECTOR_SIZE;
+    uint32_t start_offset = start % BLK_SECTOR_SIZE;
+    uint8_t tmp_buf[BLK_SECTOR_SIZE];
+
+    // Unaligned head and tail go through a bounce sector, the rest is read in place.
+    if (start_offset) {
+        uint32_t part = min(BLK_SECTOR_SIZE - start_offset, len);
+        blk_read(dev->dev, sector, 1, tmp_buf);
+        memcpy(buf, tmp_buf + start_offset, part);
+        buf += part;
+        len -= part;
         sector++;
-        start_offset = 0;
+    }
+
+    uint32_t full_sectors = len / BLK_SECTOR_SIZE;
+    if (full_sectors) {
+        blk_read(dev->dev, sector, full_sectors, buf);
+        buf += full_sectors * BLK_SECTOR_SIZE;
+        len -= full_sectors * BLK_SECTOR_SIZE;
+        sector += full_sectors;
+    }
+
+    if (len) {
+        blk_read(dev->dev, sector, 1, tmp_buf);
+        memcpy(buf, tmp_buf, len);
     }
 }
 
 static void _ext2_write_to_dev(vfs_device_t* dev, uint8_t* buf, uint32_t start, uint32_t len)
 {
-    void (*read)(device_t * d, uint32_t s, uint8_t * r) = dm_function_handler(dev->dev, DRIVER_STORAGE_READ);
-    void (*write)(device_t * d, uint32_t s, uint8_t * r, uint32_t siz) = dm_function_handler(dev->dev, DRIVER_STORAGE_WRITE);
-    int already_written = 0;
-    uint32_t sector = start / 512;
-    uint32_t start_offset = start % 512;
-    uint8_t tmp_buf[512];
-    while (len != 0) {
-        if (start_offset != 0 || len < 512) {
-            read(dev->dev, sector, tmp_buf);
-        }
-        for (int i = 0; i < min(512 - start_offset, len); i++) {
-            tmp_buf[start_offset + i] = buf[already_written++];
-        }
-        write(dev->dev, sector, tmp_buf, 512);
-        len -= min(512 - start_offset, len);
+    uint32_t sector = start / BLK_SECTOR_SIZE;
+    uint32_t start_offset = start % BLK_SECTOR_SIZE;
+    uint8_t tmp_buf[BLK_SECTOR_SIZE];
+
+    if (start_offset) {
+        uint32_t part = min(BLK_SECTOR_SIZE - start_offset, len);
+        blk_read(dev->dev, sector, 1, tmp_buf);
+        memcpy(tmp_buf + start_offset, buf, part);
+        blk_write(dev->dev, sector, 1, tmp_buf);
+        buf += part;
+        len -= part;
         sector++;
-        start_offset = 0;
+    }
+
+    uint32_t full_sectors = len / BLK_SECTOR_SIZE;
+    if (full_sectors) {
+        blk_write(dev->dev, sector, full_sectors, buf);
+        buf += full_sectors * BLK_SECTOR_SIZE;
+        len -= full_sectors * BLK_SECTOR_SIZE;
+        sector += full_sectors;
+    }
+
+    if (len) {
+        blk_read(dev->dev, sector, 1, tmp_buf);
+        memcpy(tmp_buf, buf, len);
+        blk_write(dev->dev, sector, 1, tmp_buf);
     }
 }
 
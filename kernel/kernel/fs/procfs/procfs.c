@@ -72,6 +72,24 @@ int procfs_read(dentry_t* dentry, uint8_t* buf, uint32_t start, uint32_t len)
     return procfs_inode->ops->read(dentry, buf, start, len);
 }
 
+int procfs_can_write(dentry_t* dentry, uint32_t start)
+{
+    procfs_inode_t* procfs_inode = (procfs_inode_t*)dentry->inode;
+    if (!procfs_inode->ops->can_write) {
+        return -ENOEXEC;
+    }
+    return procfs_inode->ops->can_write(dentry, start);
+}
+
+int procfs_write(dentry_t* dentry, uint8_t* buf, uint32_t start, uint32_t len)
+{
+    procfs_inode_t* procfs_inode = (procfs_inode_t*)dentry->inode;
+    if (!procfs_inode->ops->write) {
+        return -ENOEXEC;
+    }
+    return procfs_inode->ops->write(dentry, buf, start, len);
+}
+
 int procfs_getdents(dentry_t* dir, uint8_t* buf, uint32_t* offset, uint32_t len)
 {
     procfs_inode_t* procfs_inode = (procfs_inode_t*)dir->inode;
@@ -104,7 +122,8 @@ driver_desc_t _procfs_driver_info()
     fs_desc.functions[DRIVER_FILE_SYSTEM_OPEN] = NULL; /* No custom open, vfs will use its code */
     fs_desc.functions[DRIVER_FILE_SYSTEM_CAN_READ] = procfs_can_read;
     fs_desc.functions[DRIVER_FILE_SYSTEM_READ] = procfs_read;
-    fs_desc.functions[DRIVER_FILE_SYSTEM_WRITE] = NULL;
+    fs_desc.functions[DRIVER_FILE_SYSTEM_CAN_WRITE] = procfs_can_write;
+    fs_desc.functions[DRIVER_FILE_SYSTEM_WRITE] = procfs_write;
     fs_desc.functions[DRIVER_FILE_SYSTEM_TRUNCATE] = NULL;
     fs_desc.functions[DRIVER_FILE_SYSTEM_MKDIR] = NULL;
     fs_desc.functions[DRIVER_FILE_SYSTEM_EJECT_DEVICE] = NULL;
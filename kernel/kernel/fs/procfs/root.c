@@ -8,7 +8,12 @@
 #include <fs/vfs.h>
 #include <libkern/bits/errno.h>
 #include <libkern/libkern.h>
+#include <libkern/log.h>
+#include <libkern/stdarg.h>
+#include <mem/kmalloc.h>
+#include <tasking/profiler.h>
 #include <tasking/sched.h>
+#include <tasking/softirq.h>
 #include <tasking/tasking.h>
 #include <time/time_manager.h>
 
@@ -30,6 +35,16 @@ static bool procfs_root_uptime_can_read(dentry_t* dentry, uint32_t start);
 static int procfs_root_uptime_read(dentry_t* dentry, uint8_t* buf, uint32_t start, uint32_t len);
 static bool procfs_root_stat_can_read(dentry_t* dentry, uint32_t start);
 static int procfs_root_stat_read(dentry_t* dentry, uint8_t* buf, uint32_t start, uint32_t len);
+static bool procfs_root_interrupts_can_read(dentry_t* dentry, uint32_t start);
+static int procfs_root_interrupts_read(dentry_t* dentry, uint8_t* buf, uint32_t start, uint32_t len);
+static bool procfs_root_softirqs_can_read(dentry_t* dentry, uint32_t start);
+static int procfs_root_softirqs_read(dentry_t* dentry, uint8_t* buf, uint32_t start, uint32_t len);
+static bool procfs_root_profile_can_read(dentry_t* dentry, uint32_t start);
+static int procfs_root_profile_read(dentry_t* dentry, uint8_t* buf, uint32_t start, uint32_t len);
+static bool procfs_root_profile_can_write(dentry_t* dentry, uint32_t start);
+static int procfs_root_profile_write(dentry_t* dentry, uint8_t* buf, uint32_t start, uint32_t len);
+static bool procfs_root_profile_dropped_can_read(dentry_t* dentry, uint32_t start);
+static int procfs_root_profile_dropped_read(dentry_t* dentry, uint8_t* buf, uint32_t start, uint32_t len);
 
 /**
  * DATA
@@ -50,9 +65,35 @@ const file_ops_t procfs_root_stat_ops = {
     .read = procfs_root_stat_read,
 };
 
+const file_ops_t procfs_root_interrupts_ops = {
+    .can_read = procfs_root_interrupts_can_read,
+    .read = procfs_root_interrupts_read,
+};
+
+const file_ops_t procfs_root_softirqs_ops = {
+    .can_read = procfs_root_softirqs_can_read,
+    .read = procfs_root_softirqs_read,
+};
+
+const file_ops_t procfs_root_profile_ops = {
+    .can_read = procfs_root_profile_can_read,
+    .read = procfs_root_profile_read,
+    .can_write = procfs_root_profile_can_write,
+    .write = procfs_root_profile_write,
+};
+
+const file_ops_t procfs_root_profile_dropped_ops = {
+    .can_read = procfs_root_profile_dropped_can_read,
+    .read = procfs_root_profile_dropped_read,
+};
+
 static const procfs_files_t static_procfs_files[] = {
     { .name = "stat", .mode = 0, .ops = &procfs_root_stat_ops },
     { .name = "uptime", .mode = 0, .ops = &procfs_root_uptime_ops },
+    { .name = "interrupts", .mode = 0, .ops = &procfs_root_interrupts_ops },
+    { .name = "softirqs", .mode = 0, .ops = &procfs_root_softirqs_ops },
+    { .name = "profile", .mode = 0, .ops = &procfs_root_profile_ops },
+    { .name = "profile_dropped", .mode = 0, .ops = &procfs_root_profile_dropped_ops },
 };
 #define PROCFS_STATIC_FILES_COUNT_AT_LEVEL (sizeof(static_procfs_files) / sizeof(procfs_files_t))
 
@@ -75,6 +116,24 @@ static uint32_t procfs_root_pid_get_inode_index(int procid)
     return procfs_get_inode_index(PROCFS_ROOT_LEVEL, procid + PROCFS_STATIC_FILES_COUNT_AT_LEVEL);
 }
 
+/**
+ * Copies the part of @res which starts at @start, so files which do
+ * not fit into one read can be read in chunks.
+ */
+static int procfs_root_copy_from(const char* res, size_t size, uint8_t* buf, uint32_t start, uint32_t len)
+{
+    if (start >= size) {
+        return 0;
+    }
+
+    size_t to_copy = size - start;
+    if (to_copy > len) {
+        to_copy = len;
+    }
+    memcpy(buf, res + start, to_copy);
+    return to_copy;
+}
+
 /**
  * ROOT
  */
@@ -236,4 +295,161 @@ static int procfs_root_stat_read(dentry_t* dentry, uint8_t* buf, uint32_t start,
 
     memcpy(buf, res, size);
     return size;
+}
+
+/**
+ * Every line is "IRQ COUNT TIME" repeated for each cpu, where TIME is
+ * spent in the hard handler and measured in timestamp counter units.
+ * Lines which have never fired are skipped.
+ */
+#define PROCFS_ROOT_STAT_BUF_SIZE 4096
+#define PROCFS_ROOT_STAT_LINE_MAX 160
+
+static void procfs_root_append(char* res, size_t* offset, const char* format, ...)
+{
+    va_list arg;
+    va_start(arg, format);
+    vsnprintf(res + *offset, PROCFS_ROOT_STAT_BUF_SIZE - *offset, format, arg);
+    va_end(arg);
+    *offset += strlen(res + *offset);
+}
+
+static bool procfs_root_interrupts_can_read(dentry_t* dentry, uint32_t start)
+{
+    return true;
+}
+
+static int procfs_root_interrupts_read(dentry_t* dentry, uint8_t* buf, uint32_t start, uint32_t len)
+{
+    char* res = kmalloc(PROCFS_ROOT_STAT_BUF_SIZE);
+    if (!res) {
+        return -ENOMEM;
+    }
+
+    int cpus_count = active_cpu_count();
+    size_t offset = 0;
+    for (int line = 0; line < IRQ_STAT_LINES; line++) {
+        uint32_t total = 0;
+        for (int i = 0; i < cpus_count; i++) {
+            total += cpu_irq_stats[i].lines[line].count;
+        }
+        if (!total) {
+            continue;
+        }
+        if (offset + PROCFS_ROOT_STAT_LINE_MAX > PROCFS_ROOT_STAT_BUF_SIZE) {
+            break;
+        }
+
+        procfs_root_append(res, &offset, "%d", line);
+        for (int i = 0; i < cpus_count; i++) {
+            irq_stat_t* stat = &cpu_irq_stats[i].lines[line];
+            procfs_root_append(res, &offset, " %u %lu", stat->count, stat->time);
+        }
+        procfs_root_append(res, &offset, "\n");
+    }
+
+    int read = procfs_root_copy_from(res, offset, buf, start, len);
+    kfree(res);
+    return read;
+}
+
+/**
+ * Same layout as interrupts, keyed by the name of the bottom half.
+ * UNBLOCK accounts the scheduler waking up blocked threads.
+ */
+static bool procfs_root_softirqs_can_read(dentry_t* dentry, uint32_t start)
+{
+    return true;
+}
+
+static int procfs_root_softirqs_read(dentry_t* dentry, uint8_t* buf, uint32_t start, uint32_t len)
+{
+    static const char* names[SOFTIRQ_COUNT] = {
+        [SOFTIRQ_KEYBOARD] = "KEYBOARD",
+        [SOFTIRQ_MOUSE] = "MOUSE",
+        [SOFTIRQ_BLOCK] = "BLOCK",
+    };
+
+    char* res = kmalloc(PROCFS_ROOT_STAT_BUF_SIZE);
+    if (!res) {
+        return -ENOMEM;
+    }
+
+    int cpus_count = active_cpu_count();
+    size_t offset = 0;
+    for (int vec = 0; vec < SOFTIRQ_COUNT; vec++) {
+        procfs_root_append(res, &offset, "%s", names[vec]);
+        for (int i = 0; i < cpus_count; i++) {
+            irq_stat_t* stat = &cpu_irq_stats[i].softirqs[vec];
+            procfs_root_append(res, &offset, " %u %lu", stat->count, stat->time);
+        }
+        procfs_root_append(res, &offset, "\n");
+    }
+
+    procfs_root_append(res, &offset, "UNBLOCK");
+    for (int i = 0; i < cpus_count; i++) {
+        procfs_root_append(res, &offset, " %u %lu", cpus[i].stat_unblock_calls, cpus[i].stat_unblock_time);
+    }
+    procfs_root_append(res, &offset, "\n");
+
+    int read = procfs_root_copy_from(res, offset, buf, start, len);
+    kfree(res);
+    return read;
+}
+
+/**
+ * Writing "1" clears the sample rings and starts the profiler, "0"
+ * stops it. Reads drain whole profile_sample_t records. While the
+ * profiler runs, a read blocks until a ring is half full, the rest
+ * can be read after it is stopped. profile_dropped holds the number of
+ * samples lost to full rings since the last start.
+ */
+static bool procfs_root_profile_can_read(dentry_t* dentry, uint32_t start)
+{
+    return profiler_can_read();
+}
+
+static int procfs_root_profile_read(dentry_t* dentry, uint8_t* buf, uint32_t start, uint32_t len)
+{
+    return profiler_read(buf, len);
+}
+
+static bool procfs_root_profile_can_write(dentry_t* dentry, uint32_t start)
+{
+    return true;
+}
+
+static bool procfs_root_profile_dropped_can_read(dentry_t* dentry, uint32_t start)
+{
+    return true;
+}
+
+static int procfs_root_profile_dropped_read(dentry_t* dentry, uint8_t* buf, uint32_t start, uint32_t len)
+{
+    char res[16];
+    snprintf(res, sizeof(res), "%u\n", profiler_dropped());
+    return procfs_root_copy_from(res, strlen(res), buf, start, len);
+}
+
+static int procfs_root_profile_write(dentry_t* dentry, uint8_t* buf, uint32_t start, uint32_t len)
+{
+    if (!len) {
+        return 0;
+    }
+
+    switch (buf[0]) {
+    case '1': {
+        int err = profiler_start();
+        if (err) {
+            return err;
+        }
+        break;
+    }
+    case '0':
+        profiler_stop();
+        break;
+    default:
+        return -EINVAL;
+    }
+    return len;
 }
\ No newline at end of file
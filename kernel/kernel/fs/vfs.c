@@ -6,6 +6,7 @@
 
 #include <algo/dynamic_array.h>
 #include <fs/vfs.h>
+#include <io/epoll/epoll.h>
 #include <io/sockets/socket.h>
 #include <libkern/bits/errno.h>
 #include <libkern/libkern.h>
@@ -240,6 +241,8 @@ static int _int_vfs_do_close(file_descriptor_t* fd)
 {
     if (fd->type == FD_TYPE_FILE) {
         dentry_put(fd->dentry);
+    } else if (fd->type == FD_TYPE_EPOLL) {
+        epoll_put(fd->epoll);
     } else {
         socket_put(fd->sock_entry);
     }
@@ -607,15 +610,13 @@ proc_zone_t* vfs_mmap(file_descriptor_t* fd, mmap_params_t* params)
 
 int vfs_munmap(proc_t* p, proc_zone_t* zone)
 {
-    if (!(zone->flags & ZONE_TYPE_MAPPED_FILE_PRIVATLY) && !(zone->flags & ZONE_TYPE_MAPPED_FILE_SHAREDLY)) {
+    if (!(zone->type & ZONE_TYPE_MAPPED_FILE_PRIVATLY) && !(zone->type & ZONE_TYPE_MAPPED_FILE_SHAREDLY)) {
         return -EFAULT;
     }
 
     dentry_put(zone->file);
 
-    for (uint32_t vaddr = zone->start; vaddr < zone->start + zone->len + 1; vaddr += VMM_PAGE_SIZE) {
-        system_flush_tlb_entry(vaddr);
-    }
+    vmm_free_pages(zone->start, (zone->len + VMM_PAGE_SIZE - 1) / VMM_PAGE_SIZE, &p->zones);
     proc_delete_zone(p, zone);
 
     return 0;
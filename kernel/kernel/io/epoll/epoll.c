@@ -0,0 +1,201 @@
+/*
+ * Copyright (c) 2021, Krisna Pranav
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <io/epoll/epoll.h>
+#include <libkern/bits/errno.h>
+#include <libkern/libkern.h>
+#include <libkern/log.h>
+#include <mem/kmalloc.h>
+#include <tasking/proc.h>
+
+uint32_t epoll_generation = 0;
+
+static bool _epoll_fd_can_read(dentry_t* dentry, uint32_t start)
+{
+    return true;
+}
+
+static int _epoll_fd_read(dentry_t* dentry, uint8_t* buf, uint32_t start, uint32_t len)
+{
+    return -EINVAL;
+}
+
+static int _epoll_fd_write(dentry_t* dentry, uint8_t* buf, uint32_t start, uint32_t len)
+{
+    return -EINVAL;
+}
+
+static file_ops_t epoll_fd_ops = {
+    .can_read = _epoll_fd_can_read,
+    .can_write = _epoll_fd_can_read,
+    .read = _epoll_fd_read,
+    .write = _epoll_fd_write,
+};
+
+int epoll_create(file_descriptor_t* fd)
+{
+    epoll_t* ep = kmalloc(sizeof(epoll_t));
+    if (!ep) {
+        return -ENOMEM;
+    }
+
+    memset((void*)ep, 0, sizeof(epoll_t));
+    ep->d_count = 1;
+    lock_init(&ep->lock);
+
+    fd->type = FD_TYPE_EPOLL;
+    fd->epoll = ep;
+    fd->offset = 0;
+    fd->flags = 0;
+    fd->ops = &epoll_fd_ops;
+    lock_init(&fd->lock);
+    return 0;
+}
+
+epoll_t* epoll_duplicate(epoll_t* ep)
+{
+    lock_acquire(&ep->lock);
+    ep->d_count++;
+    lock_release(&ep->lock);
+    return ep;
+}
+
+int epoll_put(epoll_t* ep)
+{
+    lock_acquire(&ep->lock);
+    ep->d_count--;
+    if (ep->d_count == 0) {
+        lock_release(&ep->lock);
+        kfree(ep);
+        return 0;
+    }
+    lock_release(&ep->lock);
+    return 0;
+}
+
+static epoll_item_t* _epoll_find_item(epoll_t* ep, int fd)
+{
+    for (int i = 0; i < ep->items_count; i++) {
+        if (ep->items[i].fd == fd) {
+            return &ep->items[i];
+        }
+    }
+    return NULL;
+}
+
+int epoll_ctl(epoll_t* ep, int op, int fd, epoll_event_t* event)
+{
+    lock_acquire(&ep->lock);
+    epoll_item_t* item = _epoll_find_item(ep, fd);
+    int res = 0;
+
+    switch (op) {
+    case EPOLL_CTL_ADD:
+        if (item) {
+            res = -EEXIST;
+            break;
+        }
+        if (ep->items_count == EPOLL_MAX_ITEMS) {
+            res = -ENOSPC;
+            break;
+        }
+        item = &ep->items[ep->items_count++];
+        item->fd = fd;
+        item->events = event->events;
+        item->data = event->data;
+        item->reported = 0;
+        break;
+
+    case EPOLL_CTL_MOD:
+        if (!item) {
+            res = -ENOENT;
+            break;
+        }
+        item->events = event->events;
+        item->data = event->data;
+        item->reported = 0;
+        break;
+
+    case EPOLL_CTL_DEL:
+        if (!item) {
+            res = -ENOENT;
+            break;
+        }
+        *item = ep->items[--ep->items_count];
+        break;
+
+    default:
+        res = -EINVAL;
+    }
+
+    lock_release(&ep->lock);
+    return res;
+}
+
+static uint32_t _epoll_fd_ready(file_descriptor_t* fd)
+{
+    uint32_t res = 0;
+    if (fd->ops->can_read && fd->ops->can_read(fd->dentry, fd->offset)) {
+        res |= EPOLLIN;
+    }
+    if (fd->ops->can_write && fd->ops->can_write(fd->dentry, fd->offset)) {
+        res |= EPOLLOUT;
+    }
+    return res;
+}
+
+/**
+ * Fills up @events with ready items. With @consume unset, the function
+ * only checks if there is something to report, so it could be used by
+ * blockers without eating edges.
+ */
+int epoll_collect(proc_t* p, epoll_t* ep, epoll_event_t* events, int maxevents, bool consume)
+{
+    int cnt = 0;
+    lock_acquire(&ep->lock);
+    for (int i = 0; i < ep->items_count && cnt < maxevents; i++) {
+        epoll_item_t* item = &ep->items[i];
+        file_descriptor_t* fd = proc_get_fd(p, item->fd);
+
+        uint32_t ready = EPOLLHUP;
+        if (fd) {
+            ready = _epoll_fd_ready(fd) & item->events;
+        }
+
+        if (item->events & EPOLLET) {
+            // An edge is rearmed as soon as the fd is seen not ready, even
+            // by a check, otherwise the next rise could be missed.
+            item->reported &= ready;
+            uint32_t fresh = ready & ~item->reported;
+            if (consume) {
+                item->reported = ready;
+            }
+            ready = fresh;
+        }
+
+        if (!ready) {
+            continue;
+        }
+
+        if (events) {
+            events[cnt].events = ready;
+            events[cnt].data = item->data;
+        }
+        cnt++;
+
+        if (consume && (item->events & EPOLLONESHOT)) {
+            item->events &= ~(EPOLLIN | EPOLLOUT);
+        }
+
+        // Closed fds are reported once and then forgotten.
+        if (consume && !fd) {
+            *item = ep->items[--ep->items_count];
+            i--;
+        }
+    }
+    lock_release(&ep->lock);
+    return cnt;
+}
@@ -4,10 +4,12 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <io/epoll/epoll.h>
 #include <io/sockets/local_socket.h>
 #include <libkern/bits/errno.h>
 #include <libkern/libkern.h>
 #include <libkern/log.h>
+#include <libkern/trace.h>
 #include <mem/kmalloc.h>
 #include <tasking/proc.h>
 #include <tasking/tasking.h>
@@ -62,6 +64,8 @@ int local_socket_write(dentry_t* dentry, uint8_t* buf, uint32_t start, uint32_t
 {
     socket_t* sock_entry = (socket_t*)dentry;
     uint32_t written = sync_ringbuffer_write_ignore_bounds(&sock_entry->buffer, buf, len);
+    TRACE(TRACE_IPC_SEND, len, written, 0, 0);
+    epoll_notify();
     return 0;
 }
 
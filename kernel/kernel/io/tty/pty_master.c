@@ -5,6 +5,7 @@
  */
 
 #include <fs/vfs.h>
+#include <io/epoll/epoll.h>
 #include <io/tty/pty_master.h>
 #include <io/tty/pty_slave.h>
 #include <libkern/bits/errno.h>
@@ -86,27 +87,25 @@ bool pty_master_can_write(dentry_t* dentry, uint32_t start)
 {
     pty_master_entry_t* ptm = _ptm_get(dentry);
     ASSERT(ptm);
-    return sync_ringbuffer_space_to_write(&ptm->pts->buffer) >= 0;
+    return sync_ringbuffer_space_to_write(&ptm->pts->buffer) > 0;
 }
 
 int pty_master_read(dentry_t* dentry, uint8_t* buf, uint32_t start, uint32_t len)
 {
     pty_master_entry_t* ptm = _ptm_get(dentry);
     ASSERT(ptm);
-    uint32_t leno = sync_ringbuffer_space_to_read(&ptm->buffer);
-    if (leno > len) {
-        leno = len;
-    }
-    int res = sync_ringbuffer_read(&ptm->buffer, buf, leno);
-    return leno;
+    int res = sync_ringbuffer_read(&ptm->buffer, buf, len);
+    epoll_notify();
+    return res;
 }
 
 int pty_master_write(dentry_t* dentry, uint8_t* buf, uint32_t start, uint32_t len)
 {
     pty_master_entry_t* ptm = _ptm_get(dentry);
     ASSERT(ptm);
-    sync_ringbuffer_write(&ptm->pts->buffer, buf, len);
-    return len;
+    int res = sync_ringbuffer_write(&ptm->pts->buffer, buf, len);
+    epoll_notify();
+    return res;
 }
 
 int pty_master_fstat(dentry_t* dentry, fstat_t* stat)
@@ -5,6 +5,7 @@
  */
 
 #include <fs/devfs/devfs.h>
+#include <io/epoll/epoll.h>
 #include <io/tty/pty_master.h>
 #include <io/tty/pty_slave.h>
 #include <libkern/libkern.h>
@@ -33,27 +34,25 @@ bool pty_slave_can_write(dentry_t* dentry, uint32_t start)
 {
     pty_slave_entry_t* pts = _pts_get(dentry);
     ASSERT(pts);
-    return sync_ringbuffer_space_to_write(&pts->ptm->buffer) >= 0;
+    return sync_ringbuffer_space_to_write(&pts->ptm->buffer) > 0;
 }
 
 int pty_slave_read(dentry_t* dentry, uint8_t* buf, uint32_t start, uint32_t len)
 {
     pty_slave_entry_t* pts = _pts_get(dentry);
     ASSERT(pts);
-    uint32_t leno = sync_ringbuffer_space_to_read(&pts->buffer);
-    if (leno > len) {
-        leno = len;
-    }
-    int res = sync_ringbuffer_read(&pts->buffer, buf, leno);
-    return leno;
+    int res = sync_ringbuffer_read(&pts->buffer, buf, len);
+    epoll_notify();
+    return res;
 }
 
 int pty_slave_write(dentry_t* dentry, uint8_t* buf, uint32_t start, uint32_t len)
 {
     pty_slave_entry_t* pts = _pts_get(dentry);
     ASSERT(pts);
-    sync_ringbuffer_write(&pts->ptm->buffer, buf, len);
-    return len;
+    int res = sync_ringbuffer_write(&pts->ptm->buffer, buf, len);
+    epoll_notify();
+    return res;
 }
 
 int pty_slave_ioctl(dentry_t* dentry, uint32_t cmd, uint32_t arg)
@@ -7,6 +7,7 @@
 #include <drivers/x86/keyboard.h>
 #include <fs/devfs/devfs.h>
 #include <fs/vfs.h>
+#include <io/epoll/epoll.h>
 #include <io/tty/tty.h>
 #include <libkern/bits/errno.h>
 #include <libkern/libkern.h>
@@ -64,11 +65,11 @@ int tty_read(dentry_t* dentry, uint8_t* buf, uint32_t start, uint32_t len)
     if (leno > len) {
         leno = len;
     }
-    int res = sync_ringbuffer_read(&tty->buffer, buf, leno);
+    uint32_t res = sync_ringbuffer_read(&tty->buffer, buf, leno);
     if (tty->termios.c_lflag & ICANON && res == leno) {
         tty->lines_avail--;
     }
-    return leno;
+    return res;
 }
 
 int _tty_process_esc_seq(uint8_t* buf)
@@ -227,12 +228,11 @@ void tty_eat_key(key_t key)
         sync_ringbuffer_write_one(&tty->buffer, '\n');
         tty->lines_avail++;
     } else if (key == KEY_BACKSPACE) {
-        if (sync_ringbuffer_space_to_read(&tty->buffer) > 0) {
-            // delete_char(WHITE_ON_BLACK, -1, -1, 1);
-            tty->buffer.ringbuffer.end--;
-        }
+        // delete_char(WHITE_ON_BLACK, -1, -1, 1);
+        sync_ringbuffer_unwrite_one(&tty->buffer);
     } else {
         sync_ringbuffer_write_one(&tty->buffer, (char)key);
         _tty_echo_key(tty, key);
     }
+    epoll_notify();
 }
\ No newline at end of file
@@ -10,6 +10,7 @@
 
 #include <libkern/types.h>
 
+#include <drivers/bio.h>
 #include <drivers/driver_manager.h>
 
 #include <mem/kmalloc.h>
@@ -29,6 +30,7 @@
 #include <tasking/sched.h>
 
 #include <libkern/log.h>
+#include <libkern/trace.h>
 
 #include <syscalls/handlers.h>
 
@@ -51,6 +53,7 @@ static inline void wait_for_boot_cpu_to_finish(int* wt)
 void launching()
 {
     tasking_run_kernel_thread(dentry_flusher, NULL);
+    tasking_run_kernel_thread(blk_worker, NULL);
     tasking_start_init_proc();
     ksys1(SYS_EXIT, 0);
 }
@@ -89,6 +92,9 @@ void stage3(mem_desc_t* mem_desc)
     // pty
     ptmx_install();
 
+    // tracing
+    trace_install();
+
     // init scheduling
     tasking_init();
     scheduler_init();
@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) 2021, Krisna Pranav
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <fs/devfs/devfs.h>
+#include <fs/vfs.h>
+#include <libkern/atomic.h>
+#include <libkern/bits/errno.h>
+#include <libkern/bits/sys/ioctls.h>
+#include <libkern/libkern.h>
+#include <libkern/lock.h>
+#include <libkern/trace.h>
+#include <mem/kmalloc.h>
+#include <platform/generic/system.h>
+#include <tasking/cpu.h>
+
+/**
+ * Every cpu writes only to its own ring with interrupts off, so the
+ * producer side takes no locks. Readers serialize among themselves
+ * with read_lock and publish consumed space through tail.
+ */
+struct trace_ring {
+    trace_event_t* events;
+    uint32_t head;
+    uint32_t tail;
+    uint32_t stat_dropped;
+};
+typedef struct trace_ring trace_ring_t;
+
+volatile uint32_t trace_enabled_mask = 0;
+static trace_ring_t _trace_rings[CPU_CNT];
+static lock_t _trace_read_lock;
+
+void trace_emit(uint32_t id, uint32_t a0, uint32_t a1, uint32_t a2, uint32_t a3)
+{
+    system_disable_interrupts();
+    trace_ring_t* ring = &_trace_rings[system_cpu_id()];
+    if (unlikely(!ring->events)) {
+        system_enable_interrupts();
+        return;
+    }
+
+    uint32_t head = ring->head;
+    if (head - atomic_load_acquire(&ring->tail) == TRACE_RING_EVENTS) {
+        ring->stat_dropped++;
+        system_enable_interrupts();
+        return;
+    }
+
+    trace_event_t* event = &ring->events[head & (TRACE_RING_EVENTS - 1)];
+    event->time = system_read_timestamp();
+    event->id = id;
+    event->cpu = system_cpu_id();
+    event->tid = RUNNING_THREAD ? RUNNING_THREAD->tid : 0;
+    event->args[0] = a0;
+    event->args[1] = a1;
+    event->args[2] = a2;
+    event->args[3] = a3;
+    atomic_store_release(&ring->head, head + 1);
+    system_enable_interrupts();
+}
+
+static int _trace_alloc_rings()
+{
+    for (int i = 0; i < CPU_CNT; i++) {
+        if (_trace_rings[i].events) {
+            continue;
+        }
+        trace_event_t* events = kmalloc(TRACE_RING_EVENTS * sizeof(trace_event_t));
+        if (!events) {
+            return -ENOMEM;
+        }
+        _trace_rings[i].head = _trace_rings[i].tail = 0;
+        atomic_store_release(&_trace_rings[i].events, events);
+    }
+    return 0;
+}
+
+/**
+ * DEVFS
+ */
+
+static bool _trace_can_read(dentry_t* dentry, uint32_t start)
+{
+    return true;
+}
+
+/**
+ * Moves whole records out of the rings, cpu by cpu. Records of one cpu
+ * come in order, the reader merges cpus by time.
+ */
+static int _trace_read(dentry_t* dentry, uint8_t* buf, uint32_t start, uint32_t len)
+{
+    uint32_t want = len / sizeof(trace_event_t);
+    uint32_t read = 0;
+
+    lock_acquire(&_trace_read_lock);
+    for (int i = 0; i < CPU_CNT && read < want; i++) {
+        trace_ring_t* ring = &_trace_rings[i];
+        if (!ring->events) {
+            continue;
+        }
+
+        uint32_t tail = ring->tail;
+        uint32_t head = atomic_load_acquire(&ring->head);
+        while (tail != head && read < want) {
+            memcpy(buf + read * sizeof(trace_event_t), &ring->events[tail & (TRACE_RING_EVENTS - 1)], sizeof(trace_event_t));
+            tail++;
+            read++;
+        }
+        atomic_store_release(&ring->tail, tail);
+    }
+    lock_release(&_trace_read_lock);
+
+    return read * sizeof(trace_event_t);
+}
+
+static int _trace_ioctl(dentry_t* dentry, uint32_t cmd, uint32_t arg)
+{
+    switch (cmd) {
+    case TRACE_SET_MASK: {
+        int err = _trace_alloc_rings();
+        if (err) {
+            return err;
+        }
+        trace_enabled_mask = arg & ((1 << TRACEPOINTS_COUNT) - 1);
+        return 0;
+    }
+    case TRACE_GET_MASK: {
+        uint32_t mask = trace_enabled_mask;
+        memcpy((void*)arg, &mask, sizeof(uint32_t));
+        return 0;
+    }
+    default:
+        return -EINVAL;
+    }
+}
+
+int trace_install()
+{
+    lock_init(&_trace_read_lock);
+
+    dentry_t* mp;
+    if (vfs_resolve_path("/dev", &mp) < 0) {
+        return -1;
+    }
+
+    file_ops_t fops = { 0 };
+    fops.can_read = _trace_can_read;
+    fops.read = _trace_read;
+    fops.ioctl = _trace_ioctl;
+    devfs_inode_t* res = devfs_register(mp, MKDEV(10, 2), "trace", 5, 0, &fops);
+    dentry_put(mp);
+    return res ? 0 : -1;
+}
\ No newline at end of file
@@ -0,0 +1,170 @@
+/*
+ * Copyright (c) 2021, Krisna Pranav
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <libkern/libkern.h>
+#include <mem/vmm/tlb.h>
+#include <mem/vmm/vmm.h>
+#include <platform/generic/cpu.h>
+#include <platform/generic/system.h>
+
+/**
+ * TLB SHOOTDOWN
+ *
+ * vmm collects invalidations of an operation into a batch of the current cpu.
+ * They are applied locally right away, and when the operation is finished the
+ * batch is posted to cpus which could cache the translations: cpus with the
+ * same pdir for user addresses and all online cpus for kernel ones.
+ * Every target gets a single IPI per batch, and the sender waits until
+ * every target acks it.
+ *
+ * Cpus run the kernel with interrupts disabled, so a target could be unable to
+ * take the IPI while spinning on a lock of the sender or waiting for its own
+ * shootdown. Spinning and waiting cpus serve their mailboxes to cover that.
+ */
+
+static tlb_batch_t _tlb_batches[CPU_CNT];
+static tlb_mailbox_t _tlb_mailboxes[CPU_CNT];
+static uint32_t _tlb_online_cpus = 0;
+
+void tlb_setup_cpu()
+{
+    int id = system_cpu_id();
+    lock_init(&_tlb_mailboxes[id].lock);
+    tlb_platform_setup_cpu();
+    __atomic_or_fetch(&_tlb_online_cpus, (1 << id), __ATOMIC_RELEASE);
+}
+
+static inline void _tlb_batch_attach(tlb_batch_t* batch, uint32_t vaddr)
+{
+    // A batch could touch several pdirs (e.g. vmm_copy_to_pdir), it is sent to everybody then.
+    if (vmm_is_kernel_address(vaddr) || (batch->pdir && batch->pdir != THIS_CPU->pdir)) {
+        batch->broadcast = true;
+    }
+    batch->pdir = THIS_CPU->pdir;
+}
+
+void tlb_invalidate_page(uint32_t vaddr)
+{
+    system_flush_tlb_entry(vaddr);
+
+    tlb_batch_t* batch = &_tlb_batches[system_cpu_id()];
+    _tlb_batch_attach(batch, vaddr);
+    if (batch->flush_all) {
+        return;
+    }
+    if (batch->count == TLB_BATCH_MAX) {
+        batch->flush_all = true;
+        return;
+    }
+    batch->vaddrs[batch->count++] = vaddr;
+}
+
+void tlb_invalidate_all()
+{
+    system_flush_whole_tlb();
+
+    tlb_batch_t* batch = &_tlb_batches[system_cpu_id()];
+    _tlb_batch_attach(batch, 0);
+    batch->flush_all = true;
+}
+
+static uint32_t _tlb_post(int cpu_id, tlb_batch_t* batch)
+{
+    tlb_mailbox_t* mailbox = &_tlb_mailboxes[cpu_id];
+    lock_acquire_no_serve(&mailbox->lock);
+    if (batch->flush_all || mailbox->count + batch->count > TLB_BATCH_MAX) {
+        mailbox->flush_all = true;
+    } else {
+        memcpy(&mailbox->vaddrs[mailbox->count], batch->vaddrs, batch->count * sizeof(uint32_t));
+        mailbox->count += batch->count;
+    }
+    uint32_t gen = ++mailbox->requested;
+    lock_release(&mailbox->lock);
+
+    tlb_platform_send_ipi(cpu_id);
+    return gen;
+}
+
+/**
+ * A target which has switched to another pdir has flushed its TLB already, so
+ * it is not waited for in case of a user batch.
+ */
+static void _tlb_wait(int cpu_id, uint32_t gen, tlb_batch_t* batch)
+{
+    tlb_mailbox_t* mailbox = &_tlb_mailboxes[cpu_id];
+    while ((int)(__atomic_load_n(&mailbox->done, __ATOMIC_ACQUIRE) - gen) < 0) {
+        if (!batch->broadcast && __atomic_load_n(&cpus[cpu_id].pdir, __ATOMIC_ACQUIRE) != batch->pdir) {
+            return;
+        }
+        tlb_serve_pending();
+    }
+}
+
+void tlb_shootdown()
+{
+    system_disable_interrupts();
+    int id = system_cpu_id();
+    tlb_batch_t* batch = &_tlb_batches[id];
+    if (!batch->pdir && !batch->broadcast) {
+        system_enable_interrupts();
+        return;
+    }
+
+    uint32_t gens[CPU_CNT];
+    uint32_t targets = 0;
+    uint32_t online = __atomic_load_n(&_tlb_online_cpus, __ATOMIC_ACQUIRE);
+    for (int cpu_id = 0; cpu_id < CPU_CNT; cpu_id++) {
+        if (cpu_id == id || !(online & (1 << cpu_id))) {
+            continue;
+        }
+        if (!batch->broadcast && cpus[cpu_id].pdir != batch->pdir) {
+            continue;
+        }
+        gens[cpu_id] = _tlb_post(cpu_id, batch);
+        targets |= (1 << cpu_id);
+    }
+
+    for (int cpu_id = 0; cpu_id < CPU_CNT; cpu_id++) {
+        if (targets & (1 << cpu_id)) {
+            _tlb_wait(cpu_id, gens[cpu_id], batch);
+        }
+    }
+
+    batch->pdir = NULL;
+    batch->flush_all = false;
+    batch->broadcast = false;
+    batch->count = 0;
+    system_enable_interrupts();
+}
+
+void tlb_shootdown_handler()
+{
+    tlb_mailbox_t* mailbox = &_tlb_mailboxes[system_cpu_id()];
+    lock_acquire_no_serve(&mailbox->lock);
+    if (mailbox->flush_all) {
+        system_flush_whole_tlb();
+    } else {
+        for (uint32_t i = 0; i < mailbox->count; i++) {
+            system_flush_tlb_entry(mailbox->vaddrs[i]);
+        }
+    }
+    mailbox->flush_all = false;
+    mailbox->count = 0;
+    __atomic_store_n(&mailbox->done, mailbox->requested, __ATOMIC_RELEASE);
+    lock_release(&mailbox->lock);
+}
+
+void tlb_serve_pending()
+{
+    if (!__atomic_load_n(&_tlb_online_cpus, __ATOMIC_ACQUIRE)) {
+        return;
+    }
+
+    tlb_mailbox_t* mailbox = &_tlb_mailboxes[system_cpu_id()];
+    if (__atomic_load_n(&mailbox->requested, __ATOMIC_ACQUIRE) != __atomic_load_n(&mailbox->done, __ATOMIC_ACQUIRE)) {
+        tlb_shootdown_handler();
+    }
+}
@@ -8,7 +8,9 @@
 #include <libkern/libkern.h>
 #include <libkern/lock.h>
 #include <libkern/log.h>
+#include <libkern/trace.h>
 #include <mem/kmalloc.h>
+#include <mem/vmm/tlb.h>
 #include <mem/vmm/vmm.h>
 #include <mem/vmm/zoner.h>
 #include <platform/generic/cpu.h>
@@ -25,11 +27,64 @@
 #define PDIR_SIZE sizeof(pdirectory_t)
 #define PTABLE_SIZE sizeof(ptable_t)
 #define IS_INDIVIDUAL_PER_DIR(index) (index < VMM_KERNEL_TABLES_START || (index == VMM_OFFSET_IN_DIRECTORY(pspace_zone.start)))
+#define VMM_LARGE_PAGES_PER_GROUP (VMM_LARGE_ZONE_ALIGNMENT / VMM_LARGE_PAGE_SIZE)
 
 static pdir_t* _vmm_kernel_pdir;
 static lock_t _vmm_lock;
 static zone_t pspace_zone;
 static uint32_t kernel_ptables_start_paddr = 0x0;
+static uint16_t* _vmm_frame_refs;
+
+#define VMM_RETIRED_FRAMES_MAX 64
+
+/**
+ * Frames of unmapped pages could still be cached in TLBs of other cpus,
+ * so they are given back to pmm only after a shootdown is acked.
+ */
+struct vmm_retired_frames {
+    uint32_t count;
+    uint32_t frames[VMM_RETIRED_FRAMES_MAX];
+};
+typedef struct vmm_retired_frames vmm_retired_frames_t;
+static vmm_retired_frames_t _vmm_retired_frames[CPU_CNT];
+
+inline static void _vmm_free_page_paddr(uint32_t addr);
+
+static void _vmm_free_retired_frames_lockless(vmm_retired_frames_t* retired)
+{
+    for (uint32_t i = 0; i < retired->count; i++) {
+        _vmm_free_page_paddr(retired->frames[i]);
+    }
+    retired->count = 0;
+}
+
+static void _vmm_retire_frame_lockless(uint32_t frame)
+{
+    vmm_retired_frames_t* retired = &_vmm_retired_frames[system_cpu_id()];
+    if (retired->count == VMM_RETIRED_FRAMES_MAX) {
+        tlb_shootdown();
+        _vmm_free_retired_frames_lockless(retired);
+    }
+    retired->frames[retired->count++] = frame;
+}
+
+/**
+ * Invalidations are collected while the lock is held and are sent to
+ * other cpus after it's released, see tlb.c. pmm is guarded by the lock,
+ * so it's taken again to free retired frames.
+ */
+static ALWAYS_INLINE void _vmm_lock_release()
+{
+    lock_release(&_vmm_lock);
+    tlb_shootdown();
+
+    vmm_retired_frames_t* retired = &_vmm_retired_frames[system_cpu_id()];
+    if (retired->count) {
+        lock_acquire(&_vmm_lock);
+        _vmm_free_retired_frames_lockless(retired);
+        lock_release(&_vmm_lock);
+    }
+}
 
 #define vmm_kernel_pdir_phys2virt(paddr) ((void*)((uint32_t)paddr + KERNEL_BASE - KERNEL_PM_BASE))
 
@@ -60,11 +115,20 @@ inline static uint32_t _vmm_round_floor_to_page(uint32_t value);
 inline static table_desc_t* _vmm_pdirectory_lookup(pdirectory_t* t_pdir, uint32_t t_addr);
 inline static page_desc_t* _vmm_ptable_lookup(ptable_t* t_ptable, uint32_t t_addr);
 
+static void _vmm_frame_refs_init();
+static inline void _vmm_frame_get(uint32_t paddr);
+static inline bool _vmm_frame_put(uint32_t paddr);
+static inline bool _vmm_frame_is_shared(uint32_t paddr);
+
 static bool _vmm_is_copy_on_write(uint32_t vaddr);
 static int _vmm_resolve_copy_on_write(proc_t* p, uint32_t vaddr);
+static bool _vmm_is_page_copy_on_write(proc_t* p, uint32_t vaddr);
+static int _vmm_resolve_page_copy_on_write(proc_t* p, uint32_t vaddr);
 static void _vmm_ensure_cow_for_page(uint32_t vaddr);
 static void _vmm_ensure_cow_for_range(uint32_t vaddr, uint32_t length);
-static int _vmm_copy_page_to_resolve_cow(proc_t* p, uint32_t vaddr, ptable_t* src_ptable, int page_index);
+
+static bool _vmm_is_large_page(uint32_t vaddr);
+static bool _vmm_is_large_group_free(uint32_t vaddr);
 
 static bool _vmm_is_zeroing_on_demand(uint32_t vaddr);
 static void _vmm_resolve_zeroing_on_demand(uint32_t vaddr);
@@ -84,6 +148,7 @@ static ALWAYS_INLINE int vmm_map_page_lockless(uint32_t vaddr, uint32_t paddr, u
 static ALWAYS_INLINE int vmm_map_pages_lockless(uint32_t vaddr, uint32_t paddr, uint32_t n_pages, uint32_t settings);
 static ALWAYS_INLINE int vmm_unmap_page_lockless(uint32_t vaddr);
 static ALWAYS_INLINE int vmm_unmap_pages_lockless(uint32_t vaddr, uint32_t n_pages);
+static ALWAYS_INLINE int vmm_map_large_pages_lockless(uint32_t vaddr, uint32_t paddr, uint32_t n_pages, uint32_t settings);
 static ALWAYS_INLINE int vmm_copy_page_lockless(uint32_t to_vaddr, uint32_t src_vaddr, ptable_t* src_ptable);
 
 static ALWAYS_INLINE pdirectory_t* vmm_new_user_pdir_lockless();
@@ -96,6 +161,7 @@ static ALWAYS_INLINE int vmm_load_page_lockless(uint32_t vaddr, uint32_t setting
 static ALWAYS_INLINE int vmm_tune_page_lockless(uint32_t vaddr, uint32_t settings);
 static ALWAYS_INLINE int vmm_tune_pages_lockless(uint32_t vaddr, uint32_t length, uint32_t settings);
 static ALWAYS_INLINE int vmm_free_page_lockless(uint32_t vaddr, page_desc_t* page, dynamic_array_t* zones);
+static ALWAYS_INLINE int vmm_free_pages_lockless(uint32_t vaddr, uint32_t n_pages, dynamic_array_t* zones);
 
 static ALWAYS_INLINE int vmm_switch_pdir_lockless(pdirectory_t* pdir);
 
@@ -318,6 +384,11 @@ static void* _vmm_kernel_convert_vaddr2paddr(uint32_t vaddr)
  */
 static void* _vmm_convert_vaddr2paddr(uint32_t vaddr)
 {
+    table_desc_t* ptable_desc = _vmm_pdirectory_lookup(THIS_CPU->pdir, vaddr);
+    if (table_desc_is_large(*ptable_desc)) {
+        return (void*)(table_desc_get_large_frame(*ptable_desc) | (vaddr & (VMM_LARGE_PAGE_SIZE - 1)));
+    }
+
     ptable_t* ptable_vaddr = (ptable_t*)_vmm_pspace_get_vaddr_of_active_ptable(vaddr);
     page_desc_t* page_desc = _vmm_ptable_lookup(ptable_vaddr, vaddr);
     return (void*)((page_desc_get_frame(*page_desc)) | (vaddr & 0xfff));
@@ -420,8 +491,10 @@ int vmm_setup()
     _vmm_create_kernel_ptables();
     _vmm_pspace_init();
     _vmm_init_switch_to_kernel_pdir();
+    system_enable_large_pages();
     _vmm_map_kernel();
     zoner_place_bitmap();
+    _vmm_frame_refs_init();
     kmalloc_init();
     return 0;
 }
@@ -429,9 +502,49 @@ int vmm_setup()
 int vmm_setup_secondary_cpu()
 {
     _vmm_init_switch_to_kernel_pdir();
+    system_enable_large_pages();
     return 0;
 }
 
+/**
+ * FRAME REFERENCE FUNCTIONS
+ *
+ * After fork pages and pages of ptables are shared between several pdirs.
+ * The counter of a frame holds the number of extra owners, so a zero means
+ * that the frame has only one owner and could be freed or modified in place.
+ */
+
+static void _vmm_frame_refs_init()
+{
+    uint32_t size = pmm_get_max_blocks() * sizeof(uint16_t);
+    zone_t zone = _vmm_alloc_mapped_zone(size, VMM_PAGE_SIZE);
+    _vmm_frame_refs = (uint16_t*)zone.ptr;
+    memset((void*)_vmm_frame_refs, 0, size);
+}
+
+static inline void _vmm_frame_get(uint32_t paddr)
+{
+    _vmm_frame_refs[FRAME(paddr)]++;
+}
+
+/**
+ * The function drops a reference to the frame.
+ * Returns true if the caller was the last owner and the frame could be freed.
+ */
+static inline bool _vmm_frame_put(uint32_t paddr)
+{
+    if (!_vmm_frame_refs[FRAME(paddr)]) {
+        return true;
+    }
+    _vmm_frame_refs[FRAME(paddr)]--;
+    return false;
+}
+
+static inline bool _vmm_frame_is_shared(uint32_t paddr)
+{
+    return _vmm_frame_refs[FRAME(paddr)] > 0;
+}
+
 /**
  * VM TOOLS
  */
@@ -487,7 +600,19 @@ static int vmm_allocate_ptable_lockless(uint32_t vaddr)
     }
 
     table_desc_t* ptable_desc = _vmm_pdirectory_lookup(THIS_CPU->pdir, vaddr);
+    if (table_desc_is_large(*ptable_desc)) {
+        return -VMM_ERR_BAD_ADDR;
+    }
+
     if (table_desc_is_in_allocated_state(ptable_desc)) {
+        // The page of tables could be still shared with a forked pdir.
+        if (_vmm_frame_is_shared(PAGE_START(table_desc_get_frame(*ptable_desc)))) {
+            proc_t* holder_proc = tasking_get_proc_by_pdir(vmm_get_active_pdir());
+            if (!holder_proc) {
+                kpanic("No proc with the pdir\n");
+            }
+            _vmm_resolve_copy_on_write(holder_proc, vaddr);
+        }
         goto skip_allocation;
     }
 
@@ -524,7 +649,7 @@ int vmm_allocate_ptable(uint32_t vaddr)
 {
     lock_acquire(&_vmm_lock);
     int res = vmm_allocate_ptable_lockless(vaddr);
-    lock_release(&_vmm_lock);
+    _vmm_lock_release();
     return res;
 }
 
@@ -544,7 +669,7 @@ int vmm_force_allocate_ptable(uint32_t vaddr)
 {
     lock_acquire(&_vmm_lock);
     int res = vmm_force_allocate_ptable_lockless(vaddr);
-    lock_release(&_vmm_lock);
+    _vmm_lock_release();
     return res;
 }
 
@@ -559,12 +684,31 @@ static ALWAYS_INLINE int vmm_free_ptable_lockless(uint32_t vaddr, dynamic_array_
 
     table_desc_t* ptable_desc = _vmm_pdirectory_lookup(THIS_CPU->pdir, vaddr);
 
+    // Frames behind large pages belong to their mapper, so only the mapping goes away.
+    if (table_desc_is_large(*ptable_desc)) {
+        table_desc_clear(ptable_desc);
+        return 0;
+    }
+
     if (!table_desc_has_attrs(*ptable_desc, TABLE_DESC_PRESENT)) {
         return -EFAULT;
     }
 
+    uint32_t ptable_vaddr_start = PAGE_START((uint32_t)_vmm_pspace_get_vaddr_of_active_ptable(vaddr));
+    uint32_t ptables_per_page = VMM_PAGE_SIZE / PTABLE_SIZE;
+    uint32_t table_coverage = VMM_PAGE_SIZE * VMM_TOTAL_PAGES_PER_TABLE;
+    uint32_t ptable_serve_vaddr_start = (vaddr / (table_coverage * ptables_per_page)) * (table_coverage * ptables_per_page);
+
     if (table_desc_has_attrs(*ptable_desc, TABLE_DESC_COPY_ON_WRITE)) {
-        return -EFAULT;
+        uint32_t ptables_frame = PAGE_START(table_desc_get_frame(*ptable_desc));
+        if (_vmm_frame_is_shared(ptables_frame)) {
+            // Other pdirs still use these tables, so only our reference is dropped.
+            for (uint32_t i = 0, pvaddr = ptable_serve_vaddr_start; i < ptables_per_page; i++, pvaddr += table_coverage) {
+                table_desc_clear(_vmm_pdirectory_lookup(THIS_CPU->pdir, pvaddr));
+            }
+            _vmm_frame_put(ptables_frame);
+            return 0;
+        }
     }
 
     // Entering allocated state, since table is alloacted but not valid.
@@ -580,11 +724,6 @@ static ALWAYS_INLINE int vmm_free_ptable_lockless(uint32_t vaddr, dynamic_array_
         vmm_free_page_lockless(pages_vstart + pages_voffset, page, zones);
     }
 
-    uint32_t ptable_vaddr_start = PAGE_START((uint32_t)_vmm_pspace_get_vaddr_of_active_ptable(vaddr));
-    uint32_t ptables_per_page = VMM_PAGE_SIZE / PTABLE_SIZE;
-    uint32_t table_coverage = VMM_PAGE_SIZE * VMM_TOTAL_PAGES_PER_TABLE;
-    uint32_t ptable_serve_vaddr_start = (vaddr / (table_coverage * ptables_per_page)) * (table_coverage * ptables_per_page);
-
     // Chechking if we can delete thw whole page of tables.
     for (uint32_t i = 0, pvaddr = ptable_serve_vaddr_start; i < ptables_per_page; i++, pvaddr += table_coverage) {
         table_desc_t* ptable_desc_c = _vmm_pdirectory_lookup(THIS_CPU->pdir, pvaddr);
@@ -611,7 +750,7 @@ int vmm_free_ptable(uint32_t vaddr, dynamic_array_t* zones)
 {
     lock_acquire(&_vmm_lock);
     int res = vmm_free_ptable_lockless(vaddr, zones);
-    lock_release(&_vmm_lock);
+    _vmm_lock_release();
     return res;
 }
 
@@ -622,6 +761,9 @@ int vmm_free_ptable(uint32_t vaddr, dynamic_array_t* zones)
 static bool _vmm_is_page_present(uint32_t vaddr)
 {
     table_desc_t* ptable_desc = _vmm_pdirectory_lookup(THIS_CPU->pdir, vaddr);
+    if (table_desc_is_large(*ptable_desc)) {
+        return true;
+    }
     if (!table_desc_is_present(*ptable_desc)) {
         return false;
     }
@@ -631,6 +773,15 @@ static bool _vmm_is_page_present(uint32_t vaddr)
     return page_desc_is_present(*page);
 }
 
+/**
+ * Tells if @vaddr is backed in the active pdir, so it can be read
+ * without faulting. Used to inspect memory from interrupt handlers.
+ */
+bool vmm_is_page_present(uint32_t vaddr)
+{
+    return _vmm_is_page_present(vaddr);
+}
+
 static ALWAYS_INLINE int vmm_map_page_lockless(uint32_t vaddr, uint32_t paddr, uint32_t settings)
 {
     if (!THIS_CPU->pdir) {
@@ -641,23 +792,33 @@ static ALWAYS_INLINE int vmm_map_page_lockless(uint32_t vaddr, uint32_t paddr, u
     bool is_readable = ((settings & PAGE_READABLE) > 0);
     bool is_executable = ((settings & PAGE_EXECUTABLE) > 0);
     bool is_not_cacheable = ((settings & PAGE_NOT_CACHEABLE) > 0);
+    bool is_write_combining = ((settings & PAGE_WRITE_COMBINING) > 0);
     bool is_cow = ((settings & PAGE_COW) > 0);
     bool is_user = ((settings & PAGE_USER) > 0);
 
     table_desc_t* ptable_desc = _vmm_pdirectory_lookup(THIS_CPU->pdir, vaddr);
+    if (table_desc_is_large(*ptable_desc)) {
+        return -VMM_ERR_BAD_ADDR;
+    }
+
     if (!table_desc_is_present(*ptable_desc)) {
         vmm_allocate_ptable_lockless(vaddr);
     }
 
+    // The ptable could be shared with other pdirs, modifying it in place would affect them too.
+    if (table_desc_is_copy_on_write(*ptable_desc)) {
+        _vmm_ensure_cow_for_page(vaddr);
+    }
+
     ptable_t* ptable = (ptable_t*)_vmm_pspace_get_vaddr_of_active_ptable(vaddr);
     page_desc_t* page = _vmm_ptable_lookup(ptable, vaddr);
+    bool was_present = page_desc_is_present(*page);
 
     page_desc_init(page);
     page_desc_set_attrs(page, PAGE_DESC_PRESENT);
     page_desc_set_frame(page, paddr);
 
-    // If we are in COW, no write is allowed anyway.
-    if (is_writable && !table_desc_is_copy_on_write(*ptable_desc)) {
+    if (is_writable) {
         page_desc_set_attrs(page, PAGE_DESC_WRITABLE);
     }
 
@@ -669,11 +830,20 @@ static ALWAYS_INLINE int vmm_map_page_lockless(uint32_t vaddr, uint32_t paddr, u
         page_desc_set_attrs(page, PAGE_DESC_NOT_CACHEABLE);
     }
 
+    if (is_write_combining) {
+        page_desc_set_attrs(page, PAGE_DESC_WRITE_COMBINING);
+    }
+
 #ifdef VMM_DEBUG
     log("Page mapped %x in pdir: %x", vaddr, vmm_get_active_pdir());
 #endif
 
-    system_flush_tlb_entry(vaddr);
+    // Not present pages are not cached by TLB, so other cpus don't need to know about them.
+    if (was_present) {
+        tlb_invalidate_page(vaddr);
+    } else {
+        system_flush_tlb_entry(vaddr);
+    }
 
     return 0;
 }
@@ -682,7 +852,7 @@ int vmm_map_page(uint32_t vaddr, uint32_t paddr, uint32_t settings)
 {
     lock_acquire(&_vmm_lock);
     int res = vmm_map_page_lockless(vaddr, paddr, settings);
-    lock_release(&_vmm_lock);
+    _vmm_lock_release();
     return res;
 }
 
@@ -693,16 +863,24 @@ static ALWAYS_INLINE int vmm_unmap_page_lockless(uint32_t vaddr)
     }
 
     table_desc_t* ptable_desc = _vmm_pdirectory_lookup(THIS_CPU->pdir, vaddr);
+    if (table_desc_is_large(*ptable_desc)) {
+        return -VMM_ERR_BAD_ADDR;
+    }
+
     if (!table_desc_is_present(*ptable_desc)) {
         return -VMM_ERR_PTABLE;
     }
 
+    if (table_desc_is_copy_on_write(*ptable_desc)) {
+        _vmm_ensure_cow_for_page(vaddr);
+    }
+
     ptable_t* ptable = (ptable_t*)_vmm_pspace_get_vaddr_of_active_ptable(vaddr);
     page_desc_t* page = _vmm_ptable_lookup(ptable, vaddr);
     page_desc_del_attrs(page, PAGE_DESC_PRESENT);
     page_desc_del_attrs(page, PAGE_DESC_WRITABLE);
     page_desc_del_frame(page);
-    system_flush_tlb_entry(vaddr);
+    tlb_invalidate_page(vaddr);
 
     return 0;
 }
@@ -711,7 +889,7 @@ int vmm_unmap_page(uint32_t vaddr)
 {
     lock_acquire(&_vmm_lock);
     int res = vmm_unmap_page_lockless(vaddr);
-    lock_release(&_vmm_lock);
+    _vmm_lock_release();
     return res;
 }
 
@@ -738,7 +916,7 @@ int vmm_map_pages(uint32_t vaddr, uint32_t paddr, uint32_t n_pages, uint32_t set
 {
     lock_acquire(&_vmm_lock);
     int res = vmm_map_pages_lockless(vaddr, paddr, n_pages, settings);
-    lock_release(&_vmm_lock);
+    _vmm_lock_release();
     return res;
 }
 
@@ -749,10 +927,23 @@ static ALWAYS_INLINE int vmm_unmap_pages_lockless(uint32_t vaddr, uint32_t n_pag
     }
 
     int status = 0;
-    for (; n_pages; vaddr += VMM_PAGE_SIZE, n_pages--) {
+    while (n_pages) {
+        // A group of large pages could be unmapped only as a whole.
+        if (_vmm_is_large_page(vaddr) && (vaddr % VMM_LARGE_ZONE_ALIGNMENT) == 0 && n_pages >= VMM_LARGE_ZONE_ALIGNMENT / VMM_PAGE_SIZE) {
+            for (int i = 0; i < VMM_LARGE_PAGES_PER_GROUP; i++) {
+                table_desc_clear(_vmm_pdirectory_lookup(THIS_CPU->pdir, vaddr + i * VMM_LARGE_PAGE_SIZE));
+                tlb_invalidate_page(vaddr + i * VMM_LARGE_PAGE_SIZE);
+            }
+            vaddr += VMM_LARGE_ZONE_ALIGNMENT;
+            n_pages -= VMM_LARGE_ZONE_ALIGNMENT / VMM_PAGE_SIZE;
+            continue;
+        }
+
         if ((status = vmm_unmap_page_lockless(vaddr) < 0)) {
             return status;
         }
+        vaddr += VMM_PAGE_SIZE;
+        n_pages--;
     }
 
     return 0;
@@ -762,7 +953,101 @@ int vmm_unmap_pages(uint32_t vaddr, uint32_t n_pages)
 {
     lock_acquire(&_vmm_lock);
     int res = vmm_unmap_pages_lockless(vaddr, n_pages);
-    lock_release(&_vmm_lock);
+    _vmm_lock_release();
+    return res;
+}
+
+/**
+ * LARGE PAGES FUNCTIONS
+ *
+ * Large pages (4MB PSE pages on x86, 1MB sections on aarch32) are described
+ * right in a pdir and have no ptables. Since ptables are allocated by pages,
+ * large pages are placed by whole groups of VMM_LARGE_ZONE_ALIGNMENT, so a group
+ * is served either by large pages or by ptables, never by both.
+ * Kernel pdes are copied into every pdir, that's why large pages are used only
+ * in user space. Frames behind large pages are never freed by vmm.
+ */
+
+static bool _vmm_is_large_page(uint32_t vaddr)
+{
+    table_desc_t* ptable_desc = _vmm_pdirectory_lookup(THIS_CPU->pdir, vaddr);
+    return table_desc_is_large(*ptable_desc);
+}
+
+static bool _vmm_is_large_group_free(uint32_t vaddr)
+{
+    for (int i = 0; i < VMM_LARGE_PAGES_PER_GROUP; i++) {
+        table_desc_t* ptable_desc = _vmm_pdirectory_lookup(THIS_CPU->pdir, vaddr + i * VMM_LARGE_PAGE_SIZE);
+        // A frame in a not present desc means that ptables are in allocated state.
+        if (table_desc_is_large(*ptable_desc) || table_desc_is_present(*ptable_desc) || table_desc_get_frame(*ptable_desc)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void _vmm_map_large_group(uint32_t vaddr, uint32_t paddr, uint32_t settings)
+{
+    uint32_t attrs = 0;
+    if (settings & PAGE_WRITABLE) {
+        attrs |= TABLE_DESC_WRITABLE;
+    }
+    if (settings & PAGE_USER) {
+        attrs |= TABLE_DESC_USER;
+    }
+    if (settings & PAGE_NOT_CACHEABLE) {
+        attrs |= TABLE_DESC_PCD;
+    }
+    if (settings & PAGE_WRITE_COMBINING) {
+        attrs |= TABLE_DESC_WRITE_COMBINING;
+    }
+
+    for (int i = 0; i < VMM_LARGE_PAGES_PER_GROUP; i++) {
+        table_desc_t* ptable_desc = _vmm_pdirectory_lookup(THIS_CPU->pdir, vaddr + i * VMM_LARGE_PAGE_SIZE);
+        table_desc_init_large(ptable_desc, paddr + i * VMM_LARGE_PAGE_SIZE, attrs);
+        system_flush_tlb_entry(vaddr + i * VMM_LARGE_PAGE_SIZE);
+    }
+}
+
+/**
+ * The function maps a sequence of vaddrs to physically contiguous paddrs.
+ * Groups which are fully covered and suitably aligned are mapped with large
+ * pages, the rest falls back to usual pages.
+ */
+static ALWAYS_INLINE int vmm_map_large_pages_lockless(uint32_t vaddr, uint32_t paddr, uint32_t n_pages, uint32_t settings)
+{
+    if ((paddr & 0xfff) || (vaddr & 0xfff)) {
+        return -VMM_ERR_BAD_ADDR;
+    }
+
+    int status = 0;
+    uint32_t pages_per_group = VMM_LARGE_ZONE_ALIGNMENT / VMM_PAGE_SIZE;
+    while (n_pages) {
+        bool aligned = (vaddr % VMM_LARGE_ZONE_ALIGNMENT) == 0 && (paddr % VMM_LARGE_PAGE_SIZE) == 0;
+        if (aligned && n_pages >= pages_per_group && PAGE_CHOOSE_OWNER(vaddr) == PAGE_USER && _vmm_is_large_group_free(vaddr)) {
+            _vmm_map_large_group(vaddr, paddr, settings);
+            vaddr += VMM_LARGE_ZONE_ALIGNMENT;
+            paddr += VMM_LARGE_ZONE_ALIGNMENT;
+            n_pages -= pages_per_group;
+            continue;
+        }
+
+        if ((status = vmm_map_page_lockless(vaddr, paddr, settings)) < 0) {
+            return status;
+        }
+        vaddr += VMM_PAGE_SIZE;
+        paddr += VMM_PAGE_SIZE;
+        n_pages--;
+    }
+
+    return 0;
+}
+
+int vmm_map_large_pages(uint32_t vaddr, uint32_t paddr, uint32_t n_pages, uint32_t settings)
+{
+    lock_acquire(&_vmm_lock);
+    int res = vmm_map_large_pages_lockless(vaddr, paddr, n_pages, settings);
+    _vmm_lock_release();
     return res;
 }
 
@@ -799,60 +1084,220 @@ static bool _vmm_is_copy_on_write(uint32_t vaddr)
     return table_desc_is_copy_on_write(*ptable_desc);
 }
 
+/**
+ * Pages of device and shared file zones are never copied, so they keep
+ * the permissions of their zone. Fork on arm strips writable from every
+ * page, these pages get it back here.
+ */
+static bool _vmm_restore_uncopied_page_perm(proc_t* p, uint32_t page_vaddr, page_desc_t* page_desc)
+{
+    proc_zone_t* zone = proc_find_zone(p, page_vaddr);
+    if (!zone || !(zone->type & (ZONE_TYPE_DEVICE | ZONE_TYPE_MAPPED_FILE_SHAREDLY))) {
+        return false;
+    }
+
+    if (zone->flags & ZONE_WRITABLE) {
+        page_desc_set_attrs(page_desc, PAGE_DESC_WRITABLE);
+    }
+    return true;
+}
+
+/**
+ * The function gives the active pdir its own copy of the page of ptables
+ * which serves @vaddr. Only ptables are copied, pages stay shared: both the old
+ * and the new ptables reference them, so they are marked as read-only and are
+ * copied later on a write fault (see _vmm_resolve_page_copy_on_write).
+ */
 static int _vmm_resolve_copy_on_write(proc_t* p, uint32_t vaddr)
 {
     table_desc_t orig_table_desc[VMM_PAGE_SIZE / PTABLE_SIZE];
     uint32_t ptables_per_page = VMM_PAGE_SIZE / PTABLE_SIZE;
     uint32_t table_coverage = VMM_PAGE_SIZE * VMM_TOTAL_PAGES_PER_TABLE;
     uint32_t ptable_serve_vaddr_start = (vaddr / (table_coverage * ptables_per_page)) * (table_coverage * ptables_per_page);
+    table_desc_t* start_ptable_desc = _vmm_pdirectory_lookup(THIS_CPU->pdir, ptable_serve_vaddr_start);
+
+    // Saving descriptors of original ptables
+    uint32_t ptables_frame = 0;
+    for (int it = 0; it < ptables_per_page; it++) {
+        orig_table_desc[it] = start_ptable_desc[it];
+        if (!ptables_frame && table_desc_get_frame(orig_table_desc[it])) {
+            ptables_frame = PAGE_START(table_desc_get_frame(orig_table_desc[it]));
+        }
+    }
+
+    if (!ptables_frame) {
+        return -VMM_ERR_PTABLE;
+    }
+
+    ptable_t* root_ptable = (ptable_t*)PAGE_START((uint32_t)_vmm_pspace_get_vaddr_of_active_ptable(ptable_serve_vaddr_start));
+    uint32_t table_start = TABLE_START(ptable_serve_vaddr_start);
+
+    /* Other pdirs have already got their own copies, so the tables could be used in place. */
+    if (!_vmm_frame_is_shared(ptables_frame)) {
+        for (int ptable_idx = 0; ptable_idx < ptables_per_page; ptable_idx++) {
+            if (!table_desc_is_present(start_ptable_desc[ptable_idx])) {
+                continue;
+            }
+            table_desc_del_attrs(&start_ptable_desc[ptable_idx], TABLE_DESC_COPY_ON_WRITE);
+            table_desc_set_attrs(&start_ptable_desc[ptable_idx], TABLE_DESC_WRITABLE);
+
+            for (int page_idx = 0; page_idx < VMM_TOTAL_PAGES_PER_TABLE; page_idx++) {
+                uint32_t offset_in_table_set = ptable_idx * VMM_TOTAL_PAGES_PER_TABLE + page_idx;
+                page_desc_t* page_desc = &root_ptable->entities[offset_in_table_set];
+                if (page_desc_is_present(*page_desc)) {
+                    _vmm_restore_uncopied_page_perm(p, table_start + offset_in_table_set * VMM_PAGE_SIZE, page_desc);
+                }
+            }
+        }
+        tlb_invalidate_all();
+        return 0;
+    }
+
+    /* Pages become shared between 2 ptables, so nobody is allowed to write them directly. */
+    for (int ptable_idx = 0; ptable_idx < ptables_per_page; ptable_idx++) {
+        if (!table_desc_is_present(orig_table_desc[ptable_idx])) {
+            continue;
+        }
+        for (int page_idx = 0; page_idx < VMM_TOTAL_PAGES_PER_TABLE; page_idx++) {
+            uint32_t offset_in_table_set = ptable_idx * VMM_TOTAL_PAGES_PER_TABLE + page_idx;
+            uint32_t page_vaddr = table_start + (offset_in_table_set * VMM_PAGE_SIZE);
+            page_desc_t* page_desc = &root_ptable->entities[offset_in_table_set];
+            if (!page_desc_is_present(*page_desc)) {
+                continue;
+            }
+
+            proc_zone_t* zone = proc_find_zone(p, page_vaddr);
+            if (zone && (zone->type & ZONE_TYPE_DEVICE)) {
+                _vmm_restore_uncopied_page_perm(p, page_vaddr, page_desc);
+                continue;
+            }
+            _vmm_frame_get(page_desc_get_frame(*page_desc));
+            if (!_vmm_restore_uncopied_page_perm(p, page_vaddr, page_desc)) {
+                page_desc_del_attrs(page_desc, PAGE_DESC_WRITABLE);
+            }
+        }
+    }
 
     /* Copying old ptables which cover the full page. See a comment above vmm_allocate_ptable. */
     zone_t src_ptable_zone = _vmm_alloc_mapped_zone(VMM_PAGE_SIZE, VMM_PAGE_SIZE);
     ptable_t* src_ptable = (ptable_t*)src_ptable_zone.ptr;
-    ptable_t* root_ptable = (ptable_t*)PAGE_START((uint32_t)_vmm_pspace_get_vaddr_of_active_ptable(ptable_serve_vaddr_start));
     memcpy(src_ptable, root_ptable, VMM_PAGE_SIZE);
 
-    // Saving descriptors of original ptables
-    for (int it = 0; it < ptables_per_page; it++) {
-        table_desc_t* tmp_table_desc = _vmm_pdirectory_lookup(THIS_CPU->pdir, ptable_serve_vaddr_start);
-        orig_table_desc[it] = tmp_table_desc[it];
-    }
-
     /* Setting up new ptables. */
     int err = vmm_force_allocate_ptable_lockless(vaddr);
     if (err) {
+        _vmm_free_mapped_zone(src_ptable_zone);
         return err;
     }
 
-    /* Copying all pages from this tables to newly allocated. */
-    uint32_t table_start = TABLE_START(ptable_serve_vaddr_start);
-    table_desc_t* start_ptable_desc = _vmm_pdirectory_lookup(THIS_CPU->pdir, ptable_serve_vaddr_start);
+    /* The new ptables are mapped to the same place in pspace, where the old ones were. */
+    memcpy(root_ptable, src_ptable, VMM_PAGE_SIZE);
     for (int ptable_idx = 0; ptable_idx < ptables_per_page; ptable_idx++) {
         if (table_desc_is_present(orig_table_desc[ptable_idx])) {
             _vmm_table_desc_init_from_allocated_state(&start_ptable_desc[ptable_idx]);
-            for (int page_idx = 0; page_idx < VMM_TOTAL_PAGES_PER_TABLE; page_idx++) {
-                uint32_t offset_in_table_set = ptable_idx * VMM_TOTAL_PAGES_PER_TABLE + page_idx;
-                uint32_t page_vaddr = table_start + (offset_in_table_set * VMM_PAGE_SIZE);
-                page_desc_t* page_desc = &src_ptable->entities[offset_in_table_set];
-                if (page_desc_is_present(*page_desc)) {
-                    _vmm_copy_page_to_resolve_cow(p, page_vaddr, src_ptable, offset_in_table_set);
-                }
-            }
         }
     }
 
+    _vmm_frame_put(ptables_frame);
+    tlb_invalidate_all();
     return _vmm_free_mapped_zone(src_ptable_zone);
 }
 
+/**
+ * A page is copy-on-write if it is a private writable page, which
+ * is mapped as read-only, since it's shared with a forked process.
+ */
+static bool _vmm_is_page_copy_on_write(proc_t* p, uint32_t vaddr)
+{
+    table_desc_t* ptable_desc = _vmm_pdirectory_lookup(THIS_CPU->pdir, vaddr);
+    if (!table_desc_is_present(*ptable_desc) || table_desc_is_copy_on_write(*ptable_desc) || table_desc_is_large(*ptable_desc)) {
+        return false;
+    }
+
+    ptable_t* ptable = (ptable_t*)_vmm_pspace_get_vaddr_of_active_ptable(vaddr);
+    page_desc_t* page = _vmm_ptable_lookup(ptable, vaddr);
+    if (!page_desc_is_present(*page) || page_desc_is_writable(*page)) {
+        return false;
+    }
+
+    proc_zone_t* zone = proc_find_zone(p, vaddr);
+    if (!zone || !(zone->flags & ZONE_WRITABLE)) {
+        return false;
+    }
+    return !(zone->type & (ZONE_TYPE_DEVICE | ZONE_TYPE_MAPPED_FILE_SHAREDLY));
+}
+
+/**
+ * The function resolves cow of a single page. If the page is not shared
+ * anymore it becomes writable, otherwise the page is copied.
+ */
+static int _vmm_resolve_page_copy_on_write(proc_t* p, uint32_t vaddr)
+{
+    vaddr = PAGE_START(vaddr);
+    proc_zone_t* zone = proc_find_zone(p, vaddr);
+    if (!zone) {
+        log_error("Cow: No page in zone");
+        return SHOULD_CRASH;
+    }
+
+    ptable_t* ptable = (ptable_t*)_vmm_pspace_get_vaddr_of_active_ptable(vaddr);
+    page_desc_t* page = _vmm_ptable_lookup(ptable, vaddr);
+    uint32_t old_page_paddr = page_desc_get_frame(*page);
+
+    if (!_vmm_frame_is_shared(old_page_paddr)) {
+        return vmm_tune_page_lockless(vaddr, zone->flags);
+    }
+
+    /* The page stays shared and read-only, the faulting process is killed. */
+    uint32_t new_page_paddr = _vmm_alloc_page_paddr();
+    if (!new_page_paddr) {
+        log_warn("Cow: no physical space to copy %x", vaddr);
+        return -VMM_ERR_NO_SPACE;
+    }
+
+    /* Mapping the old page to do a copy */
+    zone_t tmp_zone = zoner_new_zone(VMM_PAGE_SIZE);
+    uint32_t old_page_vaddr = (uint32_t)tmp_zone.start;
+    vmm_map_page_lockless(old_page_vaddr, old_page_paddr, PAGE_READABLE);
+    vmm_map_page_lockless(vaddr, new_page_paddr, zone->flags);
+    memcpy((uint8_t*)vaddr, (uint8_t*)old_page_vaddr, VMM_PAGE_SIZE);
+
+    /* Freeing */
+    vmm_unmap_page_lockless(old_page_vaddr);
+    zoner_free_zone(tmp_zone);
+    _vmm_frame_put(old_page_paddr);
+    return 0;
+}
+
 static void _vmm_ensure_cow_for_page(uint32_t vaddr)
 {
+    if (PAGE_CHOOSE_OWNER(vaddr) != PAGE_USER) {
+        return;
+    }
+
+    proc_t* holder_proc = NULL;
     if (_vmm_is_copy_on_write(vaddr)) {
-        proc_t* holder_proc = tasking_get_proc_by_pdir(vmm_get_active_pdir());
+        holder_proc = tasking_get_proc_by_pdir(vmm_get_active_pdir());
         if (!holder_proc) {
             kpanic("No proc with the pdir\n");
         }
         _vmm_resolve_copy_on_write(holder_proc, vaddr);
     }
+
+    if (!_vmm_is_page_present(vaddr)) {
+        return;
+    }
+
+    if (!holder_proc) {
+        holder_proc = tasking_get_proc_by_pdir(vmm_get_active_pdir());
+        if (!holder_proc) {
+            return;
+        }
+    }
+
+    if (_vmm_is_page_copy_on_write(holder_proc, vaddr)) {
+        _vmm_resolve_page_copy_on_write(holder_proc, vaddr);
+    }
 }
 
 static void _vmm_ensure_cow_for_range(uint32_t vaddr, uint32_t length)
@@ -873,7 +1318,7 @@ static int _vmm_load_page_with_perm(uint32_t vaddr)
         }
 
         proc_zone_t* zone = proc_find_zone(holder_proc, vaddr);
-        if (!zone) {
+        if (!zone || (zone->type & ZONE_TYPE_GUARD)) {
             return SHOULD_CRASH;
         }
 
@@ -910,44 +1355,6 @@ static void _vmm_ensure_write_to_range(uint32_t vaddr, uint32_t length)
     }
 }
 
-/**
- * The function is supposed to copy a page from @src_ptable to active
- * ptable. The page which is copied has address @vaddr. ONLY TO RESOLVE COW!
- */
-static int _vmm_copy_page_to_resolve_cow(proc_t* p, uint32_t vaddr, ptable_t* src_ptable, int page_index)
-{
-    page_desc_t* old_page_desc = &src_ptable->entities[page_index];
-
-    proc_zone_t* zone = proc_find_zone(p, vaddr);
-    if (!zone) {
-        log_error("Cow: No page in zone");
-        return SHOULD_CRASH;
-    }
-
-    if ((zone->type & ZONE_TYPE_MAPPED_FILE_SHAREDLY)) {
-        uint32_t old_page_paddr = page_desc_get_frame(*old_page_desc);
-        return vmm_map_page_lockless(vaddr, old_page_paddr, zone->flags);
-    }
-
-    vmm_load_page_lockless(vaddr, zone->flags);
-
-    /* Mapping the old page to do a copy */
-    zone_t tmp_zone = zoner_new_zone(VMM_PAGE_SIZE);
-    uint32_t old_page_vaddr = (uint32_t)tmp_zone.start;
-    uint32_t old_page_paddr = page_desc_get_frame(*old_page_desc);
-    vmm_map_page_lockless(old_page_vaddr, old_page_paddr, PAGE_READABLE);
-
-    /*  We don't need to check if there is a problem with cow, since this is a special copy function
-        to resolve cow. So, we know that pages were created recently. Checking cow here would cause an
-        ub, since table has not been setup correctly yet. */
-    memcpy((uint8_t*)vaddr, (uint8_t*)old_page_vaddr, VMM_PAGE_SIZE);
-
-    /* Freeing */
-    vmm_unmap_page_lockless(old_page_vaddr);
-    zoner_free_zone(tmp_zone);
-    return 0;
-}
-
 /**
  * ZEROING ON DEMAND FUNCTIONS
  */
@@ -1014,12 +1421,14 @@ pdirectory_t* vmm_new_user_pdir()
 {
     lock_acquire(&_vmm_lock);
     pdirectory_t* res = vmm_new_user_pdir_lockless();
-    lock_release(&_vmm_lock);
+    _vmm_lock_release();
     return res;
 }
 
 /**
  * The function created a new user's pdir from the active pdir.
+ * Ptables are not copied, both pdirs share them as copy-on-write ptables
+ * and every page of ptables gets one more owner.
  * After copying the task we need to flush tlb.
  */
 static ALWAYS_INLINE pdirectory_t* vmm_new_forked_user_pdir_lockless()
@@ -1032,15 +1441,34 @@ static ALWAYS_INLINE pdirectory_t* vmm_new_forked_user_pdir_lockless()
     }
     _vmm_pspace_gen(new_pdir);
 
-    for (int i = 0; i < VMM_KERNEL_TABLES_START; i++) {
-        table_desc_t* act_ptable_desc = &THIS_CPU->pdir->entities[i];
-        if (table_desc_has_attrs(*act_ptable_desc, TABLE_DESC_PRESENT)) {
-            table_desc_t* new_ptable_desc = &new_pdir->entities[i];
-            _vmm_tables_set_cow(i, act_ptable_desc, new_ptable_desc);
+    uint32_t ptables_per_page = VMM_PAGE_SIZE / PTABLE_SIZE;
+    for (int i = 0; i < VMM_KERNEL_TABLES_START; i += ptables_per_page) {
+        // Large pages have no ptables to share, the descs are already copied.
+        if (table_desc_is_large(THIS_CPU->pdir->entities[i])) {
+            continue;
+        }
+
+        uint32_t ptables_frame = 0;
+        for (int j = i; j < i + ptables_per_page; j++) {
+            table_desc_t* act_ptable_desc = &THIS_CPU->pdir->entities[j];
+            if (table_desc_has_attrs(*act_ptable_desc, TABLE_DESC_PRESENT)) {
+                table_desc_t* new_ptable_desc = &new_pdir->entities[j];
+                _vmm_tables_set_cow(j, act_ptable_desc, new_ptable_desc);
+                ptables_frame = PAGE_START(table_desc_get_frame(*act_ptable_desc));
+            }
+        }
+
+        if (ptables_frame) {
+            _vmm_frame_get(ptables_frame);
+        } else {
+            // Tables in allocated state are not shared, the new pdir will allocate its own.
+            for (int j = i; j < i + ptables_per_page; j++) {
+                table_desc_clear(&new_pdir->entities[j]);
+            }
         }
     }
 
-    system_flush_whole_tlb();
+    tlb_invalidate_all();
     return new_pdir;
 }
 
@@ -1048,7 +1476,7 @@ pdirectory_t* vmm_new_forked_user_pdir()
 {
     lock_acquire(&_vmm_lock);
     pdirectory_t* res = vmm_new_forked_user_pdir_lockless();
-    lock_release(&_vmm_lock);
+    _vmm_lock_release();
     return res;
 }
 
@@ -1084,7 +1512,7 @@ int vmm_free_pdir(pdirectory_t* pdir, dynamic_array_t* zones)
 {
     lock_acquire(&_vmm_lock);
     int res = vmm_free_pdir_lockless(pdir, zones);
-    lock_release(&_vmm_lock);
+    _vmm_lock_release();
     return res;
 }
 
@@ -1108,7 +1536,7 @@ void vmm_prepare_active_pdir_for_copying_at(uint32_t dest_vaddr, uint32_t length
 {
     lock_acquire(&_vmm_lock);
     vmm_prepare_active_pdir_for_copying_at_lockless(dest_vaddr, length);
-    lock_release(&_vmm_lock);
+    _vmm_lock_release();
 }
 
 static ALWAYS_INLINE void vmm_copy_to_user_lockless(void* dest, void* src, uint32_t length)
@@ -1121,7 +1549,7 @@ void vmm_copy_to_user(void* dest, void* src, uint32_t length)
 {
     lock_acquire(&_vmm_lock);
     vmm_prepare_active_pdir_for_copying_at_lockless((uint32_t)dest, length);
-    lock_release(&_vmm_lock);
+    _vmm_lock_release();
     memcpy(dest, src, length);
 }
 
@@ -1163,7 +1591,7 @@ void vmm_copy_to_pdir(pdirectory_t* pdir, void* src, uint32_t dest_vaddr, uint32
     lock_acquire(&_vmm_lock);
     vmm_switch_pdir_lockless(pdir);
     vmm_prepare_active_pdir_for_copying_at_lockless(dest_vaddr, length);
-    lock_release(&_vmm_lock);
+    _vmm_lock_release();
 
     uint8_t* dest = (uint8_t*)dest_vaddr;
     memcpy(dest, ksrc, length);
@@ -1183,7 +1611,7 @@ void vmm_zero_user_pages(pdirectory_t* pdir)
         table_desc_del_attrs(ptable_desc, TABLE_DESC_WRITABLE);
         table_desc_set_attrs(ptable_desc, TABLE_DESC_ZEROING_ON_DEMAND);
     }
-    lock_release(&_vmm_lock);
+    _vmm_lock_release();
 }
 
 pdirectory_t* vmm_get_active_pdir()
@@ -1207,21 +1635,34 @@ static ALWAYS_INLINE int vmm_tune_page_lockless(uint32_t vaddr, uint32_t setting
     bool is_readable = ((settings & PAGE_READABLE) > 0);
     bool is_executable = ((settings & PAGE_EXECUTABLE) > 0);
     bool is_not_cacheable = ((settings & PAGE_NOT_CACHEABLE) > 0);
+    bool is_write_combining = ((settings & PAGE_WRITE_COMBINING) > 0);
     bool is_cow = ((settings & PAGE_COW) > 0);
     bool is_user = ((settings & PAGE_USER) > 0);
 
+    // Settings of large pages are chosen by their mapper.
+    if (_vmm_is_large_page(vaddr)) {
+        return 0;
+    }
+
     ptable_t* ptable = (ptable_t*)_vmm_pspace_get_vaddr_of_active_ptable(vaddr);
     page_desc_t* page = _vmm_ptable_lookup(ptable, vaddr);
 
     if (page_desc_is_present(*page)) {
         is_user ? page_desc_set_attrs(page, PAGE_DESC_USER) : page_desc_del_attrs(page, PAGE_DESC_USER);
         is_writable ? page_desc_set_attrs(page, PAGE_DESC_WRITABLE) : page_desc_del_attrs(page, PAGE_DESC_WRITABLE);
-        is_not_cacheable ? page_desc_set_attrs(page, PAGE_DESC_NOT_CACHEABLE) : page_desc_del_attrs(page, PAGE_DESC_NOT_CACHEABLE);
+        // Memory types could share bits of a desc, so the old one is dropped first.
+        page_desc_del_attrs(page, PAGE_DESC_NOT_CACHEABLE | PAGE_DESC_WRITE_COMBINING);
+        if (is_not_cacheable) {
+            page_desc_set_attrs(page, PAGE_DESC_NOT_CACHEABLE);
+        }
+        if (is_write_combining) {
+            page_desc_set_attrs(page, PAGE_DESC_WRITE_COMBINING);
+        }
+        tlb_invalidate_page(vaddr);
     } else {
         vmm_load_page_lockless(vaddr, settings);
     }
 
-    system_flush_tlb_entry(vaddr);
     return 0;
 }
 
@@ -1229,7 +1670,7 @@ int vmm_tune_page(uint32_t vaddr, uint32_t settings)
 {
     lock_acquire(&_vmm_lock);
     int res = vmm_tune_page_lockless(vaddr, settings);
-    lock_release(&_vmm_lock);
+    _vmm_lock_release();
     return res;
 }
 
@@ -1247,7 +1688,7 @@ int vmm_tune_pages(uint32_t vaddr, uint32_t length, uint32_t settings)
 {
     lock_acquire(&_vmm_lock);
     int res = vmm_tune_pages_lockless(vaddr, length, settings);
-    lock_release(&_vmm_lock);
+    _vmm_lock_release();
     return res;
 }
 
@@ -1268,7 +1709,7 @@ int vmm_load_page(uint32_t vaddr, uint32_t settings)
 {
     lock_acquire(&_vmm_lock);
     if (_vmm_is_page_present(vaddr)) {
-        lock_release(&_vmm_lock);
+        _vmm_lock_release();
         return -EALREADY;
     }
 
@@ -1279,7 +1720,7 @@ int vmm_load_page(uint32_t vaddr, uint32_t settings)
     }
     int res = vmm_map_page_lockless(vaddr, paddr, settings);
     uint8_t* dest = (uint8_t*)_vmm_round_floor_to_page(vaddr);
-    lock_release(&_vmm_lock);
+    _vmm_lock_release();
     memset(dest, 0, VMM_PAGE_SIZE);
     return res;
 }
@@ -1320,24 +1761,34 @@ int vmm_copy_page(uint32_t to_vaddr, uint32_t src_vaddr, ptable_t* src_ptable)
 {
     lock_acquire(&_vmm_lock);
     int res = vmm_copy_page_lockless(to_vaddr, src_vaddr, src_ptable);
-    lock_release(&_vmm_lock);
+    _vmm_lock_release();
     return res;
 }
 
+/**
+ * The page of the active pdir is unmapped, and its frame is retired if it's
+ * not shared anymore.
+ */
 static ALWAYS_INLINE int vmm_free_page_lockless(uint32_t vaddr, page_desc_t* page, dynamic_array_t* zones)
 {
     if (!page_desc_has_attrs(*page, PAGE_DESC_PRESENT)) {
         return 0;
     }
     page_desc_del_attrs(page, PAGE_DESC_PRESENT);
+    tlb_invalidate_page(vaddr);
 
-    proc_zone_t* zone = proc_find_zone_no_proc(zones, vaddr);
+    // Kernel pages have no proc zones.
+    proc_zone_t* zone = zones ? proc_find_zone_no_proc(zones, vaddr) : NULL;
     if (zone) {
         if (zone->type & ZONE_TYPE_DEVICE) {
             return 0;
         }
     }
-    _vmm_free_page_paddr(page_desc_get_frame(*page));
+
+    uint32_t frame = page_desc_get_frame(*page);
+    if (_vmm_frame_put(frame)) {
+        _vmm_retire_frame_lockless(frame);
+    }
     return 0;
 }
 
@@ -1345,22 +1796,65 @@ int vmm_free_page(uint32_t vaddr, page_desc_t* page, dynamic_array_t* zones)
 {
     lock_acquire(&_vmm_lock);
     int res = vmm_free_page_lockless(vaddr, page, zones);
-    lock_release(&_vmm_lock);
+    _vmm_lock_release();
+    return res;
+}
+
+/**
+ * The function is supposed to unmap pages of the active pdir and to free
+ * frames which are not shared anymore. Used by munmap.
+ */
+static ALWAYS_INLINE int vmm_free_pages_lockless(uint32_t vaddr, uint32_t n_pages, dynamic_array_t* zones)
+{
+    if (vaddr & 0xfff) {
+        return -VMM_ERR_BAD_ADDR;
+    }
+
+    for (; n_pages; vaddr += VMM_PAGE_SIZE, n_pages--) {
+        table_desc_t* ptable_desc = _vmm_pdirectory_lookup(THIS_CPU->pdir, vaddr);
+        if (table_desc_is_large(*ptable_desc) || !table_desc_has_attrs(*ptable_desc, TABLE_DESC_PRESENT)) {
+            continue;
+        }
+
+        if (table_desc_is_copy_on_write(*ptable_desc)) {
+            _vmm_ensure_cow_for_page(vaddr);
+        }
+
+        ptable_t* ptable = (ptable_t*)_vmm_pspace_get_vaddr_of_active_ptable(vaddr);
+        page_desc_t* page = _vmm_ptable_lookup(ptable, vaddr);
+        if (!page_desc_is_present(*page)) {
+            continue;
+        }
+
+        vmm_free_page_lockless(vaddr, page, zones);
+        page_desc_del_attrs(page, PAGE_DESC_WRITABLE);
+        page_desc_del_frame(page);
+    }
+
+    return 0;
+}
+
+int vmm_free_pages(uint32_t vaddr, uint32_t n_pages, dynamic_array_t* zones)
+{
+    lock_acquire(&_vmm_lock);
+    int res = vmm_free_pages_lockless(vaddr, n_pages, zones);
+    _vmm_lock_release();
     return res;
 }
 
 int vmm_page_fault_handler(uint32_t info, uint32_t vaddr)
 {
+    TRACE(TRACE_PAGE_FAULT, vaddr, info, 0, 0);
     lock_acquire(&_vmm_lock);
     if (_vmm_is_table_not_present(info) || _vmm_is_page_not_present(info)) {
         // Check again with locks, since other cpu could already load this page.
         if (_vmm_is_page_present(vaddr)) {
-            lock_release(&_vmm_lock);
+            _vmm_lock_release();
             return OK;
         }
 
         int res = _vmm_load_page_with_perm(vaddr);
-        lock_release(&_vmm_lock);
+        _vmm_lock_release();
         if (PAGE_CHOOSE_OWNER(vaddr) == PAGE_USER && vmm_get_active_pdir() != vmm_get_kernel_pdir()) {
             proc_t* holder_proc = tasking_get_proc_by_pdir(vmm_get_active_pdir());
             if (!holder_proc) {
@@ -1384,25 +1878,36 @@ int vmm_page_fault_handler(uint32_t info, uint32_t vaddr)
 
     if (_vmm_is_caused_writing(info)) {
         int visited = 0;
-        if (_vmm_is_copy_on_write(vaddr)) {
-            proc_t* holder_proc = tasking_get_proc_by_pdir(vmm_get_active_pdir());
+        proc_t* holder_proc = NULL;
+        if (PAGE_CHOOSE_OWNER(vaddr) == PAGE_USER) {
+            holder_proc = tasking_get_proc_by_pdir(vmm_get_active_pdir());
             if (!holder_proc) {
                 kpanic("No proc with the pdir\n");
             }
+        }
+        if (holder_proc && _vmm_is_copy_on_write(vaddr)) {
             _vmm_resolve_copy_on_write(holder_proc, vaddr);
             visited++;
         }
+        // Resolving a cow table leaves shared pages read-only, so the page is checked right after.
+        if (holder_proc && _vmm_is_page_copy_on_write(holder_proc, vaddr)) {
+            if (_vmm_resolve_page_copy_on_write(holder_proc, vaddr) < 0) {
+                _vmm_lock_release();
+                return SHOULD_CRASH;
+            }
+            visited++;
+        }
         // if (_vmm_is_zeroing_on_demand(vaddr)) {
         //     _vmm_resolve_zeroing_on_demand(vaddr);
         //     visited++;
         // }
         if (!visited) {
-            lock_release(&_vmm_lock);
+            _vmm_lock_release();
             return SHOULD_CRASH;
         }
     }
 
-    lock_release(&_vmm_lock);
+    _vmm_lock_release();
     return OK;
 }
 
@@ -1435,7 +1940,7 @@ int vmm_switch_pdir(pdirectory_t* pdir)
 {
     lock_acquire(&_vmm_lock);
     int res = vmm_switch_pdir_lockless(pdir);
-    lock_release(&_vmm_lock);
+    _vmm_lock_release();
     return res;
 }
 
@@ -11,6 +11,8 @@
 #include <drivers/aarch32/pl181.h>
 #include <drivers/aarch32/sp804.h>
 #include <drivers/aarch32/uart.h>
+#include <drivers/aarch32/virtio_mmio.h>
+#include <mem/vmm/tlb.h>
 #include <platform/aarch32/init.h>
 #include <platform/aarch32/interrupts.h>
 
@@ -26,6 +28,7 @@ void platform_setup_boot_cpu()
 {
     fpuv4_install();
     gic_setup();
+    tlb_setup_cpu();
 }
 
 void platform_setup_secondary_cpu()
@@ -33,6 +36,7 @@ void platform_setup_secondary_cpu()
     interrupts_setup_secondary_cpu();
     fpuv4_install();
     gic_setup_secondary_cpu();
+    tlb_setup_cpu();
 }
 
 void platform_drivers_setup()
@@ -40,6 +44,7 @@ void platform_drivers_setup()
     uart_remap();
     sp804_install();
     pl181_install();
+    virtio_mmio_install();
     pl111_install();
     pl050_keyboard_install();
     pl050_mouse_install();
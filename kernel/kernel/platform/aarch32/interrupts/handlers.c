@@ -15,6 +15,7 @@
 #include <syscalls/handlers.h>
 #include <tasking/cpu.h>
 #include <tasking/dump.h>
+#include <tasking/softirq.h>
 #include <tasking/tasking.h>
 
 #define ERR_BUF_SIZE 64
@@ -188,7 +189,9 @@ void irq_handler(trapframe_t* tf)
     /* We end the interrupt before handle it, since we can
        call sched() and not return here. */
     gic_descriptor.end_interrupt(int_disc);
+    irq_enter(int_disc & 0x1ff, tf);
     _irq_redirect(int_disc & 0x1ff);
+    irq_exit();
     cpu_leave_kernel_space();
     system_enable_interrupts_only_counter();
 }
@@ -203,4 +206,9 @@ void irq_register_handler(irq_line_t line, irq_priority_t prior, irq_type_t type
 {
     _irq_handlers[line] = func;
     gic_descriptor.enable_irq(line, prior, type, cpu_mask);
+}
+
+void irq_send_sgi(irq_line_t line, int cpu_mask)
+{
+    gic_descriptor.send_sgi(line, cpu_mask);
 }
\ No newline at end of file
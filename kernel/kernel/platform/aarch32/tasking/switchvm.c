@@ -16,6 +16,9 @@ void switchuvm(thread_t* thread)
 {
     system_disable_interrupts();
     RUNNING_THREAD = thread;
+    asm volatile("mcr p15, 0, %0, c13, c0, 3" // TPIDRURO
+                 :
+                 : "r"(thread->tls));
     vmm_switch_pdir(thread->process->pdir);
     fpu_make_unavail();
     system_enable_interrupts();
@@ -4,6 +4,7 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <platform/aarch32/vmm/consts.h>
 #include <platform/aarch32/vmm/pde.h>
 
 void table_desc_init(table_desc_t* pde)
@@ -109,3 +110,45 @@ uint32_t table_desc_get_frame(table_desc_t pde)
 {
     return ((pde.baddr) << TABLE_DESC_FRAME_OFFSET);
 }
+
+/**
+ * Large pages on aarch32 are 1MB sections. A section descriptor has
+ * another layout than a coarse table descriptor, so it's built from raw bits.
+ * The memory attributes follow page_desc_init: TEX=001, C=1, B=1 (normal,
+ * cacheable), TEX=001, C=0, B=0 (normal, not cacheable) for write-combining
+ * sections or strongly ordered memory for not cacheable sections.
+ */
+#define SECTION_TYPE 0b10
+#define SECTION_B (1 << 2)
+#define SECTION_C (1 << 3)
+#define SECTION_DOMAIN(x) ((x) << 5)
+#define SECTION_AP(x) ((x) << 10)
+#define SECTION_TEX(x) ((x) << 12)
+#define SECTION_S (1 << 16)
+
+void table_desc_init_large(table_desc_t* pde, uint32_t paddr, uint32_t attrs)
+{
+    uint32_t ap = 0b01; // Kernel -- R/W and User -- No access
+    if ((attrs & TABLE_DESC_USER) == TABLE_DESC_USER) {
+        ap = 0b10 | ((attrs & TABLE_DESC_WRITABLE) == TABLE_DESC_WRITABLE);
+    }
+
+    pde->data = (paddr & ~(VMM_LARGE_PAGE_SIZE - 1));
+    pde->data |= SECTION_TYPE | SECTION_DOMAIN(0b0011) | SECTION_AP(ap) | SECTION_S;
+    if ((attrs & TABLE_DESC_WRITE_COMBINING) == TABLE_DESC_WRITE_COMBINING) {
+        pde->data |= SECTION_TEX(0b001);
+    } else if ((attrs & TABLE_DESC_PCD) != TABLE_DESC_PCD) {
+        pde->data |= SECTION_TEX(0b001) | SECTION_C | SECTION_B;
+    }
+}
+
+bool table_desc_is_large(table_desc_t pde)
+{
+    return (pde.data & 0b11) == SECTION_TYPE;
+}
+
+uint32_t table_desc_get_large_frame(table_desc_t pde)
+{
+    return (pde.data & ~(VMM_LARGE_PAGE_SIZE - 1));
+}
+
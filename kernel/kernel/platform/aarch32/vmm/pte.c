@@ -35,6 +35,11 @@ void page_desc_set_attrs(page_desc_t* pte, uint32_t attrs)
     if ((attrs & PAGE_DESC_NOT_CACHEABLE) == PAGE_DESC_NOT_CACHEABLE) {
         pte->c = 0;
     }
+    // TEX=001, C=0, B=0 is normal non-cacheable memory: stores are buffered and merged.
+    if ((attrs & PAGE_DESC_WRITE_COMBINING) == PAGE_DESC_WRITE_COMBINING) {
+        pte->c = 0;
+        pte->b = 0;
+    }
 }
 
 void page_desc_del_attrs(page_desc_t* pte, uint32_t attrs)
@@ -51,6 +56,10 @@ void page_desc_del_attrs(page_desc_t* pte, uint32_t attrs)
     if ((attrs & PAGE_DESC_NOT_CACHEABLE) == PAGE_DESC_NOT_CACHEABLE) {
         pte->c = 1;
     }
+    if ((attrs & PAGE_DESC_WRITE_COMBINING) == PAGE_DESC_WRITE_COMBINING) {
+        pte->c = 1;
+        pte->b = 1;
+    }
 }
 
 bool page_desc_has_attrs(page_desc_t pte, uint32_t attrs)
@@ -61,12 +70,12 @@ bool page_desc_has_attrs(page_desc_t pte, uint32_t attrs)
         }
     }
     if ((attrs & PAGE_DESC_WRITABLE) == PAGE_DESC_WRITABLE) {
-        if (pte.ap1 != 0b01) {
+        if ((pte.ap1 & 0b01) == 0) {
             return false;
         }
     }
     if ((attrs & PAGE_DESC_USER) == PAGE_DESC_USER) {
-        if (pte.ap1 == 0b01) {
+        if ((pte.ap1 & 0b10) == 0) {
             return false;
         }
     }
@@ -96,12 +105,17 @@ bool page_desc_is_writable(page_desc_t pte)
 
 bool page_desc_is_user(page_desc_t pte)
 {
-    return page_desc_has_attrs(pte, PAGE_DESC_WRITABLE);
+    return page_desc_has_attrs(pte, PAGE_DESC_USER);
 }
 
 bool page_desc_is_not_cacheable(page_desc_t pte)
 {
-    return (pte.c == 0);
+    return (pte.c == 0 && pte.b == 1);
+}
+
+bool page_desc_is_write_combining(page_desc_t pte)
+{
+    return (pte.c == 0 && pte.b == 0);
 }
 
 uint32_t page_desc_get_frame(page_desc_t pte)
@@ -121,6 +135,9 @@ uint32_t page_desc_get_settings(page_desc_t pte)
     if (page_desc_is_not_cacheable(pte)) {
         res |= PAGE_NOT_CACHEABLE;
     }
+    if (page_desc_is_write_combining(pte)) {
+        res |= PAGE_WRITE_COMBINING;
+    }
     return res;
 }
 
@@ -136,5 +153,8 @@ uint32_t page_desc_get_settings_ignore_cow(page_desc_t pte)
     if (page_desc_is_not_cacheable(pte)) {
         res |= PAGE_NOT_CACHEABLE;
     }
+    if (page_desc_is_write_combining(pte)) {
+        res |= PAGE_WRITE_COMBINING;
+    }
     return res;
 }
\ No newline at end of file
@@ -0,0 +1,21 @@
+/*
+ * Copyright (c) 2021, Krisna Pranav
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <mem/vmm/tlb.h>
+#include <platform/aarch32/interrupts.h>
+
+/**
+ * SGIs are banked per cpu, so every cpu enables it for itself.
+ */
+void tlb_platform_setup_cpu()
+{
+    irq_register_handler(IRQ_SGI_TLB_SHOOTDOWN, 0, IRQ_TYPE_EDGE_TRIGGERED_MASK, tlb_shootdown_handler, ALL_CPU_MASK);
+}
+
+void tlb_platform_send_ipi(int cpu_id)
+{
+    irq_send_sgi(IRQ_SGI_TLB_SHOOTDOWN, (1 << cpu_id));
+}
@@ -0,0 +1,73 @@
+; AP startup code. The boot cpu copies it to AP_TRAMPOLINE_PADDR, fills
+; the params and wakes the AP with SIPI, so the code starts in real mode.
+
+AP_TRAMPOLINE_PADDR equ 0x70000
+%define TRAMPOLINE_OFFSET(x) ((x) - ap_trampoline_start)
+%define TRAMPOLINE_ADDR(x) (TRAMPOLINE_OFFSET(x) + AP_TRAMPOLINE_PADDR)
+
+global ap_trampoline_start
+global ap_trampoline_params
+global ap_trampoline_end
+
+[bits 16]
+ap_trampoline_start:
+    cli
+    cld
+    mov ax, cs
+    mov ds, ax
+    lgdt [TRAMPOLINE_OFFSET(ap_gdt_desc)]
+
+    mov eax, cr0
+    or eax, 0x1 ; CR0.PE
+    mov cr0, eax
+    jmp dword 0x08:TRAMPOLINE_ADDR(ap_protected_mode)
+
+[bits 32]
+ap_protected_mode:
+    mov ax, 0x10
+    mov ds, ax
+    mov es, ax
+    mov fs, ax
+    mov gs, ax
+    mov ss, ax
+
+    ; The kernel pdir identity maps the first 4MB, so we could keep
+    ; running here after paging is on.
+    mov eax, cr4
+    or eax, 0x10 ; CR4.PSE
+    mov cr4, eax
+    mov eax, [TRAMPOLINE_ADDR(ap_param_pdir)]
+    mov cr3, eax
+    mov eax, cr0
+    or eax, 0x80000000 ; CR0.PG
+    mov cr0, eax
+
+    ; A zero entry means the boot cpu gave up on this AP and freed its stack.
+    mov eax, [TRAMPOLINE_ADDR(ap_param_entry)]
+    test eax, eax
+    jz ap_halt
+    mov esp, [TRAMPOLINE_ADDR(ap_param_stack)]
+    call eax
+ap_halt:
+    cli
+    hlt
+    jmp ap_halt
+
+align 8
+ap_gdt:
+    dq 0x0000000000000000
+    dq 0x00CF9A000000FFFF ; kernel code
+    dq 0x00CF92000000FFFF ; kernel data
+ap_gdt_desc:
+    dw ap_gdt_desc - ap_gdt - 1
+    dd TRAMPOLINE_ADDR(ap_gdt)
+
+align 4
+ap_trampoline_params:
+ap_param_pdir:
+    dd 0
+ap_param_stack:
+    dd 0
+ap_param_entry:
+    dd 0
+ap_trampoline_end:
@@ -6,10 +6,12 @@
 
 #include <mem/kmalloc.h>
 #include <mem/vmm/vmm.h>
+#include <platform/generic/cpu.h>
+#include <platform/generic/system.h>
 #include <platform/x86/gdt.h>
 #include <platform/x86/tasking/tss.h>
 
-struct gdt_entry gdt[GDT_MAX_ENTRIES];
+struct gdt_entry gdt[CPU_CNT][GDT_MAX_ENTRIES];
 
 void lgdt(void* p, uint16_t size)
 {
@@ -24,9 +26,11 @@ void lgdt(void* p, uint16_t size)
 
 void gdt_setup()
 {
-    gdt[SEG_KCODE] = SEG_PG(SEGF_X | SEGF_R, 0, 0xffffffff, 0);
-    gdt[SEG_KDATA] = SEG_PG(SEGF_W, 0, 0xffffffff, 0);
-    gdt[SEG_UCODE] = SEG_PG(SEGF_X | SEGF_R, 0, 0xffffffff, DPL_USER);
-    gdt[SEG_UDATA] = SEG_PG(SEGF_W, 0, 0xffffffff, DPL_USER);
-    lgdt(gdt, sizeof(gdt));
+    struct gdt_entry* cpu_gdt = gdt[system_cpu_id()];
+    cpu_gdt[SEG_KCODE] = SEG_PG(SEGF_X | SEGF_R, 0, 0xffffffff, 0);
+    cpu_gdt[SEG_KDATA] = SEG_PG(SEGF_W, 0, 0xffffffff, 0);
+    cpu_gdt[SEG_UCODE] = SEG_PG(SEGF_X | SEGF_R, 0, 0xffffffff, DPL_USER);
+    cpu_gdt[SEG_UDATA] = SEG_PG(SEGF_W, 0, 0xffffffff, DPL_USER);
+    cpu_gdt[SEG_UTLS] = SEG_PG(SEGF_W, 0, 0xffffffff, DPL_USER);
+    lgdt(cpu_gdt, sizeof(gdt[0]));
 }
\ No newline at end of file
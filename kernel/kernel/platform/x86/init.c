@@ -10,12 +10,17 @@
 #include <drivers/x86/fpu.h>
 #include <drivers/x86/ide.h>
 #include <drivers/x86/keyboard.h>
+#include <drivers/x86/lapic.h>
 #include <drivers/x86/mouse.h>
 #include <drivers/x86/pci.h>
 #include <drivers/x86/pit.h>
+#include <drivers/x86/virtio_pci.h>
+#include <mem/vmm/tlb.h>
 #include <platform/x86/gdt.h>
 #include <platform/x86/idt.h>
 #include <platform/x86/init.h>
+#include <platform/x86/smp.h>
+#include <platform/x86/vmm/pat.h>
 
 void platform_init_boot_cpu()
 {
@@ -28,10 +33,20 @@ void platform_setup_boot_cpu()
     clean_screen();
     pit_setup();
     fpu_init();
+    tlb_setup_cpu();
+    pat_setup_cpu();
+    smp_setup();
 }
 
 void platform_setup_secondary_cpu()
 {
+    gdt_setup();
+    interrupts_setup_secondary_cpu();
+    lapic_install_secondary_cpu();
+    lapic_timer_setup();
+    tlb_setup_cpu();
+    pat_setup_cpu();
+    fpu_init_secondary_cpu();
 }
 
 void platform_drivers_setup()
@@ -39,6 +54,7 @@ void platform_drivers_setup()
     pci_install();
     ide_install();
     ata_install();
+    virtio_pci_blk_install();
     kbdriver_install();
     mouse_install();
     bga_install();
@@ -83,6 +83,10 @@ void interrupts_setup()
         idt_element_setup(i, (void*)syscall, SYS);
     }
 
+    idt_element_setup(IRQ_LAPIC_TIMER, (void*)irq_lapic_timer, SYS);
+    idt_element_setup(IRQ_TLB_SHOOTDOWN, (void*)irq_tlb_shootdown, SYS);
+    idt_element_setup(IRQ_LAPIC_SPURIOUS, (void*)irq_lapic_spurious, SYS);
+
     idt_element_setup(SYSCALL_HANDLER_NO, (void*)syscall, USER);
 
     init_irq_handlers();
@@ -90,6 +94,14 @@ void interrupts_setup()
     asm volatile("sti");
 }
 
+/**
+ * IDT is shared between all cpus, APs have only to load it.
+ */
+void interrupts_setup_secondary_cpu()
+{
+    lidt(idt, sizeof(idt));
+}
+
 void set_irq_handler(uint8_t interrupt_no, void (*handler)())
 {
     handlers[interrupt_no] = (void*)handler;
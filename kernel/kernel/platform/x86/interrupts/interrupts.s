@@ -47,6 +47,9 @@ global irq12
 global irq13
 global irq14
 global irq15
+global irq_lapic_timer
+global irq_lapic_spurious
+global irq_tlb_shootdown
 
 global syscall
 
@@ -415,6 +418,22 @@ irq15:
     push 47
     jmp  irq_common
 
+
+irq_lapic_timer:
+    push 0
+    push 48
+    jmp  irq_common
+
+
+irq_tlb_shootdown:
+    push 0
+    push 49
+    jmp  irq_common
+
+; Spurious interrupts must not be acknowledged with EOI.
+irq_lapic_spurious:
+    iret
+
 syscall:
     push 0
     push 0x80
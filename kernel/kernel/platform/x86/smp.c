@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) 2021, Krisna Pranav
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <drivers/x86/acpi.h>
+#include <drivers/x86/ioapic.h>
+#include <drivers/x86/lapic.h>
+#include <drivers/x86/pit.h>
+#include <libkern/libkern.h>
+#include <libkern/log.h>
+#include <mem/vmm/vmm.h>
+#include <mem/vmm/zoner.h>
+#include <platform/generic/registers.h>
+#include <platform/generic/system.h>
+#include <platform/x86/memmap.h>
+#include <platform/x86/smp.h>
+
+// #define DEBUG_SMP
+#define SMP_AP_STACK_SIZE (4 * VMM_PAGE_SIZE)
+#define SMP_AP_START_TIMEOUT_MS 100
+
+extern void ap_trampoline_start();
+extern void ap_trampoline_params();
+extern void ap_trampoline_end();
+extern void boot_secondary_cpu();
+
+static int _smp_ap_started = 0;
+
+static void _smp_ap_entry()
+{
+    __atomic_store_n(&_smp_ap_started, 1, __ATOMIC_RELEASE);
+    boot_secondary_cpu();
+}
+
+static inline bool _smp_is_ap_started()
+{
+    return __atomic_load_n(&_smp_ap_started, __ATOMIC_ACQUIRE);
+}
+
+static void _smp_copy_trampoline()
+{
+    uint32_t size = (uint32_t)ap_trampoline_end - (uint32_t)ap_trampoline_start;
+    memcpy((void*)(BIOS_SETTING_BASE + AP_TRAMPOLINE_PADDR), (void*)ap_trampoline_start, size);
+}
+
+static inline ap_trampoline_params_t* _smp_trampoline_params()
+{
+    uint32_t offset = (uint32_t)ap_trampoline_params - (uint32_t)ap_trampoline_start;
+    return (ap_trampoline_params_t*)(BIOS_SETTING_BASE + AP_TRAMPOLINE_PADDR + offset);
+}
+
+/**
+ * Starts an AP with INIT-SIPI-SIPI sequence. APs are started one by one,
+ * since they share the trampoline params. An AP which does not respond
+ * in time is put back into INIT and the params are disarmed before its
+ * stack is freed, so it can't come up late on the params of the next AP.
+ */
+static bool _smp_start_ap(uint8_t apic_id)
+{
+    zone_t stack_zone = zoner_new_zone(SMP_AP_STACK_SIZE);
+    for (uint32_t offset = 0; offset < SMP_AP_STACK_SIZE; offset += VMM_PAGE_SIZE) {
+        vmm_load_page(stack_zone.start + offset, PAGE_READABLE | PAGE_WRITABLE);
+    }
+
+    ap_trampoline_params_t* params = _smp_trampoline_params();
+    params->pdir = read_cr3();
+    params->stack = stack_zone.start + SMP_AP_STACK_SIZE;
+    params->entry = (uint32_t)_smp_ap_entry;
+    __atomic_store_n(&_smp_ap_started, 0, __ATOMIC_RELEASE);
+
+    lapic_send_init(apic_id);
+    pit_busy_wait_us(10000);
+    for (int i = 0; i < 2 && !_smp_is_ap_started(); i++) {
+        lapic_send_startup(apic_id, AP_TRAMPOLINE_PADDR);
+        pit_busy_wait_us(200);
+    }
+
+    for (int i = 0; i < SMP_AP_START_TIMEOUT_MS && !_smp_is_ap_started(); i++) {
+        pit_busy_wait_us(1000);
+    }
+    if (_smp_is_ap_started()) {
+        return true;
+    }
+
+    lapic_send_init(apic_id);
+    pit_busy_wait_us(10000);
+    __atomic_store_n(&params->entry, 0, __ATOMIC_RELEASE);
+    vmm_free_pages(stack_zone.start, SMP_AP_STACK_SIZE / VMM_PAGE_SIZE, NULL);
+    zoner_free_zone(stack_zone);
+    return false;
+}
+
+/**
+ * Moves interrupt delivery from 8259 to LAPIC/IOAPIC and wakes APs up.
+ * If ACPI tables are not found, the system stays on a single cpu with 8259.
+ */
+void smp_setup()
+{
+    if (acpi_install() < 0) {
+        return;
+    }
+
+    acpi_madt_info_t* info = acpi_madt_info();
+    if (!info->ioapic_paddr) {
+        return;
+    }
+
+    system_disable_interrupts();
+    lapic_install(info->lapic_paddr ? info->lapic_paddr : LAPIC_DEFAULT_PADDR);
+    uint8_t boot_apic_id = lapic_id();
+    lapic_id_to_cpu_id[boot_apic_id] = 0;
+    lapic_cpu_id_to_lapic_id[0] = boot_apic_id;
+    ioapic_install(info, boot_apic_id);
+    system_enable_interrupts();
+
+    _smp_copy_trampoline();
+    int cpu_id = 1;
+    for (int i = 0; i < info->cpu_count && cpu_id < CPU_CNT; i++) {
+        uint8_t apic_id = info->cpu_apic_ids[i];
+        if (apic_id == boot_apic_id) {
+            continue;
+        }
+
+        // The AP looks its cpu id up as soon as it runs, so only this
+        // direction is set before the start and it is undone on failure.
+        lapic_id_to_cpu_id[apic_id] = cpu_id;
+        if (!_smp_start_ap(apic_id)) {
+            lapic_id_to_cpu_id[apic_id] = 0;
+            log_warn("SMP: cpu with apic id %d is not responding", apic_id);
+            continue;
+        }
+        lapic_cpu_id_to_lapic_id[cpu_id] = apic_id;
+        cpu_id++;
+    }
+
+#ifdef DEBUG_SMP
+    log("SMP: %d cpus are started", cpu_id);
+#endif
+}
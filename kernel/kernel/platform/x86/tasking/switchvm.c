@@ -15,11 +15,13 @@
 void switchuvm(thread_t* thread)
 {
     system_disable_interrupts();
-    gdt[SEG_TSS] = SEG_BG(SEGTSS_TYPE, &tss, sizeof(tss) - 1, 0);
+    int cpu_id = system_cpu_id();
+    gdt[cpu_id][SEG_TSS] = SEG_BG(SEGTSS_TYPE, &tss[cpu_id], sizeof(tss_t) - 1, 0);
+    gdt[cpu_id][SEG_UTLS] = SEG_PG(SEGF_W, thread->tls, 0xffffffff, DPL_USER);
     uint32_t esp0 = ((uint32_t)thread->tf + sizeof(trapframe_t));
-    tss.esp0 = esp0;
-    tss.ss0 = (SEG_KDATA << 3);
-    // tss.iomap_offset = 0xffff;
+    tss[cpu_id].esp0 = esp0;
+    tss[cpu_id].ss0 = (SEG_KDATA << 3);
+    // tss[cpu_id].iomap_offset = 0xffff;
     RUNNING_THREAD = thread;
     fpu_make_unavail();
     ltr(SEG_TSS << 3);
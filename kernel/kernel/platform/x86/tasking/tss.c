@@ -6,10 +6,11 @@
 
 #include <mem/kmalloc.h>
 #include <mem/vmm/vmm.h>
+#include <platform/generic/cpu.h>
 #include <platform/x86/gdt.h>
 #include <platform/x86/tasking/tss.h>
 
-tss_t tss;
+tss_t tss[CPU_CNT];
 
 void ltr(uint16_t seg)
 {
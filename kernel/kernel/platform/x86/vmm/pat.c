@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) 2021, Krisna Pranav
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <libkern/log.h>
+#include <platform/x86/system.h>
+#include <platform/x86/vmm/pat.h>
+
+// #define DEBUG_PAT
+
+#define CPUID_FEATURES_EDX_PAT (1 << 16)
+
+static bool _pat_supported = false;
+
+static inline uint32_t _pat_cpuid_features_edx()
+{
+    uint32_t eax = 1, ebx, ecx = 0, edx;
+    asm volatile("cpuid"
+                 : "+a"(eax), "=b"(ebx), "+c"(ecx), "=d"(edx));
+    return edx;
+}
+
+/**
+ * Every cpu has its own PAT, all of them should be programmed the same
+ * way before any write-combining page is mapped.
+ */
+void pat_setup_cpu()
+{
+    if (!(_pat_cpuid_features_edx() & CPUID_FEATURES_EDX_PAT)) {
+#ifdef DEBUG_PAT
+        log_warn("PAT: not supported, write-combining falls back to uncached");
+#endif
+        return;
+    }
+
+    // Caches and TLB must not hold lines of the old memory type.
+    system_flush_caches();
+    system_write_msr(MSR_IA32_PAT, PAT_VALUE);
+    system_flush_caches();
+    system_flush_whole_tlb();
+
+    // Only the boot cpu sets the flag, secondaries are the same model.
+    if (system_cpu_id() == 0) {
+        _pat_supported = true;
+    }
+#ifdef DEBUG_PAT
+    log("PAT: cpu %d programmed", system_cpu_id());
+#endif
+}
+
+bool pat_is_supported()
+{
+    return _pat_supported;
+}
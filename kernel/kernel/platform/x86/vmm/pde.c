@@ -4,6 +4,8 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <platform/x86/vmm/consts.h>
+#include <platform/x86/vmm/pat.h>
 #include <platform/x86/vmm/pde.h>
 
 void table_desc_init(table_desc_t* pde)
@@ -78,3 +80,28 @@ uint32_t table_desc_get_frame(table_desc_t pde)
 {
     return ((pde >> TABLE_DESC_FRAME_OFFSET) << TABLE_DESC_FRAME_OFFSET);
 }
+
+/**
+ * Large pages on x86 are 4MB PSE pages, which are described right in
+ * a pdir. @attrs are TABLE_DESC_* flags.
+ */
+void table_desc_init_large(table_desc_t* pde, uint32_t paddr, uint32_t attrs)
+{
+    *pde = (paddr & ~(VMM_LARGE_PAGE_SIZE - 1));
+    *pde |= TABLE_DESC_4MB | TABLE_DESC_PRESENT;
+    *pde |= (attrs & (TABLE_DESC_WRITABLE | TABLE_DESC_USER | TABLE_DESC_PWT | TABLE_DESC_PCD));
+    if (attrs & TABLE_DESC_WRITE_COMBINING) {
+        *pde |= pat_is_supported() ? TABLE_DESC_WRITE_COMBINING : TABLE_DESC_PCD;
+    }
+}
+
+bool table_desc_is_large(table_desc_t pde)
+{
+    return table_desc_is_present(pde) && table_desc_is_4mb(pde);
+}
+
+uint32_t table_desc_get_large_frame(table_desc_t pde)
+{
+    return (pde & ~(VMM_LARGE_PAGE_SIZE - 1));
+}
+
@@ -5,6 +5,7 @@
  */
 
 #include <mem/vmm/vmm.h>
+#include <platform/x86/vmm/pat.h>
 #include <platform/x86/vmm/pte.h>
 
 void page_desc_init(page_desc_t* pte)
@@ -14,6 +15,10 @@ void page_desc_init(page_desc_t* pte)
 
 void page_desc_set_attrs(page_desc_t* pte, uint32_t attrs)
 {
+    // Without PAT the bit is reserved, such pages stay uncached.
+    if ((attrs & PAGE_DESC_WRITE_COMBINING) && !pat_is_supported()) {
+        attrs = (attrs & ~PAGE_DESC_WRITE_COMBINING) | PAGE_DESC_NOT_CACHEABLE;
+    }
     *pte |= attrs;
 }
 
@@ -59,6 +64,11 @@ bool page_desc_is_not_cacheable(page_desc_t pte)
     return ((pte & PAGE_DESC_NOT_CACHEABLE) > 0);
 }
 
+bool page_desc_is_write_combining(page_desc_t pte)
+{
+    return ((pte & PAGE_DESC_WRITE_COMBINING) > 0);
+}
+
 bool page_desc_is_cow(page_desc_t pte)
 {
     return ((pte & PAGE_DESC_COPY_ON_WRITE) > 0);
@@ -81,6 +91,9 @@ uint32_t page_desc_get_settings(page_desc_t pte)
     if (page_desc_is_not_cacheable(pte)) {
         res |= PAGE_NOT_CACHEABLE;
     }
+    if (page_desc_is_write_combining(pte)) {
+        res |= PAGE_WRITE_COMBINING;
+    }
     if (page_desc_is_cow(pte)) {
         res |= PAGE_COW;
     }
@@ -99,5 +112,8 @@ uint32_t page_desc_get_settings_ignore_cow(page_desc_t pte)
     if (page_desc_is_not_cacheable(pte)) {
         res |= PAGE_NOT_CACHEABLE;
     }
+    if (page_desc_is_write_combining(pte)) {
+        res |= PAGE_WRITE_COMBINING;
+    }
     return res;
 }
\ No newline at end of file
@@ -0,0 +1,19 @@
+/*
+ * Copyright (c) 2021, Krisna Pranav
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <drivers/x86/lapic.h>
+#include <mem/vmm/tlb.h>
+#include <platform/x86/idt.h>
+
+void tlb_platform_setup_cpu()
+{
+    set_irq_handler(IRQ_TLB_SHOOTDOWN, tlb_shootdown_handler);
+}
+
+void tlb_platform_send_ipi(int cpu_id)
+{
+    lapic_send_ipi(lapic_cpu_id_to_lapic_id[cpu_id], IRQ_TLB_SHOOTDOWN);
+}
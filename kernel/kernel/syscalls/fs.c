@@ -329,7 +329,7 @@ void sys_mmap(trapframe_t* tf)
     }
 
     if (map_stack) {
-        zone = proc_new_random_zone_backward(p, params->size);
+        zone = proc_new_stack_zone(p, params->size);
     } else if (map_anonymous) {
         zone = proc_new_random_zone(p, params->size);
     } else {
@@ -377,6 +377,22 @@ void sys_munmap(trapframe_t* tf)
         return_with_val(vfs_munmap(p, zone));
     }
 
-    // TODO: Split or remove zone
+    // TODO: Split zone
+    if ((uint32_t)ptr != zone->start || (zone->type & ZONE_TYPE_DEVICE)) {
+        return_with_val(0);
+    }
+
+    vmm_free_pages(zone->start, (zone->len + VMM_PAGE_SIZE - 1) / VMM_PAGE_SIZE, &p->zones);
+
+    // Stacks go with the guard page below them, see proc_new_stack_zone.
+    uint32_t guard_start = zone->start - VMM_PAGE_SIZE;
+    bool is_stack = (zone->type & ZONE_TYPE_STACK);
+    proc_delete_zone(p, zone);
+    if (is_stack) {
+        proc_zone_t* guard_zone = proc_find_zone(p, guard_start);
+        if (guard_zone && guard_zone->type == ZONE_TYPE_GUARD) {
+            proc_delete_zone(p, guard_zone);
+        }
+    }
     return_with_val(0);
 }
\ No newline at end of file
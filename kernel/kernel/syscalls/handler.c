@@ -7,6 +7,7 @@
 #include <libkern/bits/errno.h>
 #include <libkern/libkern.h>
 #include <libkern/log.h>
+#include <libkern/trace.h>
 #include <mem/kmalloc.h>
 #include <platform/generic/syscalls/params.h>
 #include <platform/generic/system.h>
@@ -62,6 +63,12 @@ static const void* syscalls[] = {
     [SYS_SHBUF_CREATE] = sys_shbuf_create,
     [SYS_SHBUF_GET] = sys_shbuf_get,
     [SYS_SHBUF_FREE] = sys_shbuf_free,
+    [SYS_VFORK] = sys_vfork,
+    [SYS_SPAWN] = sys_spawn,
+    [SYS_EPOLL_CREATE] = sys_epoll_create,
+    [SYS_EPOLL_CTL] = sys_epoll_ctl,
+    [SYS_EPOLL_WAIT] = sys_epoll_wait,
+    [SYS_EXIT_THREAD] = sys_exit_thread,
 };
 
 #ifdef __i386__
@@ -107,8 +114,11 @@ void sys_handler(trapframe_t* tf)
 {
     system_disable_interrupts();
     cpu_enter_kernel_space();
-    void (*callee)(trapframe_t*) = (void*)syscalls[sys_id];
+    uint32_t id = sys_id;
+    TRACE(TRACE_SYSCALL_ENTER, id, param1, param2, param3);
+    void (*callee)(trapframe_t*) = (void*)syscalls[id];
     callee(tf);
+    TRACE(TRACE_SYSCALL_EXIT, id, return_val, 0, 0);
     cpu_leave_kernel_space();
     system_enable_interrupts_only_counter();
 }
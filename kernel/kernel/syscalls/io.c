@@ -4,6 +4,7 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <io/epoll/epoll.h>
 #include <io/shared_buffer/shared_buffer.h>
 #include <io/sockets/local_socket.h>
 #include <libkern/bits/errno.h>
@@ -106,4 +107,70 @@ void sys_shbuf_free(trapframe_t* tf)
 {
     int id = param1;
     return_with_val(shared_buffer_free(id));
-}
\ No newline at end of file
+}
+
+static epoll_t* _sys_get_epoll(proc_t* p, int epfd)
+{
+    file_descriptor_t* fd = proc_get_fd(p, epfd);
+    if (!fd || fd->type != FD_TYPE_EPOLL) {
+        return NULL;
+    }
+    return fd->epoll;
+}
+
+void sys_epoll_create(trapframe_t* tf)
+{
+    proc_t* p = RUNNING_THREAD->process;
+    file_descriptor_t* fd = proc_get_free_fd(p);
+    if (!fd) {
+        return_with_val(-EMFILE);
+    }
+
+    int res = epoll_create(fd);
+    if (res) {
+        return_with_val(res);
+    }
+    return_with_val(proc_get_fd_id(p, fd));
+}
+
+void sys_epoll_ctl(trapframe_t* tf)
+{
+    proc_t* p = RUNNING_THREAD->process;
+    epoll_t* ep = _sys_get_epoll(p, param1);
+    int op = param2;
+    int fd = param3;
+    epoll_event_t* event = (epoll_event_t*)param4;
+
+    if (!ep) {
+        return_with_val(-EBADF);
+    }
+    if (op != EPOLL_CTL_DEL && !event) {
+        return_with_val(-EFAULT);
+    }
+    if (op != EPOLL_CTL_DEL && !proc_get_fd(p, fd)) {
+        return_with_val(-EBADF);
+    }
+    return_with_val(epoll_ctl(ep, op, fd, event));
+}
+
+void sys_epoll_wait(trapframe_t* tf)
+{
+    proc_t* p = RUNNING_THREAD->process;
+    epoll_t* ep = _sys_get_epoll(p, param1);
+    epoll_event_t* events = (epoll_event_t*)param2;
+    int maxevents = param3;
+    int timeout = param4;
+
+    if (!ep) {
+        return_with_val(-EBADF);
+    }
+    if (maxevents <= 0 || !events) {
+        return_with_val(-EINVAL);
+    }
+
+    int err = init_epoll_blocker(RUNNING_THREAD, ep, timeout);
+    if (err) {
+        return_with_val(err);
+    }
+    return_with_val(epoll_collect(p, ep, events, maxevents, true));
+}
@@ -22,6 +22,17 @@ void sys_fork(trapframe_t* tf)
     tasking_fork(tf);
 }
 
+void sys_vfork(trapframe_t* tf)
+{
+    tasking_vfork(tf);
+}
+
+void sys_spawn(trapframe_t* tf)
+{
+    int res = tasking_spawn((char*)param1, (const char**)param2, (const char**)param3);
+    return_with_val(res);
+}
+
 void sys_waitpid(trapframe_t* tf)
 {
     int ret = tasking_waitpid(param1);
@@ -110,9 +121,39 @@ void sys_create_thread(trapframe_t* tf)
     set_stack_pointer(thread->tf, esp);
     set_base_pointer(thread->tf, esp);
 
+    // Entry points never return, libc starts threads through a trampoline
+    // which calls pthread_exit.
+#ifdef __i386__
+    tf_push_to_stack(thread->tf, params->arg);
+    tf_push_to_stack(thread->tf, 0); // Return address
+#elif __arm__
+    thread->tf->r[0] = params->arg;
+#endif
+
+    int err = thread_setup_tls(thread);
+    if (err) {
+        thread->status = THREAD_DYING;
+        thread_free(thread);
+        return_with_val(err);
+    }
+
+    sched_enqueue(thread);
     return_with_val(thread->tid);
 }
 
+void sys_exit_thread(trapframe_t* tf)
+{
+    thread_t* thread = RUNNING_THREAD;
+    if (thread == thread->process->main_thread) {
+        tasking_exit((int)param1);
+        return;
+    }
+
+    // The kernel stack is freed with the proc, since we are running on it.
+    thread_die(thread);
+    resched();
+}
+
 void sys_sleep(trapframe_t* tf)
 {
     thread_t* p = RUNNING_THREAD;
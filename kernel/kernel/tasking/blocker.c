@@ -4,6 +4,9 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <drivers/bio.h>
+#include <io/epoll/epoll.h>
+#include <libkern/bits/errno.h>
 #include <libkern/libkern.h>
 #include <libkern/log.h>
 #include <libkern/syscall_structs.h>
@@ -35,6 +38,36 @@ int init_join_blocker(thread_t* thread)
     return 0;
 }
 
+int should_unblock_vfork_block(thread_t* thread)
+{
+    // The parent could run again as soon as the child leaves its address space.
+    thread_t* child = thread->joinee;
+    if (child->status == THREAD_DYING || child->status == THREAD_DEAD) {
+        return 1;
+    }
+    if (child->process->vfork_parent != thread) {
+        return 1;
+    }
+    return 0;
+}
+
+int init_vfork_blocker(thread_t* thread, thread_t* child)
+{
+    thread->joinee = child;
+
+    if (should_unblock_vfork_block(thread)) {
+        return 0;
+    }
+
+    thread->status = THREAD_BLOCKED;
+    thread->blocker.reason = BLOCKER_VFORK;
+    thread->blocker.should_unblock = should_unblock_vfork_block;
+    thread->blocker.should_unblock_for_signal = false;
+    sched_dequeue(thread);
+    resched();
+    return 0;
+}
+
 int should_unblock_read_block(thread_t* thread)
 {
     return thread->blocker_fd->ops->can_read(thread->blocker_fd->dentry, thread->blocker_fd->offset);
@@ -161,3 +194,79 @@ int init_select_blocker(thread_t* thread, int nfds, fd_set_t* readfds, fd_set_t*
     resched();
     return 0;
 }
+
+int should_unblock_epoll_block(thread_t* thread)
+{
+    if (thread->blocker.interrupted) {
+        return true;
+    }
+
+    if (thread->unblock_ticks != 0 && thread->unblock_ticks <= timeman_ticks_since_boot()) {
+        return true;
+    }
+
+    // Nothing has been produced since the last check, no need to poll fds.
+    uint32_t gen = epoll_get_generation();
+    if (gen == thread->blocker_epoll_gen) {
+        return false;
+    }
+    thread->blocker_epoll_gen = gen;
+    return epoll_collect(thread->process, thread->blocker_epoll, NULL, EPOLL_MAX_ITEMS, false) > 0;
+}
+
+int init_epoll_blocker(thread_t* thread, epoll_t* ep, int timeout_ms)
+{
+    thread->blocker_epoll = ep;
+    thread->blocker_epoll_gen = epoll_get_generation();
+    thread->unblock_ticks = 0;
+
+    if (timeout_ms == 0) {
+        return 0;
+    }
+    if (timeout_ms > 0) {
+        // Long timeouts are clamped to the furthest tick.
+        time_t now = timeman_ticks_since_boot();
+        uint64_t ticks = ((uint64_t)timeout_ms * timeman_ticks_per_second() + 999) / 1000;
+        if (ticks > (time_t)(-1) - now) {
+            ticks = (time_t)(-1) - now;
+        }
+        thread->unblock_ticks = now + (time_t)ticks;
+    }
+
+    if (epoll_collect(thread->process, ep, NULL, EPOLL_MAX_ITEMS, false) > 0) {
+        return 0;
+    }
+
+    thread->status = THREAD_BLOCKED;
+    thread->blocker.reason = BLOCKER_EPOLL;
+    thread->blocker.should_unblock = should_unblock_epoll_block;
+    thread->blocker.should_unblock_for_signal = true;
+    thread->blocker.interrupted = false;
+    sched_dequeue(thread);
+    resched();
+
+    if (thread->blocker.interrupted) {
+        return -EINTR;
+    }
+    return 0;
+}
+
+int should_unblock_blk_block(thread_t* thread)
+{
+    return blk_has_pending_work();
+}
+
+int init_blk_blocker(thread_t* thread)
+{
+    if (should_unblock_blk_block(thread)) {
+        return 0;
+    }
+
+    thread->status = THREAD_BLOCKED;
+    thread->blocker.reason = BLOCKER_BLK;
+    thread->blocker.should_unblock = should_unblock_blk_block;
+    thread->blocker.should_unblock_for_signal = false;
+    sched_dequeue(thread);
+    resched();
+    return 0;
+}
@@ -23,9 +23,15 @@
 
 #define PAGES_PER_COPING_BUFFER 8
 #define COPING_BUFFER_LEN (PAGES_PER_COPING_BUFFER * VMM_PAGE_SIZE)
-#define USER_STACK_SIZE VMM_PAGE_SIZE
 
-static int _elf_load_do_copy_to_ram(proc_t* p, file_descriptor_t* fd, elf_program_header_32_t* ph)
+/* Filled while program headers of the exec are walked. */
+struct elf_load_info {
+    bool dynamic;
+    char interp[ELF_INTERP_PATH_MAX];
+};
+typedef struct elf_load_info elf_load_info_t;
+
+static int _elf_load_do_copy_to_ram(proc_t* p, file_descriptor_t* fd, elf_program_header_32_t* ph, uint32_t base)
 {
     pdirectory_t* prev_pdir = vmm_get_active_pdir();
     vmm_switch_pdir(p->pdir);
@@ -42,7 +48,7 @@ static int _elf_load_do_copy_to_ram(proc_t* p, file_descriptor_t* fd, elf_progra
     zone_t coping_zone = zoner_new_zone(COPING_BUFFER_LEN);
     uint32_t mem_remaining = ph->p_memsz;
     uint32_t file_remaining = ph->p_filesz;
-    uint32_t mem_offset = ph->p_vaddr;
+    uint32_t mem_offset = base + ph->p_vaddr;
     uint32_t file_offset = ph->p_offset;
 
     while (mem_remaining) {
@@ -70,7 +76,7 @@ static int _elf_load_do_copy_to_ram(proc_t* p, file_descriptor_t* fd, elf_progra
     return vmm_switch_pdir(prev_pdir);
 }
 
-static int _elf_load_interpret_program_header_entry(proc_t* p, file_descriptor_t* fd)
+static int _elf_load_interpret_program_header_entry(proc_t* p, file_descriptor_t* fd, elf_load_info_t* info)
 {
     elf_program_header_32_t ph;
     int err = vfs_read(fd, &ph, sizeof(ph));
@@ -83,7 +89,28 @@ static int _elf_load_interpret_program_header_entry(proc_t* p, file_descriptor_t
 #endif
     switch (ph.p_type) {
     case PT_LOAD:
-        _elf_load_do_copy_to_ram(p, fd, &ph);
+        _elf_load_do_copy_to_ram(p, fd, &ph, 0);
+        break;
+    case PT_DYNAMIC:
+        info->dynamic = true;
+        break;
+    case PT_INTERP: {
+        if (ph.p_filesz >= ELF_INTERP_PATH_MAX) {
+            return -ENAMETOOLONG;
+        }
+        int read = fd->ops->read(fd->dentry, (uint8_t*)info->interp, ph.p_offset, ph.p_filesz);
+        if (read < 0 || (uint32_t)read != ph.p_filesz) {
+            info->interp[0] = '\0';
+            return -ENOEXEC;
+        }
+        info->interp[read] = '\0';
+        break;
+    }
+    case PT_TLS:
+        p->tls.start = ph.p_vaddr;
+        p->tls.filesz = ph.p_filesz;
+        p->tls.memsz = ph.p_memsz;
+        p->tls.align = ph.p_align;
         break;
     default:
         break;
@@ -103,6 +130,11 @@ static int _elf_load_interpret_section_header_entry(proc_t* p, file_descriptor_t
 #ifdef ELF_DEBUG
     log("Section type %x %x - %x", sh.sh_type, sh.sh_addr, sh.sh_size);
 #endif
+    // .tbss takes no space in the image, its address overlaps the next section.
+    if ((sh.sh_flags & SHF_TLS) && sh.sh_type == SHT_NOBITS) {
+        return 0;
+    }
+
     if (sh.sh_flags & SHF_ALLOC) {
         uint32_t zone_flags = ZONE_READABLE;
         uint32_t zone_type = ZONE_TYPE_NULL;
@@ -146,14 +178,191 @@ static int _elf_load_interpret_section_header_entry(proc_t* p, file_descriptor_t
 
 static int _elf_load_alloc_stack(proc_t* p)
 {
-    proc_zone_t* stack_zone = proc_new_random_zone_backward(p, USER_STACK_SIZE);
-    stack_zone->type = ZONE_TYPE_STACK;
-    stack_zone->flags |= ZONE_READABLE | ZONE_WRITABLE;
+    proc_zone_t* stack_zone = proc_new_stack_zone(p, USER_STACK_SIZE);
+    if (!stack_zone) {
+        return -ENOMEM;
+    }
     set_base_pointer(p->main_thread->tf, stack_zone->start + USER_STACK_SIZE);
     set_stack_pointer(p->main_thread->tf, stack_zone->start + USER_STACK_SIZE);
     return 0;
 }
 
+static int _elf_check_ident(elf_header_32_t* header)
+{
+    static const char elf_signature[] = { 0x7F, 0x45, 0x4c, 0x46 };
+    if (memcmp(header->e_ident, elf_signature, sizeof(elf_signature)) != 0) {
+        return -ENOEXEC;
+    }
+
+    // Currently we support only 32bit execs
+    if (header->e_ident[EI_CLASS] != ELF_CLASS_32) {
+        return -EBADARCH;
+    }
+
+    if (header->e_machine != MACHINE_ARCH) {
+        return -EBADARCH;
+    }
+
+    return 0;
+}
+
+/**
+ * The loader reads program headers of the exec from its own memory, so
+ * they are copied out of the file. PT_PHDR isn't relied on, since it is
+ * present only when the linker maps the headers.
+ */
+static int _elf_load_copy_phdrs(proc_t* p, file_descriptor_t* fd, elf_header_32_t* header)
+{
+    uint32_t len = header->e_phnum * sizeof(elf_program_header_32_t);
+    proc_zone_t* zone = proc_new_random_zone(p, len);
+    if (!zone) {
+        return -ENOMEM;
+    }
+    zone->type = ZONE_TYPE_DATA;
+    zone->flags |= ZONE_READABLE;
+
+    uint8_t* phdrs = kmalloc(len);
+    if (!phdrs) {
+        proc_delete_zone(p, zone);
+        return -ENOMEM;
+    }
+    fd->ops->read(fd->dentry, phdrs, header->e_phoff, len);
+    vmm_copy_to_pdir(p->pdir, phdrs, zone->start, len);
+    kfree(phdrs);
+
+    p->auxv.phdr = zone->start;
+    p->auxv.phnum = header->e_phnum;
+    return 0;
+}
+
+static uint32_t _elf_zone_flags(uint32_t p_flags)
+{
+    uint32_t zone_flags = 0;
+    if (p_flags & PF_R) {
+        zone_flags |= ZONE_READABLE;
+    }
+    if (p_flags & PF_W) {
+        zone_flags |= ZONE_WRITABLE;
+    }
+    if (p_flags & PF_X) {
+        zone_flags |= ZONE_EXECUTABLE;
+    }
+    return zone_flags;
+}
+
+/**
+ * Gives a segment of the loader a zone with its own permissions. A page
+ * shared with the previous segment stays in its zone and gets the
+ * permissions of both.
+ */
+static int _elf_load_interp_zone(proc_t* p, uint32_t base, elf_program_header_32_t* ph)
+{
+    uint32_t start = base + ph->p_vaddr;
+    uint32_t zone_flags = _elf_zone_flags(ph->p_flags);
+    uint32_t zone_type = (ph->p_flags & PF_X) ? ZONE_TYPE_CODE : ZONE_TYPE_DATA;
+
+    proc_zone_t* shared = proc_find_zone(p, start);
+    if (shared) {
+        shared->flags |= zone_flags;
+    }
+
+    uint32_t end = start + ph->p_memsz;
+    if (shared && end <= shared->start + shared->len) {
+        return 0;
+    }
+
+    proc_zone_t* zone = proc_extend_zone(p, start, ph->p_memsz);
+    if (!zone) {
+        return -ENOMEM;
+    }
+    zone->type = zone_type;
+    zone->flags |= zone_flags;
+    return 0;
+}
+
+/**
+ * Loads the dynamic loader named by PT_INTERP of the exec. The loader is
+ * a shared object, so it is put into any free range and runs from there.
+ * Returns its entry point in @entry.
+ */
+static int _elf_load_interp(proc_t* p, const char* path, uint32_t* entry)
+{
+    dentry_t* dentry;
+    file_descriptor_t fd;
+    if (vfs_resolve_path(path, &dentry) != 0) {
+        return -ENOENT;
+    }
+    if (vfs_open(dentry, &fd, O_EXEC) != 0) {
+        dentry_put(dentry);
+        return -ENOENT;
+    }
+
+    elf_header_32_t header;
+    elf_program_header_32_t ph;
+    proc_zone_t* zone;
+    uint32_t base = 0;
+    uint32_t span = 0;
+    int err = -ENOEXEC;
+    if (vfs_read(&fd, &header, sizeof(header)) != sizeof(header)) {
+        goto out;
+    }
+    err = _elf_check_ident(&header);
+    if (err) {
+        goto out;
+    }
+    if (header.e_type != ET_DYN) {
+        err = -ENOEXEC;
+        goto out;
+    }
+
+    // The first pass finds how much space the loader takes.
+    fd.offset = header.e_phoff;
+    for (int i = 0; i < header.e_phnum; i++) {
+        if (vfs_read(&fd, &ph, sizeof(ph)) != sizeof(ph)) {
+            err = -ENOEXEC;
+            goto out;
+        }
+        if (ph.p_type == PT_LOAD) {
+            span = max(span, ph.p_vaddr + ph.p_memsz);
+        }
+    }
+
+    // The range is only looked up here, every segment gets its own zone then.
+    zone = proc_new_random_zone(p, span);
+    if (!zone) {
+        err = -ENOMEM;
+        goto out;
+    }
+    base = zone->start;
+    proc_delete_zone(p, zone);
+
+    fd.offset = header.e_phoff;
+    for (int i = 0; i < header.e_phnum; i++) {
+        if (vfs_read(&fd, &ph, sizeof(ph)) != sizeof(ph)) {
+            err = -ENOEXEC;
+            goto out;
+        }
+        if (ph.p_type != PT_LOAD) {
+            continue;
+        }
+
+        err = _elf_load_interp_zone(p, base, &ph);
+        if (err) {
+            goto out;
+        }
+        _elf_load_do_copy_to_ram(p, &fd, &ph, base);
+    }
+
+    p->auxv.base = base;
+    *entry = base + header.e_entry;
+    err = 0;
+
+out:
+    vfs_close(&fd);
+    dentry_put(dentry);
+    return err;
+}
+
 static inline int _elf_do_load(proc_t* p, file_descriptor_t* fd, elf_header_32_t* header)
 {
     fd->offset = header->e_shoff;
@@ -162,36 +371,51 @@ static inline int _elf_do_load(proc_t* p, file_descriptor_t* fd, elf_header_32_t
         _elf_load_interpret_section_header_entry(p, fd);
     }
 
+    elf_load_info_t info = { 0 };
     fd->offset = header->e_phoff;
     int ph_num = header->e_phnum;
     for (int i = 0; i < ph_num; i++) {
-        _elf_load_interpret_program_header_entry(p, fd);
+        int err = _elf_load_interpret_program_header_entry(p, fd, &info);
+        if (err < 0) {
+            return err;
+        }
     }
 
     proc_zone_t* stack_zone = proc_new_random_zone(p, VMM_PAGE_SIZE); // Forbid 0 allocations to make it work well
-    _elf_load_alloc_stack(p);
-    set_instruction_pointer(p->main_thread->tf, header->e_entry);
-    return 0;
-}
 
-int elf_check_header(elf_header_32_t* header)
-{
-    static const char elf_signature[] = { 0x7F, 0x45, 0x4c, 0x46 };
-    if (memcmp(header->e_ident, elf_signature, sizeof(elf_signature)) != 0) {
+    // Dynamic execs start in the loader, which maps their libs and jumps to e_entry.
+    uint32_t entry = header->e_entry;
+    if (info.interp[0]) {
+        int err = _elf_load_copy_phdrs(p, fd, header);
+        if (err) {
+            return err;
+        }
+        err = _elf_load_interp(p, info.interp, &entry);
+        if (err) {
+            return err;
+        }
+        p->auxv.entry = header->e_entry;
+    } else if (info.dynamic) {
         return -ENOEXEC;
     }
 
-    // Currently we support only 32bit execs
-    if (header->e_ident[EI_CLASS] != ELF_CLASS_32) {
-        return -EBADARCH;
+    int err = _elf_load_alloc_stack(p);
+    if (err) {
+        return err;
     }
+    set_instruction_pointer(p->main_thread->tf, entry);
+    return thread_setup_tls(p->main_thread);
+}
 
-    if (header->e_type != ET_EXEC) {
-        return -ENOEXEC;
+int elf_check_header(elf_header_32_t* header)
+{
+    int err = _elf_check_ident(header);
+    if (err) {
+        return err;
     }
 
-    if (header->e_machine != MACHINE_ARCH) {
-        return -EBADARCH;
+    if (header->e_type != ET_EXEC) {
+        return -ENOEXEC;
     }
 
     return 0;
@@ -137,6 +137,9 @@ static ALWAYS_INLINE int proc_setup_lockless(proc_t* p)
     p->suid = 0;
     p->sgid = 0;
     p->is_kthread = false;
+    p->vfork_parent = NULL;
+    memset((void*)&p->tls, 0, sizeof(proc_tls_t));
+    memset((void*)&p->auxv, 0, sizeof(proc_auxv_t));
 
     p->main_thread = proc_alloc_thread();
     int res = thread_setup_main(p, p->main_thread);
@@ -224,11 +227,12 @@ int proc_setup_tty(proc_t* p, tty_entry_t* tty)
     return res;
 }
 
-int proc_copy_of(proc_t* new_proc, thread_t* from_thread)
+/**
+ * The function copies ids, cwd, tty and opened files of @from_proc,
+ * but not its address space.
+ */
+int proc_inherit_of(proc_t* new_proc, proc_t* from_proc)
 {
-    proc_t* from_proc = from_thread->process;
-    thread_copy_of(new_proc->main_thread, from_thread);
-
     new_proc->ppid = from_proc->pid;
     new_proc->uid = from_proc->uid;
     new_proc->gid = from_proc->gid;
@@ -250,6 +254,17 @@ int proc_copy_of(proc_t* new_proc, thread_t* from_thread)
         }
     }
 
+    return 0;
+}
+
+int proc_copy_of(proc_t* new_proc, thread_t* from_thread)
+{
+    proc_t* from_proc = from_thread->process;
+    thread_copy_of(new_proc->main_thread, from_thread);
+    proc_inherit_of(new_proc, from_proc);
+    new_proc->tls = from_proc->tls;
+    new_proc->auxv = from_proc->auxv;
+
     for (int i = 0; i < from_proc->zones.size; i++) {
         proc_zone_t* zone_to_copy = (proc_zone_t*)dynamic_array_get(&from_proc->zones, i);
         if (zone_to_copy->file) {
@@ -279,9 +294,7 @@ static int _proc_load_bin(proc_t* p, file_descriptor_t* fd)
     bss_zone->type = ZONE_TYPE_DATA;
     bss_zone->flags |= ZONE_READABLE | ZONE_WRITABLE;
 
-    proc_zone_t* stack_zone = proc_new_random_zone_backward(p, VMM_PAGE_SIZE);
-    stack_zone->type = ZONE_TYPE_STACK;
-    stack_zone->flags |= ZONE_READABLE | ZONE_WRITABLE;
+    proc_zone_t* stack_zone = proc_new_stack_zone(p, USER_STACK_SIZE);
 
     /* Copying an exec code */
     uint8_t* prog = kmalloc(fd->dentry->inode->size);
@@ -290,8 +303,8 @@ static int _proc_load_bin(proc_t* p, file_descriptor_t* fd)
 
     /* Setting registers */
     thread_t* main_thread = p->main_thread;
-    set_base_pointer(main_thread->tf, stack_zone->start + VMM_PAGE_SIZE);
-    set_stack_pointer(main_thread->tf, stack_zone->start + VMM_PAGE_SIZE);
+    set_base_pointer(main_thread->tf, stack_zone->start + USER_STACK_SIZE);
+    set_stack_pointer(main_thread->tf, stack_zone->start + USER_STACK_SIZE);
     set_instruction_pointer(main_thread->tf, code_zone->start);
 
     kfree(prog);
@@ -315,6 +328,10 @@ static ALWAYS_INLINE int proc_load_lockless(proc_t* p, thread_t* main_thread, co
     // Saving data to restore in case of error.
     pdirectory_t* old_pdir = p->pdir;
     dynamic_array_t old_zones = p->zones;
+    proc_tls_t old_tls = p->tls;
+    proc_auxv_t old_auxv = p->auxv;
+    memset((void*)&p->tls, 0, sizeof(proc_tls_t));
+    memset((void*)&p->auxv, 0, sizeof(proc_auxv_t));
 
     // Reallocating proc.
     pdirectory_t* new_pdir = vmm_new_user_pdir();
@@ -345,9 +362,11 @@ success:
     fpu_init_state(p->main_thread->fpu_state);
 #endif
 
-    if (old_pdir) {
+    // A vforked proc borrows the pdir of its parent, which is woken up from now.
+    if (old_pdir && !p->vfork_parent) {
         vmm_free_pdir(old_pdir, &old_zones);
     }
+    p->vfork_parent = NULL;
     dynamic_array_clear(&old_zones);
 
     // Setting up proc
@@ -360,7 +379,11 @@ success:
 
 restore:
     p->pdir = old_pdir;
-    vmm_switch_pdir(old_pdir);
+    p->tls = old_tls;
+    p->auxv = old_auxv;
+    if (old_pdir) {
+        vmm_switch_pdir(old_pdir);
+    }
     vmm_free_pdir(new_pdir, &p->zones);
     dynamic_array_clear(&p->zones);
     p->zones = old_zones;
@@ -409,10 +432,11 @@ int proc_free_lockless(proc_t* p)
     proc_kill_all_threads_lockless(p);
     p->pid = 0;
 
-    if (!p->is_kthread) {
+    if (!p->is_kthread && !p->vfork_parent) {
         vmm_free_pdir(p->pdir, &p->zones);
-        p->pdir = NULL;
     }
+    p->pdir = NULL;
+    p->vfork_parent = NULL;
 
     dynamic_array_free(&p->zones);
     return 0;
@@ -457,12 +481,17 @@ int proc_block_all_threads(proc_t* p, blocker_t* blocker)
  * PROC THREAD FUNCTIONS
  */
 
+/**
+ * The thread is not enqueued, the caller does it when the thread is set up.
+ */
 thread_t* proc_create_thread(proc_t* p)
 {
     lock_acquire(&p->lock);
     thread_t* thread = proc_alloc_thread();
-    thread_setup(p, thread);
-    sched_enqueue(thread);
+    if (thread && thread_setup(p, thread) != 0) {
+        thread->status = THREAD_DEAD;
+        thread = NULL;
+    }
     lock_release(&p->lock);
     return thread;
 }
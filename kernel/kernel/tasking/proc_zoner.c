@@ -162,6 +162,49 @@ proc_zone_t* proc_new_random_zone(proc_t* proc, uint32_t len)
     return proc_new_zone(proc, min_start, len);
 }
 
+/**
+ * The function finds a zone which starts at an @alignment boundary.
+ * Used by mappings which want to be backed by large pages, see VMM_LARGE_ZONE_ALIGNMENT.
+ */
+proc_zone_t* proc_new_random_zone_aligned(proc_t* proc, uint32_t len, uint32_t alignment)
+{
+    if (len % VMM_PAGE_SIZE) {
+        len += VMM_PAGE_SIZE - (len % VMM_PAGE_SIZE);
+    }
+
+    uint32_t zones_count = proc->zones.size;
+
+    /* Check if we can put it at the beginning */
+    proc_zone_t* ret = proc_new_zone(proc, 0, len);
+    if (ret) {
+        return ret;
+    }
+
+    uint32_t min_start = 0xffffffff;
+
+    for (uint32_t i = 0; i < zones_count; i++) {
+        proc_zone_t* zone = (proc_zone_t*)dynamic_array_get(&proc->zones, i);
+        uint32_t start = zone->start + zone->len;
+        if (start % alignment) {
+            start += alignment - (start % alignment);
+        }
+        if (start < zone->start || start + len > KERNEL_BASE || start + len < start) {
+            continue;
+        }
+        if (_proc_can_add_zone(proc, start, len)) {
+            if (min_start > start) {
+                min_start = start;
+            }
+        }
+    }
+
+    if (min_start == 0xffffffff) {
+        return 0;
+    }
+
+    return proc_new_zone(proc, min_start, len);
+}
+
 /* FIXME: Think of more efficient way */
 proc_zone_t* proc_new_random_zone_backward(proc_t* proc, uint32_t len)
 {
@@ -195,6 +238,37 @@ proc_zone_t* proc_new_random_zone_backward(proc_t* proc, uint32_t len)
     return proc_new_zone(proc, max_end - len, len);
 }
 
+/**
+ * Reserves a stack zone with a guard page below it. Pages of the stack
+ * are loaded on fault, so the stack grows while it's used.
+ */
+proc_zone_t* proc_new_stack_zone(proc_t* proc, uint32_t len)
+{
+    if (len % VMM_PAGE_SIZE) {
+        len += VMM_PAGE_SIZE - (len % VMM_PAGE_SIZE);
+    }
+
+    proc_zone_t* guard_zone = proc_new_random_zone_backward(proc, len + VMM_PAGE_SIZE);
+    if (!guard_zone) {
+        return 0;
+    }
+
+    uint32_t start = guard_zone->start;
+    guard_zone->type = ZONE_TYPE_GUARD;
+    guard_zone->len = VMM_PAGE_SIZE;
+
+    // Could move guard_zone, since zones are stored in dynamic array.
+    proc_zone_t* stack_zone = proc_new_zone(proc, start + VMM_PAGE_SIZE, len);
+    if (!stack_zone) {
+        proc_delete_zone(proc, proc_find_zone(proc, start));
+        return 0;
+    }
+
+    stack_zone->type = ZONE_TYPE_STACK;
+    stack_zone->flags |= ZONE_READABLE | ZONE_WRITABLE;
+    return stack_zone;
+}
+
 proc_zone_t* proc_find_zone_no_proc(dynamic_array_t* zones, uint32_t addr)
 {
     uint32_t zones_count = zones->size;
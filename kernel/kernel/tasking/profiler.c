@@ -0,0 +1,202 @@
+/*
+ * Copyright (c) 2021, Krisna Pranav
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <libkern/bits/errno.h>
+#include <libkern/libkern.h>
+#include <libkern/lock.h>
+#include <libkern/log.h>
+#include <mem/kmalloc.h>
+#include <mem/vmm/vmm.h>
+#include <platform/generic/system.h>
+#include <tasking/cpu.h>
+#include <tasking/profiler.h>
+#include <tasking/sched.h>
+#include <tasking/softirq.h>
+
+// #define PROFILER_DEBUG
+
+struct profile_ring {
+    lock_t lock;
+    profile_sample_t* samples;
+    uint32_t start;
+    uint32_t end;
+    uint32_t stat_dropped;
+};
+typedef struct profile_ring profile_ring_t;
+
+static profile_ring_t _profile_rings[CPU_CNT];
+static volatile bool _profiler_running = false;
+
+static inline profile_sample_t* _profile_ring_sample(profile_ring_t* ring, uint32_t index)
+{
+    return &ring->samples[index & (PROFILE_RING_SAMPLES - 1)];
+}
+
+/**
+ * Frames are followed only while they stay on the side of the address
+ * space they started on and are mapped, so a broken chain never faults
+ * inside the timer interrupt.
+ */
+static uint32_t _profiler_walk_frames(profile_sample_t* sample, uint32_t* bp, bool is_kernel)
+{
+    uint32_t depth = 1;
+    while (depth < PROFILE_MAX_DEPTH && bp) {
+        uint32_t frame = (uint32_t)bp;
+        if ((frame & 0x3) || vmm_is_kernel_address(frame) != is_kernel) {
+            break;
+        }
+        if (!vmm_is_page_present(frame) || !vmm_is_page_present(frame + sizeof(uint32_t))) {
+            break;
+        }
+
+        uint32_t ip = bp[1];
+        if (!ip || vmm_is_kernel_address(ip) != is_kernel) {
+            break;
+        }
+        sample->ips[depth++] = ip;
+
+        uint32_t* next_bp = (uint32_t*)bp[0];
+        if (next_bp <= bp) {
+            break;
+        }
+        bp = next_bp;
+    }
+    return depth;
+}
+
+int profiler_start()
+{
+    for (int i = 0; i < CPU_CNT; i++) {
+        profile_ring_t* ring = &_profile_rings[i];
+        if (!ring->samples) {
+            lock_init(&ring->lock);
+            ring->samples = kmalloc(PROFILE_RING_SAMPLES * sizeof(profile_sample_t));
+            if (!ring->samples) {
+                return -ENOMEM;
+            }
+        }
+
+        system_disable_interrupts();
+        lock_acquire(&ring->lock);
+        ring->start = ring->end = 0;
+        ring->stat_dropped = 0;
+        lock_release(&ring->lock);
+        system_enable_interrupts();
+    }
+
+    _profiler_running = true;
+    return 0;
+}
+
+void profiler_stop()
+{
+    _profiler_running = false;
+}
+
+bool profiler_is_running()
+{
+    return _profiler_running;
+}
+
+/**
+ * Called from timer interrupt handlers of every cpu. Records the
+ * interrupted instruction and a short frame pointer call chain into the
+ * ring of the current cpu. The oldest sample is dropped when the ring
+ * is full.
+ */
+void profiler_tick()
+{
+    if (!_profiler_running) {
+        return;
+    }
+
+    trapframe_t* tf = irq_current_trapframe();
+    if (!tf) {
+        return;
+    }
+
+    profile_ring_t* ring = &_profile_rings[system_cpu_id()];
+    lock_acquire(&ring->lock);
+    if (ring->end - ring->start == PROFILE_RING_SAMPLES) {
+        ring->start++;
+        ring->stat_dropped++;
+    }
+
+    profile_sample_t* sample = _profile_ring_sample(ring, ring->end);
+    uint32_t ip = get_instruction_pointer(tf);
+    bool is_kernel = vmm_is_kernel_address(ip);
+    sample->pid = RUNNING_THREAD ? RUNNING_THREAD->process->pid : 0;
+    sample->cpu = system_cpu_id();
+    sample->flags = is_kernel ? PROFILE_SAMPLE_KERNEL : 0;
+    sample->ips[0] = ip;
+    sample->depth = _profiler_walk_frames(sample, (uint32_t*)get_base_pointer(tf), is_kernel);
+    ring->end++;
+    lock_release(&ring->lock);
+}
+
+/**
+ * While the profiler runs, readers are woken only once a ring is half
+ * full, so a reader draining in a loop keeps the rings from wrapping
+ * without waking on every tick. Once it is stopped, the rest can be read.
+ */
+bool profiler_can_read()
+{
+    if (!_profiler_running) {
+        return true;
+    }
+
+    for (int i = 0; i < CPU_CNT; i++) {
+        profile_ring_t* ring = &_profile_rings[i];
+        if (ring->samples && ring->end - ring->start >= PROFILE_RING_DRAIN_SAMPLES) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Moves as many whole samples as fit into @buf out of the rings of all
+ * cpus and returns the number of bytes read.
+ */
+int profiler_read(uint8_t* buf, uint32_t len)
+{
+    uint32_t want = len / sizeof(profile_sample_t);
+    uint32_t read = 0;
+
+    for (int i = 0; i < CPU_CNT && read < want; i++) {
+        profile_ring_t* ring = &_profile_rings[i];
+        if (!ring->samples) {
+            continue;
+        }
+
+        system_disable_interrupts();
+        lock_acquire(&ring->lock);
+        while (ring->start != ring->end && read < want) {
+            memcpy(buf + read * sizeof(profile_sample_t), _profile_ring_sample(ring, ring->start), sizeof(profile_sample_t));
+            ring->start++;
+            read++;
+        }
+#ifdef PROFILER_DEBUG
+        if (ring->stat_dropped) {
+            log("profiler: cpu%d dropped %d samples", i, ring->stat_dropped);
+        }
+#endif
+        lock_release(&ring->lock);
+        system_enable_interrupts();
+    }
+
+    return read * sizeof(profile_sample_t);
+}
+
+// Samples overwritten before they were read, since the last start.
+uint32_t profiler_dropped()
+{
+    uint32_t dropped = 0;
+    for (int i = 0; i < CPU_CNT; i++) {
+        dropped += _profile_rings[i].stat_dropped;
+    }
+    return dropped;
+}
\ No newline at end of file
@@ -8,6 +8,7 @@
 #include <libkern/atomic.h>
 #include <libkern/libkern.h>
 #include <libkern/log.h>
+#include <libkern/trace.h>
 #include <mem/kmalloc.h>
 #include <platform/generic/registers.h>
 #include <platform/generic/system.h>
@@ -15,6 +16,7 @@
 #include <platform/generic/tasking/trapframe.h>
 #include <tasking/cpu.h>
 #include <tasking/sched.h>
+#include <tasking/softirq.h>
 #include <tasking/tasking.h>
 #include <time/time_manager.h>
 
@@ -191,6 +193,7 @@ extern thread_list_t thread_list;
 void sched_unblock_threads()
 {
     thread_t* thread;
+    uint64_t start = system_read_timestamp();
 
     thread_list_node_t* __thread_list_node = thread_list.head;
     while (__thread_list_node) {
@@ -206,10 +209,14 @@ void sched_unblock_threads()
         }
         __thread_list_node = __thread_list_node->next;
     }
+
+    THIS_CPU->stat_unblock_calls++;
+    THIS_CPU->stat_unblock_time += system_read_timestamp() - start;
 }
 
 void resched_dont_save_context()
 {
+    irq_exit();
     if (RUNNING_THREAD && RUNNING_THREAD->status == THREAD_RUNNING) {
         RUNNING_THREAD->stat_total_running_ticks += timeman_ticks_since_boot() - RUNNING_THREAD->start_time_in_ticks;
         _sched_add_to_end_of_runqueue(&cpus[RUNNING_THREAD->last_cpu].sched, RUNNING_THREAD);
@@ -219,6 +226,7 @@ void resched_dont_save_context()
 
 void resched()
 {
+    irq_exit();
     if (RUNNING_THREAD) {
         RUNNING_THREAD->stat_total_running_ticks += timeman_ticks_since_boot() - RUNNING_THREAD->start_time_in_ticks;
         if (RUNNING_THREAD->status == THREAD_RUNNING) {
@@ -295,6 +303,7 @@ void sched()
         thread->start_time_in_ticks = timeman_ticks_since_boot();
         thread->ticks_until_preemption = _sched_get_timeslice(thread);
         switchuvm(thread);
+        TRACE(TRACE_SCHED_SWITCH, thread->tid, thread->process->prio, 0, 0);
         switch_contexts(&(THIS_CPU->sched_context), thread->context);
     }
 }
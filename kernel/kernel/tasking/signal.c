@@ -184,6 +184,7 @@ int signal_restore_thread_after_handling_signal(thread_t* thread)
 
     /* If our thread was blocked, that means that it already has a context on stack, we need not to overwrite it */
     if (thread->blocker.reason != BLOCKER_INVALID) {
+        thread->blocker.interrupted = true;
         thread->status = THREAD_BLOCKED;
         sched_dequeue(thread);
         resched_dont_save_context();
@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2021, Krisna Pranav
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <libkern/kassert.h>
+#include <platform/generic/system.h>
+#include <tasking/softirq.h>
+
+cpu_irq_stat_t cpu_irq_stats[CPU_CNT];
+static softirq_handler_t _softirq_handlers[SOFTIRQ_COUNT];
+
+static inline cpu_irq_stat_t* _this_cpu_irq_stat()
+{
+    return &cpu_irq_stats[system_cpu_id()];
+}
+
+/**
+ * IRQ ACCOUNTING
+ */
+
+void irq_enter(int line, trapframe_t* tf)
+{
+    cpu_irq_stat_t* stat = _this_cpu_irq_stat();
+    stat->in_hard_irq = true;
+    stat->current_line = line;
+    stat->current_tf = tf;
+    stat->current_start = system_read_timestamp();
+    if (line >= 0 && line < IRQ_STAT_LINES) {
+        stat->lines[line].count++;
+    }
+}
+
+/**
+ * Closes the accounting of the running hard handler and runs the bottom
+ * halves it raised. The timer interrupt may switch to another thread
+ * before irq_handler() returns, so resched() calls this as well; the
+ * second call on the same interrupt is a no-op.
+ */
+void irq_exit()
+{
+    cpu_irq_stat_t* stat = _this_cpu_irq_stat();
+    if (!stat->in_hard_irq) {
+        return;
+    }
+
+    int line = stat->current_line;
+    if (line >= 0 && line < IRQ_STAT_LINES) {
+        stat->lines[line].time += system_read_timestamp() - stat->current_start;
+    }
+    stat->in_hard_irq = false;
+    softirq_run();
+}
+
+/**
+ * Returns the state the running hard handler interrupted, or NULL
+ * outside of hard interrupt context.
+ */
+trapframe_t* irq_current_trapframe()
+{
+    cpu_irq_stat_t* stat = _this_cpu_irq_stat();
+    if (!stat->in_hard_irq) {
+        return NULL;
+    }
+    return stat->current_tf;
+}
+
+/**
+ * SOFTIRQ
+ */
+
+void softirq_register(int vec, softirq_handler_t handler)
+{
+    ASSERT(vec >= 0 && vec < SOFTIRQ_COUNT);
+    _softirq_handlers[vec] = handler;
+}
+
+/**
+ * Marks @vec pending on the current cpu. Hard interrupt handlers call
+ * this to defer everything beyond talking to the device.
+ */
+void softirq_raise(int vec)
+{
+    system_disable_interrupts();
+    _this_cpu_irq_stat()->softirq_pending |= (1 << vec);
+    system_enable_interrupts();
+}
+
+/**
+ * Runs pending bottom halves of the current cpu. Handlers run with
+ * interrupts off, but after the interrupt controller has been
+ * acknowledged, and may raise vectors again.
+ */
+void softirq_run()
+{
+    cpu_irq_stat_t* stat = _this_cpu_irq_stat();
+
+    system_disable_interrupts();
+    while (stat->softirq_pending) {
+        uint32_t pending = stat->softirq_pending;
+        stat->softirq_pending = 0;
+
+        for (int vec = 0; vec < SOFTIRQ_COUNT; vec++) {
+            if (!(pending & (1 << vec)) || !_softirq_handlers[vec]) {
+                continue;
+            }
+
+            uint64_t start = system_read_timestamp();
+            _softirq_handlers[vec]();
+            stat->softirqs[vec].count++;
+            stat->softirqs[vec].time += system_read_timestamp() - start;
+        }
+    }
+    system_enable_interrupts();
+}
\ No newline at end of file
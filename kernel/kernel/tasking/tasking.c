@@ -216,6 +216,30 @@ void tasking_fork(trapframe_t* tf)
     resched();
 }
 
+void tasking_vfork(trapframe_t* tf)
+{
+    thread_t* parent = RUNNING_THREAD;
+    proc_t* new_proc = _tasking_setup_proc();
+
+    // The child borrows the address space until it calls exec or exits.
+    new_proc->pdir = parent->process->pdir;
+    new_proc->vfork_parent = parent;
+    proc_copy_of(new_proc, parent);
+
+    /* setting output */
+    set_syscall_result(new_proc->main_thread->tf, 0);
+    set_syscall_result(parent->tf, new_proc->pid);
+
+    new_proc->main_thread->status = THREAD_RUNNING;
+
+#ifdef TASKING_DEBUG
+    log("Vfork %d to pid %d", parent->tid, new_proc->pid);
+#endif
+
+    sched_enqueue(new_proc->main_thread);
+    init_vfork_blocker(parent, new_proc->main_thread);
+}
+
 static int _tasking_do_exec(proc_t* p, thread_t* main_thread, const char* path, int argc, char** argv, char** env)
 {
     int err = proc_load(p, main_thread, path);
@@ -225,14 +249,11 @@ static int _tasking_do_exec(proc_t* p, thread_t* main_thread, const char* path,
     return thread_fill_up_stack(p->main_thread, argc, argv, env);
 }
 
-int tasking_exec(const char* path, const char** argv, const char** env)
+static int _tasking_bring_exec_args(const char* path, const char** argv, char** kpath_res, int* kargc_res, char*** kargv_res)
 {
-    thread_t* thread = RUNNING_THREAD;
-    proc_t* p = RUNNING_THREAD->process;
     char* kpath = NULL;
     int kargc = 1;
     char** kargv = NULL;
-    char** kenv = NULL;
 
     if (!str_validate_len(path, 128)) {
         return -EINVAL;
@@ -270,7 +291,92 @@ int tasking_exec(const char* path, const char** argv, const char** env)
         kargv[i] = kmem_bring_to_kernel(argv[i - 1], strlen(argv[i - 1]) + 1);
     }
 
-    int err = _tasking_do_exec(p, thread, kpath, kargc, kargv, 0);
+    *kpath_res = kpath;
+    *kargc_res = kargc;
+    *kargv_res = kargv;
+    return 0;
+}
+
+static void _tasking_free_exec_args(int kargc, char** kargv)
+{
+    // kargv[0] is kpath.
+    for (int argi = 0; argi < kargc; argi++) {
+        kfree(kargv[argi]);
+    }
+    kfree(kargv);
+}
+
+/**
+ * Brings env of the caller to the kernel as a NULL-terminated array.
+ * A NULL env results in an empty one.
+ */
+static int _tasking_bring_exec_env(const char** env, char*** kenv_res)
+{
+    int envc = 0;
+
+    if (env) {
+        if (!ptrarr_validate_len(env, 128)) {
+            return -EINVAL;
+        }
+
+        envc = ptrarr_len(env);
+
+        /* Validating env size */
+        uint32_t data_len = 0;
+        for (int envi = 0; envi < envc; envi++) {
+            if (!str_validate_len(env[envi], 256)) {
+                return -EINVAL;
+            }
+            data_len += strlen(env[envi]) + 1;
+            if (data_len > 2048) {
+                return -E2BIG;
+            }
+        }
+    }
+
+    char** kenv = kmalloc((envc + 1) * sizeof(char*));
+    if (!kenv) {
+        return -ENOMEM;
+    }
+    for (int i = 0; i < envc; i++) {
+        kenv[i] = kmem_bring_to_kernel(env[i], strlen(env[i]) + 1);
+    }
+    kenv[envc] = NULL;
+
+    *kenv_res = kenv;
+    return 0;
+}
+
+static void _tasking_free_exec_env(char** kenv)
+{
+    for (char** it = kenv; *it; it++) {
+        kfree(*it);
+    }
+    kfree(kenv);
+}
+
+int tasking_exec(const char* path, const char** argv, const char** env)
+{
+    thread_t* thread = RUNNING_THREAD;
+    proc_t* p = RUNNING_THREAD->process;
+    char* kpath = NULL;
+    int kargc = 0;
+    char** kargv = NULL;
+
+    char** kenv = NULL;
+
+    int err = _tasking_bring_exec_args(path, argv, &kpath, &kargc, &kargv);
+    if (err) {
+        return err;
+    }
+
+    err = _tasking_bring_exec_env(env, &kenv);
+    if (err) {
+        _tasking_free_exec_args(kargc, kargv);
+        return err;
+    }
+
+    err = _tasking_do_exec(p, thread, kpath, kargc, kargv, kenv);
 
 #ifdef TASKING_DEBUG
     if (!err) {
@@ -278,13 +384,59 @@ int tasking_exec(const char* path, const char** argv, const char** env)
     }
 #endif
 
-    kfree(kpath);
-    for (int argi = 0; argi < kargc; argi++) {
-        kfree(kargv[argi]);
+    _tasking_free_exec_env(kenv);
+    _tasking_free_exec_args(kargc, kargv);
+    return err;
+}
+
+/**
+ * Creates a new proc running @path without copying the address space
+ * of the caller. Returns pid of the new proc.
+ */
+int tasking_spawn(const char* path, const char** argv, const char** env)
+{
+    thread_t* thread = RUNNING_THREAD;
+    proc_t* p = thread->process;
+    char* kpath = NULL;
+    int kargc = 0;
+    char** kargv = NULL;
+
+    char** kenv = NULL;
+
+    int err = _tasking_bring_exec_args(path, argv, &kpath, &kargc, &kargv);
+    if (err) {
+        return err;
     }
-    kfree(kargv);
 
-    return err;
+    err = _tasking_bring_exec_env(env, &kenv);
+    if (err) {
+        _tasking_free_exec_args(kargc, kargv);
+        return err;
+    }
+
+    proc_t* new_proc = _tasking_setup_proc();
+    proc_inherit_of(new_proc, p);
+
+    // proc_load switches to the pdir of the new proc, so restoring ours after it.
+    new_proc->pdir = NULL;
+    err = _tasking_do_exec(new_proc, new_proc->main_thread, kpath, kargc, kargv, kenv);
+    vmm_switch_pdir(p->pdir);
+    _tasking_free_exec_env(kenv);
+
+    if (err) {
+        _tasking_free_exec_args(kargc, kargv);
+        proc_die(new_proc);
+        return err;
+    }
+
+#ifdef TASKING_DEBUG
+    log("Spawn %s : pid %d", kpath, new_proc->pid);
+#endif
+
+    _tasking_free_exec_args(kargc, kargv);
+    new_proc->main_thread->status = THREAD_RUNNING;
+    sched_enqueue(new_proc->main_thread);
+    return new_proc->pid;
 }
 
 int tasking_waitpid(int pid)
@@ -9,6 +9,7 @@
 #include <libkern/libkern.h>
 #include <libkern/log.h>
 #include <mem/kmalloc.h>
+#include <tasking/elf.h>
 #include <tasking/proc.h>
 #include <tasking/sched.h>
 #include <tasking/tasking.h>
@@ -51,6 +52,7 @@ int thread_setup_main(proc_t* p, thread_t* thread)
     thread->process = p;
     thread->tid = p->pid;
     thread->last_cpu = LAST_CPU_NOT_SET;
+    thread->tls = 0;
 
     /* setting signal handlers to 0 */
     thread->signals_mask = 0xffffffff; /* for now all signals are legal */
@@ -78,6 +80,7 @@ int thread_setup(proc_t* p, thread_t* thread)
     thread->process = p;
     thread->tid = proc_alloc_pid();
     thread->last_cpu = LAST_CPU_NOT_SET;
+    thread->tls = 0;
 
     /* setting signal handlers to 0 */
     thread->signals_mask = 0xffffffff; /* for now all signals are legal */
@@ -97,6 +100,7 @@ int thread_setup(proc_t* p, thread_t* thread)
 int thread_copy_of(thread_t* thread, thread_t* from_thread)
 {
     memcpy(thread->tf, from_thread->tf, sizeof(trapframe_t));
+    thread->tls = from_thread->tls;
 #ifdef FPU_ENABLED
     memcpy(thread->fpu_state, from_thread->fpu_state, sizeof(fpu_state_t));
 #endif
@@ -107,19 +111,70 @@ int thread_copy_of(thread_t* thread, thread_t* from_thread)
  * STACK FUNCTIONS
  */
 
+#define THREAD_AUXV_ENTRIES 7
+
+static inline uint32_t _thread_auxv_size(proc_t* p)
+{
+    if (!p->auxv.base) {
+        return 0;
+    }
+    return THREAD_AUXV_ENTRIES * sizeof(elf_auxv_32_t);
+}
+
+/**
+ * Dynamic execs get the aux vector right after the env list, the same
+ * place other systems put it, so the loader finds the exec.
+ */
+static void _thread_fill_up_auxv(proc_t* p, elf_auxv_32_t* auxv)
+{
+    if (!p->auxv.base) {
+        return;
+    }
+
+    auxv[0] = (elf_auxv_32_t) { AT_PHDR, p->auxv.phdr };
+    auxv[1] = (elf_auxv_32_t) { AT_PHENT, sizeof(elf_program_header_32_t) };
+    auxv[2] = (elf_auxv_32_t) { AT_PHNUM, p->auxv.phnum };
+    auxv[3] = (elf_auxv_32_t) { AT_PAGESZ, VMM_PAGE_SIZE };
+    auxv[4] = (elf_auxv_32_t) { AT_BASE, p->auxv.base };
+    auxv[5] = (elf_auxv_32_t) { AT_ENTRY, p->auxv.entry };
+    auxv[6] = (elf_auxv_32_t) { AT_NULL, 0 };
+}
+
+static char* _thread_push_string(thread_t* thread, char* tmp_buf_ptr, const char* str, uint32_t* str_esp)
+{
+    uint32_t len = strlen(str);
+    tmp_buf_ptr -= len + 1;
+    tf_move_stack_pointer(thread->tf, -(len + 1));
+    memcpy(tmp_buf_ptr, str, len);
+    tmp_buf_ptr[len] = 0;
+    *str_esp = get_stack_pointer(thread->tf);
+    return tmp_buf_ptr;
+}
+
+/**
+ * The stack of a new proc from its top:
+ * [argc][argv][envp][argv array][env array][auxv][argv strings][env strings]
+ */
 int thread_fill_up_stack(thread_t* thread, int argc, char** argv, char** env)
 {
-    /* TODO: Add env */
-    uint32_t argv_data_size = 0;
+    int envc = 0;
+    uint32_t strings_size = 0;
     for (int i = 0; i < argc; i++) {
-        argv_data_size += strlen(argv[i]) + 1;
+        strings_size += strlen(argv[i]) + 1;
+    }
+    if (env) {
+        for (; env[envc]; envc++) {
+            strings_size += strlen(env[envc]) + 1;
+        }
     }
 
-    if (argv_data_size % 4) {
-        argv_data_size += 4 - (argv_data_size % 4);
+    if (strings_size % 4) {
+        strings_size += 4 - (strings_size % 4);
     }
 
-    uint32_t data_size_on_stack = argv_data_size + (argc + 1) * sizeof(char*) + sizeof(argc) + sizeof(char*);
+    uint32_t auxv_size = _thread_auxv_size(thread->process);
+    uint32_t arrays_size = (argc + 1) * sizeof(char*) + (envc + 1) * sizeof(char*);
+    uint32_t data_size_on_stack = strings_size + auxv_size + arrays_size + sizeof(argc) + 2 * sizeof(char*);
     int* tmp_buf = (int*)kmalloc(data_size_on_stack);
     if (!tmp_buf) {
         return -EAGAIN;
@@ -127,29 +182,35 @@ int thread_fill_up_stack(thread_t* thread, int argc, char** argv, char** env)
     memset((void*)tmp_buf, 0, data_size_on_stack);
 
     char* tmp_buf_ptr = ((char*)tmp_buf) + data_size_on_stack;
-    char* tmp_buf_data_ptr = tmp_buf_ptr - argv_data_size;
-    uint32_t* tmp_buf_array_ptr = (uint32_t*)((char*)tmp_buf_data_ptr - (argc + 1) * sizeof(char*));
-    int* tmp_buf_argv_ptr = (int*)((char*)tmp_buf_array_ptr - sizeof(char*));
+    char* tmp_buf_data_ptr = tmp_buf_ptr - strings_size;
+    elf_auxv_32_t* tmp_buf_auxv_ptr = (elf_auxv_32_t*)(tmp_buf_data_ptr - auxv_size);
+    uint32_t* tmp_buf_env_array_ptr = (uint32_t*)((char*)tmp_buf_auxv_ptr - (envc + 1) * sizeof(char*));
+    uint32_t* tmp_buf_array_ptr = (uint32_t*)((char*)tmp_buf_env_array_ptr - (argc + 1) * sizeof(char*));
+    int* tmp_buf_envp_ptr = (int*)((char*)tmp_buf_array_ptr - sizeof(char*));
+    int* tmp_buf_argv_ptr = (int*)((char*)tmp_buf_envp_ptr - sizeof(char*));
     int* tmp_buf_argc_ptr = (int*)((char*)tmp_buf_argv_ptr - sizeof(int));
 
-    uint32_t data_esp = get_stack_pointer(thread->tf) - argv_data_size;
-    uint32_t array_esp = data_esp - (argc + 1) * sizeof(char*);
-    uint32_t argv_esp = array_esp - 4;
+    uint32_t data_esp = get_stack_pointer(thread->tf) - strings_size;
+    uint32_t env_array_esp = data_esp - auxv_size - (envc + 1) * sizeof(char*);
+    uint32_t array_esp = env_array_esp - (argc + 1) * sizeof(char*);
+    uint32_t envp_esp = array_esp - 4;
+    uint32_t argv_esp = envp_esp - 4;
     uint32_t argc_esp = argv_esp - 4;
     uint32_t end_esp = argc_esp; // Points to the end on the stack
 
-    for (int i = argc - 1; i >= 0; i--) {
-        uint32_t len = strlen(argv[i]);
-        tmp_buf_ptr -= len + 1;
-        tf_move_stack_pointer(thread->tf, -(len + 1));
-        memcpy(tmp_buf_ptr, argv[i], len);
-        tmp_buf_ptr[len] = 0;
+    for (int i = envc - 1; i >= 0; i--) {
+        tmp_buf_ptr = _thread_push_string(thread, tmp_buf_ptr, env[i], &tmp_buf_env_array_ptr[i]);
+    }
+    tmp_buf_env_array_ptr[envc] = 0;
 
-        tmp_buf_array_ptr[i] = get_stack_pointer(thread->tf);
+    for (int i = argc - 1; i >= 0; i--) {
+        tmp_buf_ptr = _thread_push_string(thread, tmp_buf_ptr, argv[i], &tmp_buf_array_ptr[i]);
     }
     tmp_buf_array_ptr[argc] = 0;
+    _thread_fill_up_auxv(thread->process, tmp_buf_auxv_ptr);
 
     // FIXME: Remove these elements from stack for ARM
+    *tmp_buf_envp_ptr = env_array_esp;
     *tmp_buf_argv_ptr = array_esp;
     *tmp_buf_argc_ptr = argc;
 
@@ -157,6 +218,7 @@ int thread_fill_up_stack(thread_t* thread, int argc, char** argv, char** env)
 #ifdef __arm__
     thread->tf->r[0] = argc;
     thread->tf->r[1] = array_esp;
+    thread->tf->r[2] = env_array_esp;
 #endif
 
     vmm_copy_to_pdir(thread->process->pdir, (uint8_t*)tmp_buf, get_stack_pointer(thread->tf), data_size_on_stack);
@@ -166,6 +228,56 @@ int thread_fill_up_stack(thread_t* thread, int argc, char** argv, char** env)
     return 0;
 }
 
+/**
+ * TLS FUNCTIONS
+ */
+
+#define TLS_TCB_SIZE 8
+
+/**
+ * Allocates a TLS block for the thread and fills it up with the image
+ * of the proc. The proc's pdir should be active.
+ */
+int thread_setup_tls(thread_t* thread)
+{
+    proc_t* p = thread->process;
+    thread->tls = 0;
+    if (!p->tls.memsz) {
+        return 0;
+    }
+
+    uint32_t align = max(p->tls.align, TLS_TCB_SIZE);
+    uint32_t data_size = p->tls.memsz;
+    if (data_size % align) {
+        data_size += align - (data_size % align);
+    }
+
+    proc_zone_t* tls_zone = proc_new_random_zone(p, data_size + align + TLS_TCB_SIZE);
+    if (!tls_zone) {
+        return -ENOMEM;
+    }
+    tls_zone->type = ZONE_TYPE_DATA;
+    tls_zone->flags |= ZONE_READABLE | ZONE_WRITABLE;
+
+    // The zone is loaded on demand with zeroes, so only .tdata is copied.
+#ifdef __i386__
+    // Variant II: the data lies right below the TCB, which points to itself.
+    uint32_t tp = tls_zone->start + data_size;
+    uint32_t data = tp - data_size;
+    vmm_copy_to_user((void*)tp, &tp, sizeof(tp));
+#elif __arm__
+    // Variant I: the TCB is followed by the data.
+    uint32_t tp = tls_zone->start;
+    uint32_t data = tp + max(TLS_TCB_SIZE, align);
+#endif
+    if (p->tls.filesz) {
+        vmm_copy_to_user((void*)data, (void*)p->tls.start, p->tls.filesz);
+    }
+
+    thread->tls = tp;
+    return 0;
+}
+
 int thread_kstack_free(thread_t* thread)
 {
     zoner_free_zone(thread->kstack);
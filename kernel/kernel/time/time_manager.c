@@ -115,4 +115,18 @@ time_t timeman_seconds_since_boot()
 time_t timeman_get_ticks_from_last_second()
 {
     return atomic_load(&ticks_since_second);
+}
+
+/**
+ * Monotonic milliseconds since boot, driven by the boot cpu timer.
+ * Used to timestamp events, wraps around in ~49 days.
+ */
+uint32_t timeman_ms_since_boot()
+{
+    time_t secs, ticks;
+    do {
+        secs = atomic_load(&time_since_boot);
+        ticks = atomic_load(&ticks_since_second);
+    } while (secs != atomic_load(&time_since_boot));
+    return secs * 1000 + (ticks * 1000) / TIMER_TICKS_PER_SECOND;
 }
\ No newline at end of file
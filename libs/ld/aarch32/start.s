@@ -0,0 +1,28 @@
+.section .text
+
+.extern _ld_main
+.extern _ld_fixup
+
+.global _start
+_start:
+	mov r0, sp
+	bl _ld_main
+	mov ip, r0
+	ldr r0, [sp]
+	ldr r1, [sp, #4]
+	ldr r2, [sp, #8]
+	bx ip
+
+@ PLT0 pushes the return address of the call and enters with ip holding
+@ &GOT[n] and lr holding &GOT[2].
+.global _ld_runtime_resolve
+_ld_runtime_resolve:
+	push {r0-r4}
+	ldr r0, [lr, #-4]
+	sub r1, ip, lr
+	sub r1, r1, #4
+	add r1, r1, r1
+	bl _ld_fixup
+	mov ip, r0
+	pop {r0-r4, lr}
+	bx ip
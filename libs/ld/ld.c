@@ -0,0 +1,507 @@
+#include "ld.h"
+#include <bits/fcntl.h>
+#include <bits/sys/mman.h>
+#include <stdbool.h>
+#include <sysdep.h>
+
+/**
+ * The dynamic loader. The kernel starts it instead of a dynamic exec,
+ * it maps the libs named by DT_NEEDED, relocates everything and jumps to
+ * the entry of the exec. Calls through the PLT are bound lazily, on the
+ * first call of each function.
+ *
+ * The loader can't use libc, nothing here may be called before its own
+ * relocations are applied, so the code sticks to hidden symbols only.
+ *
+ * This is groundwork only, it does not share text between processes yet.
+ * Segments of libs are read into private anonymous memory of each process:
+ * mmap has no MAP_FIXED, MAP_SHARED file mappings are a TODO in vfs and the
+ * kernel has no page cache to share frames of a file. libc and libcxx are
+ * linked statically, since they carry crt0 and __thread data, and libs with
+ * PT_TLS are refused. So a dynamic exec costs more than a static one and
+ * saves no memory until file-backed shared mappings land in the kernel.
+ */
+
+#define LD_MAX_PHDRS 16
+#define LD_STDERR 2
+
+extern elf_dyn_32_t _DYNAMIC[] __attribute__((visibility("hidden")));
+
+static ld_object_t objects[LD_MAX_OBJECTS];
+static int objects_count = 0;
+
+static inline int _ld_open(const char* path)
+{
+    return DO_SYSCALL_3(SYS_OPEN, path, O_RDONLY, 0);
+}
+
+static inline int _ld_read(int fd, void* buf, size_t count)
+{
+    return DO_SYSCALL_3(SYS_READ, fd, buf, count);
+}
+
+static inline int _ld_lseek(int fd, uint32_t off)
+{
+    return DO_SYSCALL_3(SYS_LSEEK, fd, off, SEEK_SET);
+}
+
+static inline void _ld_close(int fd)
+{
+    DO_SYSCALL_1(SYS_CLOSE, fd);
+}
+
+static inline void* _ld_mmap(size_t size)
+{
+    mmap_params_t params = { 0 };
+    params.size = size;
+    params.prot = PROT_READ | PROT_WRITE | PROT_EXEC;
+    params.flags = MAP_PRIVATE | MAP_ANONYMOUS;
+    return (void*)DO_SYSCALL_1(SYS_MMAP, &params);
+}
+
+static size_t _ld_strlen(const char* s)
+{
+    size_t len = 0;
+    while (s[len]) {
+        len++;
+    }
+    return len;
+}
+
+static bool _ld_streq(const char* a, const char* b)
+{
+    while (*a && *a == *b) {
+        a++;
+        b++;
+    }
+    return *a == *b;
+}
+
+static void _ld_write_str(const char* s)
+{
+    DO_SYSCALL_3(SYS_WRITE, LD_STDERR, s, _ld_strlen(s));
+}
+
+static void _ld_fail(const char* msg, const char* what)
+{
+    _ld_write_str("ld: ");
+    _ld_write_str(msg);
+    if (what) {
+        _ld_write_str(what);
+    }
+    _ld_write_str("\n");
+    DO_SYSCALL_1(SYS_EXIT, 127);
+    for (;;) { }
+}
+
+/**
+ * Only R_RELATIVE is expected here: the loader is linked with hidden
+ * visibility and -Bsymbolic, so all other references are resolved by the
+ * static linker.
+ */
+static void _ld_relocate_self(uint32_t base)
+{
+    elf_rel_32_t* rel = NULL;
+    uint32_t relsz = 0;
+    for (elf_dyn_32_t* dyn = _DYNAMIC; dyn->d_tag != DT_NULL; dyn++) {
+        if (dyn->d_tag == DT_REL) {
+            rel = (elf_rel_32_t*)(base + dyn->d_val);
+        } else if (dyn->d_tag == DT_RELSZ) {
+            relsz = dyn->d_val;
+        }
+    }
+
+    for (uint32_t i = 0; i < relsz / sizeof(elf_rel_32_t); i++) {
+        if (ELF32_R_TYPE(rel[i].r_info) == R_RELATIVE) {
+            *(uint32_t*)(base + rel[i].r_offset) += base;
+        }
+    }
+}
+
+static void _ld_parse_dynamic(ld_object_t* obj)
+{
+    uint32_t base = obj->base;
+    for (elf_dyn_32_t* dyn = obj->dynamic; dyn->d_tag != DT_NULL; dyn++) {
+        switch (dyn->d_tag) {
+        case DT_HASH:
+            obj->hash = (uint32_t*)(base + dyn->d_val);
+            break;
+        case DT_STRTAB:
+            obj->strtab = (const char*)(base + dyn->d_val);
+            break;
+        case DT_SYMTAB:
+            obj->symtab = (elf_sym_32_t*)(base + dyn->d_val);
+            break;
+        case DT_REL:
+            obj->rel = (elf_rel_32_t*)(base + dyn->d_val);
+            break;
+        case DT_RELSZ:
+            obj->relsz = dyn->d_val;
+            break;
+        case DT_JMPREL:
+            obj->jmprel = (elf_rel_32_t*)(base + dyn->d_val);
+            break;
+        case DT_PLTRELSZ:
+            obj->pltrelsz = dyn->d_val;
+            break;
+        case DT_PLTGOT:
+            obj->pltgot = (uint32_t*)(base + dyn->d_val);
+            break;
+        case DT_INIT_ARRAY:
+            obj->init_array = (void (**)(int, char**, char**))(base + dyn->d_val);
+            break;
+        case DT_INIT_ARRAYSZ:
+            obj->init_arraysz = dyn->d_val;
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+static ld_object_t* _ld_new_object(const char* name, uint32_t base, elf_dyn_32_t* dynamic)
+{
+    if (objects_count == LD_MAX_OBJECTS) {
+        _ld_fail("too many libs, can't load ", name);
+    }
+    ld_object_t* obj = &objects[objects_count++];
+    obj->name = name;
+    obj->base = base;
+    obj->dynamic = dynamic;
+    _ld_parse_dynamic(obj);
+    return obj;
+}
+
+static ld_object_t* _ld_find_object(const char* name)
+{
+    for (int i = 0; i < objects_count; i++) {
+        if (_ld_streq(objects[i].name, name)) {
+            return &objects[i];
+        }
+    }
+    return NULL;
+}
+
+static void _ld_read_exact(int fd, void* buf, uint32_t offset, size_t count, const char* name)
+{
+    _ld_lseek(fd, offset);
+    while (count) {
+        int res = _ld_read(fd, buf, count);
+        if (res <= 0) {
+            _ld_fail("can't read ", name);
+        }
+        buf = (uint8_t*)buf + res;
+        count -= res;
+    }
+}
+
+/**
+ * Maps a lib into one anonymous range which covers all its PT_LOAD
+ * segments. The range is zero filled on demand, so .bss needs nothing.
+ */
+static ld_object_t* _ld_load_object(const char* name)
+{
+    char path[LD_PATH_MAX];
+    size_t prefix_len = 0;
+    size_t name_len = _ld_strlen(name);
+    const char* prefix = LD_LIBS_PATH;
+    if (name[0] != '/') {
+        prefix_len = _ld_strlen(prefix);
+    }
+    if (prefix_len + name_len >= LD_PATH_MAX) {
+        _ld_fail("path is too long: ", name);
+    }
+    for (size_t i = 0; i < prefix_len; i++) {
+        path[i] = prefix[i];
+    }
+    for (size_t i = 0; i <= name_len; i++) {
+        path[prefix_len + i] = name[i];
+    }
+
+    int fd = _ld_open(path);
+    if (fd < 0) {
+        _ld_fail("can't find ", path);
+    }
+
+    elf_header_32_t header;
+    _ld_read_exact(fd, &header, 0, sizeof(header), path);
+    if (header.e_ident[0] != 0x7f || header.e_ident[1] != 'E' || header.e_type != ET_DYN) {
+        _ld_fail("not a shared object: ", path);
+    }
+    if (header.e_phnum > LD_MAX_PHDRS) {
+        _ld_fail("too many program headers: ", path);
+    }
+
+    elf_program_header_32_t phdrs[LD_MAX_PHDRS];
+    _ld_read_exact(fd, phdrs, header.e_phoff, header.e_phnum * sizeof(elf_program_header_32_t), path);
+
+    uint32_t span = 0;
+    for (int i = 0; i < header.e_phnum; i++) {
+        if (phdrs[i].p_type == PT_TLS) {
+            _ld_fail("TLS isn't supported in libs: ", path);
+        }
+        if (phdrs[i].p_type == PT_LOAD && phdrs[i].p_vaddr + phdrs[i].p_memsz > span) {
+            span = phdrs[i].p_vaddr + phdrs[i].p_memsz;
+        }
+    }
+
+    // Ranges may lie above 2GB, so only small negative values are errors.
+    uint32_t base = (uint32_t)_ld_mmap(span);
+    if (base > (uint32_t)-4096) {
+        _ld_fail("no memory for ", path);
+    }
+
+    elf_dyn_32_t* dynamic = NULL;
+    for (int i = 0; i < header.e_phnum; i++) {
+        if (phdrs[i].p_type == PT_LOAD) {
+            _ld_read_exact(fd, (void*)(base + phdrs[i].p_vaddr), phdrs[i].p_offset, phdrs[i].p_filesz, path);
+        } else if (phdrs[i].p_type == PT_DYNAMIC) {
+            dynamic = (elf_dyn_32_t*)(base + phdrs[i].p_vaddr);
+        }
+    }
+    _ld_close(fd);
+
+    if (!dynamic) {
+        _ld_fail("no dynamic section in ", path);
+    }
+    return _ld_new_object(name, base, dynamic);
+}
+
+/**
+ * Objects are appended in breadth first order, so walking the list while
+ * it grows loads the whole dependency tree, each lib once.
+ */
+static void _ld_load_needed()
+{
+    for (int i = 0; i < objects_count; i++) {
+        ld_object_t* obj = &objects[i];
+        for (elf_dyn_32_t* dyn = obj->dynamic; dyn->d_tag != DT_NULL; dyn++) {
+            if (dyn->d_tag != DT_NEEDED) {
+                continue;
+            }
+            const char* name = obj->strtab + dyn->d_val;
+            if (!_ld_find_object(name)) {
+                _ld_load_object(name);
+            }
+        }
+    }
+}
+
+static uint32_t _ld_elf_hash(const char* name)
+{
+    uint32_t h = 0;
+    while (*name) {
+        h = (h << 4) + (uint8_t)*name++;
+        uint32_t g = h & 0xf0000000;
+        if (g) {
+            h ^= g >> 24;
+        }
+        h &= ~g;
+    }
+    return h;
+}
+
+static elf_sym_32_t* _ld_find_in_object(ld_object_t* obj, const char* name, uint32_t hash)
+{
+    if (!obj->hash) {
+        return NULL;
+    }
+
+    uint32_t nbucket = obj->hash[0];
+    uint32_t* buckets = &obj->hash[2];
+    uint32_t* chains = &buckets[nbucket];
+    for (uint32_t i = buckets[hash % nbucket]; i; i = chains[i]) {
+        elf_sym_32_t* sym = &obj->symtab[i];
+        if (sym->st_shndx == SHN_UNDEF || ELF32_ST_BIND(sym->st_info) == STB_LOCAL) {
+            continue;
+        }
+        if (_ld_streq(obj->strtab + sym->st_name, name)) {
+            return sym;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Resolves a symbol referenced by @obj. Objects are searched in load
+ * order, the exec comes first, so its copies of lib data (R_COPY) win.
+ * The copy itself has to be resolved past the exec, hence @skip_self.
+ */
+static uint32_t _ld_resolve(ld_object_t* obj, elf_sym_32_t* sym, bool skip_self)
+{
+    if (ELF32_ST_BIND(sym->st_info) == STB_LOCAL) {
+        return obj->base + sym->st_value;
+    }
+
+    const char* name = obj->strtab + sym->st_name;
+    uint32_t hash = _ld_elf_hash(name);
+    for (int i = 0; i < objects_count; i++) {
+        if (skip_self && &objects[i] == obj) {
+            continue;
+        }
+        elf_sym_32_t* def = _ld_find_in_object(&objects[i], name, hash);
+        if (def) {
+            return objects[i].base + def->st_value;
+        }
+    }
+
+    if (ELF32_ST_BIND(sym->st_info) == STB_WEAK) {
+        return 0;
+    }
+    _ld_fail("undefined symbol ", name);
+    return 0;
+}
+
+static void _ld_relocate(ld_object_t* obj)
+{
+    for (uint32_t i = 0; i < obj->relsz / sizeof(elf_rel_32_t); i++) {
+        elf_rel_32_t* rel = &obj->rel[i];
+        uint32_t* where = (uint32_t*)(obj->base + rel->r_offset);
+        uint32_t type = ELF32_R_TYPE(rel->r_info);
+        elf_sym_32_t* sym = NULL;
+        uint32_t value = 0;
+        if (ELF32_R_SYM(rel->r_info) && type != R_RELATIVE) {
+            sym = &obj->symtab[ELF32_R_SYM(rel->r_info)];
+            value = _ld_resolve(obj, sym, type == R_COPY);
+        }
+
+        switch (type) {
+        case R_NONE:
+            break;
+        case R_ABS32:
+            *where += value;
+            break;
+        case R_REL32:
+            *where += value - (uint32_t)where;
+            break;
+        case R_GLOB_DAT:
+        case R_JUMP_SLOT:
+            *where = value;
+            break;
+        case R_RELATIVE:
+            *where += obj->base;
+            break;
+        case R_COPY:
+            for (uint32_t j = 0; j < sym->st_size; j++) {
+                ((uint8_t*)where)[j] = ((uint8_t*)value)[j];
+            }
+            break;
+        default:
+            _ld_fail("unsupported relocation in ", obj->name);
+        }
+    }
+}
+
+/**
+ * GOT[1] and GOT[2] are reserved for the loader: the PLT stub passes
+ * GOT[1] to the resolver at GOT[2] along with the relocation to bind.
+ * Until then slots point back into the PLT, which is moved by base.
+ */
+static void _ld_setup_plt(ld_object_t* obj)
+{
+    if (!obj->pltgot || !obj->jmprel) {
+        return;
+    }
+
+    obj->pltgot[1] = (uint32_t)obj;
+    obj->pltgot[2] = (uint32_t)_ld_runtime_resolve;
+    if (!obj->base) {
+        return;
+    }
+    for (uint32_t i = 0; i < obj->pltrelsz / sizeof(elf_rel_32_t); i++) {
+        *(uint32_t*)(obj->base + obj->jmprel[i].r_offset) += obj->base;
+    }
+}
+
+uint32_t _ld_fixup(ld_object_t* obj, uint32_t reloc_offset)
+{
+    elf_rel_32_t* rel = (elf_rel_32_t*)((uint8_t*)obj->jmprel + reloc_offset);
+    uint32_t addr = _ld_resolve(obj, &obj->symtab[ELF32_R_SYM(rel->r_info)], false);
+    *(uint32_t*)(obj->base + rel->r_offset) = addr;
+    return addr;
+}
+
+/**
+ * Constructors of libs may use libc, which is linked into the exec and
+ * set up by its _init. So libc calls this through _ld_init_hook once it
+ * is ready. Libs loaded later depend on earlier ones, they go first.
+ */
+static void _ld_run_init_arrays()
+{
+    for (int i = objects_count - 1; i > 0; i--) {
+        ld_object_t* obj = &objects[i];
+        for (uint32_t j = 0; j < obj->init_arraysz / sizeof(void*); j++) {
+            obj->init_array[j](0, 0, 0);
+        }
+    }
+}
+
+static elf_dyn_32_t* _ld_find_exec_dynamic(elf_program_header_32_t* phdrs, uint32_t phnum)
+{
+    for (uint32_t i = 0; i < phnum; i++) {
+        if (phdrs[i].p_type == PT_DYNAMIC) {
+            return (elf_dyn_32_t*)phdrs[i].p_vaddr;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Called by _start with the initial stack of the proc, returns the entry
+ * of the exec. The stack is left as is, so the exec sees argc and argv.
+ */
+uint32_t _ld_main(uint32_t* sp)
+{
+    int argc = sp[0];
+    char** argv = (char**)sp[1];
+    char** envp = &argv[argc + 1];
+    while (*envp) {
+        envp++;
+    }
+
+    elf_program_header_32_t* phdrs = NULL;
+    uint32_t phnum = 0;
+    uint32_t base = 0;
+    uint32_t entry = 0;
+    for (elf_auxv_32_t* aux = (elf_auxv_32_t*)(envp + 1); aux->a_type != AT_NULL; aux++) {
+        switch (aux->a_type) {
+        case AT_PHDR:
+            phdrs = (elf_program_header_32_t*)aux->a_val;
+            break;
+        case AT_PHNUM:
+            phnum = aux->a_val;
+            break;
+        case AT_BASE:
+            base = aux->a_val;
+            break;
+        case AT_ENTRY:
+            entry = aux->a_val;
+            break;
+        default:
+            break;
+        }
+    }
+
+    _ld_relocate_self(base);
+
+    elf_dyn_32_t* exec_dynamic = _ld_find_exec_dynamic(phdrs, phnum);
+    if (!exec_dynamic) {
+        _ld_fail("no dynamic section in ", argv[0]);
+    }
+    ld_object_t* exec = _ld_new_object(argv[0], 0, exec_dynamic);
+    _ld_load_needed();
+
+    // Data of libs is ready before the exec copies it with R_COPY.
+    for (int i = objects_count - 1; i >= 0; i--) {
+        _ld_relocate(&objects[i]);
+        _ld_setup_plt(&objects[i]);
+    }
+
+    elf_sym_32_t* hook = _ld_find_in_object(exec, "_ld_init_hook", _ld_elf_hash("_ld_init_hook"));
+    if (hook) {
+        *(void (**)())(exec->base + hook->st_value) = _ld_run_init_arrays;
+    } else {
+        _ld_run_init_arrays();
+    }
+    return entry;
+}
@@ -0,0 +1,170 @@
+#ifndef _LD_LD_H
+#define _LD_LD_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define LD_MAX_OBJECTS 16
+#define LD_LIBS_PATH "/libs/"
+#define LD_PATH_MAX 128
+
+enum E_TYPE_FIELDS {
+    ET_NONE,
+    ET_REL,
+    ET_EXEC,
+    ET_DYN,
+    ET_CORE,
+};
+
+typedef struct {
+    uint8_t e_ident[16];
+    uint16_t e_type;
+    uint16_t e_machine;
+    uint32_t e_version;
+    uint32_t e_entry;
+    uint32_t e_phoff;
+    uint32_t e_shoff;
+    uint32_t e_flags;
+    uint16_t e_ehsize;
+    uint16_t e_phentsize;
+    uint16_t e_phnum;
+    uint16_t e_shentsize;
+    uint16_t e_shnum;
+    uint16_t e_shstrndx;
+} elf_header_32_t;
+
+enum P_TYPE_FIELDS {
+    PT_NULL,
+    PT_LOAD,
+    PT_DYNAMIC,
+    PT_INTERP,
+    PT_NOTE,
+    PT_SHLIB,
+    PT_PHDR,
+    PT_TLS,
+};
+
+typedef struct {
+    uint32_t p_type;
+    uint32_t p_offset;
+    uint32_t p_vaddr;
+    uint32_t p_paddr;
+    uint32_t p_filesz;
+    uint32_t p_memsz;
+    uint32_t p_flags;
+    uint32_t p_align;
+} elf_program_header_32_t;
+
+typedef struct {
+    uint32_t st_name;
+    uint32_t st_value;
+    uint32_t st_size;
+    unsigned char st_info;
+    unsigned char st_other;
+    uint16_t st_shndx;
+} elf_sym_32_t;
+
+#define ELF32_ST_BIND(info) ((info) >> 4)
+#define SHN_UNDEF 0
+
+enum ST_BINDING_FIELDS {
+    STB_LOCAL = 0,
+    STB_GLOBAL = 1,
+    STB_WEAK = 2,
+};
+
+enum D_TAG_FIELDS {
+    DT_NULL = 0,
+    DT_NEEDED = 1,
+    DT_PLTRELSZ = 2,
+    DT_PLTGOT = 3,
+    DT_HASH = 4,
+    DT_STRTAB = 5,
+    DT_SYMTAB = 6,
+    DT_REL = 17,
+    DT_RELSZ = 18,
+    DT_JMPREL = 23,
+    DT_INIT_ARRAY = 25,
+    DT_INIT_ARRAYSZ = 27,
+};
+
+typedef struct {
+    int32_t d_tag;
+    uint32_t d_val;
+} elf_dyn_32_t;
+
+typedef struct {
+    uint32_t r_offset;
+    uint32_t r_info;
+} elf_rel_32_t;
+
+#define ELF32_R_SYM(info) ((info) >> 8)
+#define ELF32_R_TYPE(info) ((uint8_t)(info))
+
+// Relocation types of the target, both use REL tables without addends.
+#ifdef __i386__
+enum R_TYPE_FIELDS {
+    R_NONE = 0,
+    R_ABS32 = 1,
+    R_REL32 = 2,
+    R_COPY = 5,
+    R_GLOB_DAT = 6,
+    R_JUMP_SLOT = 7,
+    R_RELATIVE = 8,
+};
+#elif __arm__
+enum R_TYPE_FIELDS {
+    R_NONE = 0,
+    R_ABS32 = 2,
+    R_REL32 = 3,
+    R_COPY = 20,
+    R_GLOB_DAT = 21,
+    R_JUMP_SLOT = 22,
+    R_RELATIVE = 23,
+};
+#endif
+
+enum AT_TYPE_FIELDS {
+    AT_NULL = 0,
+    AT_PHDR = 3,
+    AT_PHENT = 4,
+    AT_PHNUM = 5,
+    AT_PAGESZ = 6,
+    AT_BASE = 7,
+    AT_ENTRY = 9,
+};
+
+typedef struct {
+    uint32_t a_type;
+    uint32_t a_val;
+} elf_auxv_32_t;
+
+/**
+ * A loaded ELF object: the exec itself, a lib or the loader. Addresses
+ * from the dynamic section are already moved by base.
+ */
+struct ld_object {
+    const char* name;
+    uint32_t base;
+    elf_dyn_32_t* dynamic;
+    elf_sym_32_t* symtab;
+    const char* strtab;
+    uint32_t* hash; // nbucket, nchain, buckets[nbucket], chains[nchain]
+    elf_rel_32_t* rel;
+    uint32_t relsz;
+    elf_rel_32_t* jmprel;
+    uint32_t pltrelsz;
+    uint32_t* pltgot;
+    void (**init_array)(int, char**, char**);
+    uint32_t init_arraysz;
+};
+typedef struct ld_object ld_object_t;
+
+// Nothing may go through the GOT before the loader relocates itself.
+#pragma GCC visibility push(hidden)
+uint32_t _ld_main(uint32_t* sp);
+uint32_t _ld_fixup(ld_object_t* obj, uint32_t reloc_offset);
+void _ld_runtime_resolve();
+#pragma GCC visibility pop
+
+#endif // _LD_LD_H
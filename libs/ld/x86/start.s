@@ -0,0 +1,31 @@
+section .text
+
+extern _ld_main
+extern _ld_fixup
+
+global _start:function (_start.end - _start)
+_start:
+    mov eax, esp
+    push eax
+    call _ld_main
+    add esp, 4
+    jmp eax
+.end:
+
+; The PLT stub pushes GOT[1] over the offset of the relocation to bind,
+; the return address of the call lies above them.
+global _ld_runtime_resolve:function (_ld_runtime_resolve.end - _ld_runtime_resolve)
+_ld_runtime_resolve:
+    push eax
+    push ecx
+    push edx
+    push dword [esp+16]
+    push dword [esp+16]
+    call _ld_fixup
+    add esp, 8
+    mov [esp+12], eax
+    pop edx
+    pop ecx
+    pop eax
+    ret 4
+.end:
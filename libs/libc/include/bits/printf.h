@@ -0,0 +1,371 @@
+#ifndef _LIBC_BITS_PRINTF_H
+#define _LIBC_BITS_PRINTF_H
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/types.h>
+
+/**
+ * Formatting core shared by the kernel log and libc. Output is collected
+ * in a span buffer owned by the caller and handed to flush() in whole
+ * runs once the buffer fills up. Sinks without flush() keep what fits and
+ * drop the rest, which is how snprintf truncates.
+ *
+ * Conversions follow C with the flags - 0 + space #, width, precision
+ * and '*'. Two conventions of this system are kept: %x, %X and %p always
+ * print a 0x prefix, and a single l makes u, x and X take 64-bit values.
+ */
+typedef void (*printf_flush_t)(void* ctx, const char* data, size_t len);
+
+struct printf_sink {
+    char* buf;
+    size_t size;
+    size_t pos;
+    size_t total; // Everything produced, including dropped output.
+    printf_flush_t flush;
+    void* ctx;
+};
+typedef struct printf_sink printf_sink_t;
+
+#define PRINTF_LEFT 0x1
+#define PRINTF_ZERO 0x2
+#define PRINTF_PLUS 0x4
+#define PRINTF_SPACE 0x8
+#define PRINTF_ALT 0x10
+
+struct printf_spec {
+    int flags;
+    size_t width;
+    int precision; // -1 if not set.
+};
+typedef struct printf_spec printf_spec_t;
+
+static const char _printf_digit_pairs[] = "00010203040506070809"
+                                          "10111213141516171819"
+                                          "20212223242526272829"
+                                          "30313233343536373839"
+                                          "40414243444546474849"
+                                          "50515253545556575859"
+                                          "60616263646566676869"
+                                          "70717273747576777879"
+                                          "80818283848586878889"
+                                          "90919293949596979899";
+static const char _printf_hex_lower[] = "0123456789abcdef";
+static const char _printf_hex_upper[] = "0123456789ABCDEF";
+
+static inline void printf_sink_init(printf_sink_t* sink, char* buf, size_t size, printf_flush_t flush, void* ctx)
+{
+    sink->buf = buf;
+    sink->size = size;
+    sink->pos = 0;
+    sink->total = 0;
+    sink->flush = flush;
+    sink->ctx = ctx;
+}
+
+static inline void printf_sink_flush(printf_sink_t* sink)
+{
+    if (sink->flush && sink->pos) {
+        sink->flush(sink->ctx, sink->buf, sink->pos);
+    }
+    sink->pos = 0;
+}
+
+static inline bool _printf_sink_reserve(printf_sink_t* sink)
+{
+    if (sink->pos < sink->size) {
+        return true;
+    }
+    if (!sink->flush) {
+        return false;
+    }
+    printf_sink_flush(sink);
+    return true;
+}
+
+static inline void _printf_put(printf_sink_t* sink, const char* data, size_t len)
+{
+    sink->total += len;
+    while (len && _printf_sink_reserve(sink)) {
+        size_t chunk = sink->size - sink->pos;
+        if (chunk > len) {
+            chunk = len;
+        }
+        memcpy(sink->buf + sink->pos, data, chunk);
+        sink->pos += chunk;
+        data += chunk;
+        len -= chunk;
+    }
+}
+
+static inline void _printf_fill(printf_sink_t* sink, char c, size_t count)
+{
+    sink->total += count;
+    while (count && _printf_sink_reserve(sink)) {
+        sink->buf[sink->pos++] = c;
+        count--;
+    }
+}
+
+/* Integers are written backwards, ending right before @end. */
+static inline char* _printf_fmt_u32(uint32_t value, char* end)
+{
+    while (value >= 100) {
+        uint32_t pair = (value % 100) * 2;
+        value /= 100;
+        end -= 2;
+        end[0] = _printf_digit_pairs[pair];
+        end[1] = _printf_digit_pairs[pair + 1];
+    }
+    if (value >= 10) {
+        end -= 2;
+        end[0] = _printf_digit_pairs[value * 2];
+        end[1] = _printf_digit_pairs[value * 2 + 1];
+    } else {
+        *--end = '0' + value;
+    }
+    return end;
+}
+
+static inline char* _printf_fmt_u64(uint64_t value, char* end)
+{
+    // 64-bit division is a libgcc call, so it is done once per 9 digits.
+    while (value > 0xffffffff) {
+        uint32_t low = value % 1000000000;
+        value /= 1000000000;
+        char* start = _printf_fmt_u32(low, end);
+        while (start > end - 9) {
+            *--start = '0';
+        }
+        end = start;
+    }
+    return _printf_fmt_u32((uint32_t)value, end);
+}
+
+static inline char* _printf_fmt_pow2(uint64_t value, int shift, const char* alph, char* end)
+{
+    uint32_t mask = (1 << shift) - 1;
+    do {
+        *--end = alph[value & mask];
+        value >>= shift;
+    } while (value);
+    return end;
+}
+
+static inline void _printf_field(printf_sink_t* sink, const printf_spec_t* spec, const char* prefix, size_t prefix_len, const char* digits, size_t len)
+{
+    size_t zeros = 0;
+    if (spec->precision >= 0) {
+        if ((size_t)spec->precision > len) {
+            zeros = spec->precision - len;
+        }
+    } else if ((spec->flags & PRINTF_ZERO) && !(spec->flags & PRINTF_LEFT) && spec->width > prefix_len + len) {
+        zeros = spec->width - prefix_len - len;
+    }
+
+    size_t body = prefix_len + zeros + len;
+    size_t pad = spec->width > body ? spec->width - body : 0;
+    if (!(spec->flags & PRINTF_LEFT)) {
+        _printf_fill(sink, ' ', pad);
+    }
+    _printf_put(sink, prefix, prefix_len);
+    _printf_fill(sink, '0', zeros);
+    _printf_put(sink, digits, len);
+    if (spec->flags & PRINTF_LEFT) {
+        _printf_fill(sink, ' ', pad);
+    }
+}
+
+static inline int printf_engine(printf_sink_t* sink, const char* format, va_list arg)
+{
+    const char* p = format;
+    char tmp[32];
+    char* tmp_end = tmp + sizeof(tmp);
+
+    while (*p) {
+        // Plain text goes out in runs up to the next conversion.
+        const char* run = p;
+        while (*p && *p != '%') {
+            p++;
+        }
+        if (p != run) {
+            _printf_put(sink, run, p - run);
+        }
+        if (!*p) {
+            break;
+        }
+        if (!*(++p)) {
+            _printf_put(sink, "%", 1);
+            break;
+        }
+
+        printf_spec_t spec = { 0, 0, -1 };
+        for (;; p++) {
+            if (*p == '-') {
+                spec.flags |= PRINTF_LEFT;
+            } else if (*p == '0') {
+                spec.flags |= PRINTF_ZERO;
+            } else if (*p == '+') {
+                spec.flags |= PRINTF_PLUS;
+            } else if (*p == ' ') {
+                spec.flags |= PRINTF_SPACE;
+            } else if (*p == '#') {
+                spec.flags |= PRINTF_ALT;
+            } else {
+                break;
+            }
+        }
+
+        if (*p == '*') {
+            int width = va_arg(arg, int);
+            if (width < 0) {
+                spec.flags |= PRINTF_LEFT;
+                width = -width;
+            }
+            spec.width = width;
+            p++;
+        } else {
+            while (*p >= '0' && *p <= '9') {
+                spec.width = spec.width * 10 + (*p++ - '0');
+            }
+        }
+
+        if (*p == '.') {
+            p++;
+            spec.precision = 0;
+            if (*p == '*') {
+                spec.precision = va_arg(arg, int);
+                if (spec.precision < 0) {
+                    spec.precision = -1;
+                }
+                p++;
+            } else {
+                while (*p >= '0' && *p <= '9') {
+                    spec.precision = spec.precision * 10 + (*p++ - '0');
+                }
+            }
+        }
+
+        int l_arg = 0;
+        int h_arg = 0;
+        for (;; p++) {
+            if (*p == 'l') {
+                l_arg++;
+            } else if (*p == 'h') {
+                h_arg++;
+            } else if (*p != 'z' && *p != 't' && *p != 'j') {
+                break;
+            }
+        }
+        if (!*p) {
+            break;
+        }
+
+        const char* prefix = "";
+        size_t prefix_len = 0;
+        char* digits = tmp_end;
+        uint64_t value = 0;
+
+        switch (*p) {
+        case 'i':
+        case 'd': {
+            int64_t svalue;
+            if (l_arg > 1) {
+                svalue = va_arg(arg, int64_t);
+            } else if (l_arg) {
+                svalue = va_arg(arg, long);
+            } else {
+                svalue = va_arg(arg, int);
+                if (h_arg == 1) {
+                    svalue = (short)svalue;
+                } else if (h_arg > 1) {
+                    svalue = (signed char)svalue;
+                }
+            }
+
+            value = svalue < 0 ? -(uint64_t)svalue : (uint64_t)svalue;
+            if (svalue < 0) {
+                prefix = "-";
+            } else if (spec.flags & PRINTF_PLUS) {
+                prefix = "+";
+            } else if (spec.flags & PRINTF_SPACE) {
+                prefix = " ";
+            }
+            prefix_len = *prefix ? 1 : 0;
+
+            if (value || spec.precision) {
+                digits = value > 0xffffffff ? _printf_fmt_u64(value, tmp_end) : _printf_fmt_u32(value, tmp_end);
+            }
+            _printf_field(sink, &spec, prefix, prefix_len, digits, tmp_end - digits);
+        } break;
+        case 'u':
+        case 'x':
+        case 'X':
+        case 'o':
+        case 'p':
+            if (*p == 'p') {
+                value = (size_t)va_arg(arg, void*);
+            } else if (l_arg) {
+                value = va_arg(arg, uint64_t);
+            } else {
+                value = va_arg(arg, uint32_t);
+                if (h_arg == 1) {
+                    value = (uint16_t)value;
+                } else if (h_arg > 1) {
+                    value = (uint8_t)value;
+                }
+            }
+
+            if (*p == 'u') {
+                if (value || spec.precision) {
+                    digits = value > 0xffffffff ? _printf_fmt_u64(value, tmp_end) : _printf_fmt_u32(value, tmp_end);
+                }
+            } else if (*p == 'o') {
+                if (value || spec.precision) {
+                    digits = _printf_fmt_pow2(value, 3, _printf_hex_lower, tmp_end);
+                }
+                if ((spec.flags & PRINTF_ALT) && (digits == tmp_end || *digits != '0')) {
+                    *--digits = '0';
+                }
+            } else {
+                if (value || spec.precision) {
+                    digits = _printf_fmt_pow2(value, 4, *p == 'X' ? _printf_hex_upper : _printf_hex_lower, tmp_end);
+                }
+                prefix = "0x";
+                prefix_len = 2;
+            }
+            _printf_field(sink, &spec, prefix, prefix_len, digits, tmp_end - digits);
+            break;
+        case 'c': {
+            char c = (char)va_arg(arg, int);
+            spec.precision = -1;
+            spec.flags &= ~PRINTF_ZERO;
+            _printf_field(sink, &spec, "", 0, &c, 1);
+        } break;
+        case 's': {
+            const char* str = va_arg(arg, const char*);
+            if (!str) {
+                str = "(null)";
+            }
+            size_t len = 0;
+            while (str[len] && (spec.precision < 0 || len < (size_t)spec.precision)) {
+                len++;
+            }
+            spec.precision = -1;
+            spec.flags &= ~PRINTF_ZERO;
+            _printf_field(sink, &spec, "", 0, str, len);
+        } break;
+        case '%':
+            _printf_put(sink, "%", 1);
+            break;
+        default:
+            break;
+        }
+        p++;
+    }
+    return sink->total;
+}
+
+#endif // _LIBC_BITS_PRINTF_H
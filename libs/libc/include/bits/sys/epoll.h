@@ -0,0 +1,31 @@
+#ifndef _LIBC_BITS_SYS_EPOLL_H
+#define _LIBC_BITS_SYS_EPOLL_H
+
+#include <sys/types.h>
+
+#define EPOLL_CTL_ADD 1
+#define EPOLL_CTL_DEL 2
+#define EPOLL_CTL_MOD 3
+
+#define EPOLLIN 0x001
+#define EPOLLOUT 0x004
+#define EPOLLERR 0x008
+#define EPOLLHUP 0x010
+#define EPOLLONESHOT (1u << 30)
+#define EPOLLET (1u << 31)
+
+union epoll_data {
+    void* ptr;
+    int fd;
+    uint32_t u32;
+    uint64_t u64;
+};
+typedef union epoll_data epoll_data_t;
+
+struct epoll_event {
+    uint32_t events;
+    epoll_data_t data;
+};
+typedef struct epoll_event epoll_event_t;
+
+#endif // _LIBC_BITS_SYS_EPOLL_H
@@ -0,0 +1,34 @@
+#ifndef _LIBC_BITS_SYS_MALLOC_TRACE_H
+#define _LIBC_BITS_SYS_MALLOC_TRACE_H
+
+#include <sys/cdefs.h>
+#include <sys/types.h>
+
+__BEGIN_DECLS
+
+#define MALLOC_TRACE_MAGIC 0x4352544d // "MTRC"
+#define MALLOC_TRACE_MAX (64 * 1024)
+
+/**
+ * A trace file is a header followed by entries in call order. Entries
+ * with zero size are frees of @ptr.
+ */
+struct malloc_trace_header {
+    uint32_t magic;
+    uint32_t count;
+};
+typedef struct malloc_trace_header malloc_trace_header_t;
+
+struct malloc_trace_entry {
+    uint32_t ptr;
+    uint32_t size;
+};
+typedef struct malloc_trace_entry malloc_trace_entry_t;
+
+/* Work only in builds with malloc_trace = true. */
+void malloc_trace_start();
+int malloc_trace_dump(const char* path);
+
+__END_DECLS
+
+#endif // _LIBC_BITS_SYS_MALLOC_TRACE_H
\ No newline at end of file
@@ -0,0 +1,25 @@
+#ifndef _LIBC_BITS_SYS_PROFILE_H
+#define _LIBC_BITS_SYS_PROFILE_H
+
+#include <sys/types.h>
+
+#define PROFILE_MAX_DEPTH 8
+
+enum PROFILE_SAMPLE_FLAGS {
+    PROFILE_SAMPLE_KERNEL = 0x1,
+};
+
+/**
+ * One timer tick worth of profile. ips[0] is the interrupted
+ * instruction, the rest are return addresses of its callers.
+ */
+struct profile_sample {
+    uint32_t pid;
+    uint16_t cpu;
+    uint16_t flags;
+    uint32_t depth;
+    uint32_t ips[PROFILE_MAX_DEPTH];
+};
+typedef struct profile_sample profile_sample_t;
+
+#endif // _LIBC_BITS_SYS_PROFILE_H
\ No newline at end of file
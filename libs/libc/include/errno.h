@@ -2,9 +2,16 @@
 #define _LIBC_ERRNO_H
 
 #include <bits/errno.h>
+#include <sys/cdefs.h>
 
-extern int errno;
+__BEGIN_DECLS
+
+/* errno is kept per thread. */
+int* __errno_location();
+#define errno (*__errno_location())
 
 #define set_errno(x) (errno = x)
 
-#endif
\ No newline at end of file
+__END_DECLS
+
+#endif
@@ -9,6 +9,7 @@ __BEGIN_DECLS
 
 int open(const char* pathname, int flags);
 int creat(const char* path, mode_t mode);
+int posix_fadvise(int fd, off_t offset, off_t len, int advice);
 
 __END_DECLS
 
@@ -1,12 +1,29 @@
 #pragma once
 
 #include <bits/thread.h>
+#include <stddef.h>
 #include <sys/_structs.h>
 #include <sys/cdefs.h>
 #include <sys/types.h>
 
 __BEGIN_DECLS
 
-int pthread_create(void* func);
+#define PTHREAD_STACK_MIN (16 * 1024)
+#define PTHREAD_STACK_DEFAULT (256 * 1024)
+
+typedef int pthread_t;
+
+struct pthread_attr {
+    size_t stacksize;
+};
+typedef struct pthread_attr pthread_attr_t;
+
+int pthread_attr_init(pthread_attr_t* attr);
+int pthread_attr_destroy(pthread_attr_t* attr);
+int pthread_attr_setstacksize(pthread_attr_t* attr, size_t stacksize);
+int pthread_attr_getstacksize(const pthread_attr_t* attr, size_t* stacksize);
+
+int pthread_create(pthread_t* thread, const pthread_attr_t* attr, void* (*start_routine)(void*), void* arg);
+void pthread_exit(void* retval) __attribute__((noreturn));
 
 __END_DECLS
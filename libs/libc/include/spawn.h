@@ -0,0 +1,46 @@
+#ifndef _LIBC_SPAWN_H
+#define _LIBC_SPAWN_H
+
+#include <sys/cdefs.h>
+#include <sys/types.h>
+
+__BEGIN_DECLS
+
+#define POSIX_SPAWN_RESETIDS 0x01
+#define POSIX_SPAWN_SETPGROUP 0x02
+#define POSIX_SPAWN_SETSIGDEF 0x04
+#define POSIX_SPAWN_SETSIGMASK 0x08
+#define POSIX_SPAWN_SETSCHEDPARAM 0x10
+#define POSIX_SPAWN_SETSCHEDULER 0x20
+#define POSIX_SPAWN_FLAGS_MASK 0x3f
+
+/**
+ * File actions are not supported, adding one fails with ENOSYS. Spawning
+ * with any attribute flag set fails with ENOSYS too.
+ */
+struct posix_spawn_file_actions {
+    int __reserved;
+};
+typedef struct posix_spawn_file_actions posix_spawn_file_actions_t;
+
+struct posix_spawnattr {
+    short flags;
+};
+typedef struct posix_spawnattr posix_spawnattr_t;
+
+int posix_spawn(pid_t* pid, const char* path, const posix_spawn_file_actions_t* file_actions, const posix_spawnattr_t* attrp, char* const argv[], char* const envp[]);
+int posix_spawnp(pid_t* pid, const char* file, const posix_spawn_file_actions_t* file_actions, const posix_spawnattr_t* attrp, char* const argv[], char* const envp[]);
+
+int posix_spawn_file_actions_init(posix_spawn_file_actions_t* file_actions);
+int posix_spawn_file_actions_destroy(posix_spawn_file_actions_t* file_actions);
+int posix_spawn_file_actions_addopen(posix_spawn_file_actions_t* file_actions, int fd, const char* path, int oflag, mode_t mode);
+int posix_spawn_file_actions_addclose(posix_spawn_file_actions_t* file_actions, int fd);
+int posix_spawn_file_actions_adddup2(posix_spawn_file_actions_t* file_actions, int fd, int newfd);
+int posix_spawnattr_init(posix_spawnattr_t* attr);
+int posix_spawnattr_destroy(posix_spawnattr_t* attr);
+int posix_spawnattr_getflags(const posix_spawnattr_t* attr, short* flags);
+int posix_spawnattr_setflags(posix_spawnattr_t* attr, short flags);
+
+__END_DECLS
+
+#endif // _LIBC_SPAWN_H
@@ -24,6 +24,8 @@ typedef int ptrdiff_t;
 
 #define NULL ((void*)0)
 
+#define offsetof(type, member) __builtin_offsetof(type, member)
+
 __END_DECLS
 
 #endif // _LIBC_STDDEF_H
\ No newline at end of file
@@ -32,6 +32,8 @@ extern FILE* stdout;
 extern FILE* stderr;
 
 FILE* fopen(const char* filename, const char* mode);
+FILE* fdopen(int fd, const char* mode);
+int fileno(FILE* stream);
 
 int fclose(FILE* stream);
 
@@ -56,6 +58,8 @@ int getchar();
 int ungetc(int c, FILE* stream);
 
 char* fgets(char* str, int size, FILE* stream);
+ssize_t getdelim(char** lineptr, size_t* n, int delim, FILE* stream);
+ssize_t getline(char** lineptr, size_t* n, FILE* stream);
 
 int feof(FILE* stream);
 
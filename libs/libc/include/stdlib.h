@@ -33,10 +33,16 @@ extern void* malloc(size_t);
 extern void free(void*);
 extern void* calloc(size_t, size_t);
 extern void* realloc(void*, size_t);
+extern int malloc_trim(size_t pad);
+extern size_t malloc_count(); // malloc calls made by the calling thread.
 
 /* tools */
 int atoi(const char* s);
 
+/* env */
+extern char** environ;
+char* getenv(const char* name);
+
 /* exit */
 void abort() __attribute__((noreturn));
 void exit(int status) __attribute__((noreturn));
@@ -30,9 +30,17 @@ void* memccpy(void* dest, const void* __restrict src, int stop, size_t nbytes);
    otherwise return the difference. */
 int memcmp(const void* src1, const void* src2, size_t nbytes);
 
+/* Find the first byte matching 'c' in 'nbytes' from 'src'. Return NULL
+   if there is none. */
+void* memchr(const void* src, int c, size_t nbytes);
+
 /* Calculate the string length starting from 'str'. */
 size_t strlen(const char* str);
 
+/* Find the first occurrence of 'c' in 'str'. The null byte is part of the
+   string, so it can be searched for as well. */
+char* strchr(const char* str, int c);
+
 /* Copy 'src' into 'dest' until it finds a null byte in the source string.
    Note that this is dangerous because it writes memory no matter the size
    the 'dest' buffer is. */
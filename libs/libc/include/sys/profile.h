@@ -0,0 +1,6 @@
+#ifndef _LIBC_SYS_PROFILE_H
+#define _LIBC_SYS_PROFILE_H
+
+#include <bits/sys/profile.h>
+
+#endif // _LIBC_SYS_PROFILE_H
\ No newline at end of file
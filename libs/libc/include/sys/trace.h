@@ -0,0 +1,6 @@
+#ifndef _LIBC_SYS_TRACE_H
+#define _LIBC_SYS_TRACE_H
+
+#include <bits/sys/trace.h>
+
+#endif // _LIBC_SYS_TRACE_H
\ No newline at end of file
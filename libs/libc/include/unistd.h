@@ -18,6 +18,7 @@
 __BEGIN_DECLS
 
 int fork();
+pid_t vfork();
 int execve(const char* path, char** argv, char** env);
 int wait(int pid);
 pid_t getpid();
@@ -1,13 +1,26 @@
-int errno;
+static __thread int _errno;
+
+int* __errno_location()
+{
+    return &_errno;
+}
 
 extern int _stdio_init();
 extern int _stdio_deinit();
 extern int _malloc_init();
+extern void _string_init();
+
+// Set by the dynamic loader, runs constructors of shared libs.
+void (*_ld_init_hook)() = 0;
 
 void _libc_init()
 {
+    _string_init();
     _malloc_init();
     _stdio_init();
+    if (_ld_init_hook) {
+        _ld_init_hook();
+    }
     extern void (*__init_array_start[])(int, char**, char**) __attribute__((visibility("hidden")));
     extern void (*__init_array_end[])(int, char**, char**) __attribute__((visibility("hidden")));
 
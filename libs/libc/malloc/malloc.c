@@ -1,168 +1,491 @@
-#include "malloc.h"
-#include <stdbool.h>
-#include <stdint.h>
-#include <string.h>
-#include <sys/mman.h>
-
-#define ALIGNMENT (4)
-#define DEVIDE_SPACE_BOUNDARY (32)
-
-static malloc_header_t* memory[MALLOC_MAX_ALLOCATED_BLOCKS];
-static size_t allocated_blocks = 0;
-
-static int _alloc_new_block(size_t sz);
-
-static int _alloc_new_block(size_t sz)
-{
-    sz += sizeof(malloc_header_t);
-
-    // this will reduce system calls for the small memory allocations
-    size_t allocated_sz = sz > MALLOC_DEFAULT_BLOCK_SIZE ? sz : MALLOC_DEFAULT_BLOCK_SIZE;
-
-    int ret = (int)mmap(NULL, allocated_sz, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE, 0, 0);
-    if (ret < 0) {
-        return -1;
-    }
-    memory[allocated_blocks] = (void*)ret; // allocating a new block of memory
-    memory[allocated_blocks]->flags = 0;
-    memory[allocated_blocks]->next = 0;
-    memory[allocated_blocks]->prev = 0;
-    memory[allocated_blocks]->size = allocated_sz - sizeof(malloc_header_t);
-
-    allocated_blocks++;
-    return 0;
-}
-
-static inline char _malloc_need_to_divide_space(malloc_header_t* space, size_t alloc_size)
-{
-    return alloc_size + DEVIDE_SPACE_BOUNDARY <= space->size;
-}
-
-static inline char _malloc_can_fit_allocation(malloc_header_t* space, size_t alloc_size)
-{
-    uint32_t add[] = { 0, sizeof(malloc_header_t) };
-    return space->size >= (alloc_size + add[_malloc_need_to_divide_space(space, alloc_size)]);
-}
-
-void* malloc(size_t sz)
-{
-    if (!sz) {
-        return NULL;
-    }
-    sz += (ALIGNMENT - 1);
-    sz &= ~(uint32_t)(ALIGNMENT - 1);
-
-    void* res = slab_alloc(sz);
-    if (res) {
-        return res;
-    }
-
-    /* iterating over allocated by mmap blocks
-       and finding a first fit memory chunk */
-    malloc_header_t* first_fit = 0;
-    for (size_t i = 0; i < allocated_blocks; i++) {
-        malloc_header_t* cur_block = memory[i];
-        while (cur_block->next && !(block_is_free(cur_block) && _malloc_can_fit_allocation(cur_block, sz))) {
-            cur_block = cur_block->next;
-        }
-        if (block_is_free(cur_block) && _malloc_can_fit_allocation(cur_block, sz)) {
-            first_fit = cur_block;
-            break;
-        }
-    }
-
-    if (!first_fit) {
-        int err = _alloc_new_block(sz);
-        if (err) {
-            return NULL;
-        }
-        first_fit = memory[allocated_blocks - 1];
-    }
-
-    malloc_header_t* copy_next = first_fit->next;
-    size_t copy_size = first_fit->size;
-
-    first_fit->flags |= FLAG_ALLOCATED;
-    if (_malloc_need_to_divide_space(first_fit, sz)) {
-        first_fit->size = sz;
-        first_fit->next = (malloc_header_t*)((uintptr_t)first_fit + sz + sizeof(malloc_header_t));
-
-        // adjust the firstfit chunk
-        first_fit->next->flags = 0;
-        first_fit->next->size = copy_size - sz - sizeof(malloc_header_t);
-        first_fit->next->next = copy_next;
-        first_fit->next->prev = first_fit;
-
-        if (first_fit->next->next) {
-            first_fit->next->next->prev = first_fit->next;
-        }
-    }
-
-    return (void*)&((malloc_header_t*)first_fit)[1];
-}
-
-void free(void* mem)
-{
-    if (!mem) {
-        return;
-    }
-
-    malloc_header_t* mem_header = &((malloc_header_t*)mem)[-1];
-
-    if (block_is_slab(mem_header)) {
-        return slab_free(mem_header);
-    }
-
-    block_rem_flags(mem_header, FLAG_ALLOCATED);
-    while (mem_header->prev && block_is_free(mem_header->prev)) {
-        mem_header = mem_header->prev;
-    }
-
-    // Trying to glue the freed chunk with its neighbours.
-    while (mem_header->next && block_is_free(mem_header->next)) {
-        mem_header->size += mem_header->next->size + sizeof(malloc_header_t);
-
-        if (mem_header->next->next) {
-            mem_header->next->next->prev = mem_header;
-        }
-        mem_header->next = mem_header->next->next;
-    }
-}
-
-void* calloc(size_t num, size_t size)
-{
-    void* mem = malloc(num * size);
-    if (!mem) {
-        return NULL;
-    }
-
-    memset(mem, 0, num * size);
-    return mem;
-}
-
-void* realloc(void* ptr, size_t new_size)
-{
-    if (!ptr) {
-        return malloc(new_size);
-    }
-
-    size_t old_size = ((malloc_header_t*)ptr)[-1].size;
-    if (old_size == new_size) {
-        return ptr;
-    }
-
-    uint8_t* new_area = malloc(new_size);
-    if (!new_area) {
-        return NULL;
-    }
-
-    memcpy(new_area, ptr, new_size < old_size ? new_size : old_size);
-    free(ptr);
-
-    return new_area;
-}
-
-void _malloc_init()
-{
-    _slab_init();
-}
\ No newline at end of file
+#include "malloc.h"
+#include <fcntl.h>
+#include <sched.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/malloc_trace.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#define ALIGNMENT (8)
+#define MIN_CHUNK_SIZE (16)
+#define MAP_ALIGNMENT (4096)
+
+/**
+ * Arenas are mmapped regions split into chunks. Chunks of an arena are
+ * linked through next/prev of their headers in address order, so freeing
+ * merges with the neighbours in O(1). Free chunks also sit in one of the
+ * size-class bins, their bin links live in the payload. A bitmap of
+ * non-empty bins finds the smallest fitting class without walking lists.
+ */
+struct __malloc_bin_links {
+    malloc_header_t* next;
+    malloc_header_t* prev;
+};
+typedef struct __malloc_bin_links malloc_bin_links_t;
+
+static malloc_header_t* bins[MALLOC_BINS];
+static uint32_t binmap[MALLOC_BINS / 32];
+
+// The newest arena is kept mapped even when it becomes empty, so a
+// malloc/free loop doesn't end up in mmap on every iteration.
+static malloc_header_t* last_arena = NULL;
+
+static int malloc_lock_flag = 0;
+
+static __thread malloc_header_t* tcache[MALLOC_TCACHE_BINS];
+static __thread uint32_t tcache_count[MALLOC_TCACHE_BINS];
+static __thread size_t malloc_calls;
+
+static inline void _malloc_lock()
+{
+    while (__atomic_test_and_set(&malloc_lock_flag, __ATOMIC_ACQUIRE)) {
+        sched_yield();
+    }
+}
+
+static inline void _malloc_unlock()
+{
+    __atomic_clear(&malloc_lock_flag, __ATOMIC_RELEASE);
+}
+
+static inline malloc_bin_links_t* _bin_links(malloc_header_t* chunk)
+{
+    return (malloc_bin_links_t*)&chunk[1];
+}
+
+/**
+ * Sizes below 512 bytes get a bin per 16 bytes. Bigger sizes are split
+ * into 4 bins per power of two.
+ */
+static inline int _bin_index(size_t sz)
+{
+    if (sz < 512) {
+        return sz >> 4;
+    }
+    int log = 31 - __builtin_clz(sz);
+    int bin = 32 + (log - 9) * 4 + ((sz >> (log - 2)) & 3);
+    return bin < MALLOC_BINS ? bin : MALLOC_BINS - 1;
+}
+
+static inline size_t _bin_min_size(int bin)
+{
+    if (bin < 32) {
+        return bin << 4;
+    }
+    int log = 9 + (bin - 32) / 4;
+    return (size_t)(4 + ((bin - 32) & 3)) << (log - 2);
+}
+
+static void _bin_insert(malloc_header_t* chunk)
+{
+    int bin = _bin_index(chunk->size);
+    _bin_links(chunk)->next = bins[bin];
+    _bin_links(chunk)->prev = NULL;
+    if (bins[bin]) {
+        _bin_links(bins[bin])->prev = chunk;
+    }
+    bins[bin] = chunk;
+    binmap[bin >> 5] |= (1u << (bin & 31));
+}
+
+static void _bin_remove(malloc_header_t* chunk)
+{
+    int bin = _bin_index(chunk->size);
+    malloc_bin_links_t* links = _bin_links(chunk);
+    if (links->prev) {
+        _bin_links(links->prev)->next = links->next;
+    } else {
+        bins[bin] = links->next;
+    }
+    if (links->next) {
+        _bin_links(links->next)->prev = links->prev;
+    }
+    if (!bins[bin]) {
+        binmap[bin >> 5] &= ~(1u << (bin & 31));
+    }
+}
+
+static int _bin_find_nonempty(int start)
+{
+    for (int word = start >> 5; word < MALLOC_BINS / 32; word++) {
+        uint32_t mask = binmap[word];
+        if (word == (start >> 5)) {
+            mask &= (~0u << (start & 31));
+        }
+        if (mask) {
+            return (word << 5) + __builtin_ctz(mask);
+        }
+    }
+    return -1;
+}
+
+static malloc_header_t* _alloc_new_arena()
+{
+    int ret = (int)mmap(NULL, MALLOC_ARENA_SIZE, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE, 0, 0);
+    if (ret < 0) {
+        return NULL;
+    }
+    malloc_header_t* arena = (malloc_header_t*)ret;
+    arena->flags = 0;
+    arena->next = NULL;
+    arena->prev = NULL;
+    arena->size = MALLOC_ARENA_SIZE - sizeof(malloc_header_t);
+    last_arena = arena;
+    return arena;
+}
+
+static inline bool _chunk_is_whole_arena(malloc_header_t* chunk)
+{
+    return !chunk->prev && !chunk->next;
+}
+
+static void _unmap_arena(malloc_header_t* arena)
+{
+    if (arena == last_arena) {
+        last_arena = NULL;
+    }
+    munmap(arena, arena->size + sizeof(malloc_header_t));
+}
+
+static inline size_t _large_map_size(size_t sz)
+{
+    return (sz + sizeof(malloc_header_t) + MAP_ALIGNMENT - 1) & ~(size_t)(MAP_ALIGNMENT - 1);
+}
+
+static void* _malloc_large(size_t sz)
+{
+    size_t map_size = _large_map_size(sz);
+    int ret = (int)mmap(NULL, map_size, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE, 0, 0);
+    if (ret < 0) {
+        return NULL;
+    }
+    malloc_header_t* header = (malloc_header_t*)ret;
+    header->flags = FLAG_ALLOCATED | FLAG_MMAPPED;
+    header->next = NULL;
+    header->prev = NULL;
+    header->size = map_size - sizeof(malloc_header_t);
+    return (void*)&header[1];
+}
+
+static void* _heap_alloc(size_t sz)
+{
+    // Every chunk in the bins starting from the one whose lower bound is
+    // at least sz fits, so the bitmap gives the answer in O(1).
+    int bin = _bin_index(sz);
+    if (_bin_min_size(bin) < sz) {
+        bin++;
+    }
+
+    malloc_header_t* chunk = NULL;
+    int found = bin < MALLOC_BINS ? _bin_find_nonempty(bin) : -1;
+    if (found >= 0) {
+        chunk = bins[found];
+    } else {
+        // The only chunks left which could fit share a bin with the request.
+        for (malloc_header_t* it = bins[_bin_index(sz)]; it; it = _bin_links(it)->next) {
+            if (it->size >= sz) {
+                chunk = it;
+                break;
+            }
+        }
+    }
+
+    if (chunk) {
+        _bin_remove(chunk);
+    } else {
+        chunk = _alloc_new_arena();
+        if (!chunk) {
+            return NULL;
+        }
+    }
+
+    if (sz + sizeof(malloc_header_t) + MIN_CHUNK_SIZE <= chunk->size) {
+        malloc_header_t* rest = (malloc_header_t*)((uintptr_t)chunk + sizeof(malloc_header_t) + sz);
+        rest->flags = 0;
+        rest->size = chunk->size - sz - sizeof(malloc_header_t);
+        rest->prev = chunk;
+        rest->next = chunk->next;
+        if (chunk->next) {
+            chunk->next->prev = rest;
+        }
+        chunk->next = rest;
+        chunk->size = sz;
+        _bin_insert(rest);
+    }
+
+    block_set_flags(chunk, FLAG_ALLOCATED);
+    return (void*)&chunk[1];
+}
+
+static void _heap_free(malloc_header_t* chunk)
+{
+    block_rem_flags(chunk, FLAG_ALLOCATED);
+
+    // Free chunks are always merged, so each side has at most one free neighbour.
+    malloc_header_t* next = chunk->next;
+    if (next && block_is_free(next)) {
+        _bin_remove(next);
+        chunk->size += next->size + sizeof(malloc_header_t);
+        chunk->next = next->next;
+        if (next->next) {
+            next->next->prev = chunk;
+        }
+    }
+
+    malloc_header_t* prev = chunk->prev;
+    if (prev && block_is_free(prev)) {
+        _bin_remove(prev);
+        prev->size += chunk->size + sizeof(malloc_header_t);
+        prev->next = chunk->next;
+        if (chunk->next) {
+            chunk->next->prev = prev;
+        }
+        chunk = prev;
+    }
+
+    if (_chunk_is_whole_arena(chunk) && chunk != last_arena) {
+        _unmap_arena(chunk);
+        return;
+    }
+    _bin_insert(chunk);
+}
+
+static inline void _malloc_release(malloc_header_t* header)
+{
+    if (block_is_slab(header)) {
+        slab_free(header);
+    } else {
+        _heap_free(header);
+    }
+}
+
+static inline malloc_header_t** _tcache_link(malloc_header_t* chunk)
+{
+    return (malloc_header_t**)&chunk[1];
+}
+
+#ifdef MALLOC_TRACE
+static malloc_trace_entry_t _trace_entries[MALLOC_TRACE_MAX];
+static uint32_t _trace_count = 0;
+static bool _trace_enabled = false;
+
+static inline void _malloc_trace(void* ptr, size_t size)
+{
+    if (!_trace_enabled || !ptr) {
+        return;
+    }
+    uint32_t idx = __atomic_fetch_add(&_trace_count, 1, __ATOMIC_RELAXED);
+    if (idx < MALLOC_TRACE_MAX) {
+        _trace_entries[idx].ptr = (uint32_t)ptr;
+        _trace_entries[idx].size = size;
+    }
+}
+
+void malloc_trace_start()
+{
+    _trace_count = 0;
+    _trace_enabled = true;
+}
+
+/**
+ * Stops recording and writes the calls recorded since malloc_trace_start
+ * to @path, see sys/malloc_trace.h.
+ */
+int malloc_trace_dump(const char* path)
+{
+    _trace_enabled = false;
+    int fd = open(path, O_CREAT | O_TRUNC | O_WRONLY);
+    if (fd < 0) {
+        return -1;
+    }
+
+    malloc_trace_header_t header;
+    header.magic = MALLOC_TRACE_MAGIC;
+    header.count = _trace_count < MALLOC_TRACE_MAX ? _trace_count : MALLOC_TRACE_MAX;
+    write(fd, &header, sizeof(header));
+    write(fd, _trace_entries, header.count * sizeof(malloc_trace_entry_t));
+    close(fd);
+    return 0;
+}
+#else
+static inline void _malloc_trace(void* ptr, size_t size) { }
+
+void malloc_trace_start() { }
+
+int malloc_trace_dump(const char* path)
+{
+    return -1;
+}
+#endif // MALLOC_TRACE
+
+static inline void* _malloc(size_t sz)
+{
+    if (!sz) {
+        return NULL;
+    }
+    sz += (ALIGNMENT - 1);
+    sz &= ~(uint32_t)(ALIGNMENT - 1);
+    if (sz < MIN_CHUNK_SIZE) {
+        sz = MIN_CHUNK_SIZE;
+    }
+
+    if (sz >= MALLOC_LARGE_SIZE) {
+        return _malloc_large(sz);
+    }
+
+    // Chunks in a cache bin are at least 16 * index bytes long.
+    size_t tbin = (sz + 15) >> 4;
+    if (tbin < MALLOC_TCACHE_BINS && tcache[tbin]) {
+        malloc_header_t* chunk = tcache[tbin];
+        tcache[tbin] = *_tcache_link(chunk);
+        tcache_count[tbin]--;
+        return (void*)&chunk[1];
+    }
+
+    _malloc_lock();
+    void* res = slab_alloc(sz);
+    if (!res) {
+        res = _heap_alloc(sz);
+    }
+    _malloc_unlock();
+    return res;
+}
+
+void* malloc(size_t sz)
+{
+    malloc_calls++;
+    void* res = _malloc(sz);
+    _malloc_trace(res, sz);
+    return res;
+}
+
+void free(void* mem)
+{
+    if (!mem) {
+        return;
+    }
+    _malloc_trace(mem, 0);
+
+    malloc_header_t* mem_header = &((malloc_header_t*)mem)[-1];
+
+    if (block_is_mmapped(mem_header)) {
+        munmap(mem_header, mem_header->size + sizeof(malloc_header_t));
+        return;
+    }
+
+    // Cached chunks stay marked as allocated, so they are not merged
+    // with their neighbours until the cache hands them back.
+    if (mem_header->size <= MALLOC_TCACHE_MAX_SIZE) {
+        size_t tbin = mem_header->size >> 4;
+        if (tcache_count[tbin] < MALLOC_TCACHE_COUNT) {
+            *_tcache_link(mem_header) = tcache[tbin];
+            tcache[tbin] = mem_header;
+            tcache_count[tbin]++;
+            return;
+        }
+    }
+
+    _malloc_lock();
+    _malloc_release(mem_header);
+    _malloc_unlock();
+}
+
+size_t malloc_count()
+{
+    return malloc_calls;
+}
+
+void* calloc(size_t num, size_t size)
+{
+    if (size && num > (size_t)-1 / size) {
+        return NULL;
+    }
+
+    void* mem = malloc(num * size);
+    if (!mem) {
+        return NULL;
+    }
+
+    memset(mem, 0, num * size);
+    return mem;
+}
+
+void* realloc(void* ptr, size_t new_size)
+{
+    if (!ptr) {
+        return malloc(new_size);
+    }
+
+    size_t old_size = ((malloc_header_t*)ptr)[-1].size;
+    if (new_size <= old_size && new_size + MALLOC_LARGE_SIZE > old_size) {
+        return ptr;
+    }
+
+    uint8_t* new_area = malloc(new_size);
+    if (!new_area) {
+        return NULL;
+    }
+
+    memcpy(new_area, ptr, new_size < old_size ? new_size : old_size);
+    free(ptr);
+
+    return new_area;
+}
+
+/**
+ * Hands the calling thread's cached chunks back and unmaps every arena
+ * which is completely free. @pad is accepted for compatibility, arenas
+ * are released only as a whole. Returns 1 if any memory was released.
+ */
+// Hands the calling thread's cached chunks back to the shared bins.
+static void _tcache_release_locked()
+{
+    for (int i = 0; i < MALLOC_TCACHE_BINS; i++) {
+        while (tcache[i]) {
+            malloc_header_t* chunk = tcache[i];
+            tcache[i] = *_tcache_link(chunk);
+            _malloc_release(chunk);
+        }
+        tcache_count[i] = 0;
+    }
+}
+
+int malloc_trim(size_t pad)
+{
+    int released = 0;
+
+    _malloc_lock();
+    _tcache_release_locked();
+
+    last_arena = NULL;
+    for (int bin = 0; bin < MALLOC_BINS; bin++) {
+        malloc_header_t* chunk = bins[bin];
+        while (chunk) {
+            malloc_header_t* next = _bin_links(chunk)->next;
+            if (_chunk_is_whole_arena(chunk)) {
+                _bin_remove(chunk);
+                _unmap_arena(chunk);
+                released = 1;
+            }
+            chunk = next;
+        }
+    }
+    _malloc_unlock();
+
+    return released;
+}
+
+// Chunks left in the cache of an exiting thread would stay allocated for good.
+void _malloc_thread_exit()
+{
+    _malloc_lock();
+    _tcache_release_locked();
+    _malloc_unlock();
+}
+
+void _malloc_init()
+{
+    _slab_init();
+}
@@ -10,10 +10,19 @@
 __BEGIN_DECLS
 
 #define MALLOC_DEFAULT_BLOCK_SIZE 4096
-#define MALLOC_MAX_ALLOCATED_BLOCKS 64
+#define MALLOC_ARENA_SIZE (64 * 1024)
+#define MALLOC_LARGE_SIZE (32 * 1024) // Served straight from mmap.
+#define MALLOC_BINS 64
+
+// Per-thread caches keep up to MALLOC_TCACHE_COUNT freed chunks of every
+// 16-byte class up to MALLOC_TCACHE_MAX_SIZE.
+#define MALLOC_TCACHE_MAX_SIZE 256
+#define MALLOC_TCACHE_BINS ((MALLOC_TCACHE_MAX_SIZE >> 4) + 1)
+#define MALLOC_TCACHE_COUNT 16
 
 #define FLAG_ALLOCATED (0x1)
 #define FLAG_SLAB (0x2)
+#define FLAG_MMAPPED (0x4)
 struct __malloc_header {
     size_t size;
     uint32_t flags;
@@ -52,13 +61,20 @@ static inline bool block_is_slab(malloc_header_t* block)
     return block_has_flags(block, FLAG_SLAB);
 }
 
+static inline bool block_is_mmapped(malloc_header_t* block)
+{
+    return block_has_flags(block, FLAG_MMAPPED);
+}
+
 void _malloc_init();
+void _malloc_thread_exit();
 void _slab_init();
 
 void* malloc(size_t);
 void free(void*);
 void* calloc(size_t, size_t);
 void* realloc(void*, size_t);
+int malloc_trim(size_t pad);
 
 void* slab_alloc(size_t);
 void slab_free(malloc_header_t* mem_header);
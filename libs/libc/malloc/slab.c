@@ -60,7 +60,12 @@ void* slab_alloc(size_t size)
     int block_id = ((size + 15) >> 4);
     malloc_header_t* zone = free_blocks[block_id];
     if (!zone) {
-        return NULL;
+        // Refilling the class with a new page once it runs out.
+        prepare_free_blocks(block_id << 4);
+        zone = free_blocks[block_id];
+        if (!zone) {
+            return NULL;
+        }
     }
 
     free_blocks[block_id] = zone->next;
@@ -1,10 +1,17 @@
+#include <errno.h>
 #include <fcntl.h>
+#include <sys/epoll.h>
 #include <sys/mman.h>
 #include <sys/select.h>
 #include <sys/stat.h>
 #include <sysdep.h>
 #include <unistd.h>
 
+// The kernel has no readahead to steer yet, so access hints are kept here
+// and used by stdio to size the buffers of streams on the fd.
+#define FADVISE_MAX_FDS 32
+static char fadvise_hints[FADVISE_MAX_FDS];
+
 int open(const char* pathname, int flags)
 {
     int res = DO_SYSCALL_3(SYS_OPEN, pathname, flags, S_IFREG | S_IRWXU | S_IRWXG | S_IRWXO);
@@ -19,10 +26,37 @@ int creat(const char* path, mode_t mode)
 
 int close(int fd)
 {
+    if (fd >= 0 && fd < FADVISE_MAX_FDS) {
+        fadvise_hints[fd] = POSIX_FADV_NORMAL;
+    }
     int res = DO_SYSCALL_1(SYS_CLOSE, fd);
     RETURN_WITH_ERRNO(res, 0, -1);
 }
 
+int posix_fadvise(int fd, off_t offset, off_t len, int advice)
+{
+    if (fd < 0) {
+        return EBADF;
+    }
+    if (advice < POSIX_FADV_NORMAL || advice > POSIX_FADV_NOREUSE) {
+        return EINVAL;
+    }
+
+    // Only the access pattern matters for stdio, the range is ignored.
+    if (fd < FADVISE_MAX_FDS && advice <= POSIX_FADV_SEQUENTIAL) {
+        fadvise_hints[fd] = advice;
+    }
+    return 0;
+}
+
+int __fadvise_hint(int fd)
+{
+    if (fd < 0 || fd >= FADVISE_MAX_FDS) {
+        return POSIX_FADV_NORMAL;
+    }
+    return fadvise_hints[fd];
+}
+
 ssize_t read(int fd, char* buf, size_t count)
 {
     return (ssize_t)DO_SYSCALL_3(SYS_READ, fd, buf, count);
@@ -74,6 +108,28 @@ int select(int nfds, fd_set_t* readfds, fd_set_t* writefds, fd_set_t* exceptfds,
     RETURN_WITH_ERRNO(res, res, -1);
 }
 
+int epoll_create(int size)
+{
+    if (size <= 0) {
+        set_errno(EINVAL);
+        return -1;
+    }
+    int res = DO_SYSCALL_0(SYS_EPOLL_CREATE);
+    RETURN_WITH_ERRNO(res, res, -1);
+}
+
+int epoll_ctl(int epfd, int op, int fd, struct epoll_event* event)
+{
+    int res = DO_SYSCALL_4(SYS_EPOLL_CTL, epfd, op, fd, event);
+    RETURN_WITH_ERRNO(res, 0, -1);
+}
+
+int epoll_wait(int epfd, struct epoll_event* events, int maxevents, int timeout)
+{
+    int res = DO_SYSCALL_4(SYS_EPOLL_WAIT, epfd, events, maxevents, timeout);
+    RETURN_WITH_ERRNO(res, res, -1);
+}
+
 void* mmap(void* addr, size_t length, int prot, int flags, int fd, off_t offset)
 {
     mmap_params_t mmap_params = { 0 };
@@ -0,0 +1,140 @@
+#include <errno.h>
+#include <spawn.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sysdep.h>
+#include <unistd.h>
+
+#define SPAWN_DEFAULT_PATH "/bin"
+#define SPAWN_PATH_MAX 128
+
+int posix_spawn(pid_t* pid, const char* path, const posix_spawn_file_actions_t* file_actions, const posix_spawnattr_t* attrp, char* const argv[], char* const envp[])
+{
+    if (attrp && attrp->flags) {
+        set_errno(ENOSYS);
+        return ENOSYS;
+    }
+
+    // The kernel passes path as argv[0] itself, so skipping it here.
+    char* const* kargv = NULL;
+    if (argv && argv[0]) {
+        kargv = &argv[1];
+    }
+
+    int res = DO_SYSCALL_3(SYS_SPAWN, (int)path, (int)kargv, (int)envp);
+    if (res < 0) {
+        set_errno(res);
+        return -res;
+    }
+
+    set_errno(0);
+    if (pid) {
+        *pid = res;
+    }
+    return 0;
+}
+
+int posix_spawnp(pid_t* pid, const char* file, const posix_spawn_file_actions_t* file_actions, const posix_spawnattr_t* attrp, char* const argv[], char* const envp[])
+{
+    if (!file || !*file) {
+        set_errno(ENOENT);
+        return ENOENT;
+    }
+
+    if (strchr(file, '/')) {
+        return posix_spawn(pid, file, file_actions, attrp, argv, envp);
+    }
+
+    const char* search_path = getenv("PATH");
+    if (!search_path || !*search_path) {
+        search_path = SPAWN_DEFAULT_PATH;
+    }
+
+    char path[SPAWN_PATH_MAX];
+    size_t file_len = strlen(file);
+    int res = ENOENT;
+    const char* dir = search_path;
+    for (;;) {
+        const char* dir_end = strchr(dir, ':');
+        size_t dir_len = dir_end ? (size_t)(dir_end - dir) : strlen(dir);
+
+        // An empty entry stands for the current directory.
+        if (!dir_len) {
+            dir = ".";
+            dir_len = 1;
+        }
+
+        if (dir_len + file_len + 2 > SPAWN_PATH_MAX) {
+            res = ENAMETOOLONG;
+        } else {
+            memcpy(path, dir, dir_len);
+            path[dir_len] = '/';
+            memcpy(&path[dir_len + 1], file, file_len + 1);
+
+            res = posix_spawn(pid, path, file_actions, attrp, argv, envp);
+            if (res != ENOENT && res != EACCES) {
+                return res;
+            }
+        }
+
+        if (!dir_end) {
+            break;
+        }
+        dir = dir_end + 1;
+    }
+
+    set_errno(res);
+    return res;
+}
+
+int posix_spawn_file_actions_init(posix_spawn_file_actions_t* file_actions)
+{
+    file_actions->__reserved = 0;
+    return 0;
+}
+
+int posix_spawn_file_actions_destroy(posix_spawn_file_actions_t* file_actions)
+{
+    return 0;
+}
+
+int posix_spawn_file_actions_addopen(posix_spawn_file_actions_t* file_actions, int fd, const char* path, int oflag, mode_t mode)
+{
+    return ENOSYS;
+}
+
+int posix_spawn_file_actions_addclose(posix_spawn_file_actions_t* file_actions, int fd)
+{
+    return ENOSYS;
+}
+
+int posix_spawn_file_actions_adddup2(posix_spawn_file_actions_t* file_actions, int fd, int newfd)
+{
+    return ENOSYS;
+}
+
+int posix_spawnattr_init(posix_spawnattr_t* attr)
+{
+    attr->flags = 0;
+    return 0;
+}
+
+int posix_spawnattr_destroy(posix_spawnattr_t* attr)
+{
+    return 0;
+}
+
+int posix_spawnattr_getflags(const posix_spawnattr_t* attr, short* flags)
+{
+    *flags = attr->flags;
+    return 0;
+}
+
+int posix_spawnattr_setflags(posix_spawnattr_t* attr, short flags)
+{
+    if (flags & ~POSIX_SPAWN_FLAGS_MASK) {
+        return EINVAL;
+    }
+    attr->flags = flags;
+    return 0;
+}
\ No newline at end of file
@@ -1,14 +1,85 @@
+#include <errno.h>
 #include <pthread.h>
 #include <sys/mman.h>
 #include <sysdep.h>
 
-int pthread_create(void* func)
+extern void _malloc_thread_exit();
+
+int pthread_attr_init(pthread_attr_t* attr)
+{
+    attr->stacksize = PTHREAD_STACK_DEFAULT;
+    return 0;
+}
+
+int pthread_attr_destroy(pthread_attr_t* attr)
+{
+    return 0;
+}
+
+int pthread_attr_setstacksize(pthread_attr_t* attr, size_t stacksize)
+{
+    if (stacksize < PTHREAD_STACK_MIN) {
+        return EINVAL;
+    }
+    attr->stacksize = stacksize;
+    return 0;
+}
+
+int pthread_attr_getstacksize(const pthread_attr_t* attr, size_t* stacksize)
+{
+    *stacksize = attr->stacksize;
+    return 0;
+}
+
+// Kept at the top of the stack of a new thread.
+struct pthread_start {
+    void* (*start_routine)(void*);
+    void* arg;
+    uint32_t padding[2];
+};
+typedef struct pthread_start pthread_start_t;
+
+static void _pthread_start(pthread_start_t* start)
+{
+    pthread_exit(start->start_routine(start->arg));
+}
+
+int pthread_create(pthread_t* thread, const pthread_attr_t* attr, void* (*start_routine)(void*), void* arg)
 {
-    uint32_t start = (uint32_t)mmap(NULL, 4096, PROT_READ | PROT_WRITE | PROT_EXEC, MAP_STACK | MAP_PRIVATE, 0, 0);
+    size_t stack_size = attr ? attr->stacksize : PTHREAD_STACK_DEFAULT;
+
+    // The stack is only reserved here, its pages are loaded on first touch.
+    void* start = mmap(NULL, stack_size, PROT_READ | PROT_WRITE, MAP_STACK | MAP_PRIVATE, 0, 0);
+    // Errors come as small negative values, while stacks live in the upper half.
+    if ((uint32_t)start >= (uint32_t)(-4096)) {
+        return EAGAIN;
+    }
+
+    // The thread returns through _pthread_start, which gets its routine from the stack.
+    pthread_start_t* thread_start = (pthread_start_t*)((uint8_t*)start + stack_size) - 1;
+    thread_start->start_routine = start_routine;
+    thread_start->arg = arg;
+
     thread_create_params_t params;
-    params.stack_start = start;
-    params.stack_size = 4096;
-    params.entry_point = (uint32_t)func;
+    params.stack_start = (uint32_t)start;
+    params.stack_size = stack_size - sizeof(pthread_start_t);
+    params.entry_point = (uint32_t)_pthread_start;
+    params.arg = (uint32_t)thread_start;
     int res = DO_SYSCALL_1(SYS_PTHREADCREATE, &params);
-    RETURN_WITH_ERRNO(res, 0, res);
-}
\ No newline at end of file
+    if (res < 0) {
+        munmap(start, stack_size);
+        return -res;
+    }
+
+    if (thread) {
+        *thread = res;
+    }
+    return 0;
+}
+
+void pthread_exit(void* retval)
+{
+    _malloc_thread_exit();
+    DO_SYSCALL_1(SYS_EXIT_THREAD, retval);
+    __builtin_unreachable();
+}
@@ -0,0 +1,24 @@
+#include <stdlib.h>
+
+// Set up by crt0 from the env the kernel puts on the stack.
+char** environ = NULL;
+
+char* getenv(const char* name)
+{
+    if (!environ || !name) {
+        return NULL;
+    }
+
+    for (char** env = environ; *env; env++) {
+        const char* var = *env;
+        const char* it = name;
+        while (*it && *var == *it) {
+            var++;
+            it++;
+        }
+        if (!*it && *var == '=') {
+            return (char*)var + 1;
+        }
+    }
+    return NULL;
+}
\ No newline at end of file
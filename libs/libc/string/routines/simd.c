@@ -0,0 +1,192 @@
+/*
+ * Copyright (c) 2021, Krisna Pranav
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include "simd.h"
+
+/* The routines are written with vector extensions, so the same code turns
+   into SSE2 on x86 and NEON on ARMv7. x86 builds target plain i386, so
+   SSE2 is enabled per function and the routines are only called once
+   _string_init() has seen it in cpuid. ARMv7 builds already assume NEON. */
+
+#ifdef __i386__
+#define SIMD_TARGET __attribute__((target("sse2")))
+#else
+#define SIMD_TARGET
+#endif
+
+typedef uint8_t v16u8 __attribute__((vector_size(16)));
+typedef uint8_t v16u8_unaligned __attribute__((vector_size(16), aligned(1)));
+typedef char v16i8 __attribute__((vector_size(16)));
+typedef uint32_t v4u32 __attribute__((vector_size(16)));
+
+int _string_has_simd = 0;
+
+void _string_init()
+{
+#ifdef __i386__
+    uint32_t eax = 1, ebx, ecx, edx;
+    asm volatile("cpuid"
+                 : "+a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx));
+    _string_has_simd = (edx >> 26) & 1;
+#else
+    _string_has_simd = 1;
+#endif
+}
+
+/* Returns the index of the first byte set in a comparison result, or -1. */
+static inline SIMD_TARGET int _simd_first_set(v16i8 mask)
+{
+#ifdef __i386__
+    uint32_t bits = __builtin_ia32_pmovmskb128(mask);
+    return bits ? __builtin_ctz(bits) : -1;
+#else
+    v4u32 words = (v4u32)mask;
+    for (int i = 0; i < 4; i++) {
+        if (words[i]) {
+            return i * 4 + (__builtin_ctz(words[i]) >> 3);
+        }
+    }
+    return -1;
+#endif
+}
+
+static inline SIMD_TARGET v16u8 _simd_splat(uint8_t c)
+{
+    v16u8 res = { c, c, c, c, c, c, c, c, c, c, c, c, c, c, c, c };
+    return res;
+}
+
+SIMD_TARGET void* _simd_memcpy(void* dest, const void* src, size_t nbytes)
+{
+    uint8_t* d = (uint8_t*)dest;
+    const uint8_t* s = (const uint8_t*)src;
+
+    while (((uintptr_t)d & 15) && nbytes) {
+        *d++ = *s++;
+        nbytes--;
+    }
+
+#ifdef __i386__
+    if (nbytes >= SIMD_REP_MOVS_SIZE) {
+        size_t words = nbytes >> 2;
+        asm volatile("rep movsl"
+                     : "+D"(d), "+S"(s), "+c"(words)
+                     :
+                     : "memory");
+        nbytes &= 3;
+    }
+#endif
+
+    for (; nbytes >= 64; d += 64, s += 64, nbytes -= 64) {
+        v16u8 a = *(const v16u8_unaligned*)(s + 0);
+        v16u8 b = *(const v16u8_unaligned*)(s + 16);
+        v16u8 c = *(const v16u8_unaligned*)(s + 32);
+        v16u8 e = *(const v16u8_unaligned*)(s + 48);
+        *(v16u8*)(d + 0) = a;
+        *(v16u8*)(d + 16) = b;
+        *(v16u8*)(d + 32) = c;
+        *(v16u8*)(d + 48) = e;
+    }
+    for (; nbytes >= 16; d += 16, s += 16, nbytes -= 16) {
+        *(v16u8*)d = *(const v16u8_unaligned*)s;
+    }
+    while (nbytes--) {
+        *d++ = *s++;
+    }
+    return dest;
+}
+
+SIMD_TARGET void* _simd_memset(void* dest, int fill, size_t nbytes)
+{
+    uint8_t* d = (uint8_t*)dest;
+
+    while (((uintptr_t)d & 15) && nbytes) {
+        *d++ = fill;
+        nbytes--;
+    }
+
+    v16u8 value = _simd_splat(fill);
+    for (; nbytes >= 64; d += 64, nbytes -= 64) {
+        *(v16u8*)(d + 0) = value;
+        *(v16u8*)(d + 16) = value;
+        *(v16u8*)(d + 32) = value;
+        *(v16u8*)(d + 48) = value;
+    }
+    for (; nbytes >= 16; d += 16, nbytes -= 16) {
+        *(v16u8*)d = value;
+    }
+    while (nbytes--) {
+        *d++ = fill;
+    }
+    return dest;
+}
+
+SIMD_TARGET int _simd_memcmp(const void* src1, const void* src2, size_t nbytes)
+{
+    const uint8_t* first = (const uint8_t*)src1;
+    const uint8_t* second = (const uint8_t*)src2;
+
+    for (; nbytes >= 16; first += 16, second += 16, nbytes -= 16) {
+        v16u8 a = *(const v16u8_unaligned*)first;
+        v16u8 b = *(const v16u8_unaligned*)second;
+        int idx = _simd_first_set((v16i8)(a != b));
+        if (idx >= 0) {
+            return (int)first[idx] - (int)second[idx];
+        }
+    }
+    for (size_t i = 0; i < nbytes; i++) {
+        if (first[i] != second[i]) {
+            return (int)first[i] - (int)second[i];
+        }
+    }
+    return 0;
+}
+
+/* Aligned loads never cross a page, so reading a whole block which holds
+   the end of the buffer can't fault. */
+SIMD_TARGET void* _simd_memchr(const void* src, int c, size_t nbytes)
+{
+    const uint8_t* s = (const uint8_t*)src;
+    uint8_t ch = c;
+
+    while (((uintptr_t)s & 15) && nbytes) {
+        if (*s == ch) {
+            return (void*)s;
+        }
+        s++;
+        nbytes--;
+    }
+
+    v16u8 needle = _simd_splat(ch);
+    for (; nbytes; s += 16) {
+        int idx = _simd_first_set((v16i8)(*(const v16u8*)s == needle));
+        if (idx >= 0) {
+            return (size_t)idx < nbytes ? (void*)(s + idx) : NULL;
+        }
+        nbytes = nbytes > 16 ? nbytes - 16 : 0;
+    }
+    return NULL;
+}
+
+SIMD_TARGET size_t _simd_strlen(const char* str)
+{
+    const uint8_t* s = (const uint8_t*)str;
+
+    while ((uintptr_t)s & 15) {
+        if (!*s) {
+            return s - (const uint8_t*)str;
+        }
+        s++;
+    }
+
+    v16u8 zero = _simd_splat(0);
+    for (;; s += 16) {
+        int idx = _simd_first_set((v16i8)(*(const v16u8*)s == zero));
+        if (idx >= 0) {
+            return s + idx - (const uint8_t*)str;
+        }
+    }
+}
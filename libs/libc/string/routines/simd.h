@@ -0,0 +1,30 @@
+#ifndef _LIBC_STRING_ROUTINES_SIMD_H
+#define _LIBC_STRING_ROUTINES_SIMD_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+// Shorter calls stay on the word-wide versions, where the setup of the
+// vector loops doesn't pay off.
+#define SIMD_MIN_SIZE 64
+
+// strlen doesn't know the size upfront, it scans this many bytes word-wide
+// first. Most strings are shorter, so they never touch the FPU and don't
+// take the lazy FPU switch trap.
+#define SIMD_STRLEN_MIN_SIZE 256
+
+// From this size x86 memcpy switches to rep movs.
+#define SIMD_REP_MOVS_SIZE 2048
+
+extern int _string_has_simd;
+
+void _string_init();
+
+void* _simd_memcpy(void* dest, const void* src, size_t nbytes);
+void* _simd_memset(void* dest, int fill, size_t nbytes);
+int _simd_memcmp(const void* src1, const void* src2, size_t nbytes);
+void* _simd_memchr(const void* src, int c, size_t nbytes);
+size_t _simd_strlen(const char* str);
+
+#endif // _LIBC_STRING_ROUTINES_SIMD_H
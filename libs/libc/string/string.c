@@ -1,137 +1,239 @@
-/*
- * Copyright (c) 2021, Krisna Pranav
- *
- * SPDX-License-Identifier: BSD-2-Clause
- */
-#include <string.h>
-
-#ifdef __i386__
-void* memset(void* dest, int fill, size_t nbytes)
-{
-    for (int i = 0; i < nbytes; ++i)
-        ((uint8_t*)dest)[i] = fill;
-
-    return dest;
-}
-#endif //__i386__
-
-void* memmove(void* dest, const void* src, size_t nbytes)
-{
-    if (src > dest) {
-        memcpy(dest, src, nbytes);
-        return dest;
-    }
-
-    for (int i = nbytes - 1; i >= 0; --i)
-        ((uint8_t*)dest)[i] = ((uint8_t*)src)[i];
-
-    return dest;
-}
-
-/* This optimized version of memcpy uses 32 bit chunks to copy over data on
-   the 32 bit architecture this library is built for. If this function gets
-   used on a 64 bit arch, be sure to use 8 byte chunks so each chunk fits
-   in a single register. The important part is this should be compiled with
-   atleast -O1 or -Os, because -O0 just makes this function too big for what
-   it does.
-
-   GCC does a better job at optimizing this if the pointers are restricted,
-   making the copying part have less instructions. Clang on the other hand
-   does not really change anything if the pointers are restricted or not. */
-void* memcpy(void* __restrict dest, const void* __restrict src, size_t nbytes)
-{
-    size_t chunks, rest, i;
-
-    rest = nbytes % 4;
-    chunks = (nbytes - rest) >> 2;
-
-    if (!chunks)
-        goto skip_chunks;
-
-    for (i = 0; i < chunks; i++)
-        ((uint32_t*)dest)[i] = ((uint32_t*)src)[i];
-
-skip_chunks:
-
-    /* Multiplying chunks by 4 will give us the offset of the 'rest' bytes,
-       which were not copied over along with the 4 byte chunks. */
-    chunks <<= 2;
-
-    for (i = 0; i < rest; i++)
-        ((uint8_t*)dest)[chunks + i] = ((uint8_t*)src)[chunks + i];
-
-    return dest;
-}
-
-void* memccpy(void* dest, const void* src, int stop, size_t nbytes)
-{
-    for (int i = 0; i < nbytes; i++) {
-        *((uint8_t*)dest + i) = *((uint8_t*)src + i);
-
-        if (*((uint8_t*)src + i) == stop)
-            return ((uint8_t*)dest + i + 1);
-    }
-    return NULL;
-}
-
-int memcmp(const void* src1, const void* src2, size_t nbytes)
-{
-    const uint8_t* first = src1;
-    const uint8_t* second = src2;
-
-    for (int i = 0; i < nbytes; i++) {
-        /* Return the difference if the byte does not match. */
-        if (first[i] != second[i])
-            return (int)first[i] - (int)second[i];
-    }
-
-    return 0;
-}
-
-int strcmp(const char* a, const char* b)
-{
-    while (*a == *b && *a != '\0' && *b != '\0') {
-        a++;
-        b++;
-    }
-
-    if (*a < *b) {
-        return -1;
-    }
-    if (*a > *b) {
-        return 1;
-    }
-    return 0;
-}
-
-size_t strlen(const char* str)
-{
-    size_t i = 0;
-    while (str[i])
-        ++i;
-    return i;
-}
-
-char* strcpy(char* dest, const char* src)
-{
-    size_t i;
-    for (i = 0; src[i] != 0; i++)
-        dest[i] = src[i];
-
-    dest[i] = '\0';
-    return dest;
-}
-
-char* strncpy(char* dest, const char* src, size_t nbytes)
-{
-    size_t i;
-
-    for (i = 0; i < nbytes && src[i] != 0; i++)
-        dest[i] = src[i];
-
-    /* Fill the rest with null bytes */
-    for (; i < nbytes; i++)
-        dest[i] = 0;
-
-    return dest;
-}
+/*
+ * Copyright (c) 2021, Krisna Pranav
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+#include "routines/simd.h"
+#include <stdint.h>
+#include <string.h>
+
+/* Word-wide helpers. A word has a zero byte iff _word_has_zero() is not 0. */
+#define WORD_ONES (0x01010101u)
+#define WORD_HIGHS (0x80808080u)
+
+static inline uint32_t _word_has_zero(uint32_t word)
+{
+    return (word - WORD_ONES) & ~word & WORD_HIGHS;
+}
+
+#ifdef __i386__
+void* memset(void* dest, int fill, size_t nbytes)
+{
+    if (nbytes >= SIMD_MIN_SIZE && _string_has_simd) {
+        return _simd_memset(dest, fill, nbytes);
+    }
+
+    uint8_t* d = (uint8_t*)dest;
+    while (((uintptr_t)d & 3) && nbytes) {
+        *d++ = fill;
+        nbytes--;
+    }
+
+    uint32_t word = (uint8_t)fill * WORD_ONES;
+    for (; nbytes >= 4; d += 4, nbytes -= 4) {
+        *(uint32_t*)d = word;
+    }
+    while (nbytes--) {
+        *d++ = fill;
+    }
+    return dest;
+}
+#endif //__i386__
+
+/* Copies forward without the restrict promise of memcpy, so memmove can
+   use it for overlapping areas where dest is below src. */
+static void* _memcpy_forward(void* dest, const void* src, size_t nbytes)
+{
+    if (nbytes >= SIMD_MIN_SIZE && _string_has_simd) {
+        return _simd_memcpy(dest, src, nbytes);
+    }
+
+    uint8_t* d = (uint8_t*)dest;
+    const uint8_t* s = (const uint8_t*)src;
+    while (((uintptr_t)d & 3) && nbytes) {
+        *d++ = *s++;
+        nbytes--;
+    }
+
+    // The source may still be misaligned, both x86 and ARMv7 handle that for words.
+    for (; nbytes >= 4; d += 4, s += 4, nbytes -= 4) {
+        *(uint32_t*)d = *(const uint32_t*)s;
+    }
+    while (nbytes--) {
+        *d++ = *s++;
+    }
+    return dest;
+}
+
+void* memmove(void* dest, const void* src, size_t nbytes)
+{
+    if (dest <= src || (uint8_t*)src + nbytes <= (uint8_t*)dest) {
+        return _memcpy_forward(dest, src, nbytes);
+    }
+
+    uint8_t* d = (uint8_t*)dest + nbytes;
+    const uint8_t* s = (const uint8_t*)src + nbytes;
+    while (((uintptr_t)d & 3) && nbytes) {
+        *--d = *--s;
+        nbytes--;
+    }
+    for (; nbytes >= 4; nbytes -= 4) {
+        d -= 4;
+        s -= 4;
+        *(uint32_t*)d = *(const uint32_t*)s;
+    }
+    while (nbytes--) {
+        *--d = *--s;
+    }
+    return dest;
+}
+
+/* Small copies are done with words after aligning the destination, larger
+   ones go to the vector routines when the cpu has them. */
+void* memcpy(void* __restrict dest, const void* __restrict src, size_t nbytes)
+{
+    return _memcpy_forward(dest, src, nbytes);
+}
+
+void* memccpy(void* dest, const void* src, int stop, size_t nbytes)
+{
+    for (int i = 0; i < nbytes; i++) {
+        *((uint8_t*)dest + i) = *((uint8_t*)src + i);
+
+        if (*((uint8_t*)src + i) == stop)
+            return ((uint8_t*)dest + i + 1);
+    }
+    return NULL;
+}
+
+int memcmp(const void* src1, const void* src2, size_t nbytes)
+{
+    if (nbytes >= SIMD_MIN_SIZE && _string_has_simd) {
+        return _simd_memcmp(src1, src2, nbytes);
+    }
+
+    const uint8_t* first = src1;
+    const uint8_t* second = src2;
+    size_t i = 0;
+
+    // Skipping equal words, the differing byte is found below.
+    for (; i + 4 <= nbytes; i += 4) {
+        if (*(const uint32_t*)(first + i) != *(const uint32_t*)(second + i)) {
+            break;
+        }
+    }
+
+    for (; i < nbytes; i++) {
+        /* Return the difference if the byte does not match. */
+        if (first[i] != second[i])
+            return (int)first[i] - (int)second[i];
+    }
+
+    return 0;
+}
+
+void* memchr(const void* src, int c, size_t nbytes)
+{
+    if (nbytes >= SIMD_MIN_SIZE && _string_has_simd) {
+        return _simd_memchr(src, c, nbytes);
+    }
+
+    const uint8_t* s = src;
+    for (size_t i = 0; i < nbytes; i++) {
+        if (s[i] == (uint8_t)c) {
+            return (void*)(s + i);
+        }
+    }
+    return NULL;
+}
+
+int strcmp(const char* a, const char* b)
+{
+    while (*a == *b && *a != '\0' && *b != '\0') {
+        a++;
+        b++;
+    }
+
+    if (*a < *b) {
+        return -1;
+    }
+    if (*a > *b) {
+        return 1;
+    }
+    return 0;
+}
+
+size_t strlen(const char* str)
+{
+    const char* s = str;
+    while ((uintptr_t)s & 3) {
+        if (!*s)
+            return s - str;
+        ++s;
+    }
+
+    // Aligned words never cross a page, so reading past the end is safe.
+    const uint32_t* w = (const uint32_t*)s;
+    const uint32_t* simd_from = w + SIMD_STRLEN_MIN_SIZE / sizeof(uint32_t);
+    while (!_word_has_zero(*w)) {
+        ++w;
+        if (w == simd_from && _string_has_simd) {
+            return (const char*)w - str + _simd_strlen((const char*)w);
+        }
+    }
+
+    s = (const char*)w;
+    while (*s)
+        ++s;
+    return s - str;
+}
+
+char* strchr(const char* str, int c)
+{
+    const char* s = str;
+    char ch = c;
+    while ((uintptr_t)s & 3) {
+        if (*s == ch)
+            return (char*)s;
+        if (!*s)
+            return NULL;
+        ++s;
+    }
+
+    // Stepping over words which hold neither the terminator nor the char.
+    const uint32_t* w = (const uint32_t*)s;
+    uint32_t pattern = (uint8_t)ch * WORD_ONES;
+    while (!_word_has_zero(*w) && !_word_has_zero(*w ^ pattern))
+        ++w;
+
+    for (s = (const char*)w;; ++s) {
+        if (*s == ch)
+            return (char*)s;
+        if (!*s)
+            return NULL;
+    }
+}
+
+char* strcpy(char* dest, const char* src)
+{
+    size_t i;
+    for (i = 0; src[i] != 0; i++)
+        dest[i] = src[i];
+
+    dest[i] = '\0';
+    return dest;
+}
+
+char* strncpy(char* dest, const char* src, size_t nbytes)
+{
+    size_t i;
+
+    for (i = 0; i < nbytes && src[i] != 0; i++)
+        dest[i] = src[i];
+
+    /* Fill the rest with null bytes */
+    for (; i < nbytes; i++)
+        dest[i] = 0;
+
+    return dest;
+}
@@ -4,12 +4,15 @@
 .extern exit
 .extern _init
 .extern _deinit
+.extern environ
 
 .global _start
 _start:
-	push {r0-r1}
+	ldr r3, =environ
+	str r2, [r3]
+	push {r0-r3}
 	bl _init
-	pop {r0-r1}
+	pop {r0-r3}
 	bl main
 	push {r0}
 	bl _deinit
@@ -0,0 +1,9 @@
+.section .text
+
+// clang emits calls to it for __thread unless built with -mtp=cp15.
+// The kernel keeps the thread pointer in TPIDRURO. Only r0 may be
+// clobbered here.
+.global __aeabi_read_tp
+__aeabi_read_tp:
+	mrc p15, 0, r0, c13, c0, 3
+	bx lr
\ No newline at end of file
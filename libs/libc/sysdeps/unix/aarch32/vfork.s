@@ -0,0 +1,20 @@
+.section .text
+
+.extern __errno_location
+
+// The child runs on the stack of the parent until exec, so nothing
+// is spilled to the stack here.
+.global vfork
+vfork:
+	mov ip, r7
+	mov r7, #46 // SYS_VFORK
+	swi 1
+	mov r7, ip
+	cmp r0, #0
+	bxge lr
+	push {r0, lr}
+	bl __errno_location
+	pop {r1, lr}
+	str r1, [r0]
+	mov r0, #-1
+	bx lr
@@ -4,9 +4,12 @@ extern main
 extern exit
 extern _init
 extern _deinit
+extern environ
 
 global _start:function (_start.end - _start)
 _start:
+	mov eax, [esp+8]
+	mov [environ], eax
 	call _init
 	call main
 	push eax
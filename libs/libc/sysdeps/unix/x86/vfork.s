@@ -0,0 +1,24 @@
+section .text
+
+extern __errno_location
+
+; The child runs on the stack of the parent until exec, so the return
+; address is kept in a register, which is restored from the trapframe
+; for both of them.
+global vfork:function (vfork.end - vfork)
+vfork:
+	pop ecx
+	mov eax, 46 ; SYS_VFORK
+	int 0x80
+	push ecx
+	cmp eax, 0
+	jl .error
+	ret
+.error:
+	push eax
+	call __errno_location
+	pop ecx
+	mov [eax], ecx
+	mov eax, -1
+	ret
+.end:
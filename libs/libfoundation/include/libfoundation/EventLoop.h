@@ -52,10 +52,7 @@ public:
 
     EventLoop();
 
-    inline void add(int fd, std::function<void(void)> on_read, std::function<void(void)> on_write)
-    {
-        m_waiting_fds.push_back(FDWaiter(fd, on_read, on_write));
-    }
+    void add(int fd, std::function<void(void)> on_read, std::function<void(void)> on_write);
 
     inline void add(const Timer& timer)
     {
@@ -79,8 +76,13 @@ public:
     int run();
 
 private:
+    static constexpr int EventsPerWait = 16;
+
+    int wait_timeout() const;
+
     bool m_stop_flag { false };
     int m_exit_code { 0 };
+    int m_epoll_fd { -1 };
     std::vector<FDWaiter> m_waiting_fds;
     std::vector<Timer> m_timers;
     std::vector<QueuedEvent> m_event_queue;
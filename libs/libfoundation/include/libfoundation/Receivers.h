@@ -39,16 +39,16 @@ public:
     FDWaiter(int fd, std::function<void(void)> on_read, std::function<void(void)> on_write)
         : EventReceiver()
         , m_fd(fd)
-        , m_on_read(on_read)
-        , m_on_write(on_write)
+        , m_on_read(std::move(on_read))
+        , m_on_write(std::move(on_write))
     {
     }
 
     FDWaiter(FDWaiter&& fdw)
         : EventReceiver()
         , m_fd(fdw.m_fd)
-        , m_on_read(fdw.m_on_read)
-        , m_on_write(fdw.m_on_write)
+        , m_on_read(std::move(fdw.m_on_read))
+        , m_on_write(std::move(fdw.m_on_write))
     {
     }
 
@@ -63,8 +63,8 @@ public:
     FDWaiter& operator=(FDWaiter&& fdw)
     {
         m_fd = fdw.m_fd;
-        m_on_read = fdw.m_on_read;
-        m_on_write = fdw.m_on_write;
+        m_on_read = std::move(fdw.m_on_read);
+        m_on_write = std::move(fdw.m_on_write);
         return *this;
     }
 
@@ -103,7 +103,7 @@ public:
 
     explicit Timer(std::function<void(void)> callback, std::time_t time_interval, bool repeat = false)
         : EventReceiver()
-        , m_callback(callback)
+        , m_callback(std::move(callback))
         , m_time_interval(time_interval)
         , m_repeat(repeat)
     {
@@ -122,7 +122,7 @@ public:
 
     Timer(Timer&& fdw)
         : EventReceiver()
-        , m_callback(fdw.m_callback)
+        , m_callback(std::move(fdw.m_callback))
         , m_time_interval(fdw.m_time_interval)
         , m_repeat(fdw.m_repeat)
         , m_expire_time(fdw.m_expire_time)
@@ -137,7 +137,7 @@ public:
 
     Timer& operator=(Timer&& fdw)
     {
-        m_callback = fdw.m_callback;
+        m_callback = std::move(fdw.m_callback);
         return *this;
     }
 
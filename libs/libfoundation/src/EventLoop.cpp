@@ -11,7 +11,7 @@
 #include <libfoundation/Logger.h>
 #include <memory>
 #include <sched.h>
-#include <sys/select.h>
+#include <sys/epoll.h>
 #include <sys/time.h>
 #include <unistd.h>
 
@@ -22,47 +22,71 @@ EventLoop* s_LFoundation_EventLoop_the = nullptr;
 EventLoop::EventLoop()
 {
     s_LFoundation_EventLoop_the = this;
+    m_epoll_fd = epoll_create(EventsPerWait);
 }
 
-void EventLoop::check_fds()
+void EventLoop::add(int fd, std::function<void(void)> on_read, std::function<void(void)> on_write)
 {
-    if (m_waiting_fds.size() == 0) {
-        return;
+    epoll_event_t event;
+    event.events = 0;
+    event.data.u32 = m_waiting_fds.size();
+    if (on_read) {
+        event.events |= EPOLLIN;
     }
-    fd_set_t readfds;
-    fd_set_t writefds;
-    FD_ZERO(&readfds);
-    FD_ZERO(&writefds);
-    int nfds = -1;
-    for (int i = 0; i < m_waiting_fds.size(); i++) {
-        if (m_waiting_fds[i].m_on_read) {
-            FD_SET(m_waiting_fds[i].m_fd, &readfds);
-        }
-        if (m_waiting_fds[i].m_on_write) {
-            FD_SET(m_waiting_fds[i].m_fd, &writefds);
+    if (on_write) {
+        event.events |= EPOLLOUT;
+    }
+
+    m_waiting_fds.push_back(FDWaiter(fd, std::move(on_read), std::move(on_write)));
+    if (epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, fd, &event) < 0) {
+        Logger::debug << "EventLoop: can't watch fd " << fd << std::endl;
+    }
+}
+
+// Returns how long the loop could sleep in epoll_wait: not at all while
+// there are queued events, up to the nearest timer, or forever otherwise.
+int EventLoop::wait_timeout() const
+{
+    if (!m_event_queue.empty()) {
+        return 0;
+    }
+    if (m_timers.empty()) {
+        return -1;
+    }
+
+    std::timespec tp;
+    clock_gettime(CLOCK_MONOTONIC, &tp);
+
+    int timeout = -1;
+    for (auto& timer : m_timers) {
+        if (timer.expired(tp)) {
+            return 0;
         }
-        if (nfds < m_waiting_fds[i].m_fd) {
-            nfds = m_waiting_fds[i].m_fd;
+        long long diff_ns = (long long)(timer.m_expire_time.tv_sec - tp.tv_sec) * 1000000000LL + (timer.m_expire_time.tv_nsec - tp.tv_nsec);
+        int ms = (int)((diff_ns + 999999) / 1000000);
+        if (timeout < 0 || ms < timeout) {
+            timeout = ms;
         }
     }
+    return timeout;
+}
 
-    // For now, that means, that we don't wait for fds.
-    timeval_t timeout;
-    timeout.tv_sec = 0;
-    timeout.tv_usec = 0;
+void EventLoop::check_fds()
+{
+    if (m_waiting_fds.size() == 0) {
+        return;
+    }
 
-    int res = select(nfds + 1, &readfds, &writefds, nullptr, &timeout);
+    epoll_event_t events[EventsPerWait];
+    int res = epoll_wait(m_epoll_fd, events, EventsPerWait, wait_timeout());
 
-    for (int i = 0; i < m_waiting_fds.size(); i++) {
-        if (m_waiting_fds[i].m_on_read) {
-            if (FD_ISSET(m_waiting_fds[i].m_fd, &readfds)) {
-                m_event_queue.push_back(QueuedEvent(m_waiting_fds[i], new FDWaiterReadEvent()));
-            }
+    for (int i = 0; i < res; i++) {
+        FDWaiter& waiter = m_waiting_fds[events[i].data.u32];
+        if (waiter.m_on_read && (events[i].events & (EPOLLIN | EPOLLHUP))) {
+            m_event_queue.push_back(QueuedEvent(waiter, new FDWaiterReadEvent()));
         }
-        if (m_waiting_fds[i].m_on_write) {
-            if (FD_ISSET(m_waiting_fds[i].m_fd, &writefds)) {
-                m_event_queue.push_back(QueuedEvent(m_waiting_fds[i], new FDWaiterWriteEvent()));
-            }
+        if (waiter.m_on_write && (events[i].events & EPOLLOUT)) {
+            m_event_queue.push_back(QueuedEvent(waiter, new FDWaiterWriteEvent()));
         }
     }
 }
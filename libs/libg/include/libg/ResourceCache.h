@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2021, Krisna Pranav
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <libg/PixelBitmap.h>
+#include <sys/types.h>
+
+namespace LG {
+
+#define RESOURCE_CACHE_PATH "/res/cache/resources.cache"
+
+/**
+ * The cache is built from /res by build/tools/make_resource_cache.py at
+ * image build time. Entries are sorted by the FNV-1a hash of their path,
+ * then by the path. Bitmaps are stored as LG::Color arrays, fonts as
+ * the bytes of the font file.
+ */
+struct [[gnu::packed]] ResourceCacheHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t entries_count;
+    uint32_t strings_offset;
+};
+
+struct [[gnu::packed]] ResourceCacheEntry {
+    enum Type : uint8_t {
+        Bitmap = 0,
+        Font = 1,
+    };
+
+    uint32_t hash;
+    uint32_t path_offset;
+    uint32_t data_offset;
+    uint32_t data_size;
+    uint16_t width;
+    uint16_t height;
+    uint8_t type;
+    uint8_t format;
+    uint16_t reserved;
+};
+
+class ResourceCache {
+public:
+    static constexpr uint32_t Version = 1;
+
+    static ResourceCache& the();
+
+    // Bitmaps point into the read-only mapping of the cache and must not be drawn into.
+    bool find_bitmap(const char* path, PixelBitmap& bitmap) const;
+    const uint8_t* find_font(const char* path) const;
+
+private:
+    ResourceCache();
+    ~ResourceCache() = default;
+
+    const ResourceCacheEntry* find(const char* path, uint8_t type) const;
+    inline const ResourceCacheEntry* entries() const { return (const ResourceCacheEntry*)(m_data + sizeof(ResourceCacheHeader)); }
+    inline const ResourceCacheHeader& header() const { return *(const ResourceCacheHeader*)m_data; }
+
+    const uint8_t* m_data { nullptr };
+    size_t m_size { 0 };
+};
+
+} // namespace LG
\ No newline at end of file
@@ -29,11 +29,9 @@ public:
 
     void decode(const char* buf, size_t& offset) override
     {
-        while (buf[offset] != '\0') {
-            push_back(buf[offset]);
-            offset++;
-        }
-        offset++;
+        size_t len = strlen(&buf[offset]);
+        append(&buf[offset], len);
+        offset += len + 1;
     }
 };
 } // namespace LG
\ No newline at end of file
@@ -7,6 +7,7 @@
 #include <fcntl.h>
 #include <libfoundation/Logger.h>
 #include <libg/Font.h>
+#include <libg/ResourceCache.h>
 #include <new>
 #include <string.h>
 #include <sys/mman.h>
@@ -65,6 +66,12 @@ Font::Font(uint32_t* raw_data, uint8_t* width_data, uint8_t width, uint8_t heigh
 
 Font* Font::load_from_file(const char* path)
 {
+    // Fonts from /res share the mapping of the resource cache.
+    const uint8_t* cached = ResourceCache::the().find_font(path);
+    if (cached) {
+        return Font::load_from_mem((uint8_t*)cached);
+    }
+
     int fd = open(path, O_RDONLY);
     if (fd < 0) {
         return nullptr;
@@ -9,6 +9,7 @@
 #include <libfoundation/Logger.h>
 #include <libfoundation/compress/puff.h>
 #include <libg/ImageLoaders/PNGLoader.h>
+#include <libg/ResourceCache.h>
 #include <memory>
 #include <sys/mman.h>
 #include <sys/stat.h>
@@ -24,6 +25,12 @@ namespace PNG {
 
     PixelBitmap PNGLoader::load_from_file(const std::string& path)
     {
+        // Images from /res are decoded at image build time.
+        PixelBitmap cached;
+        if (ResourceCache::the().find_bitmap(path.c_str(), cached)) {
+            return cached;
+        }
+
         int fd = open(path.c_str(), O_RDONLY);
         if (fd < 0) {
             Logger::debug << "PNGLoader: cant open" << std::endl;
@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2021, Krisna Pranav
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <cstring>
+#include <fcntl.h>
+#include <libfoundation/Logger.h>
+#include <libg/ResourceCache.h>
+#include <new>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace LG {
+
+static uint32_t resource_cache_hash(const char* path)
+{
+    uint32_t hash = 0x811c9dc5;
+    for (; *path; path++) {
+        hash ^= (uint8_t)*path;
+        hash *= 0x01000193;
+    }
+    return hash;
+}
+
+ResourceCache& ResourceCache::the()
+{
+    static ResourceCache* s_resource_cache_ptr;
+    if (!s_resource_cache_ptr) {
+        s_resource_cache_ptr = new ResourceCache();
+    }
+    return *s_resource_cache_ptr;
+}
+
+// A missing or broken cache leaves it empty, every lookup then falls
+// back to the loaders.
+ResourceCache::ResourceCache()
+{
+    int fd = open(RESOURCE_CACHE_PATH, O_RDONLY);
+    if (fd < 0) {
+        return;
+    }
+
+    fstat_t stat;
+    if (fstat(fd, &stat) < 0 || stat.size < sizeof(ResourceCacheHeader)) {
+        close(fd);
+        return;
+    }
+
+    uint8_t* ptr = (uint8_t*)mmap(NULL, stat.size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (!ptr || (uint32_t)ptr >= (uint32_t)(-4096)) {
+        return;
+    }
+
+    auto& cache_header = *(const ResourceCacheHeader*)ptr;
+    size_t entries_end = sizeof(ResourceCacheHeader) + (size_t)cache_header.entries_count * sizeof(ResourceCacheEntry);
+    if (memcmp((uint8_t*)cache_header.magic, (const uint8_t*)"RCCH", 4) || cache_header.version != Version || entries_end > stat.size) {
+        Logger::debug << "ResourceCache: unsupported cache" << std::endl;
+        munmap(ptr, stat.size);
+        return;
+    }
+
+    m_data = ptr;
+    m_size = stat.size;
+}
+
+const ResourceCacheEntry* ResourceCache::find(const char* path, uint8_t type) const
+{
+    if (!m_data) {
+        return nullptr;
+    }
+
+    uint32_t hash = resource_cache_hash(path);
+    const ResourceCacheEntry* ents = entries();
+    size_t left = 0;
+    size_t right = header().entries_count;
+    while (left < right) {
+        size_t mid = (left + right) / 2;
+        if (ents[mid].hash < hash) {
+            left = mid + 1;
+        } else {
+            right = mid;
+        }
+    }
+
+    for (; left < header().entries_count && ents[left].hash == hash; left++) {
+        const ResourceCacheEntry& entry = ents[left];
+        if (entry.path_offset >= m_size || entry.data_offset > m_size || entry.data_size > m_size - entry.data_offset) {
+            return nullptr;
+        }
+        if (entry.type == type && strcmp((const char*)m_data + entry.path_offset, path) == 0) {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+bool ResourceCache::find_bitmap(const char* path, PixelBitmap& bitmap) const
+{
+    const ResourceCacheEntry* entry = find(path, ResourceCacheEntry::Bitmap);
+    if (!entry || entry->data_size != (size_t)entry->width * entry->height * sizeof(Color)) {
+        return false;
+    }
+
+    auto format = entry->format == RGBA ? RGBA : RGB;
+    bitmap = PixelBitmap((Color*)(m_data + entry->data_offset), entry->width, entry->height, format);
+    return true;
+}
+
+const uint8_t* ResourceCache::find_font(const char* path) const
+{
+    const ResourceCacheEntry* entry = find(path, ResourceCacheEntry::Font);
+    if (!entry) {
+        return nullptr;
+    }
+    return m_data + entry->data_offset;
+}
+
+} // namespace LG
\ No newline at end of file
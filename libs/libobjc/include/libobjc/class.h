@@ -8,15 +8,54 @@
 #define _LIBOBJC_CLASS_H
 
 #include <libobjc/module.h>
+#include <stddef.h>
 
 #define DISPATCH_TABLE_NOT_INITIALIZED (void*)0x0
 
+/**
+ * Per-class selector to IMP cache, kept in disp_table of the class. It is
+ * an open addressing table probed linearly from (sel >> 3) & mask. An
+ * empty bucket has a NULL sel. objc_msgSend walks it in assembly, so the
+ * layout is fixed: mask at 0, buckets at 8, 8 bytes per bucket.
+ */
+struct objc_cache_bucket {
+    SEL sel;
+    IMP imp;
+};
+
+struct objc_cache {
+    uint32_t mask;
+    uint32_t occupied;
+    struct objc_cache_bucket buckets[1]; // Variable len
+};
+
+#define OBJC_CACHE_INITIAL_SIZE 8
+
+static inline IMP class_cache_lookup(Class cls, SEL sel)
+{
+    struct objc_cache* cache = (struct objc_cache*)cls->disp_table;
+    if (!cache) {
+        return nil_method;
+    }
+
+    for (uint32_t index = (uintptr_t)sel >> 3;; index++) {
+        index &= cache->mask;
+        if (cache->buckets[index].sel == sel) {
+            return cache->buckets[index].imp;
+        }
+        if (!cache->buckets[index].sel) {
+            return nil_method;
+        }
+    }
+}
+
 bool class_resolve_links(Class cls);
 void class_resolve_all_unresolved();
 
 void class_table_init();
 void class_add_from_module(struct objc_symtab* symtab);
 IMP class_get_implementation(Class cls, SEL sel);
+void class_flush_caches();
 
 Class objc_getClass(const char* name);
 
@@ -10,10 +10,24 @@
 #include <libobjc/objc.h>
 #include <libobjc/runtime.h>
 
+static id nil_receiver_method(id receiver, SEL sel, ...)
+{
+    return nil;
+}
+
+// Compiled message sends call it and then the returned IMP.
 OBJC_EXPORT IMP objc_msg_lookup(id receiver, SEL sel)
 {
-    IMP impl = class_get_implementation(receiver->get_isa(), sel);
-    return impl;
+    if (!receiver) {
+        return (IMP)nil_receiver_method;
+    }
+
+    Class cls = receiver->get_isa();
+    IMP impl = class_cache_lookup(cls, sel);
+    if (impl) [[likely]] {
+        return impl;
+    }
+    return class_get_implementation(cls, sel);
 }
 
 static inline id call_alloc(Class cls, bool checkNil, bool allocWithZone = false)
@@ -11,8 +11,16 @@
 #include <libobjc/objc.h>
 #include <libobjc/runtime.h>
 #include <libobjc/selector.h>
+#include <sched.h>
+#include <stdbool.h>
+#include <stddef.h>
 #include <string.h>
 
+// objc_msgSend reads the cache with hardcoded offsets.
+static_assert(offsetof(struct objc_class, disp_table) == 32);
+static_assert(offsetof(struct objc_cache, buckets) == 8);
+static_assert(sizeof(struct objc_cache_bucket) == 8);
+
 struct class_node {
     const char* name;
     int length;
@@ -71,6 +79,100 @@ static inline void class_disp_table_preinit(Class cls)
     cls->disp_table = DISPATCH_TABLE_NOT_INITIALIZED;
 }
 
+// Serializes cache writers, objc_msgSend reads the caches without it.
+static bool class_cache_lock_flag = false;
+
+static inline void class_cache_lock()
+{
+    while (__atomic_test_and_set(&class_cache_lock_flag, __ATOMIC_ACQUIRE)) {
+        sched_yield();
+    }
+}
+
+static inline void class_cache_unlock()
+{
+    __atomic_clear(&class_cache_lock_flag, __ATOMIC_RELEASE);
+}
+
+static struct objc_cache* class_cache_alloc(uint32_t size)
+{
+    size_t bytes = sizeof(struct objc_cache) + (size - 1) * sizeof(struct objc_cache_bucket);
+    struct objc_cache* cache = (struct objc_cache*)objc_calloc(1, bytes);
+    cache->mask = size - 1;
+    return cache;
+}
+
+static void class_cache_put(struct objc_cache* cache, SEL sel, IMP imp)
+{
+    uint32_t index = (uintptr_t)sel >> 3;
+    for (;; index++) {
+        index &= cache->mask;
+        if (!cache->buckets[index].sel) {
+            // A reader which sees the sel must see its imp too.
+            cache->buckets[index].imp = imp;
+            __atomic_store_n(&cache->buckets[index].sel, sel, __ATOMIC_RELEASE);
+            cache->occupied++;
+            return;
+        }
+    }
+}
+
+/**
+ * Keeps the cache at most 3/4 full, so a probe always ends on an empty bucket.
+ * objc_msgSend probes the cache without a lock, and there is no point at
+ * which every thread is known to be out of it, so a replaced cache is
+ * never freed. Tables double, so what a class leaks stays below the size
+ * of its live cache.
+ */
+static void class_cache_insert(Class cls, SEL sel, IMP imp)
+{
+    class_cache_lock();
+    struct objc_cache* cache = (struct objc_cache*)cls->disp_table;
+    if (cache && class_cache_lookup(cls, sel) != nil_method) {
+        // Another thread which missed on the same selector got here first.
+        class_cache_unlock();
+        return;
+    }
+
+    if (!cache) {
+        cache = class_cache_alloc(OBJC_CACHE_INITIAL_SIZE);
+        __atomic_store_n(&cls->disp_table, cache, __ATOMIC_RELEASE);
+    }
+
+    uint32_t size = cache->mask + 1;
+    if ((cache->occupied + 1) * 4 > size * 3) {
+        struct objc_cache* new_cache = class_cache_alloc(size * 2);
+        for (uint32_t i = 0; i < size; i++) {
+            if (cache->buckets[i].sel) {
+                class_cache_put(new_cache, cache->buckets[i].sel, cache->buckets[i].imp);
+            }
+        }
+        __atomic_store_n(&cls->disp_table, new_cache, __ATOMIC_RELEASE);
+        cache = new_cache;
+    }
+
+    class_cache_put(cache, sel, imp);
+    class_cache_unlock();
+}
+
+// Like a replaced cache, a flushed one is left to readers which may still probe it.
+static void class_cache_flush(Class cls)
+{
+    class_cache_lock();
+    __atomic_store_n(&cls->disp_table, DISPATCH_TABLE_NOT_INITIALIZED, __ATOMIC_RELEASE);
+    class_cache_unlock();
+}
+
+// Subclasses cache methods they inherit, so any method list change drops every cache.
+void class_flush_caches()
+{
+    for (int i = 0; i < class_table_next_free; i++) {
+        Class cls = class_tabel_storage[i].cls;
+        class_cache_flush(cls);
+        class_cache_flush(cls->get_isa());
+    }
+}
+
 static Method class_lookup_method_in_list(struct objc_method_list* objc_method_list, SEL sel)
 {
     if (!objc_method_list) {
@@ -140,11 +242,10 @@ static void class_root_add_instance_methods(Class cls)
     if (new_list->method_count) {
         new_list->method_next = cls->get_isa()->methods;
         cls->get_isa()->methods = new_list;
+        class_flush_caches();
     } else {
         objc_free(new_list);
     }
-
-    // TODO: Update dispatch table.
 }
 
 static void class_send_initialize(Class cls)
@@ -213,6 +314,8 @@ bool class_resolve_links(Class cls)
         cls->get_isa()->superclass = supcls->get_isa();
         cls->set_info(CLS_RESOLVED);
         cls->get_isa()->set_info(CLS_RESOLVED);
+        class_cache_flush(cls);
+        class_cache_flush(cls->get_isa());
         return true;
     }
 
@@ -281,6 +384,11 @@ OBJC_EXPORT Class objc_lookup_class(const char* name)
     return objc_getClass(name);
 }
 
+/**
+ * Slow path of objc_msgSend, taken when the selector is not in the cache
+ * of @cls yet. The cache is keyed by the SEL pointer the caller passed,
+ * so registering the selector is paid for only on the first send.
+ */
 IMP class_get_implementation(Class cls, SEL sel)
 {
     // TODO: Can't init it here, since meta classes are passed here.
@@ -288,8 +396,8 @@ IMP class_get_implementation(Class cls, SEL sel)
     //     class_send_initialize(cls);
     // }
 
-    sel = sel_registerTypedName((char*)sel->id, sel->types);
-    Method method = class_lookup_method_in_hierarchy(cls, sel);
+    SEL registered_sel = sel->types ? sel_registerTypedName((char*)sel->id, sel->types) : sel_registerName((char*)sel->id);
+    Method method = class_lookup_method_in_hierarchy(cls, registered_sel);
 
     if (!method) {
         return nil_method;
@@ -297,5 +405,6 @@ IMP class_get_implementation(Class cls, SEL sel)
 
     // TODO: Message forwarding
 
+    class_cache_insert(cls, sel, method->method_imp);
     return method->method_imp;
 }
\ No newline at end of file
@@ -23,7 +23,7 @@ public:
 
     CallEvent(target_func_type callback, UI::View* view)
         : Event(Event::Type::UIHandlerInvoke)
-        , m_callback(callback)
+        , m_callback(std::move(callback))
         , m_view(view)
     {
     }
@@ -70,7 +70,7 @@ public:
     template <class ActionType>
     void add_target(ActionType target_func, UI::Event::Type for_event)
     {
-        m_targets.push_back(Target { target_func, for_event });
+        m_targets.push_back(Target { std::move(target_func), for_event });
     }
 
     void send_actions(UI::Event::Type for_event)
@@ -20,8 +20,8 @@ class MenuItem {
 
 public:
     MenuItem(LG::string&& title, std::function<void()> action)
-        : m_title(title)
-        , m_action(action)
+        : m_title(std::move(title))
+        , m_action(std::move(action))
     {
     }
 
@@ -56,7 +56,7 @@ public:
     void set_spacing(size_t spacing) { m_spacing = spacing; }
     size_t spacing() const { return m_spacing; }
 
-    virtual bool receive_layout_event(const LayoutEvent&, bool force_layout_if_not_target = false) override;
+    virtual void did_layout_subviews() override;
 
 protected:
     StackView(View* superview, const LG::Rect&);
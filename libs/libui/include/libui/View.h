@@ -78,6 +78,7 @@ public:
     const std::vector<UI::Constraint>& constraints() const { return m_constrints; }
 
     virtual void layout_subviews();
+    virtual void did_layout_subviews() { }
     inline void set_needs_layout()
     {
         send_layout_message(*window(), this);
@@ -143,6 +144,8 @@ protected:
     inline void constraint_interpreter(const Constraint& constraint);
 
 private:
+    uint32_t layout_signature();
+
     void set_window(Window* window) { m_window = window; }
     void set_superview(View* superview) { m_superview = superview; }
 
@@ -155,6 +158,7 @@ private:
     bool m_constraint_based_layout { false };
     std::vector<Constraint> m_constrints {};
     uint32_t m_applied_constraints_mask { 0 }; // Constraints applied to this view;
+    uint32_t m_layout_signature { 0 }; // Signature after the last layout, see layout_signature().
 
     bool m_active { false };
     bool m_hovered { false };
@@ -18,6 +18,7 @@
 #include <libui/View.h>
 #include <libui/ViewController.h>
 #include <sys/types.h>
+#include <vector>
 
 namespace UI {
 
@@ -26,6 +27,11 @@ using ::WindowType;
 
 class Connection;
 
+struct FrameStats {
+    uint32_t views_displayed { 0 };
+    uint32_t views_laid_out { 0 };
+};
+
 class Window : public LFoundation::EventReceiver {
     UI_OBJECT();
     friend Connection;
@@ -71,12 +77,24 @@ public:
 
     inline const LG::string& icon_path() const { return m_icon_path; }
 
+    void set_needs_display(const LG::Rect& rect);
+
+    // Counters of the frame being built, and of the last flushed one.
+    inline FrameStats& frame_stats() { return m_frame_stats; }
+    inline const FrameStats& last_frame_stats() const { return m_last_frame_stats; }
+
     void receive_event(std::unique_ptr<LFoundation::Event> event) override;
 
 private:
     void resize(ResizeEvent&);
     void setup_superview();
     void fill_with_opaque(const LG::Rect&);
+    void add_damage(const LG::Rect&);
+    void flush_damage();
+
+    // Damage closer than DamageMergeDistance pixels is merged into one rect.
+    static constexpr int DamageMergeDistance = 16;
+    static constexpr size_t MaxDamageRects = 8;
 
     uint32_t m_id;
     BaseViewController* m_root_view_controller { nullptr };
@@ -89,6 +107,11 @@ private:
     LFoundation::SharedBuffer<LG::Color> m_buffer;
     LG::string m_icon_path { "/res/icons/apps/missing.icon" };
 
+    bool m_display_pending { false };
+    std::vector<LG::Rect> m_damage {};
+    FrameStats m_frame_stats {};
+    FrameStats m_last_frame_stats {};
+
     MenuBar m_menubar;
 };
 
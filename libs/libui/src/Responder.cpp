@@ -21,16 +21,11 @@ bool Responder::send_invalidate_message_to_server(const LG::Rect& rect) const
 void Responder::send_layout_message(Window& win, UI::View* for_view)
 {
     LFoundation::EventLoop::the().add(win, new LayoutEvent(for_view));
-    m_display_message_sent = false;
 }
 
 void Responder::send_display_message_to_self(Window& win, const LG::Rect& display_rect)
 {
-    if (!m_display_message_sent || m_prev_display_message != display_rect) {
-        LFoundation::EventLoop::the().add(win, new DisplayEvent(display_rect));
-        m_display_message_sent = true;
-        m_prev_display_message = display_rect;
-    }
+    win.set_needs_display(display_rect);
 }
 
 void Responder::receive_event(std::unique_ptr<LFoundation::Event> event)
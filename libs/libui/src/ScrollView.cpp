@@ -96,6 +96,7 @@ void ScrollView::receive_mouse_move_event(MouseEvent& event)
 void ScrollView::receive_display_event(DisplayEvent& event)
 {
     event.bounds().intersect(bounds());
+    window()->frame_stats().views_displayed++;
     display(event.bounds());
     foreach_subview([&](View& subview) -> bool {
         auto bounds = event.bounds();
@@ -113,11 +114,6 @@ void ScrollView::receive_display_event(DisplayEvent& event)
     });
     did_display(event.bounds());
 
-    if (!has_superview()) {
-        // Only superview sends invalidate_message to server.
-        bool success = send_invalidate_message_to_server(event.bounds());
-    }
-
     Responder::receive_display_event(event);
 }
 
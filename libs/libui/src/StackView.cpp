@@ -21,15 +21,11 @@ StackView::StackView(View* superview, Window* window, const LG::Rect& frame)
 {
 }
 
-bool StackView::receive_layout_event(const LayoutEvent& event, bool force_layout_if_not_target)
+void StackView::did_layout_subviews()
 {
-    // StackView uses receive_layout_event to recalculate positions of
-    // subviews.
-    bool res = View::receive_layout_event(event, force_layout_if_not_target);
-    if (this == event.target() || force_layout_if_not_target) {
-        recalc_subviews_positions();
-    }
-    return res;
+    // Positions depend on the sizes of subviews, so they are
+    // recalculated once the subviews are laid out.
+    recalc_subviews_positions();
 }
 
 size_t StackView::recalc_subview_min_x(View* view)
@@ -8,6 +8,7 @@
 #include <libg/Color.h>
 #include <libui/Context.h>
 #include <libui/View.h>
+#include <libui/Window.h>
 
 namespace UI {
 
@@ -69,6 +70,36 @@ void View::layout_subviews()
     }
 }
 
+static inline void layout_signature_add(uint32_t& sig, const LG::Rect& rect)
+{
+    const uint32_t values[] = { (uint32_t)rect.min_x(), (uint32_t)rect.min_y(), (uint32_t)rect.width(), (uint32_t)rect.height() };
+    for (uint32_t value : values) {
+        sig = (sig ^ value) * 0x01000193;
+    }
+}
+
+// Covers everything the layout of this view reads or writes, so an
+// unchanged signature means the last result still holds.
+uint32_t View::layout_signature()
+{
+    uint32_t sig = 0x811c9dc5;
+    layout_signature_add(sig, bounds());
+    for (auto* subview : subviews()) {
+        layout_signature_add(sig, subview->frame());
+    }
+
+    for (const auto& constraint : m_constrints) {
+        layout_signature_add(sig, constraint.item()->frame());
+        if (constraint.rel_item()) {
+            layout_signature_add(sig, constraint.rel_item()->frame());
+            layout_signature_add(sig, constraint.rel_item()->bounds());
+        } else if (constraint.item()->has_superview()) {
+            layout_signature_add(sig, constraint.item()->superview()->bounds());
+        }
+    }
+    return (sig ^ subviews().size()) * 0x01000193 ^ m_constrints.size();
+}
+
 std::optional<LG::Point<int>> View::subview_location(const View& subview) const
 {
     return subview.frame().origin();
@@ -219,6 +250,7 @@ void View::receive_keydown_event(KeyDownEvent&)
 void View::receive_display_event(DisplayEvent& event)
 {
     event.bounds().intersect(bounds());
+    window()->frame_stats().views_displayed++;
     display(event.bounds());
     foreach_subview([&](View& subview) -> bool {
         auto bounds = event.bounds();
@@ -233,27 +265,40 @@ void View::receive_display_event(DisplayEvent& event)
     });
     did_display(event.bounds());
 
-    if (!has_superview()) {
-        // Only superview sends invalidate_message to server.
-        bool success = send_invalidate_message_to_server(event.bounds());
-    }
-
     Responder::receive_display_event(event);
 }
 
+/**
+ * Views under the target are laid out again only if their signature
+ * changed since their last layout, the target itself always is.
+ * did_layout_subviews() runs once the subviews are done, it is also
+ * called when the subviews changed on their own during the pass.
+ */
 bool View::receive_layout_event(const LayoutEvent& event, bool force_layout_if_not_target)
 {
-    bool need_to_layout = (this == event.target()) | force_layout_if_not_target;
+    bool is_target = (this == event.target());
+    bool in_target_subtree = is_target | force_layout_if_not_target;
+    bool need_to_layout = is_target || (in_target_subtree && m_layout_signature != layout_signature());
     if (need_to_layout) {
         layout_subviews();
+        window()->frame_stats().views_laid_out++;
     }
 
     foreach_subview([&](View& subview) -> bool {
-        bool found_target = subview.receive_layout_event(event, need_to_layout);
-        return need_to_layout || !found_target;
+        bool found_target = subview.receive_layout_event(event, in_target_subtree);
+        return in_target_subtree || !found_target;
     });
 
-    return need_to_layout;
+    if (in_target_subtree) {
+        uint32_t signature = layout_signature();
+        if (need_to_layout || m_layout_signature != signature) {
+            did_layout_subviews();
+            signature = layout_signature();
+        }
+        m_layout_signature = signature;
+    }
+
+    return in_target_subtree;
 }
 
 } // namespace UI
\ No newline at end of file
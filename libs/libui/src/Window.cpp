@@ -10,6 +10,8 @@
 #include <libui/Context.h>
 #include <libui/Window.h>
 
+// #define UI_FRAME_STATS_DEBUG
+
 namespace UI {
 
 Window::Window(const LG::Size& size, WindowType type)
@@ -120,18 +122,7 @@ void Window::receive_event(std::unique_ptr<LFoundation::Event> event)
     }
 
     if (event->type() == Event::Type::DisplayEvent) {
-        if (m_superview) {
-            DisplayEvent& own_event = *(DisplayEvent*)event.get();
-
-            // If the window is in RGBA mode, we have to fill this rect
-            // with opaque color before superview will mix it's color on
-            // top of bitmap.
-            if (bitmap().format() == LG::PixelBitmapFormat::RGBA) {
-                fill_with_opaque(own_event.bounds());
-            }
-
-            m_superview->receive_display_event(own_event);
-        }
+        flush_damage();
     }
 
     if (event->type() == Event::Type::LayoutEvent) {
@@ -154,6 +145,115 @@ void Window::receive_event(std::unique_ptr<LFoundation::Event> event)
     }
 }
 
+/**
+ * Damage is collected into a few rects until the event loop gets to the
+ * display event posted for the first damage of a frame. Every rect is
+ * then redrawn, and the server gets one InvalidateMessage with their union.
+ */
+void Window::set_needs_display(const LG::Rect& rect)
+{
+    if (rect.empty()) {
+        return;
+    }
+
+    add_damage(rect);
+    if (m_display_pending) {
+        return;
+    }
+
+    m_display_pending = true;
+    LFoundation::EventLoop::the().add(*this, new DisplayEvent(rect));
+}
+
+/**
+ * Rects which overlap or lie close together are united, so a run of
+ * small updates becomes one redraw. Far apart rects stay separate,
+ * uniting them would redraw everything between them. Past
+ * MaxDamageRects the pair whose union grows the least is united.
+ */
+void Window::add_damage(const LG::Rect& rect)
+{
+    auto area = rect;
+    for (auto& damage : m_damage) {
+        if (damage.contains(area)) {
+            return;
+        }
+    }
+
+    bool merged = true;
+    while (merged) {
+        merged = false;
+        LG::Rect near(area.min_x() - DamageMergeDistance, area.min_y() - DamageMergeDistance,
+            area.width() + 2 * DamageMergeDistance, area.height() + 2 * DamageMergeDistance);
+        for (size_t i = 0; i < m_damage.size(); i++) {
+            if (near.intersects(m_damage[i])) {
+                area.unite(m_damage[i]);
+                m_damage[i] = m_damage.back();
+                m_damage.pop_back();
+                merged = true;
+                break;
+            }
+        }
+    }
+
+    if (m_damage.size() < MaxDamageRects) {
+        m_damage.push_back(area);
+        return;
+    }
+
+    size_t best = 0;
+    size_t best_growth = (size_t)-1;
+    for (size_t i = 0; i < m_damage.size(); i++) {
+        size_t growth = m_damage[i].union_of(area).square() - m_damage[i].square();
+        if (growth < best_growth) {
+            best = i;
+            best_growth = growth;
+        }
+    }
+    m_damage[best].unite(area);
+}
+
+void Window::flush_damage()
+{
+    if (!m_display_pending) {
+        return;
+    }
+    m_display_pending = false;
+
+    if (m_superview) {
+        LG::Rect invalidated {};
+        for (auto& damage : m_damage) {
+            DisplayEvent own_event(damage);
+
+            // If the window is in RGBA mode, we have to fill this rect
+            // with opaque color before superview will mix it's color on
+            // top of bitmap.
+            if (bitmap().format() == LG::PixelBitmapFormat::RGBA) {
+                fill_with_opaque(own_event.bounds());
+            }
+
+            m_superview->receive_display_event(own_event);
+            if (invalidated.empty()) {
+                invalidated = own_event.bounds();
+            } else if (!own_event.bounds().empty()) {
+                invalidated.unite(own_event.bounds());
+            }
+        }
+
+        // Views are drawn rect by rect, but the server is told once per frame.
+        if (!invalidated.empty()) {
+            m_superview->send_invalidate_message_to_server(invalidated);
+        }
+    }
+    m_damage.clear_remain_capacity();
+
+#ifdef UI_FRAME_STATS_DEBUG
+    Logger::debug << "Frame: displayed " << m_frame_stats.views_displayed << " laid out " << m_frame_stats.views_laid_out << std::endl;
+#endif
+    m_last_frame_stats = m_frame_stats;
+    m_frame_stats = FrameStats();
+}
+
 void Window::resize(ResizeEvent& resize_event)
 {
     m_bounds = resize_event.bounds();
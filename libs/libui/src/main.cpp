@@ -2,6 +2,7 @@
 #include <libfoundation/ProcessInfo.h>
 #include <libui/App.h>
 #include <libui/AppDelegate.h>
+#include <libui/Event.h>
 #include <libui/View.h>
 #include <libui/Window.h>
 #include <memory>
@@ -22,6 +23,15 @@ extern "C" int main(int argc, char** argv)
 
     app.set_delegate(app_delegate);
     app.set_state(UI::AppState::Active);
+
+    // The startup bench spawns apps with this flag, an app counts as
+    // started once its window is up and the first events are handled.
+    auto& args = process_info.arguments();
+    if (args.size() && args[0] == "--startup-bench") {
+        app.event_loop().pump();
+        app.receive_event(std::make_unique<UI::WindowCloseRequestEvent>(app.window().id()));
+    }
+
     int status = app.run();
     app_delegate->application_will_terminate();
     return status;
@@ -31,6 +31,7 @@ Compositor::Compositor()
 #endif // TARGET_MOBILE
 {
     s_WinServer_Compositor_the = this;
+    m_buffer_damage.resize(Screen::the().buffers_count());
     invalidate(Screen::the().bounds());
     LFoundation::EventLoop::the().add(LFoundation::Timer([] {
         Compositor::the().refresh();
@@ -38,20 +39,28 @@ Compositor::Compositor()
         1000 / 60, LFoundation::Timer::Repeat));
 }
 
-void Compositor::copy_changes_to_second_buffer(const std::vector<LG::Rect>& areas)
+/**
+ * Instead of copying changes from the displayed buffer (which is slow to
+ * read back from write-combined video memory), every buffer keeps the
+ * areas it has missed and they are redrawn when it becomes the back one.
+ */
+std::vector<LG::Rect> Compositor::collect_damage_for_write_buffer()
 {
     auto& screen = Screen::the();
-
-    for (int i = 0; i < areas.size(); i++) {
-        auto bounds = areas[i].intersection(screen.bounds());
-        auto* buf1_ptr = reinterpret_cast<uint32_t*>(&screen.display_bitmap()[bounds.min_y()][bounds.min_x()]);
-        auto* buf2_ptr = reinterpret_cast<uint32_t*>(&screen.write_bitmap()[bounds.min_y()][bounds.min_x()]);
-        for (int j = 0; j < bounds.height(); j++) {
-            LFoundation::fast_copy(buf2_ptr, buf1_ptr, bounds.width());
-            buf1_ptr += screen.width();
-            buf2_ptr += screen.width();
+    size_t write_buffer = screen.write_buffer_index();
+    auto areas = std::move(m_buffer_damage[write_buffer]);
+    m_buffer_damage[write_buffer].clear();
+
+    for (auto& area : m_invalidated_areas) {
+        optimized_invalidate_insert(areas, area);
+        for (size_t i = 0; i < m_buffer_damage.size(); i++) {
+            if (i != write_buffer) {
+                optimized_invalidate_insert(m_buffer_damage[i], area);
+            }
         }
     }
+    m_invalidated_areas.clear();
+    return areas;
 }
 
 [[gnu::flatten]] void Compositor::refresh()
@@ -62,7 +71,7 @@ void Compositor::copy_changes_to_second_buffer(const std::vector<LG::Rect>& area
 
     auto& screen = Screen::the();
     auto& wm = WindowManager::the();
-    auto invalidated_areas = std::move(m_invalidated_areas);
+    auto invalidated_areas = collect_damage_for_write_buffer();
     LG::Context ctx(screen.write_bitmap());
 
     auto is_window_area_invalidated = [&](const std::vector<LG::Rect>& areas, const LG::Rect& area) -> bool {
@@ -163,7 +172,6 @@ void Compositor::copy_changes_to_second_buffer(const std::vector<LG::Rect>& area
     }
 
     screen.swap_buffers();
-    copy_changes_to_second_buffer(invalidated_areas);
 }
 
 } // namespace WinServer
\ No newline at end of file
@@ -85,9 +85,10 @@ public:
 #endif // TARGET_MOBILE
 
 private:
-    void copy_changes_to_second_buffer(const std::vector<LG::Rect>& areas);
+    std::vector<LG::Rect> collect_damage_for_write_buffer();
 
     std::vector<LG::Rect> m_invalidated_areas;
+    std::vector<std::vector<LG::Rect>> m_buffer_damage;
     MenuBar& m_menu_bar;
     Popup& m_popup;
     CursorManager& m_cursor_manager;
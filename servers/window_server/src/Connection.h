@@ -28,6 +28,8 @@ public:
     }
 
     inline bool send_async_message(const Message& msg) const { return m_connection_with_clients.send_message(msg); }
+    // A connection is only the key its messages carry. No state is kept per
+    // connection, so the decoder has nothing to look up by it.
     inline int alloc_connection() { return ++m_connections_number; }
     void receive_event(std::unique_ptr<LFoundation::Event> event) override;
 
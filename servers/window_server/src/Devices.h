@@ -23,20 +23,22 @@ public:
     Devices();
     ~Devices() = default;
 
+    // The kernel coalesces motion and returns whole packets only, a buffer
+    // as big as its queue drains all pending input with a single read.
     inline void pump_mouse() const
     {
         LFoundation::EventLoop& el = LFoundation::EventLoop::the();
         WindowManager& wm = WindowManager::the();
 
-        char buf[512];
-        int read_cnt = read(m_mouse_fd, buf, sizeof(buf));
+        MousePacket packets[InputQueueSize];
+        int read_cnt = read(m_mouse_fd, packets, sizeof(packets));
         if (read_cnt <= 0) {
             return;
         }
 
-        auto* packet_buf = reinterpret_cast<MousePacket*>(buf);
-        for (int offset = 0, cnt = 0; offset < read_cnt; offset += sizeof(MousePacket), cnt++) {
-            el.add(wm, new MouseEvent(packet_buf[cnt]));
+        int cnt = read_cnt / sizeof(MousePacket);
+        for (int i = 0; i < cnt; i++) {
+            el.add(wm, new MouseEvent(packets[i]));
         }
     }
 
@@ -45,19 +47,21 @@ public:
         LFoundation::EventLoop& el = LFoundation::EventLoop::the();
         WindowManager& wm = WindowManager::the();
 
-        char buf[512];
-        int read_cnt = read(m_keyboard_fd, buf, sizeof(buf));
+        KeyboardPacket packets[InputQueueSize];
+        int read_cnt = read(m_keyboard_fd, packets, sizeof(packets));
         if (read_cnt <= 0) {
             return;
         }
 
-        auto* packet_buf = reinterpret_cast<KeyboardPacket*>(buf);
-        for (int offset = 0, cnt = 0; offset < read_cnt; offset += sizeof(KeyboardPacket), cnt++) {
-            el.add(wm, new KeyboardEvent(packet_buf[cnt]));
+        int cnt = read_cnt / sizeof(KeyboardPacket);
+        for (int i = 0; i < cnt; i++) {
+            el.add(wm, new KeyboardEvent(packets[i]));
         }
     }
 
 private:
+    static constexpr int InputQueueSize = 256;
+
     int m_mouse_fd;
     int m_keyboard_fd;
 };
@@ -36,10 +36,12 @@ struct MousePacket {
     int16_t y_offset;
     uint16_t button_states;
     int16_t wheel_data;
+    uint32_t time;
 };
 
 struct KeyboardPacket {
     uint32_t key;
+    uint32_t time;
 };
 
 class MouseEvent : public WinServer::Event {
@@ -10,7 +10,6 @@
 #include <fcntl.h>
 #include <sys/ioctl.h>
 #include <sys/mman.h>
-#include <utility>
 
 namespace WinServer {
 
@@ -18,31 +17,42 @@ Screen* s_WinServer_Screen_the = nullptr;
 
 Screen::Screen()
     : m_depth(4)
-    , m_write_bitmap()
-    , m_display_bitmap()
 {
     s_WinServer_Screen_the = this;
     m_screen_fd = open("/dev/bga", O_RDWR);
     m_bounds = LG::Rect(0, 0, ioctl(m_screen_fd, BGA_GET_WIDTH, 0), ioctl(m_screen_fd, BGA_GET_HEIGHT, 0));
 
-    size_t screen_buffer_size = width() * height() * depth();
-    auto* first_buffer = reinterpret_cast<LG::Color*>(mmap(NULL, 1, PROT_READ | PROT_WRITE, MAP_SHARED, m_screen_fd, 0));
-    auto* second_buffer = reinterpret_cast<LG::Color*>(reinterpret_cast<uint8_t*>(first_buffer) + screen_buffer_size);
-
-    m_display_bitmap = LG::PixelBitmap(first_buffer, width(), height());
-    m_write_bitmap = LG::PixelBitmap(second_buffer, width(), height());
+    // Ask for triple buffering, small video memories fall back to double buffering.
+    display_mode_t mode = { 0 };
+    mode.width = width();
+    mode.height = height();
+    mode.bpp = depth() * 8;
+    for (mode.buffers = BGA_MAX_BUFFERS; mode.buffers > 2; mode.buffers--) {
+        if (ioctl(m_screen_fd, BGA_SET_MODE, (uint32_t)&mode) == 0) {
+            break;
+        }
+    }
+    int buffers_count = ioctl(m_screen_fd, BGA_GET_BUFFERS, 0);
+    if (buffers_count < 2) {
+        buffers_count = 2;
+    }
 
-    m_display_bitmap_ptr = &m_display_bitmap;
-    m_write_bitmap_ptr = &m_write_bitmap;
-
-    m_active_buffer = 0;
+    size_t screen_buffer_size = width() * height() * depth();
+    auto* first_buffer = reinterpret_cast<uint8_t*>(mmap(NULL, 1, PROT_READ | PROT_WRITE, MAP_SHARED, m_screen_fd, 0));
+    for (int i = 0; i < buffers_count; i++) {
+        auto* buffer = reinterpret_cast<LG::Color*>(first_buffer + i * screen_buffer_size);
+        m_buffers.push_back(LG::PixelBitmap(buffer, width(), height()));
+    }
+
+    m_display_buffer = 0;
+    m_write_buffer = 1;
 }
 
 void Screen::swap_buffers()
 {
-    m_write_bitmap_ptr.swap(m_display_bitmap_ptr);
-    m_active_buffer ^= 1;
-    ioctl(m_screen_fd, BGA_SWAP_BUFFERS, m_active_buffer);
+    m_display_buffer = m_write_buffer;
+    m_write_buffer = (m_write_buffer + 1) % m_buffers.size();
+    ioctl(m_screen_fd, BGA_SWAP_BUFFERS, m_display_buffer);
 }
 
 } // namespace WinServer
@@ -7,7 +7,7 @@
 #pragma once
 #include <libg/Color.h>
 #include <libg/PixelBitmap.h>
-#include <memory>
+#include <vector>
 
 namespace WinServer {
 
@@ -29,23 +29,24 @@ public:
     inline const LG::Rect& bounds() const { return m_bounds; }
     inline uint32_t depth() const { return m_depth; }
 
-    inline LG::PixelBitmap& write_bitmap() { return *m_write_bitmap_ptr; }
-    inline const LG::PixelBitmap& write_bitmap() const { return *m_write_bitmap_ptr; }
-    inline LG::PixelBitmap& display_bitmap() { return *m_display_bitmap_ptr; }
-    inline const LG::PixelBitmap& display_bitmap() const { return *m_display_bitmap_ptr; }
+    // Scanout buffers are flipped round-robin. Every buffer lags behind the
+    // screen by the frames drawn into the others since it was written.
+    inline size_t buffers_count() const { return m_buffers.size(); }
+    inline size_t write_buffer_index() const { return m_write_buffer; }
+
+    inline LG::PixelBitmap& write_bitmap() { return m_buffers[m_write_buffer]; }
+    inline const LG::PixelBitmap& write_bitmap() const { return m_buffers[m_write_buffer]; }
+    inline LG::PixelBitmap& display_bitmap() { return m_buffers[m_display_buffer]; }
+    inline const LG::PixelBitmap& display_bitmap() const { return m_buffers[m_display_buffer]; }
 
 private:
     int m_screen_fd;
     LG::Rect m_bounds;
     uint32_t m_depth;
 
-    int m_active_buffer;
-
-    LG::PixelBitmap m_write_bitmap;
-    LG::PixelBitmap m_display_bitmap;
-
-    std::unique_ptr<LG::PixelBitmap> m_write_bitmap_ptr { nullptr };
-    std::unique_ptr<LG::PixelBitmap> m_display_bitmap_ptr { nullptr };
+    std::vector<LG::PixelBitmap> m_buffers;
+    size_t m_display_buffer;
+    size_t m_write_buffer;
 };
 
 } // namespace WinServer
\ No newline at end of file
@@ -53,6 +53,7 @@ void WindowManager::add_window(Window* window)
         setup_dock(window);
     }
     m_windows.push_back(window);
+    m_windows_by_id[window->id()] = window;
     set_active_window(window);
     notify_window_status_changed(window->id(), WindowStatusUpdateType::Created);
 }
@@ -88,6 +89,7 @@ void WindowManager::remove_window(Window* window)
     }
     remove_window_from_screen(window);
     m_windows.erase(std::find(m_windows.begin(), m_windows.end(), window));
+    m_windows_by_id.erase(window->id());
     notify_window_status_changed(window->id(), WindowStatusUpdateType::Removed);
 #ifdef TARGET_MOBILE
     if (auto* top_window = get_top_standard_window_in_view(); top_window) {
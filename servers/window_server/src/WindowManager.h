@@ -20,6 +20,7 @@
 #include <libfoundation/EventReceiver.h>
 #include <libipc/ServerConnection.h>
 #include <list>
+#include <unordered_map>
 #include <vector>
 
 namespace WinServer {
@@ -69,12 +70,11 @@ public:
     Window* get_top_standard_window_in_view() const;
     inline Window* window(int id)
     {
-        for (auto* window : m_windows) {
-            if (window->id() == id) {
-                return window;
-            }
+        auto it = m_windows_by_id.find(id);
+        if (it == m_windows_by_id.end()) {
+            return nullptr;
         }
-        return nullptr;
+        return it->second;
     }
 
     inline void move_window(Window* window, int x_offset, int y_offset)
@@ -134,6 +134,8 @@ private:
     inline void send_event(Message* msg) { m_event_loop.add(m_connection, new SendEvent(msg)); }
 
     std::list<Window*> m_windows;
+    // Every message from a client names its window by id.
+    std::unordered_map<int, Window*> m_windows_by_id;
 
     Screen& m_screen;
     Connection& m_connection;
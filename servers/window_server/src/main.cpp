@@ -19,9 +19,14 @@
 #include <cstdlib>
 #include <libfoundation/EventLoop.h>
 #include <new>
+#include <spawn.h>
+#include <sys/malloc_trace.h>
 #include <sys/socket.h>
 #include <unistd.h>
 
+#define MALLOC_TRACE_PATH "/home/window_server.mtrace"
+#define MALLOC_TRACE_TIME_MS (60 * 1000)
+
 #ifdef TARGET_DESKTOP
 #define LAUNCH_PATH "/System/dock"
 #elif TARGET_MOBILE
@@ -30,8 +35,8 @@
 
 void start_dock()
 {
-    if (fork()) {
-        execve(LAUNCH_PATH, nullptr, nullptr);
+    pid_t pid;
+    if (posix_spawn(&pid, LAUNCH_PATH, nullptr, nullptr, nullptr, nullptr) != 0) {
         std::abort();
     }
 }
@@ -58,8 +63,21 @@ constexpr inline void add_widget(Args&&... args)
     WinServer::LoadingScreen::the().move_progress<T, Cost>();
 }
 
+// In malloc_trace builds the calls of the first minute, startup included,
+// are saved for userland/tests/bench to replay.
+void malloc_trace_schedule_dump()
+{
+#ifdef MALLOC_TRACE
+    LFoundation::EventLoop::the().add(LFoundation::Timer([] {
+        malloc_trace_dump(MALLOC_TRACE_PATH);
+    },
+        MALLOC_TRACE_TIME_MS, LFoundation::Timer::Once));
+#endif
+}
+
 int main()
 {
+    malloc_trace_start();
     screen_init();
     auto* event_loop = new LFoundation::EventLoop();
     load_core_component<WinServer::Connection>(socket(PF_LOCAL, 0, 0));
@@ -77,5 +95,6 @@ int main()
     add_widget<WinServer::Clock>();
 
     WinServer::LoadingScreen::destroy_the();
+    malloc_trace_schedule_dump();
     return event_loop->run();
 }
\ No newline at end of file
@@ -7,6 +7,7 @@
 // includes
 #include <pthread.h>
 #include <signal.h>
+#include <spawn.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -108,13 +109,10 @@ void _cmd_processor()
         uint32_t namelen = strlen(_cmd_parsed_buffer[0]);
         memcpy(_cmd_app + 5, _cmd_buffer, namelen + 1);
 
-        int res = fork();
-        if (!res) {
-            execve(_cmd_app, &_cmd_parsed_buffer[1], 0);
-            exit(-1);
-        } else {
-            running_job = res;
-            wait(res);
+        pid_t pid;
+        if (posix_spawn(&pid, _cmd_app, NULL, NULL, _cmd_parsed_buffer, NULL) == 0) {
+            running_job = pid;
+            wait(pid);
         }
     } else {
         _cmd_do_internal(cmd);
@@ -7,6 +7,7 @@
 #include <libg/ImageLoaders/PNGLoader.h>
 #include <libui/App.h>
 #include <libui/Context.h>
+#include <spawn.h>
 #include <unistd.h>
 
 static DockView* this_view;
@@ -99,10 +100,8 @@ void DockView::set_icon(int window_id, const LG::string& path)
 
 void DockView::launch(const FastLaunchEntity& ent)
 {
-    if (fork() == 0) {
-        execve(ent.path_to_exec().c_str(), 0, 0);
-        std::abort();
-    }
+    pid_t pid;
+    posix_spawn(&pid, ent.path_to_exec().c_str(), nullptr, nullptr, nullptr, nullptr);
 }
 
 void DockView::mouse_down(const LG::Point<int>& location)
@@ -5,6 +5,7 @@
 #include <libui/Label.h>
 #include <libui/View.h>
 #include <list>
+#include <spawn.h>
 #include <string>
 #include <unistd.h>
 
@@ -31,10 +32,8 @@ public:
 private:
     void launch(const std::string& path_to_exec)
     {
-        if (fork() == 0) {
-            execve(path_to_exec.c_str(), 0, 0);
-            std::abort();
-        }
+        pid_t pid;
+        posix_spawn(&pid, path_to_exec.c_str(), nullptr, nullptr, nullptr, nullptr);
     }
 
     UI::Label* m_label;
@@ -1,7 +1,18 @@
 #include "common.h"
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <functional>
+#include <map>
+#include <spawn.h>
+#include <string>
+#include <sys/ioctl.h>
+#include <sys/malloc_trace.h>
+#include <sys/mman.h>
 #include <unistd.h>
+#include <unordered_map>
+#include <vector>
 
 char* bench_name;
 int bench_pno = -1;
@@ -26,12 +37,584 @@ void bench_kernel()
             }
         }
     }
+
+    RUN_BENCH("VFORK", 3)
+    {
+        for (int i = 0; i < 20; i++) {
+            int pid = vfork();
+            if (pid < 0) {
+                return;
+            }
+            if (pid) {
+                wait(pid);
+            } else {
+                exit(0);
+            }
+        }
+    }
+
+    RUN_BENCH("SPAWN", 3)
+    {
+        char* spawn_argv[] = { (char*)"/bin/bench", (char*)"--nop", nullptr };
+        for (int i = 0; i < 20; i++) {
+            pid_t pid;
+            if (posix_spawn(&pid, "/bin/bench", nullptr, nullptr, spawn_argv, nullptr) != 0) {
+                return;
+            }
+            wait(pid);
+        }
+    }
+}
+
+void bench_pty()
+{
+    int ptmx = posix_openpt(O_RDWR);
+    if (ptmx < 0) {
+        return;
+    }
+    char pts_name[16];
+    if (ptsname_r(ptmx, pts_name, sizeof(pts_name)) != 0) {
+        close(ptmx);
+        return;
+    }
+    int pts = open(pts_name, O_RDWR);
+    if (pts < 0) {
+        close(ptmx);
+        return;
+    }
+
+    static char data[4096];
+    RUN_BENCH("PTY", 3)
+    {
+        // Pushing 1MB through the pair in 4KB chunks.
+        for (int i = 0; i < 256; i++) {
+            int written = write(ptmx, data, sizeof(data));
+            int got = 0;
+            while (got < written) {
+                int res = read(pts, data, sizeof(data));
+                if (res <= 0) {
+                    break;
+                }
+                got += res;
+            }
+        }
+    }
+
+    close(pts);
+    close(ptmx);
+}
+
+void bench_blit()
+{
+    int fd = open("/dev/bga", O_RDWR);
+    if (fd < 0) {
+        return;
+    }
+    uint32_t width = ioctl(fd, BGA_GET_WIDTH, 0);
+    uint32_t height = ioctl(fd, BGA_GET_HEIGHT, 0);
+    uint32_t* screen = (uint32_t*)mmap(NULL, 1, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (!screen || (uint32_t)screen >= (uint32_t)(-4096)) {
+        close(fd);
+        return;
+    }
+
+    // Drawing into the back buffer column by column, so every pixel lands
+    // on another line and the walk is dominated by TLB misses.
+    uint32_t* back_buffer = screen + width * height;
+    RUN_BENCH("BLIT", 3)
+    {
+        for (int it = 0; it < 4; it++) {
+            for (uint32_t x = 0; x < width; x++) {
+                for (uint32_t y = 0; y < height; y++) {
+                    back_buffer[y * width + x] = x ^ y ^ it;
+                }
+            }
+        }
+    }
+
+    // Filling the back buffer line by line, like the compositor does on a
+    // full-screen redraw. This is bound by the memory type of the mapping.
+    RUN_BENCH("FB FILL", 3)
+    {
+        for (int it = 0; it < 16; it++) {
+            uint32_t color = 0xff000000 | (it * 0x10101);
+            for (uint32_t i = 0; i < width * height; i++) {
+                back_buffer[i] = color;
+            }
+        }
+    }
+
+    munmap(screen, width * height * 4 * 2);
+    close(fd);
+}
+
+void bench_disk()
+{
+    const char* path = "/bench_disk.tmp";
+    const int file_size = 256 * 1024;
+    static char data[4096];
+
+    int fd = creat(path, 0600);
+    if (fd < 0) {
+        return;
+    }
+    close(fd);
+    fd = open(path, O_RDWR);
+    if (fd < 0) {
+        return;
+    }
+    for (int i = 0; i < file_size / (int)sizeof(data); i++) {
+        memset(data, i, sizeof(data));
+        write(fd, data, sizeof(data));
+    }
+
+    RUN_BENCH("DISK SEQ READ", 3)
+    {
+        lseek(fd, 0, SEEK_SET);
+        for (int i = 0; i < file_size / (int)sizeof(data); i++) {
+            read(fd, data, sizeof(data));
+        }
+    }
+
+    // Same amount of data in 512-byte reads at scattered offsets, so
+    // the queue gets nothing to merge.
+    RUN_BENCH("DISK RAND READ", 3)
+    {
+        uint32_t seed = 12345;
+        for (int i = 0; i < file_size / 512; i++) {
+            seed = seed * 1103515245 + 12345;
+            lseek(fd, ((seed >> 8) % (file_size / 512)) * 512, SEEK_SET);
+            read(fd, data, 512);
+        }
+    }
+
+    close(fd);
+    unlink(path);
+}
+
+void bench_string()
+{
+    static char src[64 * 1024 + 64];
+    static char dst[64 * 1024 + 64];
+    memset(src, 'a', sizeof(src));
+    src[sizeof(src) - 1] = '\0';
+
+    // Small copies with shifting alignment, like IPC message encoding.
+    RUN_BENCH("MEMCPY SMALL", 3)
+    {
+        for (int it = 0; it < 8192; it++) {
+            for (int size = 8; size <= 128; size += 24) {
+                memcpy(dst + (it & 15), src + ((it >> 4) & 15), size);
+            }
+        }
+    }
+
+    RUN_BENCH("MEMCPY 64K", 3)
+    {
+        for (int it = 0; it < 256; it++) {
+            memcpy(dst, src + (it & 1), 64 * 1024);
+        }
+    }
+
+    RUN_BENCH("MEMSET 64K", 3)
+    {
+        for (int it = 0; it < 256; it++) {
+            memset(dst + (it & 1), it, 64 * 1024);
+        }
+    }
+
+    RUN_BENCH("MEMCMP 64K", 3)
+    {
+        memcpy(dst, src, sizeof(src));
+        for (int it = 0; it < 256; it++) {
+            if (memcmp(dst, src, 64 * 1024)) {
+                break;
+            }
+        }
+    }
+
+    RUN_BENCH("STRLEN 64K", 3)
+    {
+        for (int it = 0; it < 256; it++) {
+            if (strlen(src + (it & 7)) == 0) {
+                break;
+            }
+        }
+    }
+}
+
+void bench_printf()
+{
+    static char line[256];
+
+    // A line like ls -l or activitymonitor prints.
+    RUN_BENCH("SNPRINTF", 3)
+    {
+        for (int i = 0; i < 20000; i++) {
+            snprintf(line, sizeof(line), "%s %8u %-12s %5d%% %x\n", "-rw-r--r--", i * 4093, "kernel.bin", i % 100, i);
+        }
+    }
+
+    FILE* file = fopen("/bench_printf.tmp", "w");
+    if (!file) {
+        return;
+    }
+    RUN_BENCH("FPRINTF", 3)
+    {
+        for (int i = 0; i < 20000; i++) {
+            fprintf(file, "pid %d cpu %u name %s\n", i, i % 4, "window_server");
+        }
+    }
+    fclose(file);
+    unlink("/bench_printf.tmp");
+}
+
+void bench_stdio()
+{
+    const char* path = "/bench_stdio.tmp";
+    static char data[64 * 1024];
+
+    FILE* file = fopen(path, "w");
+    if (!file) {
+        return;
+    }
+    for (int i = 0; i < 8192; i++) {
+        fprintf(file, "line %d of a text file read by stdio\n", i);
+    }
+    fclose(file);
+
+    RUN_BENCH("STDIO FGETC", 3)
+    {
+        file = fopen(path, "r");
+        while (fgetc(file) != EOF) { }
+        fclose(file);
+    }
+
+    RUN_BENCH("STDIO GETLINE", 3)
+    {
+        char* line = nullptr;
+        size_t cap = 0;
+        file = fopen(path, "r");
+        while (getline(&line, &cap, file) > 0) { }
+        fclose(file);
+        free(line);
+    }
+
+    RUN_BENCH("STDIO FREAD 64K", 3)
+    {
+        file = fopen(path, "r");
+        while (fread(data, 1, sizeof(data), file) > 0) { }
+        fclose(file);
+    }
+
+    unlink(path);
+}
+
+void bench_hash()
+{
+    const int ids = 1024;
+    std::map<int, int> tree;
+    std::unordered_map<int, int> table;
+    for (int i = 0; i < ids; i++) {
+        tree[i * 7] = i;
+        table[i * 7] = i;
+    }
+
+    // Window ids looked up per message, the way the window server does.
+    RUN_BENCH("MAP LOOKUP", 3)
+    {
+        int sum = 0;
+        for (int it = 0; it < 200000; it++) {
+            sum += tree[(it % ids) * 7];
+        }
+        if (sum == -1) {
+            break;
+        }
+    }
+
+    RUN_BENCH("UNORDERED_MAP LOOKUP", 3)
+    {
+        int sum = 0;
+        for (int it = 0; it < 200000; it++) {
+            sum += table.find((it % ids) * 7)->second;
+        }
+        if (sum == -1) {
+            break;
+        }
+    }
+
+    RUN_BENCH("UNORDERED_MAP CHURN", 3)
+    {
+        std::unordered_map<int, int> churn;
+        for (int it = 0; it < 100000; it++) {
+            churn[it] = it;
+            if (it >= 64) {
+                churn.erase(it - 64);
+            }
+        }
+    }
+}
+
+// Printed apart from the timings, bench.py only reads [BENCH] lines.
+static void bench_report_allocs(const char* name, size_t start, int runs)
+{
+    printf("[ALLOCS][%s] %d per run\n", name, (int)((malloc_count() - start) / runs));
+    fflush(stdout);
+}
+
+void bench_small_objects()
+{
+    // Window titles and menu items, both fit the inline buffer.
+    size_t allocs = malloc_count();
+    RUN_BENCH("STRING SMALL", 3)
+    {
+        for (int it = 0; it < 50000; it++) {
+            std::string title("Terminal");
+            std::string copy = title;
+            copy += " 2";
+            if (copy.size() != 10) {
+                break;
+            }
+        }
+    }
+    bench_report_allocs("STRING SMALL", allocs, 3);
+
+    // Callbacks like the ones libui controls and timers keep.
+    allocs = malloc_count();
+    RUN_BENCH("FUNCTION SMALL", 3)
+    {
+        int counter = 0;
+        for (int it = 0; it < 50000; it++) {
+            std::function<void()> callback = [&counter, it] { counter += it & 1; };
+            std::function<void()> copy = callback;
+            copy();
+        }
+        if (counter < 0) {
+            break;
+        }
+    }
+    bench_report_allocs("FUNCTION SMALL", allocs, 3);
+
+    allocs = malloc_count();
+    RUN_BENCH("VECTOR PUSH", 3)
+    {
+        std::vector<std::string> names;
+        for (int it = 0; it < 20000; it++) {
+            names.emplace_back("item");
+        }
+    }
+    bench_report_allocs("VECTOR PUSH", allocs, 3);
+}
+
+struct malloc_trace_op {
+    uint16_t slot;
+    uint32_t size; // 0 frees the slot.
+};
+
+#define MALLOC_TRACE_PATH "/home/window_server.mtrace"
+
+/**
+ * Loads the trace the window server records in malloc_trace builds, see
+ * servers/window_server/src/main.cpp. Pointers are given slots as they are
+ * allocated, frees of pointers allocated before recording are skipped. The
+ * trace is cut where the frees of the live slots would not fit, and those
+ * frees close it out. Returns -1 if there is no recorded trace.
+ */
+static int bench_malloc_load_trace(malloc_trace_op* ops, int max_ops, int slots)
+{
+    int fd = open(MALLOC_TRACE_PATH, O_RDONLY);
+    if (fd < 0) {
+        return -1;
+    }
+
+    malloc_trace_header_t header;
+    if (read(fd, (char*)&header, sizeof(header)) != sizeof(header) || header.magic != MALLOC_TRACE_MAGIC) {
+        close(fd);
+        return -1;
+    }
+
+    std::unordered_map<uint32_t, uint16_t> live;
+    std::vector<uint16_t> free_slots;
+    for (int slot = slots - 1; slot >= 0; slot--) {
+        free_slots.push_back(slot);
+    }
+
+    int cnt = 0;
+    bool full = false;
+    malloc_trace_entry_t entries[256];
+    for (uint32_t left = header.count; left && !full;) {
+        uint32_t chunk = left < 256 ? left : 256;
+        int rd = read(fd, (char*)entries, chunk * sizeof(malloc_trace_entry_t));
+        if (rd <= 0) {
+            break;
+        }
+        chunk = rd / sizeof(malloc_trace_entry_t);
+        left -= chunk;
+
+        for (uint32_t i = 0; i < chunk; i++) {
+            if (!entries[i].size) {
+                auto it = live.find(entries[i].ptr);
+                if (it != live.end()) {
+                    ops[cnt++] = { it->second, 0 };
+                    free_slots.push_back(it->second);
+                    live.erase(it);
+                }
+                continue;
+            }
+
+            if (cnt + (int)live.size() + 2 > max_ops || free_slots.empty()) {
+                full = true;
+                break;
+            }
+            uint16_t slot = free_slots.back();
+            free_slots.pop_back();
+            ops[cnt++] = { slot, entries[i].size };
+            live[entries[i].ptr] = slot;
+        }
+    }
+    close(fd);
+
+    for (auto& it : live) {
+        ops[cnt++] = { it.second, 0 };
+    }
+    return cnt;
+}
+
+/**
+ * Builds an allocation trace shaped after a compositor frame loop: short-lived
+ * event messages and damage rects, view objects and titles which live for
+ * many frames, icon sized buffers and rare full window backings.
+ */
+static int bench_malloc_build_trace(malloc_trace_op* ops, int max_ops, int slots)
+{
+    static bool used[1024];
+    uint32_t seed = 4242;
+    int cnt = 0;
+    memset(used, 0, sizeof(used));
+
+    auto rnd = [&seed]() {
+        seed = seed * 1103515245 + 12345;
+        return seed >> 8;
+    };
+    auto emit = [&](int slot, uint32_t size) {
+        ops[cnt++] = { (uint16_t)slot, size };
+    };
+
+    // A frame takes at most 2 * frame_slots + 4 ops, the room for the frees
+    // of the long-lived slots is kept for the end.
+    const int frame_slots = 64;
+    while (cnt + 2 * frame_slots + 4 + slots <= max_ops) {
+        // Messages and damage rects, all gone by the end of the frame.
+        int per_frame = 8 + rnd() % (frame_slots - 8);
+        for (int i = 0; i < per_frame; i++) {
+            emit(i, (i & 1) ? 16 + rnd() % 16 : 24 + rnd() % 96);
+        }
+
+        // Long-lived objects are replaced at random.
+        for (int i = 0; i < 4; i++) {
+            int slot = frame_slots + rnd() % (slots - frame_slots);
+            if (used[slot]) {
+                emit(slot, 0);
+                used[slot] = false;
+                continue;
+            }
+            uint32_t kind = rnd() % 100;
+            uint32_t size;
+            if (kind < 50) {
+                size = 20 + rnd() % 48;
+            } else if (kind < 90) {
+                size = 128 + rnd() % 384;
+            } else if (kind < 99) {
+                size = 4096 + rnd() % 12288;
+            } else {
+                size = 64 * 1024 + rnd() % (192 * 1024);
+            }
+            emit(slot, size);
+            used[slot] = true;
+        }
+
+        for (int i = 0; i < per_frame; i++) {
+            emit(i, 0);
+        }
+    }
+
+    for (int slot = 0; slot < slots; slot++) {
+        if (used[slot]) {
+            emit(slot, 0);
+        }
+    }
+    return cnt;
+}
+
+void bench_malloc()
+{
+    const int max_ops = 64 * 1024;
+    const int slots = 1024;
+    const int trace_slots = 8192;
+    malloc_trace_op* ops = (malloc_trace_op*)malloc(max_ops * sizeof(malloc_trace_op));
+    void** ptrs = (void**)malloc(trace_slots * sizeof(void*));
+    if (!ops || !ptrs) {
+        return;
+    }
+
+    const char* trace_name = "MALLOC TRACE";
+    int cnt = bench_malloc_load_trace(ops, max_ops, trace_slots);
+    if (cnt < 0) {
+        trace_name = "MALLOC SYNTHETIC TRACE";
+        cnt = bench_malloc_build_trace(ops, max_ops, slots);
+    }
+
+    RUN_BENCH(trace_name, 3)
+    {
+        for (int i = 0; i < cnt; i++) {
+            if (ops[i].size) {
+                char* mem = (char*)malloc(ops[i].size);
+                if (mem) {
+                    mem[0] = 0;
+                }
+                ptrs[ops[i].slot] = mem;
+            } else {
+                free(ptrs[ops[i].slot]);
+            }
+        }
+    }
+
+    RUN_BENCH("MALLOC SMALL", 3)
+    {
+        for (int it = 0; it < 64; it++) {
+            for (int i = 0; i < slots; i++) {
+                ptrs[i] = malloc(16 + (i & 127));
+            }
+            for (int i = 0; i < slots; i++) {
+                free(ptrs[i]);
+            }
+        }
+    }
+
+    malloc_trim(0);
+    free(ptrs);
+    free(ops);
 }
 
 int main(int argc, char** argv)
 {
+    // Used by SPAWN bench as the cheapest possible process.
+    if (argc > 1 && strcmp(argv[1], "--nop") == 0) {
+        return 0;
+    }
+
     bench_kernel();
+    bench_pty();
+    bench_blit();
+    bench_disk();
+    bench_string();
+    bench_printf();
+    bench_stdio();
+    bench_hash();
+    bench_small_objects();
+    bench_malloc();
     bench_pngloader();
+    bench_startup();
     printf("[BENCH END]\n\n");
     fflush(stdout);
     return 0;
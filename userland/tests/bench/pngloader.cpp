@@ -1,13 +1,35 @@
 #include "common.h"
+#include <fcntl.h>
 #include <libg/ImageLoaders/PNGLoader.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 LG::PixelBitmap bitmap;
 
 void bench_pngloader()
 {
+    // Served by the resource cache when it is present.
     RUN_BENCH("PNG LOADER", 5)
     {
         LG::PNG::PNGLoader loader;
         bitmap = loader.load_from_file("/res/wallpapers/mountain_orange.png");
     }
+
+    int fd = open("/res/wallpapers/mountain_orange.png", O_RDONLY);
+    if (fd < 0) {
+        return;
+    }
+    fstat_t stat;
+    fstat(fd, &stat);
+    uint8_t* ptr = (uint8_t*)mmap(NULL, stat.size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    RUN_BENCH("PNG DECODE", 5)
+    {
+        LG::PNG::PNGLoader loader;
+        bitmap = loader.load_from_mem(ptr);
+    }
+
+    munmap(ptr, stat.size);
+    close(fd);
 }
\ No newline at end of file
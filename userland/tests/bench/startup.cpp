@@ -0,0 +1,50 @@
+#include "common.h"
+#include <cstdio>
+#include <spawn.h>
+#include <unistd.h>
+
+struct startup_app {
+    const char* first_name;
+    const char* repeat_name;
+    const char* path;
+};
+
+static bool startup_spawn_and_wait(const char* path)
+{
+    char* spawn_argv[] = { (char*)path, (char*)"--startup-bench", nullptr };
+    pid_t pid;
+    if (posix_spawn(&pid, path, nullptr, nullptr, spawn_argv, nullptr) != 0) {
+        return false;
+    }
+    wait(pid);
+    return true;
+}
+
+void bench_startup()
+{
+    static startup_app apps[] = {
+        { "STARTUP FIRST TERMINAL", "STARTUP REPEAT TERMINAL", "/Applications/terminal.app/Content/terminal" },
+        { "STARTUP FIRST CALCULATOR", "STARTUP REPEAT CALCULATOR", "/Applications/calculator.app/Content/calculator" },
+    };
+
+    // There is no page cache, so every launch reads the binary and the
+    // resource cache from disk again. The first launch is still reported
+    // apart from the repeated ones. The dock is not launched here: the
+    // window server takes any dock for the system one and would replace
+    // the running dock.
+    for (auto& app : apps) {
+        RUN_BENCH(app.first_name, 1)
+        {
+            if (!startup_spawn_and_wait(app.path)) {
+                return;
+            }
+        }
+
+        RUN_BENCH(app.repeat_name, 3)
+        {
+            if (!startup_spawn_and_wait(app.path)) {
+                return;
+            }
+        }
+    }
+}
\ No newline at end of file
@@ -4,6 +4,8 @@
 #include <optional>
 #include <stdio.h>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <utility>
 
 int main()
@@ -18,4 +20,21 @@ int main()
     printf("Result: %d", a.size());
     printf("Result: %d", a[10]);
     printf("Result: %d", a.size());
+
+    std::unordered_map<int, int> b;
+    b[10] = 20;
+    printf("Result: %d", b[10]);
+    printf("Result: %d", b.contains(11));
+    printf("Result: %d", b.size());
+    b.erase(10);
+    printf("Result: %d", b.size());
+
+    std::unordered_map<std::string, int, std::hash<std::string>, std::equal_to<>> c;
+    c["window_server"] = 1;
+    printf("Result: %d", c.find("window_server")->second);
+
+    std::unordered_set<int> d;
+    d.insert(5);
+    d.insert(5);
+    printf("Result: %d", d.size());
 }
\ No newline at end of file
@@ -1,6 +1,8 @@
 #include <libfoundation/NSObject.h>
 #include <libobjc/helpers.h>
+#include <libobjc/runtime.h>
 #include <stdio.h>
+#include <sys/time.h>
 
 @interface SampleClass : NSObject {
 @public
@@ -31,11 +33,39 @@
 
 @end
 
+static int elapsed_usec(timeval_t* start, timeval_t* end)
+{
+    return (end->tv_sec - start->tv_sec) * 1000000 + (end->tv_usec - start->tv_usec);
+}
+
+// Every send after the first one is served from the class method cache.
+static void bench_msg_send(id object)
+{
+    const int sends = 100000;
+    timeval_t start, end;
+    timezone_t tz;
+
+    gettimeofday(&start, &tz);
+    for (int i = 0; i < sends; i++) {
+        [object get_last];
+    }
+    gettimeofday(&end, &tz);
+    printf("[BENCH][MSG SEND] %d (usec)\n", elapsed_usec(&start, &end));
+
+    gettimeofday(&start, &tz);
+    for (int i = 0; i < sends; i++) {
+        ((int (*)(id, SEL))objc_msgSend)(object, @selector(get_last));
+    }
+    gettimeofday(&end, &tz);
+    printf("[BENCH][OBJC_MSGSEND] %d (usec)\n", elapsed_usec(&start, &end));
+}
+
 int main()
 {
     id objectAlloc = [[SampleClass alloc] init];
     [objectAlloc sampleMethod:22];
     [SampleClass sampleMethod];
     printf("Last called with %d", [objectAlloc get_last]);
+    bench_msg_send(objectAlloc);
     return 0;
 }
\ No newline at end of file
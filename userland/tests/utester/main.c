@@ -1,9 +1,11 @@
 #include <fcntl.h>
+#include <pthread.h>
 #include <sched.h>
 #include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
 #include <unistd.h>
 
 void exectest(void)
@@ -229,6 +231,217 @@ void testsignals()
     }
 }
 
+#define TLB_WORKERS 4
+#define TLB_ROUNDS 32
+#define TLB_PAGES 8
+
+static volatile int tlb_counter = 0;
+static volatile int tlb_stop = 0;
+static int tlb_workers_done = 0;
+static int tlb_failed = 0;
+
+// Every round maps fresh pages, which must read as zero, and checks what was
+// written. A stale TLB entry after munmap shows up as someone else's data.
+static void* tlbworker(void* arg)
+{
+    char pattern = (char)(int)arg;
+    while (!tlb_stop) {
+        char* buf = (char*)mmap(NULL, TLB_PAGES * 4096, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if ((unsigned int)buf < (unsigned int)(-4096)) {
+            for (int i = 0; i < TLB_PAGES; i++) {
+                if (buf[i * 4096] != 0) {
+                    __atomic_store_n(&tlb_failed, 1, __ATOMIC_RELAXED);
+                }
+                buf[i * 4096] = pattern + i;
+            }
+            for (int i = 0; i < TLB_PAGES; i++) {
+                if (buf[i * 4096] != (char)(pattern + i)) {
+                    __atomic_store_n(&tlb_failed, 1, __ATOMIC_RELAXED);
+                }
+            }
+            munmap(buf, TLB_PAGES * 4096);
+        }
+        tlb_counter++;
+    }
+    __atomic_add_fetch(&tlb_workers_done, 1, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+// Workers keep writing to tlb_counter on all cores while the main thread forks.
+// After a fork the page is copy-on-write, so a child sees a changing counter
+// only if some core kept a stale writable TLB entry. Children report it with
+// a file, since the exit status is not passed to wait.
+void tlbstress(void)
+{
+    const char* fail_name = "tlb.e";
+    int workers = 0;
+
+    write(1, "tlb stress test\n", 16);
+    unlink(fail_name);
+    for (int i = 0; i < TLB_WORKERS; i++) {
+        pthread_t tid;
+        if (pthread_create(&tid, NULL, tlbworker, (void*)((i + 1) * 16)) != 0) {
+            write(1, "pthread_create failed\n", 22);
+            tlb_failed = 1;
+            break;
+        }
+        workers++;
+    }
+
+    for (int round = 0; round < TLB_ROUNDS && workers; round++) {
+        int pid = fork();
+        if (pid < 0) {
+            write(1, "fork failed\n", 12);
+            tlb_failed = 1;
+            break;
+        }
+        if (pid) {
+            wait(pid);
+        } else {
+            int snapshot = tlb_counter;
+            for (int i = 0; i < 8; i++) {
+                sched_yield();
+            }
+            if (tlb_counter != snapshot) {
+                write(1, "tlb stress: stale tlb entry\n", 28);
+                close(open(fail_name, O_CREAT | O_RDWR));
+            }
+            exit(0);
+        }
+    }
+
+    tlb_stop = 1;
+    while (__atomic_load_n(&tlb_workers_done, __ATOMIC_ACQUIRE) != workers) {
+        sched_yield();
+    }
+
+    int fd = open(fail_name, 0);
+    if (fd >= 0) {
+        close(fd);
+        unlink(fail_name);
+        tlb_failed = 1;
+    }
+
+    if (tlb_failed) {
+        write(1, "tlb stress failed\n", 18);
+        return;
+    }
+    write(1, "tlb stress ok\n", 14);
+}
+
+#define STR_BUF 4352
+#define STR_ALIGNS 16
+
+static unsigned char str_src[STR_BUF];
+static unsigned char str_dst[STR_BUF];
+static unsigned char str_ref[STR_BUF];
+
+static int str_sizes[] = { 0, 1, 2, 3, 4, 5, 7, 8, 15, 16, 17, 31, 32, 33, 63, 64, 65, 100, 127, 128, 129, 255, 256, 257, 1000, 2047, 2048, 2049, 4096 };
+
+// The references are built and compared with plain byte loops, so a broken
+// routine can't hide itself.
+static int str_same(const unsigned char* a, const unsigned char* b, int n)
+{
+    for (int i = 0; i < n; i++) {
+        if (a[i] != b[i]) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static void str_copy(unsigned char* dst, const unsigned char* src, int n)
+{
+    for (int i = 0; i < n; i++) {
+        dst[i] = src[i];
+    }
+}
+
+static int str_fail(const char* name, int sa, int da, int n)
+{
+    printf("string test: %s failed, src align %d, dst align %d, size %d\n", name, sa, da, n);
+    return 1;
+}
+
+// Every routine is checked against a byte loop for all alignments in
+// every size bucket, so both the word-wide and the vector paths are hit.
+void stringtest(void)
+{
+    int failed = 0;
+    write(1, "string test\n", 12);
+
+    for (int si = 0; si < sizeof(str_sizes) / sizeof(str_sizes[0]) && !failed; si++) {
+        int n = str_sizes[si];
+        for (int sa = 0; sa < STR_ALIGNS && !failed; sa++) {
+            for (int da = 0; da < STR_ALIGNS && !failed; da++) {
+                for (int i = 0; i < STR_BUF; i++) {
+                    str_src[i] = 1 + (i * 7) % 251;
+                    str_dst[i] = str_ref[i] = 0xaa;
+                }
+
+                memcpy(str_dst + da, str_src + sa, n);
+                for (int i = 0; i < n; i++) {
+                    str_ref[da + i] = str_src[sa + i];
+                }
+                if (!str_same(str_dst, str_ref, STR_BUF)) {
+                    failed = str_fail("memcpy", sa, da, n);
+                }
+
+                memset(str_dst + da, sa, n);
+                for (int i = 0; i < n; i++) {
+                    str_ref[da + i] = sa;
+                }
+                if (!str_same(str_dst, str_ref, STR_BUF)) {
+                    failed = str_fail("memset", sa, da, n);
+                }
+
+                // Overlapping moves in both directions.
+                str_copy(str_dst, str_src, STR_BUF);
+                str_copy(str_ref, str_src, STR_BUF);
+                memmove(str_dst + 16 + da, str_dst + 16 + sa, n);
+                for (int i = 0; i < n; i++) {
+                    str_ref[16 + da + i] = str_src[16 + sa + i];
+                }
+                if (!str_same(str_dst, str_ref, STR_BUF)) {
+                    failed = str_fail("memmove", sa, da, n);
+                }
+
+                str_copy(str_dst + da, str_src + sa, n);
+                if (memcmp(str_dst + da, str_src + sa, n) != 0) {
+                    failed = str_fail("memcmp equal", sa, da, n);
+                }
+                if (n) {
+                    int k = (n * 5) / 7;
+                    str_dst[da + k] = str_src[sa + k] + 1;
+                    if (memcmp(str_src + sa, str_dst + da, n) >= 0 || memcmp(str_dst + da, str_src + sa, n) <= 0) {
+                        failed = str_fail("memcmp order", sa, da, n);
+                    }
+
+                    str_dst[da + k] = 0xff;
+                    if (memchr(str_dst + da, 0xff, n) != str_dst + da + k || memchr(str_dst + da, 0xff, k) != NULL) {
+                        failed = str_fail("memchr", sa, da, n);
+                    }
+                }
+
+                str_dst[da + n] = 0;
+                if (strlen((char*)str_dst + da) != n) {
+                    failed = str_fail("strlen", sa, da, n);
+                }
+                if (strchr((char*)str_dst + da, 0) != (char*)str_dst + da + n || strchr((char*)str_dst + da, 0xfe) != NULL) {
+                    failed = str_fail("strchr", sa, da, n);
+                }
+                if (n && strchr((char*)str_dst + da, 0xff) != (char*)str_dst + da + (n * 5) / 7) {
+                    failed = str_fail("strchr", sa, da, n);
+                }
+            }
+        }
+    }
+
+    if (!failed) {
+        write(1, "string ok\n", 10);
+    }
+}
+
 int main(int argc, char** argv)
 {
     testsignals();
@@ -236,5 +449,7 @@ int main(int argc, char** argv)
     exectest();
     fourfiles();
     dirfile();
+    tlbstress();
+    stringtest();
     return 0;
 }
\ No newline at end of file
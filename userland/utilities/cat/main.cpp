@@ -3,13 +3,27 @@
 #include <stdlib.h>
 #include <unistd.h>
 
-#define BUF_SIZE 512
+// Files are advised as sequential, so the stdio buffer does the large
+// reads and this one only hands chunks to stdout.
+#define BUF_SIZE BUFSIZ
 char buf[BUF_SIZE];
 
+// Terminals and pipes hand out what they have, so stdin is read directly.
 void cat(int fd)
 {
     int n = 0;
-    while ((n = read(fd, buf, sizeof(buf))) > 0) {
+    while ((n = read(fd, buf, 512)) > 0) {
+        if (fwrite(buf, n, 1, stdout) != n) {
+            exit(1);
+        }
+    }
+}
+
+void cat_file(FILE* file)
+{
+    posix_fadvise(fileno(file), 0, 0, POSIX_FADV_SEQUENTIAL);
+    int n = 0;
+    while ((n = fread(buf, 1, sizeof(buf), file)) > 0) {
         if (fwrite(buf, n, 1, stdout) != n) {
             exit(1);
         }
@@ -18,7 +32,8 @@ void cat(int fd)
 
 int main(int argc, char** argv)
 {
-    int fd, i;
+    FILE* file;
+    int i;
 
     if (argc <= 1) {
         cat(0);
@@ -26,12 +41,12 @@ int main(int argc, char** argv)
     }
 
     for (i = 1; i < argc; i++) {
-        if ((fd = open(argv[i], 0)) < 0) {
+        if (!(file = fopen(argv[i], "r"))) {
             // printf(1, "cat: cannot open %s\n", argv[i]);
             return 1;
         }
-        cat(fd);
-        close(fd);
+        cat_file(file);
+        fclose(file);
     }
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,425 @@
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <spawn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/profile.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define KERNEL_PATH "/boot/kernel.bin"
+#define PROFILE_PATH "/proc/profile"
+#define PROFILE_DROPPED_PATH "/proc/profile_dropped"
+#define READ_SAMPLES 64
+#define MAX_FUNCTIONS 1024
+#define MAX_EDGES 2048
+#define REPORT_LINES 20
+
+#define SHT_SYMTAB 2
+#define STT_FUNC 2
+
+struct elf_header {
+    uint8_t e_ident[16];
+    uint16_t e_type;
+    uint16_t e_machine;
+    uint32_t e_version;
+    uint32_t e_entry;
+    uint32_t e_phoff;
+    uint32_t e_shoff;
+    uint32_t e_flags;
+    uint16_t e_ehsize;
+    uint16_t e_phentsize;
+    uint16_t e_phnum;
+    uint16_t e_shentsize;
+    uint16_t e_shnum;
+    uint16_t e_shstrndx;
+};
+
+struct elf_section_header {
+    uint32_t sh_name;
+    uint32_t sh_type;
+    uint32_t sh_flags;
+    uint32_t sh_addr;
+    uint32_t sh_offset;
+    uint32_t sh_size;
+    uint32_t sh_link;
+    uint32_t sh_info;
+    uint32_t sh_addralign;
+    uint32_t sh_entsize;
+};
+
+struct elf_sym {
+    uint32_t st_name;
+    uint32_t st_value;
+    uint32_t st_size;
+    uint8_t st_info;
+    uint8_t st_other;
+    uint16_t st_shndx;
+};
+
+struct symbol {
+    uint32_t addr;
+    const char* name;
+};
+
+struct symtab {
+    uint8_t* data;
+    symbol* syms;
+    uint32_t count;
+};
+
+struct function_stat {
+    const char* name;
+    uint32_t self;
+    uint32_t total;
+    uint32_t last_sample;
+};
+
+struct edge_stat {
+    const char* caller;
+    const char* callee;
+    uint32_t count;
+};
+
+static symtab kernel_syms;
+static symtab user_syms;
+static pid_t user_pid;
+
+static function_stat functions[MAX_FUNCTIONS];
+static uint32_t functions_count;
+static edge_stat edges[MAX_EDGES];
+static uint32_t edges_count;
+static uint32_t samples_count;
+
+static char unknown_names[2][16] = { "[kernel]", "[user]" };
+
+static bool read_file(const char* path, uint8_t** data, uint32_t* size)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    fstat_t stat;
+    if (fstat(fd, &stat) < 0) {
+        close(fd);
+        return false;
+    }
+
+    uint8_t* buf = (uint8_t*)malloc(stat.size);
+    if (!buf) {
+        close(fd);
+        return false;
+    }
+
+    uint32_t done = 0;
+    while (done < stat.size) {
+        int n = read(fd, (char*)buf + done, stat.size - done);
+        if (n <= 0) {
+            break;
+        }
+        done += n;
+    }
+    close(fd);
+
+    *data = buf;
+    *size = done;
+    return true;
+}
+
+static void sort_symbols(symbol* syms, uint32_t count)
+{
+    for (uint32_t gap = count / 2; gap > 0; gap /= 2) {
+        for (uint32_t i = gap; i < count; i++) {
+            symbol tmp = syms[i];
+            uint32_t j = i;
+            for (; j >= gap && syms[j - gap].addr > tmp.addr; j -= gap) {
+                syms[j] = syms[j - gap];
+            }
+            syms[j] = tmp;
+        }
+    }
+}
+
+/**
+ * Loads function symbols of the elf file at @path sorted by address.
+ */
+static bool load_symtab(const char* path, symtab* tab)
+{
+    uint32_t size;
+    if (!read_file(path, &tab->data, &size)) {
+        return false;
+    }
+
+    elf_header* header = (elf_header*)tab->data;
+    if (size < sizeof(elf_header) || memcmp(header->e_ident, "\x7f" "ELF", 4) != 0) {
+        return false;
+    }
+    if (header->e_shoff + header->e_shnum * sizeof(elf_section_header) > size) {
+        return false;
+    }
+
+    elf_section_header* sections = (elf_section_header*)(tab->data + header->e_shoff);
+    for (int i = 0; i < header->e_shnum; i++) {
+        if (sections[i].sh_type != SHT_SYMTAB || sections[i].sh_link >= header->e_shnum) {
+            continue;
+        }
+
+        elf_sym* syms = (elf_sym*)(tab->data + sections[i].sh_offset);
+        uint32_t syms_count = sections[i].sh_size / sizeof(elf_sym);
+        const char* strs = (const char*)(tab->data + sections[sections[i].sh_link].sh_offset);
+
+        tab->syms = (symbol*)malloc(syms_count * sizeof(symbol));
+        if (!tab->syms) {
+            return false;
+        }
+        for (uint32_t j = 0; j < syms_count; j++) {
+            if ((syms[j].st_info & 0xf) == STT_FUNC && syms[j].st_value) {
+                tab->syms[tab->count].addr = syms[j].st_value;
+                tab->syms[tab->count].name = strs + syms[j].st_name;
+                tab->count++;
+            }
+        }
+        sort_symbols(tab->syms, tab->count);
+        return true;
+    }
+    return false;
+}
+
+static const char* resolve(const profile_sample_t* sample, uint32_t ip)
+{
+    const symtab* tab = nullptr;
+    if (sample->flags & PROFILE_SAMPLE_KERNEL) {
+        tab = &kernel_syms;
+    } else if (sample->pid == user_pid) {
+        tab = &user_syms;
+    }
+
+    if (!tab || !tab->count || ip < tab->syms[0].addr) {
+        return unknown_names[(sample->flags & PROFILE_SAMPLE_KERNEL) ? 0 : 1];
+    }
+
+    uint32_t lo = 0;
+    uint32_t hi = tab->count;
+    while (hi - lo > 1) {
+        uint32_t mid = (lo + hi) / 2;
+        if (tab->syms[mid].addr <= ip) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+    return tab->syms[lo].name;
+}
+
+static function_stat* find_function(const char* name)
+{
+    for (uint32_t i = 0; i < functions_count; i++) {
+        if (functions[i].name == name) {
+            return &functions[i];
+        }
+    }
+    if (functions_count == MAX_FUNCTIONS) {
+        return nullptr;
+    }
+
+    function_stat* func = &functions[functions_count++];
+    func->name = name;
+    func->self = func->total = func->last_sample = 0;
+    return func;
+}
+
+static void account_edge(const char* caller, const char* callee)
+{
+    for (uint32_t i = 0; i < edges_count; i++) {
+        if (edges[i].caller == caller && edges[i].callee == callee) {
+            edges[i].count++;
+            return;
+        }
+    }
+    if (edges_count == MAX_EDGES) {
+        return;
+    }
+
+    edges[edges_count].caller = caller;
+    edges[edges_count].callee = callee;
+    edges[edges_count].count = 1;
+    edges_count++;
+}
+
+static void account_sample(const profile_sample_t* sample)
+{
+    samples_count++;
+
+    const char* callee = nullptr;
+    for (uint32_t i = 0; i < sample->depth && i < PROFILE_MAX_DEPTH; i++) {
+        const char* name = resolve(sample, sample->ips[i]);
+        function_stat* func = find_function(name);
+        if (func) {
+            if (i == 0) {
+                func->self++;
+            }
+            // Recursive functions are counted once per sample.
+            if (func->last_sample != samples_count) {
+                func->total++;
+                func->last_sample = samples_count;
+            }
+        }
+        if (callee) {
+            account_edge(name, callee);
+        }
+        callee = name;
+    }
+}
+
+static void print_flat()
+{
+    for (uint32_t i = 1; i < functions_count; i++) {
+        for (uint32_t j = i; j > 0 && functions[j - 1].self < functions[j].self; j--) {
+            function_stat tmp = functions[j];
+            functions[j] = functions[j - 1];
+            functions[j - 1] = tmp;
+        }
+    }
+
+    printf("Flat profile, %d samples\n", samples_count);
+    printf("self%% self total name\n");
+    for (uint32_t i = 0; i < functions_count && i < REPORT_LINES; i++) {
+        printf("%d%% %d %d %s\n", functions[i].self * 100 / samples_count, functions[i].self, functions[i].total, functions[i].name);
+    }
+}
+
+static void print_call_graph()
+{
+    for (uint32_t i = 1; i < edges_count; i++) {
+        for (uint32_t j = i; j > 0 && edges[j - 1].count < edges[j].count; j--) {
+            edge_stat tmp = edges[j];
+            edges[j] = edges[j - 1];
+            edges[j - 1] = tmp;
+        }
+    }
+
+    printf("\nCall graph\n");
+    printf("count caller -> callee\n");
+    for (uint32_t i = 0; i < edges_count && i < REPORT_LINES; i++) {
+        printf("%d %s -> %s\n", edges[i].count, edges[i].caller, edges[i].callee);
+    }
+}
+
+static bool has_slash(const char* str)
+{
+    for (; *str; str++) {
+        if (*str == '/') {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool profiler_control(const char* cmd)
+{
+    int fd = open(PROFILE_PATH, O_WRONLY);
+    if (fd < 0) {
+        return false;
+    }
+    int res = write(fd, cmd, 1);
+    close(fd);
+    return res == 1;
+}
+
+static bool drain_done = false;
+
+/**
+ * Runs next to the command. While the profiler runs, reads block until
+ * a ring is half full, so the rings are drained before they wrap. The
+ * loop ends once the profiler is stopped and the rings are empty.
+ */
+static void* drain_samples(void*)
+{
+    profile_sample_t samples[READ_SAMPLES];
+    int fd = open(PROFILE_PATH, O_RDONLY);
+    if (fd >= 0) {
+        int n;
+        while ((n = read(fd, (char*)samples, sizeof(samples))) > 0) {
+            for (int i = 0; i < n / (int)sizeof(profile_sample_t); i++) {
+                account_sample(&samples[i]);
+            }
+        }
+        close(fd);
+    }
+
+    __atomic_store_n(&drain_done, true, __ATOMIC_RELEASE);
+    return nullptr;
+}
+
+static int read_dropped()
+{
+    char buf[16] = {};
+    int fd = open(PROFILE_DROPPED_PATH, O_RDONLY);
+    if (fd < 0) {
+        return 0;
+    }
+    read(fd, buf, sizeof(buf) - 1);
+    close(fd);
+    return atoi(buf);
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2) {
+        printf("usage: profile <command> [args]\n");
+        return 1;
+    }
+
+    char path[256];
+    if (has_slash(argv[1])) {
+        snprintf(path, sizeof(path), "%s", argv[1]);
+    } else {
+        snprintf(path, sizeof(path), "/bin/%s", argv[1]);
+    }
+
+    if (!load_symtab(KERNEL_PATH, &kernel_syms)) {
+        printf("profile: can't read symbols of %s\n", KERNEL_PATH);
+    }
+    if (!load_symtab(path, &user_syms)) {
+        printf("profile: can't read symbols of %s\n", path);
+    }
+
+    if (!profiler_control("1")) {
+        printf("profile: can't start profiler\n");
+        return 1;
+    }
+
+    if (posix_spawn(&user_pid, path, nullptr, nullptr, &argv[1], nullptr) != 0) {
+        profiler_control("0");
+        printf("profile: can't run %s\n", path);
+        return 1;
+    }
+    pthread_t drain_thread;
+    bool draining = pthread_create(&drain_thread, nullptr, drain_samples, nullptr) == 0;
+    wait(user_pid);
+    profiler_control("0");
+
+    if (draining) {
+        while (!__atomic_load_n(&drain_done, __ATOMIC_ACQUIRE)) {
+            sched_yield();
+        }
+    } else {
+        drain_samples(nullptr);
+    }
+
+    int dropped = read_dropped();
+    if (dropped) {
+        printf("profile: %d samples were dropped, the report is partial\n", dropped);
+    }
+    if (!samples_count) {
+        printf("profile: no samples\n");
+        return 0;
+    }
+
+    print_flat();
+    print_call_graph();
+    return 0;
+}
\ No newline at end of file
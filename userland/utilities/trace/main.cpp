@@ -0,0 +1,158 @@
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/trace.h>
+#include <unistd.h>
+
+#define TRACE_PATH "/dev/trace"
+#define READ_EVENTS 64
+
+#define TRACEPOINT_NAME_ENTRY(id, name, args) name,
+static const char* tracepoint_names[] = { TRACEPOINTS(TRACEPOINT_NAME_ENTRY) };
+#undef TRACEPOINT_NAME_ENTRY
+
+#define TRACEPOINT_ARGS_ENTRY(id, name, args) args,
+static const char* tracepoint_args[] = { TRACEPOINTS(TRACEPOINT_ARGS_ENTRY) };
+#undef TRACEPOINT_ARGS_ENTRY
+
+static int find_tracepoint(const char* name)
+{
+    for (int i = 0; i < TRACEPOINTS_COUNT; i++) {
+        if (strcmp(tracepoint_names[i], name) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static int set_mask(uint32_t mask)
+{
+    int fd = open(TRACE_PATH, O_RDONLY);
+    if (fd < 0) {
+        printf("trace: can't open %s\n", TRACE_PATH);
+        return 1;
+    }
+    int err = ioctl(fd, TRACE_SET_MASK, mask);
+    close(fd);
+    if (err < 0) {
+        printf("trace: can't set tracepoints\n");
+        return 1;
+    }
+    return 0;
+}
+
+static int cmd_start(int argc, char** argv)
+{
+    uint32_t mask = 0;
+    for (int i = 2; i < argc; i++) {
+        int id = find_tracepoint(argv[i]);
+        if (id < 0) {
+            printf("trace: unknown tracepoint %s\n", argv[i]);
+            return 1;
+        }
+        mask |= (1 << id);
+    }
+    if (!mask) {
+        mask = (1 << TRACEPOINTS_COUNT) - 1;
+    }
+    return set_mask(mask);
+}
+
+static void print_event(const trace_event_t* event, uint64_t first_time)
+{
+    if (event->id >= TRACEPOINTS_COUNT) {
+        return;
+    }
+
+    // Labels of the arguments are separated with spaces.
+    char labels[64];
+    snprintf(labels, sizeof(labels), "%s", tracepoint_args[event->id]);
+    char* label = labels;
+
+    printf("+%lu cpu%d tid %d %s", event->time - first_time, event->cpu, event->tid, tracepoint_names[event->id]);
+    for (int i = 0; i < TRACE_ARGS && *label; i++) {
+        char* end = label;
+        while (*end && *end != ' ') {
+            end++;
+        }
+        bool last = (*end == '\0');
+        *end = '\0';
+        printf(" %s=%x", label, event->args[i]);
+        label = last ? end : end + 1;
+    }
+    printf("\n");
+}
+
+/**
+ * Records come grouped by cpu, so they are merged by time before
+ * printing the timeline.
+ */
+static int cmd_dump()
+{
+    int fd = open(TRACE_PATH, O_RDONLY);
+    if (fd < 0) {
+        printf("trace: can't open %s\n", TRACE_PATH);
+        return 1;
+    }
+
+    trace_event_t* events = nullptr;
+    uint32_t count = 0;
+    uint32_t capacity = 0;
+    for (;;) {
+        if (count + READ_EVENTS > capacity) {
+            capacity = capacity ? capacity * 2 : 4 * READ_EVENTS;
+            events = (trace_event_t*)realloc(events, capacity * sizeof(trace_event_t));
+            if (!events) {
+                close(fd);
+                return 1;
+            }
+        }
+        int n = read(fd, (char*)&events[count], READ_EVENTS * sizeof(trace_event_t));
+        if (n <= 0) {
+            break;
+        }
+        count += n / sizeof(trace_event_t);
+    }
+    close(fd);
+
+    for (uint32_t gap = count / 2; gap > 0; gap /= 2) {
+        for (uint32_t i = gap; i < count; i++) {
+            trace_event_t tmp = events[i];
+            uint32_t j = i;
+            for (; j >= gap && events[j - gap].time > tmp.time; j -= gap) {
+                events[j] = events[j - gap];
+            }
+            events[j] = tmp;
+        }
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        print_event(&events[i], events[0].time);
+    }
+    free(events);
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc >= 2 && strcmp(argv[1], "start") == 0) {
+        return cmd_start(argc, argv);
+    }
+    if (argc >= 2 && strcmp(argv[1], "stop") == 0) {
+        return set_mask(0);
+    }
+    if (argc >= 2 && strcmp(argv[1], "dump") == 0) {
+        return cmd_dump();
+    }
+    if (argc >= 2 && strcmp(argv[1], "list") == 0) {
+        for (int i = 0; i < TRACEPOINTS_COUNT; i++) {
+            printf("%s: %s\n", tracepoint_names[i], tracepoint_args[i]);
+        }
+        return 0;
+    }
+
+    printf("usage: trace start [tracepoint...] | stop | dump | list\n");
+    return 1;
+}
\ No newline at end of file